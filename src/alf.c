@@ -161,10 +161,9 @@ static void set_ey_from_clip(const alf_covariance *cov, const int* clip, double
   }
 }
 
-static int gns_cholesky_dec(double inp_matr[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], double out_matr[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], int num_eq)
+static int gns_cholesky_dec_rows(double inp_matr[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], double out_matr[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], double inv_diag[MAX_NUM_ALF_LUMA_COEFF], int first_row, int num_eq)
 {
-  double inv_diag[MAX_NUM_ALF_LUMA_COEFF];  /* Vector of the inverse of diagonal entries of outMatr */
-  for (int i = 0; i < num_eq; i++)
+  for (int i = first_row; i < num_eq; i++)
   {
     for (int j = i; j < num_eq; j++)
     {
@@ -200,6 +199,40 @@ static int gns_cholesky_dec(double inp_matr[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_
   return 1; /* Signal that Cholesky factorization is successfully performed */
 }
 
+static int gns_cholesky_dec(double inp_matr[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], double out_matr[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], int num_eq)
+{
+  double inv_diag[MAX_NUM_ALF_LUMA_COEFF];  /* Vector of the inverse of diagonal entries of outMatr */
+  return gns_cholesky_dec_rows(inp_matr, out_matr, inv_diag, 0, num_eq);
+}
+
+/**
+ * \brief Cholesky factorization of a matrix that differs from an already
+ * factorized matrix only in row and column k.
+ *
+ * The rows above k of the factor only change in column k, so the rest of
+ * them are taken from the old factor. The result is identical to
+ * gns_cholesky_dec.
+ *
+ * \param base  Cholesky factor of the matrix before row and column k changed.
+ */
+static int gns_cholesky_dec_update(double inp_matr[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], double base[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], double out_matr[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], int k, int num_eq)
+{
+  double inv_diag[MAX_NUM_ALF_LUMA_COEFF];
+  for (int i = 0; i < k; i++)
+  {
+    memcpy(out_matr[i], base[i], sizeof(double) * num_eq);
+    inv_diag[i] = 1.0 / out_matr[i][i];
+
+    double scale = inp_matr[i][k];
+    for (int m = i - 1; m >= 0; m--)
+    {
+      scale -= out_matr[m][k] * out_matr[m][i];
+    }
+    out_matr[i][k] = scale * inv_diag[i];
+  }
+  return gns_cholesky_dec_rows(inp_matr, out_matr, inv_diag, k, num_eq);
+}
+
 static void gns_transpose_backsubstitution(double u[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], double* rhs, double* x, int order)
 {
   /* Backsubstitution starts */
@@ -284,6 +317,34 @@ static int gns_solve_by_chol(double lhs[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA
   return res;
 }
 
+/**
+ * \brief Solve lhs * x = rhs when lhs differs from a factorized matrix only
+ * in row and column k.
+ *
+ * Falls back to gns_solve_by_chol, which regularizes lhs, if lhs is
+ * singular.
+ *
+ * \param base  Cholesky factor of lhs before row and column k changed, or
+ *              NULL to factorize lhs from scratch.
+ *
+ * \return  0 if lhs was regularized, 1 otherwise.
+ */
+static int gns_solve_by_chol_update(double lhs[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], double rhs[MAX_NUM_ALF_LUMA_COEFF], double *x, double base[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], int k, int num_eq)
+{
+  double aux[MAX_NUM_ALF_LUMA_COEFF];
+  double u[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF];
+
+  const int res = base ? gns_cholesky_dec_update(lhs, base, u, k, num_eq) : gns_cholesky_dec(lhs, u, num_eq);
+  if (!res)
+  {
+    gns_solve_by_chol(lhs, rhs, x, num_eq);
+    return 0;
+  }
+  gns_transpose_backsubstitution(u, rhs, aux, num_eq);
+  gns_backsubstitution(u, aux, num_eq, x);
+  return 1;
+}
+
 static int gns_solve_by_chol_clip_gns(alf_covariance *cov, const int *clip, double *x, int num_eq)
 {
   double lhs[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF];
@@ -332,6 +393,11 @@ static double optimize_filter(const alf_covariance *cov, int* clip, double *f, b
 
   int step = optimize_clip ? (cov->num_bins + 1) / 2 : 0;
 
+  // Each candidate changes one clipping value, i.e. one row and column of
+  // ke, so the factorization of the current ke is reused for the rows above.
+  double ke_chol[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF];
+  enum { CHOL_STALE, CHOL_VALID, CHOL_SINGULAR } chol_state = CHOL_STALE;
+
   while (step > 0)
   {
     double err_min = err_best;
@@ -340,6 +406,11 @@ static double optimize_filter(const alf_covariance *cov, int* clip, double *f, b
 
     for (int k = 0; k < size - 1; ++k)
     {
+      if (chol_state == CHOL_STALE)
+      {
+        chol_state = gns_cholesky_dec(ke, ke_chol, size) ? CHOL_VALID : CHOL_SINGULAR;
+      }
+
       if (clip[k] - step >= clip_max[k])
       {
         clip[k] -= step;
@@ -350,7 +421,10 @@ static double optimize_filter(const alf_covariance *cov, int* clip, double *f, b
           ke[l][k] = (double)cov->ee[l][k][clip[l]][clip[k]];
         }
 
-        gns_solve_by_chol(ke, ky, f, size);
+        if (!gns_solve_by_chol_update(ke, ky, f, chol_state == CHOL_VALID ? ke_chol : NULL, k, size))
+        {
+          chol_state = CHOL_STALE;
+        }
         err_last = calculate_error(cov, clip, f);
 
         if (err_last < err_min)
@@ -371,7 +445,10 @@ static double optimize_filter(const alf_covariance *cov, int* clip, double *f, b
           ke[l][k] = (double)cov->ee[l][k][clip[l]][clip[k]];
         }
 
-        gns_solve_by_chol(ke, ky, f, size);
+        if (!gns_solve_by_chol_update(ke, ky, f, chol_state == CHOL_VALID ? ke_chol : NULL, k, size))
+        {
+          chol_state = CHOL_STALE;
+        }
         err_last = calculate_error(cov, clip, f);
 
         if (err_last < err_min)
@@ -393,6 +470,7 @@ static double optimize_filter(const alf_covariance *cov, int* clip, double *f, b
 
     if (idx_min >= 0)
     {
+      chol_state = CHOL_STALE;
       err_best = err_min;
       clip[idx_min] += inc_min;
       ky[idx_min] = cov->y[idx_min][clip[idx_min]];
@@ -471,6 +549,96 @@ static double calc_error_for_coeffs(const alf_covariance *cov, const int *clip,
   return error / factor;
 }
 
+/**
+ * \brief Gather the covariance of the filter taps with fixed clipping values.
+ */
+static void get_clipped_cov(const alf_covariance *cov, const int *clip, const int num_coeff,
+  int64_t ee[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF], int32_t y[MAX_NUM_ALF_LUMA_COEFF])
+{
+  for (int i = 0; i < num_coeff; i++)
+  {
+    y[i] = cov->y[i][clip[i]];
+    for (int j = i; j < num_coeff; j++)
+    {
+      ee[i][j] = cov->ee[i][j][clip[i]][clip[j]];
+    }
+  }
+}
+
+/**
+ * \brief Terms of the filter error of the current coefficients.
+ *
+ * Used to evaluate the change of a single coefficient without computing
+ * the unchanged terms again.
+ */
+typedef struct {
+  double partial_sum[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF]; // Sums of the cross terms of row i up to column j, the whole sum at j = i
+  double term[MAX_NUM_ALF_LUMA_COEFF]; // Error term of each coefficient
+} alf_coeff_error_cache;
+
+/**
+ * \brief Same as calc_error_for_coeffs for a covariance gathered with
+ * get_clipped_cov. Stores the terms of the error to the cache.
+ */
+static double calc_error_for_clipped_coeffs(alf_coeff_error_cache *cache,
+  const int64_t ee[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF],
+  const int32_t y[MAX_NUM_ALF_LUMA_COEFF], const int *coeff, const int num_coeff, const int bit_depth)
+{
+  double factor = 1 << (bit_depth - 1);
+  double error = 0;
+
+  for (int i = 0; i < num_coeff; i++)   //diagonal
+  {
+    double sum = 0;
+    for (int j = i + 1; j < num_coeff; j++)
+    {
+      sum += ee[i][j] * coeff[j];
+      cache->partial_sum[i][j] = sum;
+    }
+    cache->partial_sum[i][i] = sum;
+    cache->term[i] = ((ee[i][i] * coeff[i] + sum * 2) / factor - 2 * y[i]) * coeff[i];
+    error += cache->term[i];
+  }
+
+  return error / factor;
+}
+
+/**
+ * \brief Error of the coefficients when only coefficient k differs from the
+ * coefficients stored in the cache.
+ *
+ * The terms are computed in the same order as in calc_error_for_coeffs, so
+ * the result is identical.
+ */
+static double calc_error_for_changed_coeff(const alf_coeff_error_cache *cache,
+  const int64_t ee[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF],
+  const int32_t y[MAX_NUM_ALF_LUMA_COEFF], const int *coeff, const int k, const int num_coeff, const int bit_depth)
+{
+  double factor = 1 << (bit_depth - 1);
+  double error = 0;
+
+  for (int i = 0; i < num_coeff; i++)
+  {
+    double term = cache->term[i];
+    if (i < k)
+    {
+      double sum = k > i + 1 ? cache->partial_sum[i][k - 1] : 0;
+      for (int j = k; j < num_coeff; j++)
+      {
+        sum += ee[i][j] * coeff[j];
+      }
+      term = ((ee[i][i] * coeff[i] + sum * 2) / factor - 2 * y[i]) * coeff[i];
+    }
+    else if (i == k)
+    {
+      term = ((ee[k][k] * coeff[k] + cache->partial_sum[k][k] * 2) / factor - 2 * y[k]) * coeff[k];
+    }
+    error += term;
+  }
+
+  return error / factor;
+}
+
 static double calc_error_for_cc_alf_coeffs(const alf_covariance *cov, const int16_t* coeff, const int num_coeff, const int bit_depth)
 {
   double factor = 1 << (bit_depth - 1);
@@ -1654,121 +1822,62 @@ static void filter_blk_cc_alf(encoder_state_t * const state,
   assert(!((end_height - start_height) % cls_size_y)); //Wrong end_height in filtering
   assert(!((end_width - start_width) % cls_size_x)); //Wrong end_width in filtering
 
-  const uvg_pixel* src_buf = rec_src;
-  const uvg_pixel* luma_ptr = src_buf + luma_start_height * rec_luma_stride + luma_start_width;
-
   const int chroma_stride = rec_luma_stride >> scale_x;
-  uvg_pixel* chroma_ptr = dst_buf + start_height * chroma_stride + start_width;
-
-  for (int i = 0; i < end_height - start_height; i += cls_size_y)
-  {
-    for (int j = 0; j < end_width - start_width; j += cls_size_x)
-    {
-      for (int ii = 0; ii < cls_size_y; ii++)
-      {
-        int row = ii;
-        int col = j;
-        uvg_pixel *src_self = chroma_ptr + col + row * chroma_stride;
-
-        int offset1 = rec_luma_stride;
-        int offset2 = -rec_luma_stride;
-        int offset3 = 2 * rec_luma_stride;
-        row <<= scale_y;
-        col <<= scale_x;
-        const uvg_pixel *src_cross = luma_ptr + col + row * rec_luma_stride;
-
-        int pos = ((start_height + i + ii) << scale_y) & (vb_ctu_height - 1);
-        if (scale_y == 0 && (pos == vb_pos || pos == vb_pos + 1))
-        {
-          continue;
-        }
-        if (pos == (vb_pos - 2) || pos == (vb_pos + 1))
-        {
-          offset3 = offset1;
-        }
-        else if (pos == (vb_pos - 1) || pos == vb_pos)
-        {
-          offset1 = 0;
-          offset2 = 0;
-          offset3 = 0;
-        }
-
-        for (int jj = 0; jj < cls_size_x; jj++)
-        {
-          const int jj2 = (jj << scale_x);
-          const int offset0 = 0;
-
-          int sum = 0;
-          const uvg_pixel curr_src_cross = src_cross[offset0 + jj2];
-          sum += filter_coeff[0] * (src_cross[offset2 + jj2] - curr_src_cross);
-          sum += filter_coeff[1] * (src_cross[offset0 + jj2 - 1] - curr_src_cross);
-          sum += filter_coeff[2] * (src_cross[offset0 + jj2 + 1] - curr_src_cross);
-          sum += filter_coeff[3] * (src_cross[offset1 + jj2 - 1] - curr_src_cross);
-          sum += filter_coeff[4] * (src_cross[offset1 + jj2] - curr_src_cross);
-          sum += filter_coeff[5] * (src_cross[offset1 + jj2 + 1] - curr_src_cross);
-          sum += filter_coeff[6] * (src_cross[offset3 + jj2] - curr_src_cross);
-
-          sum = (sum + ((1 << 7/*m_scaleBits*/) >> 1)) >> 7/*m_scaleBits*/;
-          const int offset = 1 << clp_rngs.comp[comp_id].bd >> 1;
-          sum = uvg_fast_clip_32bit_to_pixel(sum + offset) - offset;
-          sum += src_self[jj];
-          src_self[jj] = uvg_fast_clip_32bit_to_pixel(sum);
-        }
-      }
-    }
-
-    chroma_ptr += chroma_stride * cls_size_y;
-
-    luma_ptr += rec_luma_stride * cls_size_y << scale_y;
-  }
+  uvg_alf_filter_cc_blk(dst_buf + start_height * chroma_stride + start_width,
+    chroma_stride,
+    rec_src + luma_start_height * rec_luma_stride + luma_start_width,
+    rec_luma_stride,
+    filter_coeff,
+    clp_rngs.comp[comp_id],
+    scale_x,
+    scale_y,
+    start_height,
+    blk_width,
+    blk_height,
+    vb_ctu_height,
+    vb_pos);
 }
 
 static void apply_cc_alf_filter(encoder_state_t * const state, alf_component_id comp_id, uvg_pixel *dst_buf,
   const uvg_pixel *rec_yuv_ext, const int luma_stride, uint8_t *filter_control,
   const short filter_set[MAX_NUM_CC_ALF_FILTERS][MAX_NUM_CC_ALF_CHROMA_COEFF],
   const int   selected_filter_idx,
-  array_variables *arr_vars)
+  array_variables *arr_vars,
+  const int ctu_row)
 {
   enum uvg_chroma_format chroma_format = state->encoder_control->chroma_format;
   uint8_t component_scale_y = (comp_id == COMPONENT_Y || chroma_format != UVG_CSP_420) ? 0 : 1;
   uint8_t component_scale_x = (comp_id == COMPONENT_Y || chroma_format == UVG_CSP_444) ? 0 : 1;
   const int pic_height = state->tile->frame->height;
   const int pic_width = state->tile->frame->width;
-  const int max_ctu_height_log2 = uvg_math_floor_log2(LCU_WIDTH);
   const int max_ctu_width_log2 = uvg_math_floor_log2(LCU_WIDTH);
   const int width_in_ctus = state->tile->frame->width_in_lcu;
   const int alf_vb_luma_ctu_height = LCU_WIDTH;
   const int alf_vb_luma_pos = LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA;
 
-  int ctu_idx = 0;
-  for (int y_pos = 0; y_pos < pic_height; y_pos += LCU_WIDTH)
+  const int y_pos = ctu_row * LCU_WIDTH;
+  for (int x_pos = 0; x_pos < pic_width; x_pos += LCU_WIDTH)
   {
-    for (int x_pos = 0; x_pos < pic_width; x_pos += LCU_WIDTH)
+    int filter_idx =
+      (filter_control == NULL)
+      ? selected_filter_idx
+      : filter_control[ctu_row * width_in_ctus + (x_pos >> max_ctu_width_log2)];
+    bool skip_filtering = (filter_control != NULL && filter_idx == 0) ? true : false;
+    if (!skip_filtering)
     {
-      int filter_idx =
-        (filter_control == NULL)
-        ? selected_filter_idx
-        : filter_control[(y_pos >> max_ctu_height_log2) * width_in_ctus + (x_pos >> max_ctu_width_log2)];
-      bool skip_filtering = (filter_control != NULL && filter_idx == 0) ? true : false;
-      if (!skip_filtering)
+      if (filter_control != NULL)
       {
-        if (filter_control != NULL)
-        {
-          filter_idx--;
-        }
+        filter_idx--;
+      }
 
-        const int16_t *filter_coeff = filter_set[filter_idx];
+      const int16_t *filter_coeff = filter_set[filter_idx];
 
-        const int width = (x_pos + LCU_WIDTH > pic_width) ? (pic_width - x_pos) : LCU_WIDTH;
-        const int height = (y_pos + LCU_WIDTH > pic_height) ? (pic_height - y_pos) : LCU_WIDTH;
+      const int width = (x_pos + LCU_WIDTH > pic_width) ? (pic_width - x_pos) : LCU_WIDTH;
+      const int height = (y_pos + LCU_WIDTH > pic_height) ? (pic_height - y_pos) : LCU_WIDTH;
 
-        {
-          filter_blk_cc_alf(state, dst_buf, rec_yuv_ext, luma_stride, comp_id, filter_coeff, arr_vars->clp_rngs, alf_vb_luma_ctu_height,
-            alf_vb_luma_pos, x_pos >> component_scale_x, y_pos >> component_scale_y,
-            width >> component_scale_x, height >> component_scale_y);
-        }
-      }
-      ctu_idx++;
+      filter_blk_cc_alf(state, dst_buf, rec_yuv_ext, luma_stride, comp_id, filter_coeff, arr_vars->clp_rngs, alf_vb_luma_ctu_height,
+        alf_vb_luma_pos, x_pos >> component_scale_x, y_pos >> component_scale_y,
+        width >> component_scale_x, height >> component_scale_y);
     }
   }
 }
@@ -2580,36 +2689,6 @@ static void derive_cc_alf_filter(encoder_state_t * const state, alf_component_id
 
 }
 
-static void calc_covariance_cc_alf(int32_t e_local[MAX_NUM_CC_ALF_CHROMA_COEFF][1], const uvg_pixel *rec, const int stride, int vb_distance)
-{
-  const uvg_pixel *rec_y_m1 = rec - 1 * stride;
-  const uvg_pixel *rec_y_0 = rec;
-  const uvg_pixel *rec_y_p1 = rec + 1 * stride;
-  const uvg_pixel *rec_y_p2 = rec + 2 * stride;
-
-  if (vb_distance == -2 || vb_distance == +1)
-  {
-    rec_y_p2 = rec_y_p1;
-  }
-  else if (vb_distance == -1 || vb_distance == 0)
-  {
-    rec_y_m1 = rec_y_0;
-    rec_y_p2 = rec_y_p1 = rec_y_0;
-  }
-
-  const uvg_pixel center_value = rec_y_0[+0];
-  for (int b = 0; b < 1; b++)
-  {
-    e_local[0][b] += rec_y_m1[+0] - center_value;
-    e_local[1][b] += rec_y_0[-1] - center_value;
-    e_local[2][b] += rec_y_0[+1] - center_value;
-    e_local[3][b] += rec_y_p1[-1] - center_value;
-    e_local[4][b] += rec_y_p1[+0] - center_value;
-    e_local[5][b] += rec_y_p1[+1] - center_value;
-    e_local[6][b] += rec_y_p2[+0] - center_value;
-  }
-}
-
 static void get_blk_stats_cc_alf(encoder_state_t * const state,
   alf_covariance *alf_covariance,
   const uvg_picture *org_yuv,
@@ -2631,150 +2710,35 @@ static void get_blk_stats_cc_alf(encoder_state_t * const state,
   const int c_width = width >> chroma_scale_x;
   const int c_height = height >> chroma_scale_y;
 
-  const int num_coeff = 8;
-  const channel_type channel = (comp_id == COMPONENT_Y) ? CHANNEL_TYPE_LUMA : CHANNEL_TYPE_CHROMA;
-
-  enum uvg_chroma_format chroma_format = state->encoder_control->chroma_format;
-  const int number_of_components = (chroma_format == UVG_CSP_400) ? 1 : MAX_NUM_COMPONENT;;
-  int rec_stride[MAX_NUM_COMPONENT];
-  int rec_pixel_idx[MAX_NUM_COMPONENT];
-  const int luma_rec_pos = y_pos * state->tile->frame->rec->stride + x_pos;
-  const int chroma_rec_pos = y_pos_c * (state->tile->frame->rec->stride >> chroma_scale_x) + x_pos_c;
-  uvg_pixel *rec_y = &alf_info->alf_tmp_y[luma_rec_pos];
-  uvg_pixel *rec_u = &alf_info->alf_tmp_u[chroma_rec_pos];
-  uvg_pixel *rec_v = &alf_info->alf_tmp_v[chroma_rec_pos];
+  assert(comp_id != COMPONENT_Y); //Must be chroma
 
-  for (int c_idx = 0; c_idx < number_of_components; c_idx++)
-  {
-    bool is_luma = c_idx == COMPONENT_Y;
-    rec_stride[c_idx] = state->tile->frame->rec->stride >> (is_luma ? 0 : chroma_scale_x);
-    rec_pixel_idx[c_idx] = 0;
-  }
+  const int rec_stride = state->tile->frame->rec->stride;
+  const int luma_rec_pos = y_pos * rec_stride + x_pos;
+  const int chroma_rec_pos = y_pos_c * (rec_stride >> chroma_scale_x) + x_pos_c;
+  const uvg_pixel *rec_c = comp_id == COMPONENT_Cb ? &alf_info->alf_tmp_u[chroma_rec_pos] : &alf_info->alf_tmp_v[chroma_rec_pos];
 
-  int org_stride = 0;
-  const uvg_pixel *org = 0;
-  if (comp_id == COMPONENT_Y)
-  {
-    org_stride = org_yuv->stride;
-    org = &org_yuv->y[y_pos*org_stride + x_pos];
-  }
-  else if (comp_id == COMPONENT_Cb)
-  {
-    org_stride = org_yuv->stride >> chroma_scale_x;
-    org = &org_yuv->u[y_pos_c*org_stride + x_pos_c];
-  }
-  else if (comp_id == COMPONENT_Cr)
-  {
-    org_stride = org_yuv->stride >> chroma_scale_x;
-    org = &org_yuv->v[y_pos_c*org_stride + x_pos_c];
-  }
+  const int org_stride = org_yuv->stride >> chroma_scale_x;
+  const uvg_pixel *org = comp_id == COMPONENT_Cb ? &org_yuv->u[y_pos_c * org_stride + x_pos_c] : &org_yuv->v[y_pos_c * org_stride + x_pos_c];
 
-  const int  num_bins = 1;
-  int vb_ctu_height = alf_vb_luma_ctu_height;
   int vb_pos = alf_vb_luma_pos;
   if ((y_pos + max_cu_height) >= frame_height)
   {
     vb_pos = frame_height;
   }
 
-  int32_t e_local[MAX_NUM_CC_ALF_CHROMA_COEFF][1];
-  uvg_pixel *rec_pixels = (comp_id == COMPONENT_Y ? rec_y : (comp_id == COMPONENT_Cb ? rec_u : rec_v));
-  uint8_t component_scale_y = (comp_id == COMPONENT_Y || chroma_format != UVG_CSP_420) ? 0 : 1;
-  uint8_t component_scale_x = (comp_id == COMPONENT_Y || chroma_format == UVG_CSP_444) ? 0 : 1;
-  int16_t y_local = 0;
-
-  for (int i = 0; i < (comp_id == COMPONENT_Y ? height : c_height); i++)
-  {
-    int vb_distance = ((i << component_scale_y) % vb_ctu_height) - vb_pos;
-    const bool skip_this_row = (component_scale_y == 0 && (vb_distance == 0 || vb_distance == 1));
-    for (int j = 0; j < (comp_id == COMPONENT_Y ? width : c_width) && (!skip_this_row); j++)
-    {
-      memset(e_local, 0, sizeof(e_local));
-
-      double weight = 1.0;
-      if (0 /*g_alf_wssd*/)
-      {
-        //weight = m_lumaLevelToWeightPLUT[org[j]];
-      }
-
-      y_local = org[j] - rec_pixels[j + rec_pixel_idx[comp_id]];
-      calc_covariance_cc_alf(e_local, rec_y + rec_pixel_idx[COMPONENT_Y] + (j << component_scale_x), rec_stride[COMPONENT_Y], vb_distance);
-
-      for (int k = 0; k < (num_coeff - 1); k++)
-      {
-        for (int l = k; l < (num_coeff - 1); l++)
-        {
-          for (int b0 = 0; b0 < num_bins; b0++)
-          {
-            for (int b1 = 0; b1 < num_bins; b1++)
-            {
-              if (0 /*g_alf_wssd*/)
-              {
-                alf_covariance->ee[k][l][b0][b1] += (int64_t)(weight * (e_local[k][b0] * (double)e_local[l][b1]));
-              }
-              else
-              {
-                alf_covariance->ee[k][l][b0][b1] += (int64_t)(e_local[k][b0] * (double)e_local[l][b1]);
-              }
-            }
-          }
-        }
-        for (int b = 0; b < num_bins; b++)
-        {
-          if (0 /*g_alf_wssd*/)
-          {
-            alf_covariance->y[k][b] += (int32_t)(weight * (e_local[k][b] * (double)y_local));
-          }
-          else
-          {
-            alf_covariance->y[k][b] += (int32_t)(e_local[k][b] * (double)y_local);
-          }
-        }
-      }
-      if (0 /*g_alf_wssd*/)
-      {
-        alf_covariance->pix_acc += weight * (y_local * (double)y_local);
-      }
-      else
-      {
-        alf_covariance->pix_acc += y_local * (double)y_local;
-      }
-    }
-    org += org_stride;
-    for (int src_c_idx = 0; src_c_idx < number_of_components; src_c_idx++)
-    {
-      const channel_type c_channel = (src_c_idx == COMPONENT_Y) ? CHANNEL_TYPE_LUMA : CHANNEL_TYPE_CHROMA;
-      if (c_channel == channel)
-      {
-        rec_pixel_idx[src_c_idx] += rec_stride[src_c_idx];
-      }
-      else
-      {
-        if (comp_id == COMPONENT_Y)
-        {
-          rec_pixel_idx[src_c_idx] += rec_stride[src_c_idx] >> ((src_c_idx == COMPONENT_Y || chroma_format != UVG_CSP_420) ? 0 : 1);
-        }
-        else
-        {
-          rec_pixel_idx[src_c_idx] += rec_stride[src_c_idx] << ((comp_id == COMPONENT_Y || chroma_format != UVG_CSP_420) ? 0 : 1);
-        }
-      }
-    }
-  }
-
-  for (int k = 1; k < (MAX_NUM_CC_ALF_CHROMA_COEFF - 1); k++)
-  {
-    for (int l = 0; l < k; l++)
-    {
-      for (int b0 = 0; b0 < num_bins; b0++)
-      {
-        for (int b1 = 0; b1 < num_bins; b1++)
-        {
-          alf_covariance->ee[k][l][b0][b1] = alf_covariance->ee[l][k][b1][b0];
-        }
-      }
-    }
-  }
+  uvg_alf_get_blk_stats_cc(alf_covariance,
+    org,
+    org_stride,
+    rec_c,
+    rec_stride >> chroma_scale_x,
+    &alf_info->alf_tmp_y[luma_rec_pos],
+    rec_stride,
+    chroma_scale_x,
+    chroma_scale_y,
+    c_width,
+    c_height,
+    alf_vb_luma_ctu_height,
+    vb_pos);
 }
 
 static void derive_stats_for_cc_alf_filtering(encoder_state_t * const state,
@@ -3161,13 +3125,18 @@ static void alf_create_frame_buffer(encoder_state_t * const state, alf_info_t *a
     const size_t simd_padding_width = 64;
     int width = state->tile->frame->width;
     int height = state->tile->frame->height;
-    int stride = state->tile->frame->source->stride;
-    unsigned int luma_size = (width + 8) * (height + 8);
+    // The buffer has the layout of the reconstruction, whose borders may
+    // be wider than the four pixels needed here.
+    int stride = state->tile->frame->rec->stride;
+    int padding = (stride - width) / 2;
+    unsigned int luma_size = stride * (height + 2 * padding);
     unsigned chroma_sizes[] = { 0, luma_size / 4, luma_size / 2, luma_size };
     unsigned chroma_size = chroma_sizes[chroma_format];
+    const int padding_luma = padding * stride + padding;
+    const int padding_chroma = (padding / 2) * (stride / 2) + padding / 2;
 
     alf_info->alf_fulldata_buf = MALLOC_SIMD_PADDED(uvg_pixel, (luma_size + 2 * chroma_size), simd_padding_width * 2);
-    alf_info->alf_fulldata = &alf_info->alf_fulldata_buf[4 * (width + 8) + 4] + simd_padding_width / sizeof(uvg_pixel);
+    alf_info->alf_fulldata = &alf_info->alf_fulldata_buf[padding_luma] + simd_padding_width / sizeof(uvg_pixel);
     alf_info->alf_tmp_y = &alf_info->alf_fulldata[0];
 
     if (chroma_format == UVG_CSP_400) {
@@ -3175,8 +3144,8 @@ static void alf_create_frame_buffer(encoder_state_t * const state, alf_info_t *a
       alf_info->alf_tmp_v = NULL;
     }
     else {
-      alf_info->alf_tmp_u = &alf_info->alf_fulldata[luma_size - (4 * (width + 8) + 4) + (2 * (stride / 2) + 2)];
-      alf_info->alf_tmp_v = &alf_info->alf_fulldata[luma_size - (4 * (width + 8) + 4) + chroma_size + (2 * (stride / 2) + 2)];
+      alf_info->alf_tmp_u = &alf_info->alf_fulldata[luma_size - padding_luma + padding_chroma];
+      alf_info->alf_tmp_v = &alf_info->alf_fulldata[luma_size - padding_luma + chroma_size + padding_chroma];
     }
   }
 
@@ -3289,6 +3258,10 @@ void uvg_alf_create(videoframe_t *frame, enum uvg_chroma_format chroma_format)
 
   alf_info_t *alf_info = frame->alf_info;
   alf_info->aps_id_start = ALF_CTB_MAX_NUM_APS;
+  for (int aps_id = 0; aps_id < ALF_CTB_MAX_NUM_APS; aps_id++) {
+    alf_info->aps_frame_num[aps_id] = -1;
+  }
+  alf_info->last_irap_num = -1;
 
   alf_info->ctu_enable_flag[MAX_NUM_COMPONENT] = malloc(num_ctus_in_pic * MAX_NUM_COMPONENT * sizeof(*alf_info->ctu_enable_flag[MAX_NUM_COMPONENT]));
   memset(alf_info->ctu_enable_flag[MAX_NUM_COMPONENT], 0, num_ctus_in_pic * MAX_NUM_COMPONENT * sizeof(*alf_info->ctu_enable_flag[MAX_NUM_COMPONENT]));
@@ -3528,6 +3501,14 @@ static void alf_merge_classes(alf_aps *alf_aps,
   int8_t index_list_temp[MAX_NUM_ALF_CLASSES];
   int num_remaining = num_classes;
 
+  // The merge of a pair only changes when one of the classes has been merged
+  // with another class, so the errors and clippings of the other pairs are
+  // kept for the next round.
+  double pair_err[MAX_NUM_ALF_CLASSES][MAX_NUM_ALF_CLASSES];
+  int pair_clip[MAX_NUM_ALF_CLASSES][MAX_NUM_ALF_CLASSES][MAX_NUM_ALF_LUMA_COEFF];
+  bool pair_valid[MAX_NUM_ALF_CLASSES][MAX_NUM_ALF_CLASSES];
+  memset(pair_valid, 0, sizeof(pair_valid));
+
   memset(filter_indices, 0, sizeof(short) * MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_CLASSES);
 
   for (int i = 0; i < num_classes; i++)
@@ -3577,19 +3558,26 @@ static void alf_merge_classes(alf_aps *alf_aps,
             double error1 = err[i];
             double error2 = err[j];
 
-            add_alf_cov_lhs_rhs(tmp_cov, &cov_merged[i], &cov_merged[j]);
-            for (int l = 0; l < MAX_NUM_ALF_LUMA_COEFF; ++l)
+            if (!pair_valid[i][j])
             {
-              tmp_clip[l] = (clip_merged[num_remaining - 1][i][l] + clip_merged[num_remaining - 1][j][l] + 1) >> 1;
+              add_alf_cov_lhs_rhs(tmp_cov, &cov_merged[i], &cov_merged[j]);
+              for (int l = 0; l < MAX_NUM_ALF_LUMA_COEFF; ++l)
+              {
+                tmp_clip[l] = (clip_merged[num_remaining - 1][i][l] + clip_merged[num_remaining - 1][j][l] + 1) >> 1;
+              }
+
+              pair_err[i][j] = alf_aps->non_linear_flag[CHANNEL_TYPE_LUMA] ? optimize_filter_clip(tmp_cov, tmp_clip) : calculate_error_opt_filt(tmp_cov, tmp_clip);
+              memcpy(pair_clip[i][j], tmp_clip, sizeof(tmp_clip));
+              pair_valid[i][j] = true;
             }
 
-            double error_merged = alf_aps->non_linear_flag[CHANNEL_TYPE_LUMA] ? optimize_filter_clip(tmp_cov, tmp_clip) : calculate_error_opt_filt(tmp_cov, tmp_clip);
+            double error_merged = pair_err[i][j];
             double error = error_merged - error1 - error2;
 
             if (error < error_min)
             {
               best_merge_err = error_merged;
-              memcpy(best_merge_clip, tmp_clip, sizeof(best_merge_clip));
+              memcpy(best_merge_clip, pair_clip[i][j], sizeof(best_merge_clip));
               error_min = error;
               best_to_merge_idx1 = i;
               best_to_merge_idx2 = j;
@@ -3604,6 +3592,11 @@ static void alf_merge_classes(alf_aps *alf_aps,
     memcpy(clip_merged[num_remaining - 2][best_to_merge_idx1], best_merge_clip, sizeof(best_merge_clip));
     err[best_to_merge_idx1] = best_merge_err;
     available_class[best_to_merge_idx2] = false;
+    for (int i = 0; i < num_classes; i++)
+    {
+      pair_valid[i][best_to_merge_idx1] = false;
+      pair_valid[best_to_merge_idx1][i] = false;
+    }
 
     for (int i = 0; i < num_classes; i++)
     {
@@ -3681,7 +3674,13 @@ static double alf_derive_coeff_quant(channel_type channel,
 
   int modified = 1;
 
-  double err_ref = calc_error_for_coeffs(cov, filter_clipp, filter_coeff_quant, num_coeff, bit_depth);
+  // The clipping values are fixed from here on.
+  int64_t ee[MAX_NUM_ALF_LUMA_COEFF][MAX_NUM_ALF_LUMA_COEFF];
+  int32_t y[MAX_NUM_ALF_LUMA_COEFF];
+  get_clipped_cov(cov, filter_clipp, num_coeff, ee, y);
+
+  alf_coeff_error_cache err_cache;
+  double err_ref = calc_error_for_clipped_coeffs(&err_cache, ee, y, filter_coeff_quant, num_coeff, bit_depth);
   int sign;
   while (modified)
   {
@@ -3701,7 +3700,7 @@ static double alf_derive_coeff_quant(channel_type channel,
 
         filter_coeff_quant[k] -= sign;
 
-        double error = calc_error_for_coeffs(cov, filter_clipp, filter_coeff_quant, num_coeff, bit_depth);
+        double error = calc_error_for_changed_coeff(&err_cache, ee, y, filter_coeff_quant, k, num_coeff, bit_depth);
         if (error < err_min)
         {
           err_min = error;
@@ -3714,6 +3713,7 @@ static double alf_derive_coeff_quant(channel_type channel,
         filter_coeff_quant[min_ind] -= sign;
         modified++;
         err_ref = err_min;
+        calc_error_for_clipped_coeffs(&err_cache, ee, y, filter_coeff_quant, num_coeff, bit_depth);
       }
     }
   }
@@ -4224,7 +4224,11 @@ static void alf_get_avai_aps_ids_luma(encoder_state_t * const state,
 }
 
 
+/**
+ * \brief Derive the covariances of the CTUs of a CTU row.
+ */
 static void alf_derive_stats_for_filtering(encoder_state_t * const state,
+  const int ctu_row,
   short alf_clipping_values[MAX_NUM_CHANNEL_TYPE][MAX_ALF_NUM_CLIPPING_VALUES])
 {
   alf_info_t *alf_info = state->tile->frame->alf_info;
@@ -4232,33 +4236,74 @@ static void alf_derive_stats_for_filtering(encoder_state_t * const state,
   bool chroma_scale_x = (chroma_fmt == UVG_CSP_444) ? 0 : 1;
   bool chroma_scale_y = (chroma_fmt != UVG_CSP_420) ? 0 : 1;
 
-  const int32_t num_ctus_in_pic = state->tile->frame->width_in_lcu * state->tile->frame->height_in_lcu;
   const int alf_vb_luma_ctu_height = LCU_WIDTH;
   const int alf_vb_chma_ctu_height = (LCU_WIDTH >> ((chroma_fmt == UVG_CSP_420) ? 1 : 0));
   const int alf_vb_luma_pos = LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA;
   const int alf_vb_chma_pos = (LCU_WIDTH >> ((chroma_fmt == UVG_CSP_420) ? 1 : 0)) - ALF_VB_POS_ABOVE_CTUROW_CHMA;
   int32_t pic_width = state->tile->frame->width;
   int32_t pic_height = state->tile->frame->height;
-  int ctu_rs_addr = 0;
+  int ctu_rs_addr = ctu_row * state->tile->frame->width_in_lcu;
 
   const int number_of_components = (chroma_fmt == UVG_CSP_400) ? 1 : MAX_NUM_COMPONENT;
 
-  // init CTU stats buffers
+  alf_covariance* alf_cov;
+  const int y_pos = ctu_row * LCU_WIDTH;
+  for (int x_pos = 0; x_pos < pic_width; x_pos += LCU_WIDTH)
   {
-    for (int ctu_idx = 0; ctu_idx < num_ctus_in_pic; ctu_idx++)
+    const int width = (x_pos + LCU_WIDTH > pic_width) ? (pic_width - x_pos) : LCU_WIDTH;
+    const int height = (y_pos + LCU_WIDTH > pic_height) ? (pic_height - y_pos) : LCU_WIDTH;
+    for (int comp_idx = 0; comp_idx < number_of_components; comp_idx++)
     {
-      for (int class_idx = 0; class_idx < MAX_NUM_ALF_CLASSES; class_idx++)
-      {
-        reset_alf_covariance(&state->tile->frame->alf_info->alf_covariance_y[(ctu_idx * MAX_NUM_ALF_CLASSES) + class_idx], MAX_ALF_NUM_CLIPPING_VALUES);
+      alf_cov = comp_idx == COMPONENT_Y ? alf_info->alf_covariance_y :
+        comp_idx == COMPONENT_Cb ? alf_info->alf_covariance_u :
+        comp_idx == COMPONENT_Cr ? alf_info->alf_covariance_v : NULL;
+
+      if (alf_cov == NULL) {
+        assert(0);
       }
-    }
 
-    for (int ctu_idx = 0; ctu_idx < num_ctus_in_pic; ctu_idx++)
-    {
-      reset_alf_covariance(&state->tile->frame->alf_info->alf_covariance_u[ctu_idx], MAX_ALF_NUM_CLIPPING_VALUES);
-      reset_alf_covariance(&state->tile->frame->alf_info->alf_covariance_v[ctu_idx], MAX_ALF_NUM_CLIPPING_VALUES);
+      const bool is_luma = comp_idx == COMPONENT_Y ? 1 : 0;
+      channel_type ch_type = is_luma ? CHANNEL_TYPE_LUMA : CHANNEL_TYPE_CHROMA;
+
+      int blk_w = is_luma ? width : width >> chroma_scale_x;
+      int blk_h = is_luma ? height : height >> chroma_scale_y;
+      int pos_x = is_luma ? x_pos : x_pos >> chroma_scale_x;
+      int pos_y = is_luma ? y_pos : y_pos >> chroma_scale_y;
+
+      int32_t org_stride = is_luma ? state->tile->frame->source->stride : state->tile->frame->source->stride >> chroma_scale_x;
+      int32_t rec_stride = is_luma ? state->tile->frame->rec->stride : state->tile->frame->rec->stride >> chroma_scale_x;
+
+      uvg_pixel *org = comp_idx ? (comp_idx - 1 ? &state->tile->frame->source->v[pos_x + pos_y * org_stride] : &state->tile->frame->source->u[pos_x + pos_y * org_stride]) : &state->tile->frame->source->y[pos_x + pos_y * org_stride];
+      uvg_pixel *rec = comp_idx ? (comp_idx - 1 ? &state->tile->frame->rec->v[pos_x + pos_y * rec_stride] : &state->tile->frame->rec->u[pos_x + pos_y * rec_stride]) : &state->tile->frame->rec->y[pos_x + pos_y * rec_stride];
+
+      const int num_classes = is_luma ? MAX_NUM_ALF_CLASSES : 1;
+      const int cov_index = ctu_rs_addr * num_classes;
+      for (int class_idx = 0; class_idx < num_classes; class_idx++)
+      {
+        reset_alf_covariance(&alf_cov[cov_index + class_idx], MAX_ALF_NUM_CLIPPING_VALUES);
+      }
+      uvg_alf_get_blk_stats(state, ch_type,
+        &alf_cov[cov_index],
+        comp_idx ? NULL : alf_info->classifier,
+        org, org_stride, rec, rec_stride, pos_x, pos_y, pos_x, pos_y, blk_w, blk_h,
+        (is_luma ? alf_vb_luma_ctu_height : alf_vb_chma_ctu_height),
+        (is_luma) ? alf_vb_luma_pos : alf_vb_chma_pos,
+        alf_clipping_values
+      );
     }
+    ctu_rs_addr++;
   }
+}
+
+/**
+ * \brief Sum the covariances of the CTUs to the covariances of the frame.
+ */
+static void alf_derive_frame_stats(encoder_state_t * const state)
+{
+  alf_info_t *alf_info = state->tile->frame->alf_info;
+  enum uvg_chroma_format chroma_fmt = state->encoder_control->chroma_format;
+  const int32_t num_ctus_in_pic = state->tile->frame->width_in_lcu * state->tile->frame->height_in_lcu;
+  const int number_of_components = (chroma_fmt == UVG_CSP_400) ? 1 : MAX_NUM_COMPONENT;
 
   // init Frame stats buffers
   const int number_of_channels = (chroma_fmt == UVG_CSP_400) ? 1 : MAX_NUM_CHANNEL_TYPE;
@@ -4273,58 +4318,23 @@ static void alf_derive_stats_for_filtering(encoder_state_t * const state,
     reset_alf_covariance(&alf_info->alf_covariance_frame_chroma[0], MAX_ALF_NUM_CLIPPING_VALUES);
   }
 
-  alf_covariance* alf_cov;
-  alf_covariance* alf_cov_frame;
-  for (int y_pos = 0; y_pos < pic_height; y_pos += LCU_WIDTH)
+  for (int ctu_rs_addr = 0; ctu_rs_addr < num_ctus_in_pic; ctu_rs_addr++)
   {
-    for (int x_pos = 0; x_pos < pic_width; x_pos += LCU_WIDTH)
+    for (int comp_idx = 0; comp_idx < number_of_components; comp_idx++)
     {
-      const int width = (x_pos + LCU_WIDTH > pic_width) ? (pic_width - x_pos) : LCU_WIDTH;
-      const int height = (y_pos + LCU_WIDTH > pic_height) ? (pic_height - y_pos) : LCU_WIDTH;
-      for (int comp_idx = 0; comp_idx < number_of_components; comp_idx++)
-      {
-        alf_cov = comp_idx == COMPONENT_Y ? state->tile->frame->alf_info->alf_covariance_y :
-          comp_idx == COMPONENT_Cb ? state->tile->frame->alf_info->alf_covariance_u :
-          comp_idx == COMPONENT_Cr ? state->tile->frame->alf_info->alf_covariance_v : NULL;
-
-        if (alf_cov == NULL) {
-          assert(0);
-        }
+      alf_covariance *alf_cov = comp_idx == COMPONENT_Y ? alf_info->alf_covariance_y :
+        comp_idx == COMPONENT_Cb ? alf_info->alf_covariance_u : alf_info->alf_covariance_v;
+      const bool is_luma = comp_idx == COMPONENT_Y ? 1 : 0;
+      alf_covariance *alf_cov_frame = is_luma ? alf_info->alf_covariance_frame_luma : alf_info->alf_covariance_frame_chroma;
 
-        const bool is_luma = comp_idx == COMPONENT_Y ? 1 : 0;
-        channel_type ch_type = is_luma ? CHANNEL_TYPE_LUMA : CHANNEL_TYPE_CHROMA;
-        alf_cov_frame = is_luma ? alf_info->alf_covariance_frame_luma : alf_info->alf_covariance_frame_chroma;
-
-        int blk_w = is_luma ? width : width >> chroma_scale_x;
-        int blk_h = is_luma ? height : height >> chroma_scale_y;
-        int pos_x = is_luma ? x_pos : x_pos >> chroma_scale_x;
-        int pos_y = is_luma ? y_pos : y_pos >> chroma_scale_y;
-
-        int32_t org_stride = is_luma ? state->tile->frame->source->stride : state->tile->frame->source->stride >> chroma_scale_x;
-        int32_t rec_stride = is_luma ? state->tile->frame->rec->stride : state->tile->frame->rec->stride >> chroma_scale_x;
-
-        uvg_pixel *org = comp_idx ? (comp_idx - 1 ? &state->tile->frame->source->v[pos_x + pos_y * org_stride] : &state->tile->frame->source->u[pos_x + pos_y * org_stride]) : &state->tile->frame->source->y[pos_x + pos_y * org_stride];
-        uvg_pixel *rec = comp_idx ? (comp_idx - 1 ? &state->tile->frame->rec->v[pos_x + pos_y * rec_stride] : &state->tile->frame->rec->u[pos_x + pos_y * rec_stride]) : &state->tile->frame->rec->y[pos_x + pos_y * rec_stride];
-
-        const int num_classes = is_luma ? MAX_NUM_ALF_CLASSES : 1;
-        const int cov_index = ctu_rs_addr * num_classes;
-        uvg_alf_get_blk_stats(state, ch_type,
-          &alf_cov[cov_index],
-          comp_idx ? NULL : alf_info->classifier,
-          org, org_stride, rec, rec_stride, pos_x, pos_y, pos_x, pos_y, blk_w, blk_h,
-          (is_luma ? alf_vb_luma_ctu_height : alf_vb_chma_ctu_height),
-          (is_luma) ? alf_vb_luma_pos : alf_vb_chma_pos,
-          alf_clipping_values
+      const int num_classes = is_luma ? MAX_NUM_ALF_CLASSES : 1;
+      const int cov_index = ctu_rs_addr * num_classes;
+      for (int class_idx = 0; class_idx < num_classes; class_idx++)
+      {
+        add_alf_cov(&alf_cov_frame[is_luma ? class_idx : 0],
+          &alf_cov[cov_index + class_idx]
         );
-
-        for (int class_idx = 0; class_idx < num_classes; class_idx++)
-        {
-          add_alf_cov(&alf_cov_frame[is_luma ? class_idx : 0],
-            &alf_cov[cov_index + class_idx]
-          );
-        }
       }
-      ctu_rs_addr++;
     }
   }
 }
@@ -5029,7 +5039,13 @@ static void alf_encoder_ctb(encoder_state_t * const state,
 }
 
 
-static void alf_reconstruct(encoder_state_t * const state,
+/**
+ * \brief Prepare the reconstruction of the frame with the derived filters.
+ *
+ * The reconstructed samples are copied to a buffer that is used as the
+ * input of the filters.
+ */
+static void alf_reconstruct_init(encoder_state_t * const state,
   array_variables *arr_vars)
 {
   if (!state->slice->alf->tile_group_alf_enabled_flag[COMPONENT_Y])
@@ -5040,22 +5056,11 @@ static void alf_reconstruct(encoder_state_t * const state,
   alf_reconstruct_coeff_aps(state, true, state->slice->alf->tile_group_alf_enabled_flag[COMPONENT_Cb] || state->slice->alf->tile_group_alf_enabled_flag[COMPONENT_Cr], false, arr_vars);
 
   alf_info_t *alf_info = state->tile->frame->alf_info;
-  bool **ctu_enable_flags = alf_info->ctu_enable_flag;
   enum uvg_chroma_format chroma_fmt = state->encoder_control->chroma_format;
   bool chroma_scale_x = (chroma_fmt == UVG_CSP_444) ? 0 : 1;
   bool chroma_scale_y = (chroma_fmt != UVG_CSP_420) ? 0 : 1;
 
-  const int alf_vb_luma_ctu_height = LCU_WIDTH;
-  const int alf_vb_chma_ctu_height = (LCU_WIDTH >> ((chroma_fmt == UVG_CSP_420) ? 1 : 0));
-  const int alf_vb_luma_pos = LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA;
-  const int alf_vb_chma_pos = (LCU_WIDTH >> ((chroma_fmt == UVG_CSP_420) ? 1 : 0)) - ALF_VB_POS_ABOVE_CTUROW_CHMA;
   const int luma_height = state->tile->frame->height;
-  const int luma_width = state->tile->frame->width;
-  const int max_cu_width = LCU_WIDTH;
-  const int max_cu_height = LCU_WIDTH;
-
-  int ctu_idx = 0;
-
   const int luma_stride = state->tile->frame->rec->stride;
   const int chroma_stride = luma_stride >> chroma_scale_x;
   const int chroma_height = luma_height >> chroma_scale_y;
@@ -5071,108 +5076,151 @@ static void alf_reconstruct(encoder_state_t * const state,
     sizeof(uvg_pixel) * chroma_stride * (chroma_height + chroma_padding * 2));
   memcpy(&alf_info->alf_tmp_v[index_chroma], &state->tile->frame->rec->v[index_chroma],
     sizeof(uvg_pixel) * chroma_stride * (chroma_height + chroma_padding * 2));
+}
 
-  for (int y_pos = 0; y_pos < luma_height; y_pos += max_cu_height)
+/**
+ * \brief Filter the CTUs of a CTU row.
+ *
+ * Reads the copy made by alf_reconstruct_init and writes only the samples
+ * of the row, so the rows can be filtered in parallel.
+ */
+static void alf_reconstruct_ctu_row(encoder_state_t * const state,
+  array_variables *arr_vars,
+  const int ctu_row)
+{
+  if (!state->slice->alf->tile_group_alf_enabled_flag[COMPONENT_Y])
   {
-    for (int x_pos = 0; x_pos < luma_width; x_pos += max_cu_width)
-    {
-
-      const int width = (x_pos + max_cu_width > luma_width) ? (luma_width - x_pos) : max_cu_width;
-      const int height = (y_pos + max_cu_height > luma_height) ? (luma_height - y_pos) : max_cu_height;
+    return;
+  }
 
-      bool ctu_enable_flag = ctu_enable_flags[COMPONENT_Y][ctu_idx];
-      for (int comp_idx = 1; comp_idx < MAX_NUM_COMPONENT; comp_idx++)
-      {
-        ctu_enable_flag |= ctu_enable_flags[comp_idx][ctu_idx] > 0;
-      }
+  alf_info_t *alf_info = state->tile->frame->alf_info;
+  bool **ctu_enable_flags = alf_info->ctu_enable_flag;
+  enum uvg_chroma_format chroma_fmt = state->encoder_control->chroma_format;
+  bool chroma_scale_x = (chroma_fmt == UVG_CSP_444) ? 0 : 1;
+  bool chroma_scale_y = (chroma_fmt != UVG_CSP_420) ? 0 : 1;
 
-      {
-        if (ctu_enable_flags[COMPONENT_Y][ctu_idx])
-        {
-          short filter_set_index = alf_info->alf_ctb_filter_index[ctu_idx];
-          short *coeff;
-          int16_t *clip;
-          if (filter_set_index >= ALF_NUM_FIXED_FILTER_SETS)
-          {
-            coeff = arr_vars->coeff_aps_luma[filter_set_index - ALF_NUM_FIXED_FILTER_SETS];
-            clip = arr_vars->clipp_aps_luma[filter_set_index - ALF_NUM_FIXED_FILTER_SETS];
-          }
-          else
-          {
-            coeff = arr_vars->fixed_filter_set_coeff_dec[filter_set_index];
-            clip = arr_vars->clip_default;
-          }
-          uvg_alf_filter_7x7_blk(state,
-            alf_info->alf_tmp_y, state->tile->frame->rec->y,
-            luma_stride, luma_stride,
-            coeff, clip, arr_vars->clp_rngs.comp[COMPONENT_Y],
-            width, height, x_pos, y_pos, x_pos, y_pos,
-            alf_vb_luma_pos, alf_vb_luma_ctu_height);
-        }
-        for (int comp_idx = 1; comp_idx < MAX_NUM_COMPONENT; comp_idx++)
-        {
-          alf_component_id comp_id = comp_idx;
+  const int alf_vb_luma_ctu_height = LCU_WIDTH;
+  const int alf_vb_chma_ctu_height = (LCU_WIDTH >> ((chroma_fmt == UVG_CSP_420) ? 1 : 0));
+  const int alf_vb_luma_pos = LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA;
+  const int alf_vb_chma_pos = (LCU_WIDTH >> ((chroma_fmt == UVG_CSP_420) ? 1 : 0)) - ALF_VB_POS_ABOVE_CTUROW_CHMA;
+  const int luma_height = state->tile->frame->height;
+  const int luma_width = state->tile->frame->width;
+  const int max_cu_width = LCU_WIDTH;
+  const int max_cu_height = LCU_WIDTH;
 
-          if (ctu_enable_flags[comp_idx][ctu_idx])
-          {
-            uvg_pixel *dst_pixels = comp_id - 1 ? state->tile->frame->rec->v : state->tile->frame->rec->u;
-            const uvg_pixel *src_pixels = comp_id - 1 ? alf_info->alf_tmp_v : alf_info->alf_tmp_u;
-
-            const int alt_num = alf_info->ctu_alternative[comp_id][ctu_idx];
-            uvg_alf_filter_5x5_blk(state,
-              src_pixels, dst_pixels,
-              chroma_stride, chroma_stride,
-              arr_vars->chroma_coeff_final[alt_num], arr_vars->chroma_clipp_final[alt_num], arr_vars->clp_rngs.comp[comp_idx],
-              width >> chroma_scale_x, height >> chroma_scale_y,
-              x_pos >> chroma_scale_x, y_pos >> chroma_scale_y,
-              x_pos >> chroma_scale_x, y_pos >> chroma_scale_y,
-              alf_vb_chma_pos, alf_vb_chma_ctu_height);
-          }
-        }
+  int ctu_idx = ctu_row * state->tile->frame->width_in_lcu;
+
+  const int luma_stride = state->tile->frame->rec->stride;
+  const int chroma_stride = luma_stride >> chroma_scale_x;
+
+  const int y_pos = ctu_row * max_cu_height;
+  for (int x_pos = 0; x_pos < luma_width; x_pos += max_cu_width)
+  {
+    const int width = (x_pos + max_cu_width > luma_width) ? (luma_width - x_pos) : max_cu_width;
+    const int height = (y_pos + max_cu_height > luma_height) ? (luma_height - y_pos) : max_cu_height;
+
+    if (ctu_enable_flags[COMPONENT_Y][ctu_idx])
+    {
+      short filter_set_index = alf_info->alf_ctb_filter_index[ctu_idx];
+      short *coeff;
+      int16_t *clip;
+      if (filter_set_index >= ALF_NUM_FIXED_FILTER_SETS)
+      {
+        coeff = arr_vars->coeff_aps_luma[filter_set_index - ALF_NUM_FIXED_FILTER_SETS];
+        clip = arr_vars->clipp_aps_luma[filter_set_index - ALF_NUM_FIXED_FILTER_SETS];
       }
-      ctu_idx++;
+      else
+      {
+        coeff = arr_vars->fixed_filter_set_coeff_dec[filter_set_index];
+        clip = arr_vars->clip_default;
+      }
+      uvg_alf_filter_7x7_blk(state,
+        alf_info->alf_tmp_y, state->tile->frame->rec->y,
+        luma_stride, luma_stride,
+        coeff, clip, arr_vars->clp_rngs.comp[COMPONENT_Y],
+        width, height, x_pos, y_pos, x_pos, y_pos,
+        alf_vb_luma_pos, alf_vb_luma_ctu_height);
     }
+    for (int comp_idx = 1; comp_idx < MAX_NUM_COMPONENT; comp_idx++)
+    {
+      alf_component_id comp_id = comp_idx;
+
+      if (ctu_enable_flags[comp_idx][ctu_idx])
+      {
+        uvg_pixel *dst_pixels = comp_id - 1 ? state->tile->frame->rec->v : state->tile->frame->rec->u;
+        const uvg_pixel *src_pixels = comp_id - 1 ? alf_info->alf_tmp_v : alf_info->alf_tmp_u;
+
+        const int alt_num = alf_info->ctu_alternative[comp_id][ctu_idx];
+        uvg_alf_filter_5x5_blk(state,
+          src_pixels, dst_pixels,
+          chroma_stride, chroma_stride,
+          arr_vars->chroma_coeff_final[alt_num], arr_vars->chroma_clipp_final[alt_num], arr_vars->clp_rngs.comp[comp_idx],
+          width >> chroma_scale_x, height >> chroma_scale_y,
+          x_pos >> chroma_scale_x, y_pos >> chroma_scale_y,
+          x_pos >> chroma_scale_x, y_pos >> chroma_scale_y,
+          alf_vb_chma_pos, alf_vb_chma_ctu_height);
+      }
+    }
+    ctu_idx++;
   }
 }
 
-static void alf_derive_classification(encoder_state_t * const state,
-  const int width,
-  const int height,
-  int x_pos,
-  int y_pos,
-  const int blk_dst_x,
-  const int blk_dst_y)
+/**
+ * \brief Pad the picture borders of the reconstruction of a CTU row.
+ *
+ * The first rows of the next CTU row are padded too, because they are read
+ * by the classification and the statistics of this row. The rows must be
+ * padded in order.
+ */
+static void alf_pad_ctu_row(encoder_state_t * const state,
+  const int ctu_row)
 {
   enum uvg_chroma_format chroma_fmt = state->encoder_control->chroma_format;
   bool chroma_scale_x = (chroma_fmt == UVG_CSP_444) ? 0 : 1;
   bool chroma_scale_y = (chroma_fmt != UVG_CSP_420) ? 0 : 1;
 
-  const int alf_vb_luma_ctu_height = LCU_WIDTH;
-  const int alf_vb_luma_pos = LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA;
   int32_t pic_height = state->tile->frame->rec->height;
   int32_t pic_width = state->tile->frame->rec->width;
+  const int y_start = ctu_row * LCU_WIDTH;
+  const int y_end = MIN(y_start + LCU_WIDTH + MAX_ALF_PADDING_SIZE, pic_height);
+  const int y_end_chroma = MIN(((y_start + LCU_WIDTH) >> chroma_scale_y) + MAX_ALF_PADDING_SIZE, pic_height >> chroma_scale_y);
 
-  int max_height = y_pos + height;
-  int max_width = x_pos + width;
-
-  adjust_pixels(state->tile->frame->rec->y, x_pos, pic_width, y_pos, pic_height, state->tile->frame->rec->stride,
+  adjust_pixels(state->tile->frame->rec->y, 0, pic_width, y_start, y_end, state->tile->frame->rec->stride,
     pic_width, pic_height);
   adjust_pixels_chroma(state->tile->frame->rec->u,
-    x_pos >> chroma_scale_x,
+    0,
     pic_width >> chroma_scale_x,
-    y_pos >> chroma_scale_y,
-    pic_height >> chroma_scale_y,
+    y_start >> chroma_scale_y,
+    y_end_chroma,
     state->tile->frame->rec->stride >> chroma_scale_x,
     pic_width >> chroma_scale_x,
     pic_height >> chroma_scale_y);
   adjust_pixels_chroma(state->tile->frame->rec->v,
-    x_pos >> chroma_scale_x,
+    0,
     pic_width >> chroma_scale_x,
-    y_pos >> chroma_scale_y,
-    pic_height >> chroma_scale_y,
+    y_start >> chroma_scale_y,
+    y_end_chroma,
     state->tile->frame->rec->stride >> chroma_scale_x,
     pic_width >> chroma_scale_x,
     pic_height >> chroma_scale_y);
+}
+
+static void alf_derive_classification(encoder_state_t * const state,
+  const uvg_pixel *src,
+  const int src_stride,
+  alf_classifier **classifier,
+  const int width,
+  const int height,
+  int x_pos,
+  int y_pos,
+  const int blk_dst_x,
+  const int blk_dst_y)
+{
+  const int alf_vb_luma_ctu_height = LCU_WIDTH;
+  const int alf_vb_luma_pos = LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA;
+
+  int max_height = y_pos + height;
+  int max_width = x_pos + width;
 
   for (int i = y_pos; i < max_height; i += CLASSIFICATION_BLK_SIZE)
   {
@@ -5182,7 +5230,8 @@ static void alf_derive_classification(encoder_state_t * const state,
     {
       int n_width = MIN(j + CLASSIFICATION_BLK_SIZE, max_width) - j;
 
-      uvg_alf_derive_classification_blk(state, state->encoder_control->cfg.input_bitdepth + 4, n_height, n_width, j, i,
+      uvg_alf_derive_classification_blk(state, src, src_stride, classifier,
+        state->encoder_control->cfg.input_bitdepth + 4, n_height, n_width, j, i,
         j - x_pos + blk_dst_x, i - y_pos + blk_dst_y,
         alf_vb_luma_ctu_height,
         alf_vb_luma_pos);
@@ -5190,122 +5239,106 @@ static void alf_derive_classification(encoder_state_t * const state,
   }
 }
 
-void uvg_alf_enc_process(encoder_state_t *const state)
+static void alf_init_array_variables(encoder_state_t * const state,
+  array_variables *arr_vars)
 {
-  alf_init_covariance(state->tile->frame, state->encoder_control->chroma_format);
-  alf_info_t *alf_info = state->tile->frame->alf_info;
-  alf_create_frame_buffer(state, alf_info);
-  /*
-  //if (!layerIdx && cs.slice->getPendingRasInit()
-  if (1 && (false
-  || (state->frame->pictype == UVG_NAL_IDR_W_RADL || state->frame->pictype == UVG_NAL_IDR_N_LP)))
-  {
-    for (int i = 0; i < ALF_CTB_MAX_NUM_APS; i++) {
-      reset_aps(&state->slice->alf->apss[i], state->encoder_control->cfg.alf_type == UVG_ALF_FULL);
-      if (state->tile->frame->alf_param_set_map[i + T_ALF_APS].b_changed)
-      {
-        alf_aps* alf_aps = &state->tile->frame->alf_param_set_map[i + T_ALF_APS].parameter_set;
-        state->tile->frame->alf_param_set_map[i + T_ALF_APS].b_changed = false;
-        reset_aps(alf_aps, state->encoder_control->cfg.alf_type == UVG_ALF_FULL);
-      }
-    }
-    alf_info->aps_id_start = ALF_CTB_MAX_NUM_APS;
-  }*/
-
-  alf_aps alf_param;
-  reset_alf_param(&alf_param);
-  cc_alf_filter_param *cc_filter_param = state->slice->alf->cc_filter_param;
-
-
-  enum uvg_chroma_format chroma_fmt = state->encoder_control->chroma_format;
-  bool chroma_scale_x = (chroma_fmt == UVG_CSP_444) ? 0 : 1;
-  bool chroma_scale_y = (chroma_fmt != UVG_CSP_420) ? 0 : 1;
   int8_t uvg_bit_depth = state->encoder_control->bitdepth;
-  const uint32_t num_ctus_in_pic = state->tile->frame->width_in_lcu * state->tile->frame->height_in_lcu;
   const int8_t input_bitdepth = state->encoder_control->bitdepth;
-  double lambda_chroma_weight = 0.0;
-
-  cabac_data_t ctx_start;
-  cabac_data_t ctx_start_cc_alf;
-  cabac_data_t *cabac_estimator = &alf_info->cabac_estimator;
-  memcpy(cabac_estimator, &state->cabac, sizeof(*cabac_estimator));
-  memcpy(&ctx_start, &state->cabac, sizeof(ctx_start));
-  memcpy(&ctx_start_cc_alf, cabac_estimator, sizeof(ctx_start_cc_alf));
-  cabac_estimator->only_count = 1;
-  ctx_start.only_count = 1;
-  ctx_start_cc_alf.only_count = 1;
 
-  // derive classification
-  const int luma_height = state->tile->frame->height;
-  const int luma_width = state->tile->frame->width;
-
-  array_variables arr_vars;
-  bool init_values = false;
-
-  if (!init_values)
+  assert(MAX_ALF_NUM_CLIPPING_VALUES > 0); //"g_alf_num_clipping_values[CHANNEL_TYPE_LUMA] must be at least one"
+  arr_vars->alf_clipping_values[CHANNEL_TYPE_LUMA][0] = 1 << input_bitdepth;
+  int shift_luma = input_bitdepth - 8;
+  for (int i = 1; i < MAX_ALF_NUM_CLIPPING_VALUES; ++i)
   {
-    assert(MAX_ALF_NUM_CLIPPING_VALUES > 0); //"g_alf_num_clipping_values[CHANNEL_TYPE_LUMA] must be at least one"
-    arr_vars.alf_clipping_values[CHANNEL_TYPE_LUMA][0] = 1 << input_bitdepth;
-    int shift_luma = input_bitdepth - 8;
-    for (int i = 1; i < MAX_ALF_NUM_CLIPPING_VALUES; ++i)
-    {
-      arr_vars.alf_clipping_values[CHANNEL_TYPE_LUMA][i] = 1 << (7 - 2 * i + shift_luma);
-    }
+    arr_vars->alf_clipping_values[CHANNEL_TYPE_LUMA][i] = 1 << (7 - 2 * i + shift_luma);
+  }
 
-    assert(MAX_ALF_NUM_CLIPPING_VALUES > 0); //"g_alf_num_clipping_values[CHANNEL_TYPE_CHROMA] must be at least one"
-    arr_vars.alf_clipping_values[CHANNEL_TYPE_CHROMA][0] = 1 << input_bitdepth;
-    int shift_chroma = input_bitdepth - 8;
-    for (int i = 1; i < MAX_ALF_NUM_CLIPPING_VALUES; ++i)
-    {
-      arr_vars.alf_clipping_values[CHANNEL_TYPE_CHROMA][i] = 1 << (7 - 2 * i + shift_chroma);
-    }
+  assert(MAX_ALF_NUM_CLIPPING_VALUES > 0); //"g_alf_num_clipping_values[CHANNEL_TYPE_CHROMA] must be at least one"
+  arr_vars->alf_clipping_values[CHANNEL_TYPE_CHROMA][0] = 1 << input_bitdepth;
+  int shift_chroma = input_bitdepth - 8;
+  for (int i = 1; i < MAX_ALF_NUM_CLIPPING_VALUES; ++i)
+  {
+    arr_vars->alf_clipping_values[CHANNEL_TYPE_CHROMA][i] = 1 << (7 - 2 * i + shift_chroma);
+  }
 
-    for (int i = 0; i < MAX_NUM_ALF_LUMA_COEFF * MAX_NUM_ALF_CLASSES; i++)
-    {
-      arr_vars.clip_default[i] = arr_vars.alf_clipping_values[CHANNEL_TYPE_LUMA][0];
-    }
+  for (int i = 0; i < MAX_NUM_ALF_LUMA_COEFF * MAX_NUM_ALF_CLASSES; i++)
+  {
+    arr_vars->clip_default[i] = arr_vars->alf_clipping_values[CHANNEL_TYPE_LUMA][0];
+  }
 
-    for (int filter_set_index = 0; filter_set_index < ALF_NUM_FIXED_FILTER_SETS; filter_set_index++)
+  for (int filter_set_index = 0; filter_set_index < ALF_NUM_FIXED_FILTER_SETS; filter_set_index++)
+  {
+    for (int class_idx = 0; class_idx < MAX_NUM_ALF_CLASSES; class_idx++)
     {
-      for (int class_idx = 0; class_idx < MAX_NUM_ALF_CLASSES; class_idx++)
+      int fixed_filter_idx = g_class_to_filter_mapping[filter_set_index][class_idx];
+      for (int i = 0; i < MAX_NUM_ALF_LUMA_COEFF - 1; i++)
       {
-        int fixed_filter_idx = g_class_to_filter_mapping[filter_set_index][class_idx];
-        for (int i = 0; i < MAX_NUM_ALF_LUMA_COEFF - 1; i++)
-        {
-          arr_vars.fixed_filter_set_coeff_dec[filter_set_index][class_idx * MAX_NUM_ALF_LUMA_COEFF + i] = g_fixed_filter_set_coeff[fixed_filter_idx][i];
-        }
-        arr_vars.fixed_filter_set_coeff_dec[filter_set_index][class_idx * MAX_NUM_ALF_LUMA_COEFF + MAX_NUM_ALF_LUMA_COEFF - 1] = (1 << (input_bitdepth - 1));
+        arr_vars->fixed_filter_set_coeff_dec[filter_set_index][class_idx * MAX_NUM_ALF_LUMA_COEFF + i] = g_fixed_filter_set_coeff[fixed_filter_idx][i];
       }
+      arr_vars->fixed_filter_set_coeff_dec[filter_set_index][class_idx * MAX_NUM_ALF_LUMA_COEFF + MAX_NUM_ALF_LUMA_COEFF - 1] = (1 << (input_bitdepth - 1));
     }
+  }
 
-    //Default clp_rng
-    arr_vars.clp_rngs.comp[COMPONENT_Y].min = arr_vars.clp_rngs.comp[COMPONENT_Cb].min = arr_vars.clp_rngs.comp[COMPONENT_Cr].min = 0;
-    arr_vars.clp_rngs.comp[COMPONENT_Y].max = (1 << uvg_bit_depth) - 1;
-    arr_vars.clp_rngs.comp[COMPONENT_Y].bd = uvg_bit_depth;
-    arr_vars.clp_rngs.comp[COMPONENT_Y].n = 0;
-    arr_vars.clp_rngs.comp[COMPONENT_Cb].max = arr_vars.clp_rngs.comp[COMPONENT_Cr].max = (1 << uvg_bit_depth) - 1;
-    arr_vars.clp_rngs.comp[COMPONENT_Cb].bd = arr_vars.clp_rngs.comp[COMPONENT_Cr].bd = uvg_bit_depth;
-    arr_vars.clp_rngs.comp[COMPONENT_Cb].n = arr_vars.clp_rngs.comp[COMPONENT_Cr].n = 0;
-    arr_vars.clp_rngs.used = arr_vars.clp_rngs.chroma = false;
+  //Default clp_rng
+  arr_vars->clp_rngs.comp[COMPONENT_Y].min = arr_vars->clp_rngs.comp[COMPONENT_Cb].min = arr_vars->clp_rngs.comp[COMPONENT_Cr].min = 0;
+  arr_vars->clp_rngs.comp[COMPONENT_Y].max = (1 << uvg_bit_depth) - 1;
+  arr_vars->clp_rngs.comp[COMPONENT_Y].bd = uvg_bit_depth;
+  arr_vars->clp_rngs.comp[COMPONENT_Y].n = 0;
+  arr_vars->clp_rngs.comp[COMPONENT_Cb].max = arr_vars->clp_rngs.comp[COMPONENT_Cr].max = (1 << uvg_bit_depth) - 1;
+  arr_vars->clp_rngs.comp[COMPONENT_Cb].bd = arr_vars->clp_rngs.comp[COMPONENT_Cr].bd = uvg_bit_depth;
+  arr_vars->clp_rngs.comp[COMPONENT_Cb].n = arr_vars->clp_rngs.comp[COMPONENT_Cr].n = 0;
+  arr_vars->clp_rngs.used = arr_vars->clp_rngs.chroma = false;
+}
 
-    init_values = true;
-  }
+void uvg_alf_enc_init(encoder_state_t *const state)
+{
+  alf_init_covariance(state->tile->frame, state->encoder_control->chroma_format);
+  alf_info_t *alf_info = state->tile->frame->alf_info;
+  alf_create_frame_buffer(state, alf_info);
+  alf_init_array_variables(state, &alf_info->arr_vars);
+}
 
-  for (int y_pos = 0; y_pos < luma_height; y_pos += LCU_WIDTH)
+void uvg_alf_enc_ctu_row_stats(encoder_state_t *const state, const int ctu_row)
+{
+  alf_pad_ctu_row(state, ctu_row);
+
+  // derive classification
+  const int luma_height = state->tile->frame->height;
+  const int luma_width = state->tile->frame->width;
+  const int y_pos = ctu_row * LCU_WIDTH;
+  const int height = (y_pos + LCU_WIDTH > luma_height) ? (luma_height - y_pos) : LCU_WIDTH;
+  for (int x_pos = 0; x_pos < luma_width; x_pos += LCU_WIDTH)
   {
-    for (int x_pos = 0; x_pos < luma_width; x_pos += LCU_WIDTH)
-    {
-      const int width = (x_pos + LCU_WIDTH > luma_width) ? (luma_width - x_pos) : LCU_WIDTH;
-      const int height = (y_pos + LCU_WIDTH > luma_height) ? (luma_height - y_pos) : LCU_WIDTH;
-      {
-        alf_derive_classification(state, width, height, x_pos, y_pos, x_pos, y_pos);
-      }
-    }
+    const int width = (x_pos + LCU_WIDTH > luma_width) ? (luma_width - x_pos) : LCU_WIDTH;
+    alf_derive_classification(state, state->tile->frame->rec->y, state->tile->frame->rec->stride,
+      state->tile->frame->alf_info->classifier, width, height, x_pos, y_pos, x_pos, y_pos);
   }
 
+  // get CTB stats for filtering
+  alf_derive_stats_for_filtering(state, ctu_row, state->tile->frame->alf_info->arr_vars.alf_clipping_values);
+}
 
-  // get CTB stats for filtering 
-  alf_derive_stats_for_filtering(state, arr_vars.alf_clipping_values);
+void uvg_alf_enc_derive(encoder_state_t *const state)
+{
+  alf_info_t *alf_info = state->tile->frame->alf_info;
+  array_variables *arr_vars = &alf_info->arr_vars;
+
+  alf_aps alf_param;
+  reset_alf_param(&alf_param);
+
+  const uint32_t num_ctus_in_pic = state->tile->frame->width_in_lcu * state->tile->frame->height_in_lcu;
+  double lambda_chroma_weight = 0.0;
+
+  cabac_data_t ctx_start;
+  cabac_data_t *cabac_estimator = &alf_info->cabac_estimator;
+  memcpy(cabac_estimator, &state->cabac, sizeof(*cabac_estimator));
+  memcpy(&ctx_start, &state->cabac, sizeof(ctx_start));
+  memcpy(&alf_info->ctx_start_cc_alf, cabac_estimator, sizeof(alf_info->ctx_start_cc_alf));
+  cabac_estimator->only_count = 1;
+  ctx_start.only_count = 1;
+  alf_info->ctx_start_cc_alf.only_count = 1;
+
+  alf_derive_frame_stats(state);
 
   for (uint32_t ctb_iIdx = 0; ctb_iIdx < num_ctus_in_pic; ctb_iIdx++)
   {
@@ -5321,7 +5354,7 @@ void uvg_alf_enc_process(encoder_state_t *const state)
   alf_encoder(state,
     &alf_param, CHANNEL_TYPE_LUMA,
     lambda_chroma_weight,
-    &arr_vars
+    arr_vars
   );
 
   // derive filter (chroma)
@@ -5329,7 +5362,7 @@ void uvg_alf_enc_process(encoder_state_t *const state)
     alf_encoder(state,
       &alf_param, CHANNEL_TYPE_CHROMA,
       lambda_chroma_weight,
-      &arr_vars
+      arr_vars
     );
   }
   // let alfEncoderCtb decide now
@@ -5339,7 +5372,7 @@ void uvg_alf_enc_process(encoder_state_t *const state)
 
   //m_CABACEstimator->getCtx() = AlfCtx(ctxStart);
   memcpy(cabac_estimator, &ctx_start, sizeof(*cabac_estimator));
-  alf_encoder_ctb(state, &alf_param, lambda_chroma_weight, &arr_vars);
+  alf_encoder_ctb(state, &alf_param, lambda_chroma_weight, arr_vars);
 
   //for (int s = 0; s < state.; s++) //numSliceSegments
   {
@@ -5355,13 +5388,33 @@ void uvg_alf_enc_process(encoder_state_t *const state)
     }
   }
 
-  alf_reconstruct(state, &arr_vars);
+  alf_reconstruct_init(state, arr_vars);
+}
+
+void uvg_alf_enc_filter_ctu_row(encoder_state_t *const state, const int ctu_row)
+{
+  alf_reconstruct_ctu_row(state, &state->tile->frame->alf_info->arr_vars, ctu_row);
+}
+
+void uvg_alf_enc_finish(encoder_state_t *const state)
+{
+  alf_info_t *alf_info = state->tile->frame->alf_info;
+  array_variables *arr_vars = &alf_info->arr_vars;
 
   if (state->encoder_control->cfg.alf_type != UVG_ALF_FULL)
   {
+    alf_covariance_destroy(state->tile->frame);
     return;
   }
 
+  cc_alf_filter_param *cc_filter_param = state->slice->alf->cc_filter_param;
+  enum uvg_chroma_format chroma_fmt = state->encoder_control->chroma_format;
+  bool chroma_scale_x = (chroma_fmt == UVG_CSP_444) ? 0 : 1;
+  bool chroma_scale_y = (chroma_fmt != UVG_CSP_420) ? 0 : 1;
+  const uint32_t num_ctus_in_pic = state->tile->frame->width_in_lcu * state->tile->frame->height_in_lcu;
+  const int luma_height = state->tile->frame->height;
+  cabac_data_t *cabac_estimator = &alf_info->cabac_estimator;
+
   // Do not transmit CC ALF if it is unchanged
   if (state->slice->alf->tile_group_alf_enabled_flag[COMPONENT_Y])
   {
@@ -5425,23 +5478,458 @@ void uvg_alf_enc_process(encoder_state_t *const state)
   derive_stats_for_cc_alf_filtering(state, org_yuv, COMPONENT_Cr, num_ctus_in_width, (0 + 1));
   init_distortion_cc_alf(alf_info->alf_covariance_cc_alf, alf_info->ctb_distortion_unfilter, num_ctus_in_pic);
 
-  memcpy(cabac_estimator, &ctx_start_cc_alf, sizeof(*cabac_estimator));
-  derive_cc_alf_filter(state, COMPONENT_Cb, org_yuv, rec_yuv, arr_vars.cc_reuse_aps_id);
-  memcpy(cabac_estimator, &ctx_start_cc_alf, sizeof(*cabac_estimator));
-  derive_cc_alf_filter(state, COMPONENT_Cr, org_yuv, rec_yuv, arr_vars.cc_reuse_aps_id);
+  memcpy(cabac_estimator, &alf_info->ctx_start_cc_alf, sizeof(*cabac_estimator));
+  derive_cc_alf_filter(state, COMPONENT_Cb, org_yuv, rec_yuv, arr_vars->cc_reuse_aps_id);
+  memcpy(cabac_estimator, &alf_info->ctx_start_cc_alf, sizeof(*cabac_estimator));
+  derive_cc_alf_filter(state, COMPONENT_Cr, org_yuv, rec_yuv, arr_vars->cc_reuse_aps_id);
+
+  setup_cc_alf_aps(state, arr_vars->cc_reuse_aps_id);
+
+  alf_covariance_destroy(state->tile->frame);
+}
+
+void uvg_alf_enc_cc_filter_ctu_row(encoder_state_t *const state, const int ctu_row)
+{
+  if (state->encoder_control->cfg.alf_type != UVG_ALF_FULL)
+  {
+    return;
+  }
 
-  setup_cc_alf_aps(state, arr_vars.cc_reuse_aps_id);
+  alf_info_t *alf_info = state->tile->frame->alf_info;
+  cc_alf_filter_param *cc_filter_param = state->slice->alf->cc_filter_param;
+  const uvg_picture *rec_yuv = state->tile->frame->rec;
 
   for (alf_component_id comp_idx = 1; comp_idx < (state->encoder_control->chroma_format == UVG_CSP_400 ? 1 : MAX_NUM_COMPONENT); comp_idx++)
   {
     if (cc_filter_param->cc_alf_filter_enabled[comp_idx - 1])
     {
       uvg_pixel* rec_uv = comp_idx == COMPONENT_Cb ? rec_yuv->u : rec_yuv->v;
-      const int luma_stride = rec_yuv->stride;
-      apply_cc_alf_filter(state, comp_idx, rec_uv, alf_info->alf_tmp_y, luma_stride, alf_info->cc_alf_filter_control[comp_idx - 1],
-        cc_filter_param->cc_alf_coeff[comp_idx - 1], -1, &arr_vars);
+      apply_cc_alf_filter(state, comp_idx, rec_uv, alf_info->alf_tmp_y, rec_yuv->stride, alf_info->cc_alf_filter_control[comp_idx - 1],
+        cc_filter_param->cc_alf_coeff[comp_idx - 1], -1, &alf_info->arr_vars, ctu_row);
+    }
+  }
+}
+
+/**
+ * \brief Select the filters of a frame in the low latency mode.
+ *
+ * Every APS sent by the previous frames of the state since the latest IRAP
+ * picture is used, up to ALF_CTB_MAX_NUM_APS - 1 frames back. The APS ids
+ * are the frame numbers modulo ALF_CTB_MAX_NUM_APS, so the APS of a frame
+ * is not replaced before the frames that may use it have been coded.
+ */
+void uvg_alf_enc_low_latency_init(encoder_state_t *const state)
+{
+  alf_info_t *alf_info = state->tile->frame->alf_info;
+  alf_aps *apss = state->slice->alf->apss;
+  const int32_t num = state->frame->num;
+
+  uvg_alf_enc_init(state);
+  alf_init_array_variables(state, &alf_info->arr_vars_rdo);
+
+  // The frames coded in parallel may have an IRAP picture the state has not seen.
+  const encoder_state_t *other = state;
+  do {
+    if (other->frame->is_irap && other->frame->num <= num) {
+      alf_info->last_irap_num = MAX(alf_info->last_irap_num, other->frame->num);
+    }
+    other = other->previous_encoder_state;
+  } while (other != state);
+
+  for (int aps_id = 0; aps_id < ALF_CTB_MAX_NUM_APS; aps_id++) {
+    if (alf_info->aps_frame_num[aps_id] < alf_info->last_irap_num) {
+      alf_info->aps_frame_num[aps_id] = -1;
+    }
+  }
+
+  int num_aps = 0;
+  int chroma_aps_id = -1;
+  for (int age = 1; age < ALF_CTB_MAX_NUM_APS && num - age >= 0; age++) {
+    const int aps_id = (num - age) % ALF_CTB_MAX_NUM_APS;
+    if (alf_info->aps_frame_num[aps_id] != num - age) continue;
+
+    alf_aps *aps = &state->tile->frame->alf_param_set_map[aps_id + NUM_APS_TYPE_LEN + T_ALF_APS].parameter_set;
+    copy_aps(&apss[aps_id], aps, false);
+    if (aps->new_filter_flag[CHANNEL_TYPE_LUMA]) {
+      state->slice->alf->tile_group_luma_aps_id[num_aps++] = aps_id;
+    }
+    if (aps->new_filter_flag[CHANNEL_TYPE_CHROMA] && chroma_aps_id < 0 &&
+        state->encoder_control->chroma_format != UVG_CSP_400) {
+      chroma_aps_id = aps_id;
+    }
+  }
+
+  const bool luma_enabled = num_aps > 0 || state->encoder_control->cfg.alf_allow_predefined_filters;
+  const bool chroma_enabled = luma_enabled && chroma_aps_id >= 0;
+  state->slice->alf->tile_group_num_aps = num_aps;
+  state->slice->alf->tile_group_chroma_aps_id = chroma_aps_id;
+  state->slice->alf->tile_group_alf_enabled_flag[COMPONENT_Y] = luma_enabled;
+  state->slice->alf->tile_group_alf_enabled_flag[COMPONENT_Cb] = chroma_enabled;
+  state->slice->alf->tile_group_alf_enabled_flag[COMPONENT_Cr] = chroma_enabled;
+  state->slice->alf->tile_group_cc_alf_cb_enabled_flag = false;
+  state->slice->alf->tile_group_cc_alf_cr_enabled_flag = false;
+
+  if (luma_enabled) {
+    alf_reconstruct_coeff_aps(state, true, chroma_enabled, false, &alf_info->arr_vars);
+    alf_reconstruct_coeff_aps(state, true, chroma_enabled, true, &alf_info->arr_vars_rdo);
+  }
+}
+
+// Stride of the CTU buffers of the low latency mode, with room for the
+// SIMD reads past the padding.
+#define ALF_LL_BUF_STRIDE (LCU_WIDTH + 2 * MAX_ALF_PADDING_SIZE + 16)
+#define ALF_LL_BUF_HEIGHT (LCU_WIDTH + 2 * MAX_ALF_PADDING_SIZE + 1)
+
+/**
+ * \brief Decide the ALF parameters of a CTU in the low latency mode.
+ *
+ * The statistics are collected from the reconstruction of the CTU padded
+ * as if it was the whole picture, because the neighbouring CTUs are not
+ * final yet. The filter set and the on/off flags are chosen with the rates
+ * estimated from the current cabac contexts of the CTU.
+ */
+void uvg_alf_enc_low_latency_ctu(encoder_state_t *const state, const int lcu_x, const int lcu_y)
+{
+  const encoder_control_t *const encoder = state->encoder_control;
+  alf_info_t *alf_info = state->tile->frame->alf_info;
+  bool **ctu_enable_flag = alf_info->ctu_enable_flag;
+  const int ctu_idx = lcu_y * state->tile->frame->width_in_lcu + lcu_x;
+
+  if (!state->slice->alf->tile_group_alf_enabled_flag[COMPONENT_Y])
+  {
+    ctu_enable_flag[COMPONENT_Y][ctu_idx] = 0;
+    ctu_enable_flag[COMPONENT_Cb][ctu_idx] = 0;
+    ctu_enable_flag[COMPONENT_Cr][ctu_idx] = 0;
+    return;
+  }
+
+  enum uvg_chroma_format chroma_fmt = encoder->chroma_format;
+  bool chroma_scale_x = (chroma_fmt == UVG_CSP_444) ? 0 : 1;
+  bool chroma_scale_y = (chroma_fmt != UVG_CSP_420) ? 0 : 1;
+  const int number_of_components = (chroma_fmt == UVG_CSP_400) ? 1 : MAX_NUM_COMPONENT;
+
+  const int alf_vb_luma_ctu_height = LCU_WIDTH;
+  const int alf_vb_chma_ctu_height = (LCU_WIDTH >> ((chroma_fmt == UVG_CSP_420) ? 1 : 0));
+  const int alf_vb_luma_pos = LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA;
+  const int alf_vb_chma_pos = (LCU_WIDTH >> ((chroma_fmt == UVG_CSP_420) ? 1 : 0)) - ALF_VB_POS_ABOVE_CTUROW_CHMA;
+
+  const int x_pos = lcu_x * LCU_WIDTH;
+  const int y_pos = lcu_y * LCU_WIDTH;
+  const int width = MIN(LCU_WIDTH, state->tile->frame->width - x_pos);
+  const int height = MIN(LCU_WIDTH, state->tile->frame->height - y_pos);
+
+  uvg_pixel rec_buf[MAX_NUM_COMPONENT][ALF_LL_BUF_STRIDE * ALF_LL_BUF_HEIGHT];
+  alf_classifier classifier_buf[LCU_WIDTH * LCU_WIDTH];
+  alf_classifier *classifier[LCU_WIDTH];
+  for (int i = 0; i < LCU_WIDTH; i++)
+  {
+    classifier[i] = &classifier_buf[i * LCU_WIDTH];
+  }
+
+  for (int comp_idx = 0; comp_idx < number_of_components; comp_idx++)
+  {
+    const bool is_luma = comp_idx == COMPONENT_Y ? 1 : 0;
+    const channel_type ch_type = is_luma ? CHANNEL_TYPE_LUMA : CHANNEL_TYPE_CHROMA;
+    const int blk_w = is_luma ? width : width >> chroma_scale_x;
+    const int blk_h = is_luma ? height : height >> chroma_scale_y;
+    const int pos_x = is_luma ? x_pos : x_pos >> chroma_scale_x;
+    const int pos_y = is_luma ? y_pos : y_pos >> chroma_scale_y;
+
+    const int32_t org_stride = is_luma ? state->tile->frame->source->stride : state->tile->frame->source->stride >> chroma_scale_x;
+    const int32_t rec_stride = is_luma ? state->tile->frame->rec->stride : state->tile->frame->rec->stride >> chroma_scale_x;
+    uvg_pixel *org = comp_idx ? (comp_idx - 1 ? &state->tile->frame->source->v[pos_x + pos_y * org_stride] : &state->tile->frame->source->u[pos_x + pos_y * org_stride]) : &state->tile->frame->source->y[pos_x + pos_y * org_stride];
+    const uvg_pixel *rec = comp_idx ? (comp_idx - 1 ? &state->tile->frame->rec->v[pos_x + pos_y * rec_stride] : &state->tile->frame->rec->u[pos_x + pos_y * rec_stride]) : &state->tile->frame->rec->y[pos_x + pos_y * rec_stride];
+
+    uvg_pixel *buf = &rec_buf[comp_idx][MAX_ALF_PADDING_SIZE * ALF_LL_BUF_STRIDE + MAX_ALF_PADDING_SIZE];
+    for (int y = 0; y < blk_h; y++)
+    {
+      memcpy(&buf[y * ALF_LL_BUF_STRIDE], &rec[y * rec_stride], sizeof(uvg_pixel) * blk_w);
+    }
+    if (is_luma)
+    {
+      adjust_pixels(buf, 0, blk_w, 0, blk_h, ALF_LL_BUF_STRIDE, blk_w, blk_h);
+      alf_derive_classification(state, buf, ALF_LL_BUF_STRIDE, classifier, blk_w, blk_h, 0, 0, 0, 0);
+    }
+    else
+    {
+      adjust_pixels_chroma(buf, 0, blk_w, 0, blk_h, ALF_LL_BUF_STRIDE, blk_w, blk_h);
+    }
+
+    alf_covariance *alf_cov = comp_idx == COMPONENT_Y ? alf_info->alf_covariance_y :
+      comp_idx == COMPONENT_Cb ? alf_info->alf_covariance_u : alf_info->alf_covariance_v;
+    const int num_classes = is_luma ? MAX_NUM_ALF_CLASSES : 1;
+    const int cov_index = ctu_idx * num_classes;
+    for (int class_idx = 0; class_idx < num_classes; class_idx++)
+    {
+      reset_alf_covariance(&alf_cov[cov_index + class_idx], MAX_ALF_NUM_CLIPPING_VALUES);
+    }
+    uvg_alf_get_blk_stats(state, ch_type,
+      &alf_cov[cov_index],
+      comp_idx ? NULL : classifier,
+      org, org_stride, buf, ALF_LL_BUF_STRIDE, 0, 0, 0, 0, blk_w, blk_h,
+      (is_luma ? alf_vb_luma_ctu_height : alf_vb_chma_ctu_height),
+      (is_luma) ? alf_vb_luma_pos : alf_vb_chma_pos,
+      alf_info->arr_vars.alf_clipping_values
+    );
+  }
+
+  if (encoder->cfg.lossless)
+  {
+    ctu_enable_flag[COMPONENT_Y][ctu_idx] = 0;
+    ctu_enable_flag[COMPONENT_Cb][ctu_idx] = 0;
+    ctu_enable_flag[COMPONENT_Cr][ctu_idx] = 0;
+    return;
+  }
+
+  array_variables *arr_vars = &alf_info->arr_vars_rdo;
+  const int8_t bit_depth = encoder->bitdepth;
+  const double lambda = state->frame->lambda;
+  int filter_tmp[MAX_NUM_ALF_LUMA_COEFF];
+  int clip_tmp[MAX_NUM_ALF_LUMA_COEFF];
+  int clip_default[MAX_NUM_ALF_LUMA_COEFF] = { 0 };
+
+  // The other CTUs use the cabac contexts of their own wavefront rows.
+  cabac_data_t ctx_start;
+  cabac_data_t cabac_estimator;
+  memcpy(&ctx_start, &state->cabac, sizeof(ctx_start));
+  ctx_start.only_count = 1;
+
+  //luma
+  {
+    alf_covariance *alf_cov = &alf_info->alf_covariance_y[ctu_idx * MAX_NUM_ALF_CLASSES];
+    const double dist_unfilter = get_unfiltered_distortion_cov_classes(alf_cov, MAX_NUM_ALF_CLASSES);
+    const int num_filter_set = ALF_NUM_FIXED_FILTER_SETS + state->slice->alf->tile_group_num_aps;
+    const int first_filter_set_idx = encoder->cfg.alf_allow_predefined_filters ? 0 : ALF_NUM_FIXED_FILTER_SETS;
+
+    double cost_on = MAX_DOUBLE;
+    int best_filter_set_idx = first_filter_set_idx;
+    ctu_enable_flag[COMPONENT_Y][ctu_idx] = 1;
+    for (int filter_set_idx = first_filter_set_idx; filter_set_idx < num_filter_set; filter_set_idx++)
+    {
+      memcpy(&cabac_estimator, &ctx_start, sizeof(cabac_estimator));
+      alf_cabac_reset_bits(&cabac_estimator);
+      code_alf_ctu_enable_flag(state, &cabac_estimator, ctu_idx, COMPONENT_Y, NULL);
+      alf_info->alf_ctb_filter_index[ctu_idx] = filter_set_idx;
+      code_alf_ctu_filter_index(state, &cabac_estimator, ctu_idx, true);
+      const double rate = (23 - cabac_estimator.bits_left) + (cabac_estimator.num_buffered_bytes << 3);
+
+      double dist = dist_unfilter;
+      for (int class_idx = 0; class_idx < MAX_NUM_ALF_CLASSES; class_idx++)
+      {
+        if (filter_set_idx < ALF_NUM_FIXED_FILTER_SETS)
+        {
+          int filter_idx = g_class_to_filter_mapping[filter_set_idx][class_idx];
+          dist += calc_error_for_coeffs(&alf_cov[class_idx], clip_default, g_fixed_filter_set_coeff[filter_idx], MAX_NUM_ALF_LUMA_COEFF, bit_depth);
+        }
+        else
+        {
+          const short *p_coeff = arr_vars->coeff_aps_luma[filter_set_idx - ALF_NUM_FIXED_FILTER_SETS];
+          const int16_t *p_clipp = arr_vars->clipp_aps_luma[filter_set_idx - ALF_NUM_FIXED_FILTER_SETS];
+          for (int i = 0; i < MAX_NUM_ALF_LUMA_COEFF; i++)
+          {
+            filter_tmp[i] = p_coeff[class_idx * MAX_NUM_ALF_LUMA_COEFF + i];
+            clip_tmp[i] = p_clipp[class_idx * MAX_NUM_ALF_LUMA_COEFF + i];
+          }
+          dist += calc_error_for_coeffs(&alf_cov[class_idx], clip_tmp, filter_tmp, MAX_NUM_ALF_LUMA_COEFF, bit_depth);
+        }
+      }
+
+      const double cost = dist + lambda * rate;
+      if (cost < cost_on)
+      {
+        cost_on = cost;
+        best_filter_set_idx = filter_set_idx;
+      }
+    }
+
+    ctu_enable_flag[COMPONENT_Y][ctu_idx] = 0;
+    memcpy(&cabac_estimator, &ctx_start, sizeof(cabac_estimator));
+    alf_cabac_reset_bits(&cabac_estimator);
+    code_alf_ctu_enable_flag(state, &cabac_estimator, ctu_idx, COMPONENT_Y, NULL);
+    const double cost_off = dist_unfilter + lambda * ((23 - cabac_estimator.bits_left) + (cabac_estimator.num_buffered_bytes << 3));
+
+    ctu_enable_flag[COMPONENT_Y][ctu_idx] = cost_on < cost_off;
+    alf_info->alf_ctb_filter_index[ctu_idx] = best_filter_set_idx;
+  }
+
+  //chroma
+  for (int comp_idx = COMPONENT_Cb; comp_idx < number_of_components; comp_idx++)
+  {
+    ctu_enable_flag[comp_idx][ctu_idx] = 0;
+    if (!state->slice->alf->tile_group_alf_enabled_flag[comp_idx])
+    {
+      continue;
+    }
+
+    alf_covariance *alf_cov = comp_idx == COMPONENT_Cb ? &alf_info->alf_covariance_u[ctu_idx] : &alf_info->alf_covariance_v[ctu_idx];
+    const double dist_unfilter = get_unfiltered_distortion_cov_classes(alf_cov, 1);
+    const int num_alts = state->slice->alf->apss[state->slice->alf->tile_group_chroma_aps_id].num_alternatives_chroma;
+
+    memcpy(&cabac_estimator, &ctx_start, sizeof(cabac_estimator));
+    alf_cabac_reset_bits(&cabac_estimator);
+    code_alf_ctu_enable_flag(state, &cabac_estimator, ctu_idx, comp_idx, NULL);
+    const double cost_off = dist_unfilter + lambda * ((23 - cabac_estimator.bits_left) + (cabac_estimator.num_buffered_bytes << 3));
+
+    double cost_on = MAX_DOUBLE;
+    int best_alt_idx = 0;
+    ctu_enable_flag[comp_idx][ctu_idx] = 1;
+    for (int alt_idx = 0; alt_idx < num_alts; ++alt_idx)
+    {
+      memcpy(&cabac_estimator, &ctx_start, sizeof(cabac_estimator));
+      alf_cabac_reset_bits(&cabac_estimator);
+      alf_info->ctu_alternative[comp_idx][ctu_idx] = alt_idx;
+      code_alf_ctu_enable_flag(state, &cabac_estimator, ctu_idx, comp_idx, NULL);
+      code_alf_ctu_alternative_ctu(state, &cabac_estimator, ctu_idx, comp_idx, NULL);
+      const double rate = (23 - cabac_estimator.bits_left) + (cabac_estimator.num_buffered_bytes << 3);
+
+      for (int i = 0; i < MAX_NUM_ALF_CHROMA_COEFF; i++)
+      {
+        filter_tmp[i] = arr_vars->chroma_coeff_final[alt_idx][i];
+        clip_tmp[i] = arr_vars->chroma_clipp_final[alt_idx][i];
+      }
+      const double cost = dist_unfilter + calc_error_for_coeffs(alf_cov, clip_tmp, filter_tmp, MAX_NUM_ALF_CHROMA_COEFF, bit_depth) + lambda * rate;
+      if (cost < cost_on)
+      {
+        cost_on = cost;
+        best_alt_idx = alt_idx;
+      }
+    }
+
+    ctu_enable_flag[comp_idx][ctu_idx] = cost_on < cost_off;
+    alf_info->ctu_alternative[comp_idx][ctu_idx] = best_alt_idx;
+  }
+}
+
+/**
+ * \brief Prepare a CTU row for the filtering in the low latency mode.
+ *
+ * The row is padded and copied to the filter input buffer. Each row copies
+ * the samples up to the padding below it, because the filtering of the row
+ * above may already be modifying the reconstruction. The classification is
+ * derived from the copy for the same reason.
+ */
+void uvg_alf_enc_low_latency_ctu_row(encoder_state_t *const state, const int ctu_row)
+{
+  if (!state->slice->alf->tile_group_alf_enabled_flag[COMPONENT_Y])
+  {
+    return;
+  }
+
+  alf_pad_ctu_row(state, ctu_row);
+
+  alf_info_t *alf_info = state->tile->frame->alf_info;
+  enum uvg_chroma_format chroma_fmt = state->encoder_control->chroma_format;
+  bool chroma_scale_x = (chroma_fmt == UVG_CSP_444) ? 0 : 1;
+  bool chroma_scale_y = (chroma_fmt != UVG_CSP_420) ? 0 : 1;
+
+  const int luma_height = state->tile->frame->height;
+  const int luma_width = state->tile->frame->width;
+  const int luma_stride = state->tile->frame->rec->stride;
+  const bool last_row = ctu_row == state->tile->frame->height_in_lcu - 1;
+  const int y_pos = ctu_row * LCU_WIDTH;
+
+  const int copy_start = ctu_row ? y_pos + MAX_ALF_PADDING_SIZE : -MAX_ALF_PADDING_SIZE;
+  const int copy_end = last_row ? luma_height + MAX_ALF_PADDING_SIZE : y_pos + LCU_WIDTH + MAX_ALF_PADDING_SIZE;
+  const int index_luma = copy_start * luma_stride - MAX_ALF_PADDING_SIZE;
+  memcpy(&alf_info->alf_tmp_y[index_luma], &state->tile->frame->rec->y[index_luma],
+    sizeof(uvg_pixel) * luma_stride * (copy_end - copy_start));
+
+  if (chroma_fmt != UVG_CSP_400)
+  {
+    const int chroma_stride = luma_stride >> chroma_scale_x;
+    const int chroma_padding = MAX_ALF_PADDING_SIZE >> chroma_scale_x;
+    const int chroma_start = ctu_row ? (y_pos >> chroma_scale_y) + chroma_padding : -chroma_padding;
+    const int chroma_end = last_row ? (luma_height >> chroma_scale_y) + chroma_padding : ((y_pos + LCU_WIDTH) >> chroma_scale_y) + chroma_padding;
+    const int index_chroma = chroma_start * chroma_stride - chroma_padding;
+    memcpy(&alf_info->alf_tmp_u[index_chroma], &state->tile->frame->rec->u[index_chroma],
+      sizeof(uvg_pixel) * chroma_stride * (chroma_end - chroma_start));
+    memcpy(&alf_info->alf_tmp_v[index_chroma], &state->tile->frame->rec->v[index_chroma],
+      sizeof(uvg_pixel) * chroma_stride * (chroma_end - chroma_start));
+  }
+
+  const int height = (y_pos + LCU_WIDTH > luma_height) ? (luma_height - y_pos) : LCU_WIDTH;
+  for (int x_pos = 0; x_pos < luma_width; x_pos += LCU_WIDTH)
+  {
+    const int width = (x_pos + LCU_WIDTH > luma_width) ? (luma_width - x_pos) : LCU_WIDTH;
+    alf_derive_classification(state, alf_info->alf_tmp_y, luma_stride,
+      alf_info->classifier, width, height, x_pos, y_pos, x_pos, y_pos);
+  }
+}
+
+/**
+ * \brief Derive the filters of the frame for the following frames.
+ *
+ * Runs after the frame has been filtered and its CTUs written, so the CTU
+ * parameters of the frame may be overwritten by the derivation. The new
+ * APS is sent only when the slice enables ALF, so it is recorded only then.
+ */
+void uvg_alf_enc_low_latency_finish(encoder_state_t *const state)
+{
+  alf_info_t *alf_info = state->tile->frame->alf_info;
+
+  if (state->slice->alf->tile_group_alf_enabled_flag[COMPONENT_Y])
+  {
+    const uint32_t num_ctus_in_pic = state->tile->frame->width_in_lcu * state->tile->frame->height_in_lcu;
+    const int num_aps = state->slice->alf->tile_group_num_aps;
+
+    cabac_data_t *cabac_estimator = &alf_info->cabac_estimator;
+    memcpy(cabac_estimator, &state->cabac, sizeof(*cabac_estimator));
+    cabac_estimator->only_count = 1;
+
+    alf_derive_frame_stats(state);
+    for (uint32_t ctb_idx = 0; ctb_idx < num_ctus_in_pic; ctb_idx++)
+    {
+      alf_info->alf_ctb_filter_index[ctb_idx] = ALF_NUM_FIXED_FILTER_SETS;
+    }
+
+    alf_aps alf_param;
+    reset_alf_param(&alf_param);
+    alf_param.new_filter_flag[CHANNEL_TYPE_LUMA] = true;
+    alf_param.new_filter_flag[CHANNEL_TYPE_CHROMA] = true;
+    state->slice->alf->tile_group_num_aps = 1; // Only new filter for RD cost optimization
+
+    alf_encoder(state, &alf_param, CHANNEL_TYPE_LUMA, 0.0, &alf_info->arr_vars);
+    if (state->encoder_control->chroma_format != UVG_CSP_400) {
+      alf_encoder(state, &alf_param, CHANNEL_TYPE_CHROMA, 0.0, &alf_info->arr_vars);
+    }
+    state->slice->alf->tile_group_num_aps = num_aps;
+
+    const bool new_luma = alf_param.enabled_flag[COMPONENT_Y];
+    const bool new_chroma = alf_param.enabled_flag[COMPONENT_Cb] || alf_param.enabled_flag[COMPONENT_Cr];
+    if (new_luma || new_chroma)
+    {
+      const int aps_id = state->frame->num % ALF_CTB_MAX_NUM_APS;
+      param_set_map *aps_map = &state->tile->frame->alf_param_set_map[aps_id + NUM_APS_TYPE_LEN + T_ALF_APS];
+      copy_alf_param(&aps_map->parameter_set, &alf_param);
+      aps_map->parameter_set.aps_id = aps_id;
+      aps_map->parameter_set.aps_type = T_ALF_APS;
+      aps_map->parameter_set.temporal_id = state->slice->id;
+      aps_map->parameter_set.layer_id = 0;
+      aps_map->parameter_set.new_filter_flag[CHANNEL_TYPE_LUMA] = new_luma;
+      aps_map->parameter_set.new_filter_flag[CHANNEL_TYPE_CHROMA] = new_chroma;
+      aps_map->b_changed = true;
+      alf_info->aps_frame_num[aps_id] = state->frame->num;
     }
   }
 
   alf_covariance_destroy(state->tile->frame);
-}
\ No newline at end of file
+}
+
+void uvg_alf_enc_process(encoder_state_t *const state)
+{
+  uvg_alf_enc_init(state);
+  for (int ctu_row = 0; ctu_row < state->tile->frame->height_in_lcu; ctu_row++)
+  {
+    uvg_alf_enc_ctu_row_stats(state, ctu_row);
+  }
+  uvg_alf_enc_derive(state);
+  for (int ctu_row = 0; ctu_row < state->tile->frame->height_in_lcu; ctu_row++)
+  {
+    uvg_alf_enc_filter_ctu_row(state, ctu_row);
+  }
+  uvg_alf_enc_finish(state);
+  for (int ctu_row = 0; ctu_row < state->tile->frame->height_in_lcu; ctu_row++)
+  {
+    uvg_alf_enc_cc_filter_ctu_row(state, ctu_row);
+  }
+}
@@ -235,6 +235,30 @@ typedef struct alf_aps {
 
 } alf_aps;
 
+typedef struct array_variables {
+  short fixed_filter_set_coeff_dec[ALF_NUM_FIXED_FILTER_SETS][MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
+  short chroma_coeff_final[MAX_NUM_ALF_ALTERNATIVES_CHROMA][MAX_NUM_ALF_CHROMA_COEFF];
+  short coeff_final[MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
+  short coeff_aps_luma[ALF_CTB_MAX_NUM_APS][MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
+
+  int16_t chroma_clipp_final[MAX_NUM_ALF_ALTERNATIVES_CHROMA][MAX_NUM_ALF_CHROMA_COEFF];
+  int16_t clip_default[MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
+  int16_t clipp_final[MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
+  int16_t clipp_aps_luma[ALF_CTB_MAX_NUM_APS][MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
+
+  short filter_indices[MAX_NUM_ALF_CLASSES][MAX_NUM_ALF_CLASSES];
+
+  unsigned bits_new_filter[MAX_NUM_CHANNEL_TYPE];
+  short alf_clipping_values[MAX_NUM_CHANNEL_TYPE][MAX_ALF_NUM_CLIPPING_VALUES];
+  int cc_reuse_aps_id[2];
+
+  int filter_coeff_set[MAX_NUM_ALF_CLASSES][MAX_NUM_ALF_LUMA_COEFF];
+  int filter_clipp_set[MAX_NUM_ALF_CLASSES][MAX_NUM_ALF_LUMA_COEFF];
+
+  struct clp_rngs clp_rngs;
+
+} array_variables;
+
 typedef struct alf_info_t {
   cabac_data_t cabac_estimator;
 
@@ -278,6 +302,13 @@ typedef struct alf_info_t {
   alf_classifier **classifier;
   alf_aps alf_param_temp;
 
+  array_variables arr_vars; // Filters and clipping values of the frame
+  cabac_data_t ctx_start_cc_alf; // Cabac contexts before the filter derivation
+
+  array_variables arr_vars_rdo; // Filters of the low latency mode in the form used by the rate-distortion estimates
+  int32_t aps_frame_num[ALF_CTB_MAX_NUM_APS]; // Frame that sent the APS of the id in the low latency mode, -1 if none
+  int32_t last_irap_num; // Frame number of the latest IRAP picture seen by the low latency mode
+
 } alf_info_t;
 
 typedef struct param_set_map {
@@ -286,30 +317,6 @@ typedef struct param_set_map {
   struct alf_aps parameter_set;
 } param_set_map;
 
-typedef struct array_variables {
-  short fixed_filter_set_coeff_dec[ALF_NUM_FIXED_FILTER_SETS][MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
-  short chroma_coeff_final[MAX_NUM_ALF_ALTERNATIVES_CHROMA][MAX_NUM_ALF_CHROMA_COEFF];
-  short coeff_final[MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
-  short coeff_aps_luma[ALF_CTB_MAX_NUM_APS][MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
-
-  int16_t chroma_clipp_final[MAX_NUM_ALF_ALTERNATIVES_CHROMA][MAX_NUM_ALF_CHROMA_COEFF];
-  int16_t clip_default[MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
-  int16_t clipp_final[MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
-  int16_t clipp_aps_luma[ALF_CTB_MAX_NUM_APS][MAX_NUM_ALF_CLASSES * MAX_NUM_ALF_LUMA_COEFF];
-
-  short filter_indices[MAX_NUM_ALF_CLASSES][MAX_NUM_ALF_CLASSES];
-
-  unsigned bits_new_filter[MAX_NUM_CHANNEL_TYPE];
-  short alf_clipping_values[MAX_NUM_CHANNEL_TYPE][MAX_ALF_NUM_CLIPPING_VALUES];
-  int cc_reuse_aps_id[2];
-
-  int filter_coeff_set[MAX_NUM_ALF_CLASSES][MAX_NUM_ALF_LUMA_COEFF];
-  int filter_clipp_set[MAX_NUM_ALF_CLASSES][MAX_NUM_ALF_LUMA_COEFF];
-
-  struct clp_rngs clp_rngs;
-
-} array_variables;
-
 //inits aps parameter set in videoframe
 void uvg_set_aps_map(videoframe_t* frame, enum uvg_alf alf_type);
 
@@ -319,6 +326,28 @@ void uvg_reset_cc_alf_aps_param(cc_alf_filter_param *cc_alf);
 //starts alf encoding process
 void uvg_alf_enc_process(encoder_state_t *const state);
 
+//allocates the statistics of a frame, called before the other stages
+void uvg_alf_enc_init(encoder_state_t *const state);
+//derives classification and statistics of a CTU row, called for the rows in order
+void uvg_alf_enc_ctu_row_stats(encoder_state_t *const state, const int ctu_row);
+//derives the filters of a frame when the statistics of every CTU row are ready
+void uvg_alf_enc_derive(encoder_state_t *const state);
+//filters a CTU row with the derived filters
+void uvg_alf_enc_filter_ctu_row(encoder_state_t *const state, const int ctu_row);
+//derives cc alf and frees the statistics of a frame, called when every CTU row has been filtered
+void uvg_alf_enc_finish(encoder_state_t *const state);
+//applies cc alf to a CTU row, called after uvg_alf_enc_finish
+void uvg_alf_enc_cc_filter_ctu_row(encoder_state_t *const state, const int ctu_row);
+
+//selects the APSs of the previous frames for a frame in the low latency mode, called before the frame is encoded
+void uvg_alf_enc_low_latency_init(encoder_state_t *const state);
+//decides the ALF parameters of a reconstructed CTU in the low latency mode
+void uvg_alf_enc_low_latency_ctu(encoder_state_t *const state, const int lcu_x, const int lcu_y);
+//pads a CTU row and copies it for the filtering in the low latency mode, called for the rows in order
+void uvg_alf_enc_low_latency_ctu_row(encoder_state_t *const state, const int ctu_row);
+//derives new filters for the following frames and frees the statistics in the low latency mode
+void uvg_alf_enc_low_latency_finish(encoder_state_t *const state);
+
 //creates variables for alf_info_t structure in videoframe_t 
 void uvg_alf_create(videoframe_t *frame, enum uvg_chroma_format chroma_format);
 //frees allocated memory in alf_info_t structure
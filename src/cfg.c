@@ -246,6 +246,15 @@ int uvg_config_init(uvg_config *cfg)
 
   cfg->ref_wraparound = 0;
 
+  cfg->hash_me = UVG_HASH_ME_OFF;
+
+  cfg->intra_gradient_presel = 0;
+  cfg->intra_chroma_fast = 0;
+
+  cfg->alf_low_latency = 0;
+
+  cfg->ref_padding = 0;
+
   return 1;
 }
 
@@ -587,6 +596,7 @@ int uvg_config_parse(uvg_config *cfg, const char *name, const char *value)
   static const char * const cu_split_termination_names[] = { "zero", "off", NULL };
 
   static const char * const me_early_termination_names[] = { "off", "on", "sensitive", NULL };
+  static const char * const hash_me_names[] = { "off", "on", "auto", NULL };
 
   static const char * const sao_names[] = { "off", "edge", "band", "full", NULL };
   static const char * const alf_names[] = { "off", "no-cc", "full", NULL };
@@ -1617,6 +1627,18 @@ int uvg_config_parse(uvg_config *cfg, const char *name, const char *value)
   else if OPT("intra-rough-granularity") {
     cfg->intra_rough_search_levels = atoi(value);
   }
+  else if OPT("intra-gradient-presel") {
+    cfg->intra_gradient_presel = (bool)atobool(value);
+  }
+  else if OPT("intra-chroma-fast") {
+    cfg->intra_chroma_fast = (bool)atobool(value);
+  }
+  else if OPT("alf-low-latency") {
+    cfg->alf_low_latency = (bool)atobool(value);
+  }
+  else if OPT("ref-padding") {
+    cfg->ref_padding = (bool)atobool(value);
+  }
   else if OPT ("ibc") {
     int ibc_value = atoi(value);
     if (ibc_value < 0 || ibc_value > 2) {
@@ -1630,6 +1652,12 @@ int uvg_config_parse(uvg_config *cfg, const char *name, const char *value)
   } else if OPT ("ref-wraparound") {
     cfg->ref_wraparound = (bool)atobool(value);
   }
+  else if OPT("hash-me") {
+    int8_t mode = UVG_HASH_ME_AUTO;
+    int result = parse_enum(value, hash_me_names, &mode);
+    cfg->hash_me = mode;
+    return result;
+  }
   else {
     return 0;
   }
@@ -1943,6 +1971,27 @@ int uvg_config_validate(const uvg_config *const cfg)
     error = 1;
   }
 
+  if (cfg->alf_low_latency && cfg->alf_type) {
+    if (cfg->alf_type == UVG_ALF_FULL) {
+      fprintf(stderr, "Input error: --alf-low-latency does not support cross component ALF, use --alf=no-cc.\n");
+      error = 1;
+    }
+    if (!cfg->wpp) {
+      fprintf(stderr, "Input error: --alf-low-latency requires --wpp.\n");
+      error = 1;
+    }
+  }
+
+  if (cfg->alf_type && (cfg->tiles_width_count > 1 || cfg->tiles_height_count > 1)) {
+    fprintf(stderr, "Input error: --alf does not support tiles.\n");
+    error = 1;
+  }
+
+  if (cfg->ref_padding && (cfg->ref_wraparound || cfg->lossless)) {
+    fprintf(stderr, "Input error: --ref-padding does not work with --ref-wraparound or --lossless.\n");
+    error = 1;
+  }
+
   if ((cfg->scaling_list == UVG_SCALING_LIST_CUSTOM) && !cfg->cqmfile) {
     fprintf(stderr, "Input error: --scaling-list=custom does not work without --cqmfile=<FILE>.\n");
     error = 1;
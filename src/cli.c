@@ -203,6 +203,15 @@ static const struct option long_options[] = {
   { "no-dep-quant",             no_argument, NULL, 0 },
   { "ref-wraparound",           no_argument, NULL, 0 },
   { "no-ref-wraparound",        no_argument, NULL, 0 },
+  { "hash-me",            required_argument, NULL, 0 },
+  { "intra-gradient-presel",    no_argument, NULL, 0 },
+  { "no-intra-gradient-presel", no_argument, NULL, 0 },
+  { "intra-chroma-fast",        no_argument, NULL, 0 },
+  { "no-intra-chroma-fast",     no_argument, NULL, 0 },
+  { "alf-low-latency",          no_argument, NULL, 0 },
+  { "no-alf-low-latency",       no_argument, NULL, 0 },
+  { "ref-padding",              no_argument, NULL, 0 },
+  { "no-ref-padding",           no_argument, NULL, 0 },
   {0, 0, 0, 0}
 };
 
@@ -579,6 +588,13 @@ void print_help(void)
     "                                   - no-cc: ALF enabled without cross component\n"
     "                                            refinement\n"
     "                                   - full: Full ALF\n"
+    "                                   Not supported with tiles.\n"
+    "      --(no-)alf-low-latency : Filter each CTU with the ALF filters of\n"
+    "                                   the previous frames as soon as it is\n"
+    "                                   reconstructed. The filters of the frame\n"
+    "                                   are only used by the following frames.\n"
+    "                                   Requires --wpp and --alf=no-cc.\n"
+    "                                   [disabled]\n"
     "      --(no-)rdoq            : Rate-distortion optimized quantization [enabled]\n"
     "      --(no-)rdoq-skip       : Skip RDOQ for 4x4 blocks. [disabled]\n"
     "      --(no-)dep-quant       : Use dependent quantization. [disabled]\n"
@@ -651,6 +667,16 @@ void print_help(void)
     "                                   mode is checked on first level and then\n"
     "                                   second level checks the modes surrounding\n"
     "                                   the three best modes. [2]\n"
+    "      --(no-)intra-gradient-presel : Restrict the intra rough search to\n"
+    "                                   planar, DC, the MPMs and the dominant\n"
+    "                                   directions of the source gradients.\n"
+    "                                   [disabled]\n"
+    "      --(no-)intra-chroma-fast : Rank the chroma intra modes by the joint\n"
+    "                                   SATD of U and V and run RDO only for the\n"
+    "                                   luma derived mode and the best other\n"
+    "                                   modes. RDO stops after the luma derived\n"
+    "                                   mode if its cost is low enough.\n"
+    "                                   [disabled]\n"
     "      --(no-)combine-intra-cus: Whether the encoder tries to code a cu\n"
     "                                   on lower depth even when search is not\n"
     "                                   performed on said depth. Should only\n"
@@ -669,6 +695,20 @@ void print_help(void)
     "                                   - off: Don't terminate early.\n"
     "                                   - on: Terminate early.\n"
     "                                   - sensitive: Terminate even earlier.\n"
+    "      --hash-me <string>     : Hash based motion search. Proposes motion\n"
+    "                               vectors to exactly matching 8x8 blocks of\n"
+    "                               the reference frames before the integer\n"
+    "                               motion search. [off]\n"
+    "                                   - off: Disabled.\n"
+    "                                   - on: Enabled for all frames.\n"
+    "                                   - auto: Enabled for frames that are\n"
+    "                                           detected as screen content.\n"
+    "      --(no-)ref-padding     : Extend the borders of the reconstructed\n"
+    "                               pictures once as their LCU rows are done,\n"
+    "                               so that motion compensation reads the\n"
+    "                               reference pictures directly near the\n"
+    "                               borders. Not with --ref-wraparound or\n"
+    "                               --lossless. [disabled]\n"
     "      --fast-residual-cost <int> : Skip CABAC cost for residual coefficients\n"
     "                                   when QP is below the limit. [0]\n"
     "      --fast-coeff-table <string> : Read custom weights for residual\n"
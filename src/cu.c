@@ -266,6 +266,119 @@ cu_array_t * uvg_cu_array_copy_ref(cu_array_t* cua)
 }
 
 
+const motion_info_t* uvg_motion_field_at_const(const motion_field_t *mf, unsigned x_px, unsigned y_px)
+{
+  assert(x_px < mf->width);
+  assert(y_px < mf->height);
+  return &mf->data[(x_px >> MOTION_FIELD_LOG2_GRID) +
+                   (y_px >> MOTION_FIELD_LOG2_GRID) * (mf->stride >> MOTION_FIELD_LOG2_GRID)];
+}
+
+
+/**
+ * \brief Allocate a motion field.
+ *
+ * \param width   width of the field in luma pixels
+ * \param height  height of the field in luma pixels
+ * \return        the motion field, or NULL on failure
+ */
+motion_field_t * uvg_motion_field_alloc(const int width, const int height)
+{
+  motion_field_t *mf = MALLOC(motion_field_t, 1);
+  if (mf == NULL) return NULL;
+
+  // Round up to a multiple of LCU width and divide by cell width.
+  const int grid = 1 << MOTION_FIELD_LOG2_GRID;
+  const int width_cells  = CEILDIV(width,  LCU_WIDTH) * LCU_WIDTH / grid;
+  const int height_cells = CEILDIV(height, LCU_WIDTH) * LCU_WIDTH / grid;
+
+  mf->base     = NULL;
+  mf->data     = calloc(width_cells * height_cells, sizeof(motion_info_t));
+  mf->width    = width_cells  * grid;
+  mf->height   = height_cells * grid;
+  mf->stride   = mf->width;
+  mf->refcount = 1;
+
+  return mf;
+}
+
+
+motion_field_t * uvg_motion_subfield(motion_field_t *base,
+                                     const unsigned x_offset,
+                                     const unsigned y_offset,
+                                     const unsigned width,
+                                     const unsigned height)
+{
+  assert(x_offset + width <= base->width);
+  assert(y_offset + height <= base->height);
+
+  if (x_offset == 0 &&
+      y_offset == 0 &&
+      width == base->width &&
+      height == base->height)
+  {
+    return uvg_motion_field_copy_ref(base);
+  }
+
+  motion_field_t *mf = MALLOC(motion_field_t, 1);
+  if (mf == NULL) return NULL;
+
+  // Find the real base field.
+  motion_field_t *real_base = base;
+  while (real_base->base) {
+    real_base = real_base->base;
+  }
+  mf->base     = uvg_motion_field_copy_ref(real_base);
+  mf->data     = (motion_info_t *)uvg_motion_field_at_const(base, x_offset, y_offset);
+  mf->width    = width;
+  mf->height   = height;
+  mf->stride   = base->stride;
+  mf->refcount = 1;
+
+  return mf;
+}
+
+
+void uvg_motion_field_free(motion_field_t **mf_ptr)
+{
+  motion_field_t *mf = *mf_ptr;
+  if (mf == NULL) return;
+  *mf_ptr = NULL;
+
+  int new_refcount = UVG_ATOMIC_DEC(&mf->refcount);
+  if (new_refcount > 0) {
+    // Still we have some references, do nothing.
+    return;
+  }
+
+  assert(new_refcount == 0);
+
+  if (!mf->base) {
+    FREE_POINTER(mf->data);
+  } else {
+    uvg_motion_field_free(&mf->base);
+    mf->data = NULL;
+  }
+
+  FREE_POINTER(mf);
+}
+
+
+/**
+ * \brief Get a new pointer to a motion field.
+ *
+ * Increment reference count and return the motion field.
+ */
+motion_field_t * uvg_motion_field_copy_ref(motion_field_t *mf)
+{
+  int32_t new_refcount = UVG_ATOMIC_INC(&mf->refcount);
+  // The caller should have had another reference and we added one
+  // reference so refcount should be at least 2.
+  assert(new_refcount >= 2);
+  return mf;
+}
+
+
 /**
  * \brief Copy an lcu to a cu array.
  *
@@ -291,6 +404,40 @@ void uvg_cu_array_copy_from_lcu(cu_array_t* dst, int dst_x, int dst_y, const lcu
   }
 }
 
+
+/**
+ * \brief Copy the motion of an lcu to a motion field.
+ *
+ * The motion of the top-left 4x4 block of each 8x8 block is stored.
+ * All values are in luma pixels.
+ *
+ * \param dst     destination motion field
+ * \param dst_x   x-coordinate of the left edge of the copied area in dst
+ * \param dst_y   y-coordinate of the top edge of the copied area in dst
+ * \param src     source lcu
+ */
+void uvg_motion_field_copy_from_lcu(motion_field_t* dst, int dst_x, int dst_y, const lcu_t *src)
+{
+  const int grid = 1 << MOTION_FIELD_LOG2_GRID;
+  const int dst_stride = dst->stride >> MOTION_FIELD_LOG2_GRID;
+  for (int y = 0; y < LCU_WIDTH; y += grid) {
+    for (int x = 0; x < LCU_WIDTH; x += grid) {
+      const cu_info_t *from_cu = LCU_GET_CU_AT_PX(src, x, y);
+      const int x_mf = (dst_x + x) >> MOTION_FIELD_LOG2_GRID;
+      const int y_mf = (dst_y + y) >> MOTION_FIELD_LOG2_GRID;
+      motion_info_t *to = &dst->data[x_mf + y_mf * dst_stride];
+      if (from_cu->type == CU_INTER) {
+        memcpy(to->mv, from_cu->inter.mv, sizeof(to->mv));
+        to->mv_ref[0] = from_cu->inter.mv_ref[0];
+        to->mv_ref[1] = from_cu->inter.mv_ref[1];
+        to->mv_dir = from_cu->inter.mv_dir;
+      } else {
+        memset(to, 0, sizeof(*to));
+      }
+    }
+  }
+}
+
 /*
  * \brief Constructs cu_loc_t based on given parameters. Calculates chroma dimensions automatically.
  *
@@ -258,6 +258,44 @@ cu_array_t * uvg_cu_subarray(cu_array_t *base,
 void uvg_cu_array_free(cu_array_t **cua_ptr);
 cu_array_t * uvg_cu_array_copy_ref(cu_array_t* cua);
 
+// Motion is stored for TMVP with 8x8 granularity.
+#define MOTION_FIELD_LOG2_GRID 3
+
+/**
+ * \brief Motion of a 8x8 block of a reference picture.
+ */
+typedef struct {
+  mv_t    mv[2][2];  //!< \brief Motion vectors for L0 and L1
+  uint8_t mv_ref[2]; //!< \brief Index of the L0 and L1 array.
+  uint8_t mv_dir;    //!< \brief 1 for L0, 2 for L1, 3 for bi-pred, 0 if not inter
+} motion_info_t;
+
+/**
+ * \brief Compressed motion field of a picture.
+ *
+ * Reference pictures only need the motion at 8x8 granularity for TMVP,
+ * so they keep this instead of the full cu_array_t.
+ */
+typedef struct motion_field_t {
+  struct motion_field_t *base; //!< \brief base motion field or NULL
+  motion_info_t *data; //!< \brief motion field
+  uint32_t width;    //!< \brief width of the field in pixels
+  uint32_t height;   //!< \brief height of the field in pixels
+  uint32_t stride;   //!< \brief stride of the field in pixels
+  uint32_t refcount; //!< \brief number of references to this motion field
+} motion_field_t;
+
+const motion_info_t* uvg_motion_field_at_const(const motion_field_t *mf, unsigned x_px, unsigned y_px);
+
+motion_field_t * uvg_motion_field_alloc(const int width, const int height);
+motion_field_t * uvg_motion_subfield(motion_field_t *base,
+                                     const unsigned x_offset,
+                                     const unsigned y_offset,
+                                     const unsigned width,
+                                     const unsigned height);
+void uvg_motion_field_free(motion_field_t **mf_ptr);
+motion_field_t * uvg_motion_field_copy_ref(motion_field_t *mf);
+
 
 /**
  * \brief Return the 7 lowest-order bits of the pixel coordinate.
@@ -383,6 +421,7 @@ typedef struct {
 } lcu_t;
 
 void uvg_cu_array_copy_from_lcu(cu_array_t* dst, int dst_x, int dst_y, const lcu_t *src);
+void uvg_motion_field_copy_from_lcu(motion_field_t* dst, int dst_x, int dst_y, const lcu_t *src);
 
 int uvg_count_available_edge_cus(const cu_loc_t* const cu_loc, const lcu_t* const lcu, bool left);
 
@@ -128,12 +128,15 @@ static void compute_psnr(const uvg_picture *const src,
     uvg_pixel* rec_ptr = rec->data[c];
     int32_t width = src->width;
     int32_t height = src->height;
-    int32_t stride = src->stride;
+    // The reconstruction may have a wider border than the source.
+    int32_t src_stride = src->stride;
+    int32_t rec_stride = rec->stride;
     int32_t num_pixels = pixels;
     if (c != COLOR_Y) {
       width >>= 1;
       height >>= 1;
-      stride >>= 1;
+      src_stride >>= 1;
+      rec_stride >>= 1;
       num_pixels >>= 2;
     }
     for (int32_t y = 0; y < height; ++y) {
@@ -141,8 +144,8 @@ static void compute_psnr(const uvg_picture *const src,
         const int32_t error = src_ptr[x] - rec_ptr[x];
         sse[c] += error * error;
       }
-      src_ptr += stride;
-      rec_ptr += stride;
+      src_ptr += src_stride;
+      rec_ptr += rec_stride;
     }
 
     // Avoid division by zero
@@ -77,9 +77,15 @@ static int get_max_parallelism(const encoder_control_t *const encoder)
       threads_per_frame = encoder->cfg.tiles_width_count *
                           encoder->cfg.tiles_height_count;
     }
-    // Divide by two since all frames cannot achieve the maximum
-    // parallelism all the time.
-    parallelism = par_frames * threads_per_frame / 2;
+    if (encoder->independent_frames && !encoder->cfg.wpp) {
+      // Frames and tiles are coded as separate jobs that do not wait for
+      // each other, so every frame runs at full parallelism.
+      parallelism = par_frames * threads_per_frame;
+    } else {
+      // Divide by two since all frames cannot achieve the maximum
+      // parallelism all the time.
+      parallelism = par_frames * threads_per_frame / 2;
+    }
 
   } else {
     if (encoder->cfg.wpp) {
@@ -239,6 +245,17 @@ encoder_control_t* uvg_encoder_control_init(const uvg_config *const cfg)
     encoder->cfg.intra_qp_offset = 0;
   }
 
+  // Every frame is an IRAP picture without references. Rate control needs
+  // the statistics of the previous frames, so it keeps the frames in order.
+  encoder->independent_frames = encoder->cfg.intra_period == 1 &&
+                                encoder->cfg.target_bitrate == 0;
+
+  // The validation guarantees WPP without tiles and no cross component ALF.
+  encoder->alf_low_latency = encoder->cfg.alf_type && encoder->cfg.alf_low_latency;
+
+  // All-intra coding has no references to extend.
+  encoder->ref_padding = encoder->cfg.ref_padding && encoder->cfg.intra_period != 1 ? REF_PADDING_LUMA : 0;
+
   encoder->poc_lsb_bits = MAX(4, uvg_math_ceil_log2(encoder->cfg.gop_len * 2 + 1));
 
   encoder->max_inter_ref_lcu.right = 1;
@@ -126,6 +126,16 @@ typedef struct encoder_control_t
 
   threadqueue_queue_t *threadqueue;
 
+  //! All-intra frames without rate control, which can be encoded in parallel.
+  bool independent_frames;
+
+  //! ALF decided per CTU with the filters of the previous frames.
+  bool alf_low_latency;
+
+  //! Pixels the reconstructed pictures are extended by on each side for the
+  //! motion compensation, or 0 if the borders are not extended.
+  int32_t ref_padding;
+
   //! Target average bits per picture.
   double target_avg_bppic;
 
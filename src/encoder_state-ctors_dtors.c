@@ -176,11 +176,14 @@ static int encoder_state_config_tile_init(encoder_state_t * const state,
   state->tile->ver_buf_search = uvg_yuv_t_alloc(luma_size, chroma_size_ver);
 
   if (encoder->cfg.sao_type) {
-    state->tile->hor_buf_before_sao = uvg_yuv_t_alloc(luma_size, chroma_size_hor);
-    state->tile->ver_buf_before_sao = uvg_yuv_t_alloc(luma_size, chroma_size_ver);
+    // One LCU row with a line above and below it. The AVX2 SAO
+    // reconstruction reads up to two extra pixels after the last line.
+    const int width = state->tile->frame->width;
+    const int band_size = (LCU_WIDTH + 2) * width + 2;
+    const int band_size_c = encoder->chroma_format != UVG_CSP_400 ? (LCU_WIDTH_C + 2) * (width / 2) + 2 : 0;
+    state->tile->sao_band_buf = uvg_yuv_t_alloc(band_size, band_size_c);
   } else {
-    state->tile->hor_buf_before_sao = NULL;
-    state->tile->ver_buf_before_sao = NULL;
+    state->tile->sao_band_buf = NULL;
   }
 
   if (encoder->cfg.wpp) {
@@ -199,6 +202,52 @@ static int encoder_state_config_tile_init(encoder_state_t * const state,
     state->tile->wf_jobs = NULL;
     state->tile->wf_recon_jobs = NULL;
   }
+
+  const bool alf_row_jobs = encoder->cfg.wpp && encoder->cfg.alf_type &&
+    encoder->cfg.tiles_width_count == 1 && encoder->cfg.tiles_height_count == 1;
+
+  // The loop filter jobs extend the borders of the rows without ALF too.
+  if (encoder->cfg.wpp && (encoder->cfg.sao_type || alf_row_jobs || encoder->ref_padding)) {
+    int num_rows = state->tile->frame->height_in_lcu;
+    state->tile->loop_filter_jobs = MALLOC(threadqueue_job_t*, num_rows);
+    if (!state->tile->loop_filter_jobs) {
+      printf("Error allocating loop filter jobs array!\n");
+      return 0;
+    }
+    for (int i = 0; i < num_rows; ++i) {
+      state->tile->loop_filter_jobs[i] = NULL;
+    }
+  } else {
+    state->tile->loop_filter_jobs = NULL;
+  }
+
+  if (alf_row_jobs) {
+    int num_rows = state->tile->frame->height_in_lcu;
+    state->tile->alf_filter_jobs = MALLOC(threadqueue_job_t*, num_rows);
+    if (!state->tile->alf_filter_jobs) {
+      printf("Error allocating alf jobs array!\n");
+      return 0;
+    }
+    for (int i = 0; i < num_rows; ++i) {
+      state->tile->alf_filter_jobs[i] = NULL;
+    }
+  } else {
+    state->tile->alf_filter_jobs = NULL;
+  }
+
+  if (alf_row_jobs && encoder->cfg.alf_type == UVG_ALF_FULL) {
+    int num_rows = state->tile->frame->height_in_lcu;
+    state->tile->cc_alf_filter_jobs = MALLOC(threadqueue_job_t*, num_rows);
+    if (!state->tile->cc_alf_filter_jobs) {
+      printf("Error allocating cc alf jobs array!\n");
+      return 0;
+    }
+    for (int i = 0; i < num_rows; ++i) {
+      state->tile->cc_alf_filter_jobs[i] = NULL;
+    }
+  } else {
+    state->tile->cc_alf_filter_jobs = NULL;
+  }
   state->tile->id = encoder->tiles_tile_id[state->tile->lcu_offset_in_ts];
   return 1;
 }
@@ -208,8 +257,7 @@ static void encoder_state_config_tile_finalize(encoder_state_t * const state) {
 
   uvg_yuv_t_free(state->tile->hor_buf_search);
   uvg_yuv_t_free(state->tile->ver_buf_search);
-  uvg_yuv_t_free(state->tile->hor_buf_before_sao);
-  uvg_yuv_t_free(state->tile->ver_buf_before_sao);
+  uvg_yuv_t_free(state->tile->sao_band_buf);
 
   if (state->encoder_control->cfg.wpp) {
     int num_jobs = state->tile->frame->width_in_lcu * state->tile->frame->height_in_lcu;
@@ -218,6 +266,21 @@ static void encoder_state_config_tile_finalize(encoder_state_t * const state) {
       uvg_threadqueue_free_job(&state->tile->wf_recon_jobs[i]);
     }
   }
+  if (state->tile->loop_filter_jobs) {
+    for (int i = 0; i < state->tile->frame->height_in_lcu; ++i) {
+      uvg_threadqueue_free_job(&state->tile->loop_filter_jobs[i]);
+    }
+  }
+  if (state->tile->alf_filter_jobs) {
+    for (int i = 0; i < state->tile->frame->height_in_lcu; ++i) {
+      uvg_threadqueue_free_job(&state->tile->alf_filter_jobs[i]);
+    }
+  }
+  if (state->tile->cc_alf_filter_jobs) {
+    for (int i = 0; i < state->tile->frame->height_in_lcu; ++i) {
+      uvg_threadqueue_free_job(&state->tile->cc_alf_filter_jobs[i]);
+    }
+  }
 
   FREE_POINTER(state->tile->frame->hmvp_lut);
   FREE_POINTER(state->tile->frame->hmvp_size);
@@ -244,6 +307,9 @@ static void encoder_state_config_tile_finalize(encoder_state_t * const state) {
   state->tile->frame = NULL;
   FREE_POINTER(state->tile->wf_jobs);
   FREE_POINTER(state->tile->wf_recon_jobs);
+  FREE_POINTER(state->tile->loop_filter_jobs);
+  FREE_POINTER(state->tile->alf_filter_jobs);
+  FREE_POINTER(state->tile->cc_alf_filter_jobs);
 }
 
 static int encoder_state_config_slice_init(encoder_state_t * const state,
@@ -57,6 +57,7 @@
 #include "reshape.h"
 
 #include "strategies/strategies-picture.h"
+#include "strategies/strategies-reshape.h"
 
 
 /**
@@ -77,122 +78,6 @@ int uvg_encoder_state_match_children_of_previous_frame(encoder_state_t * const s
   return 1;
 }
 
-/**
- * \brief Save edge pixels before SAO to buffers.
- *
- * Copies pixels at the edges of the area that will be filtered with SAO to
- * the given buffers. If deblocking is enabled, the pixels must have been
- * deblocked before this.
- *
- * The saved pixels will be needed later when doing SAO for the neighboring
- * areas.
- */
-static void encoder_state_recdata_before_sao_to_bufs(
-    encoder_state_t * const state,
-    const lcu_order_element_t * const lcu,
-    yuv_t * const hor_buf,
-    yuv_t * const ver_buf)
-{
-  videoframe_t* const frame = state->tile->frame;
-
-  if (hor_buf && lcu->below) {
-    // Copy the bottommost row that will be filtered with SAO to the
-    // horizontal buffer.
-    vector2d_t pos = {
-      .x = lcu->position_px.x,
-      .y = lcu->position_px.y + LCU_WIDTH - SAO_DELAY_PX - 1,
-    };
-    // Copy all pixels that have been deblocked.
-    int length = lcu->size.x - DEBLOCK_DELAY_PX;
-
-    if (!lcu->right) {
-      // If there is no LCU to the right, the last pixels will be
-      // filtered too.
-      length += DEBLOCK_DELAY_PX;
-    }
-
-    if (lcu->left) {
-      // The rightmost pixels of the CTU to the left will also be filtered.
-      pos.x -= DEBLOCK_DELAY_PX;
-      length += DEBLOCK_DELAY_PX;
-    }
-
-    const unsigned from_index = pos.x + pos.y * frame->rec->stride;
-    // NOTE: The horizontal buffer is indexed by
-    //    x_px + y_lcu * frame->width
-    // where x_px is in pixels and y_lcu in number of LCUs.
-    const unsigned to_index = pos.x + lcu->position.y * frame->width;
-
-    uvg_pixels_blit(&frame->rec->y[from_index],
-                    &hor_buf->y[to_index],
-                    length, 1,
-                    frame->rec->stride,
-                    frame->width);
-
-    if (state->encoder_control->chroma_format != UVG_CSP_400) {
-      const unsigned from_index_c = (pos.x / 2) + (pos.y / 2) * frame->rec->stride / 2;
-      const unsigned to_index_c = (pos.x / 2) + lcu->position.y * frame->width / 2;
-
-      uvg_pixels_blit(&frame->rec->u[from_index_c],
-                      &hor_buf->u[to_index_c],
-                      length / 2, 1,
-                      frame->rec->stride / 2,
-                      frame->width / 2);
-      uvg_pixels_blit(&frame->rec->v[from_index_c],
-                      &hor_buf->v[to_index_c],
-                      length / 2, 1,
-                      frame->rec->stride / 2,
-                      frame->width / 2);
-    }
-  }
-
-  if (ver_buf && lcu->right) {
-    // Copy the rightmost column that will be filtered with SAO to the
-    // vertical buffer.
-    vector2d_t pos = {
-      .x = lcu->position_px.x + LCU_WIDTH - SAO_DELAY_PX - 1,
-      .y = lcu->position_px.y,
-    };
-    int length = lcu->size.y - DEBLOCK_DELAY_PX;
-
-    if (!lcu->below) {
-      // If there is no LCU below, the last pixels will be filtered too.
-      length += DEBLOCK_DELAY_PX;
-    }
-
-    if (lcu->above) {
-      // The bottommost pixels of the CTU above will also be filtered.
-      pos.y -= DEBLOCK_DELAY_PX;
-      length += DEBLOCK_DELAY_PX;
-    }
-
-    const unsigned from_index = pos.x + pos.y * frame->rec->stride;
-    // NOTE: The vertical buffer is indexed by
-    //    x_lcu * frame->height + y_px
-    // where x_lcu is in number of LCUs and y_px in pixels.
-    const unsigned to_index = lcu->position.x * frame->height + pos.y;
-
-    uvg_pixels_blit(&frame->rec->y[from_index],
-                    &ver_buf->y[to_index],
-                    1, length,
-                    frame->rec->stride, 1);
-
-    if (state->encoder_control->chroma_format != UVG_CSP_400) {
-      const unsigned from_index_c = (pos.x / 2) + (pos.y / 2) * frame->rec->stride / 2;
-      const unsigned to_index_c = lcu->position.x * frame->height / 2 + pos.y / 2;
-
-      uvg_pixels_blit(&frame->rec->u[from_index_c],
-                      &ver_buf->u[to_index_c],
-                      1, length / 2,
-                      frame->rec->stride / 2, 1);
-      uvg_pixels_blit(&frame->rec->v[from_index_c],
-                      &ver_buf->v[to_index_c],
-                      1, length / 2,
-                      frame->rec->stride / 2, 1);
-    }
-  }
-}
-
 static void encoder_state_recdata_to_bufs(encoder_state_t * const state,
                                           const lcu_order_element_t * const lcu,
                                           yuv_t * const hor_buf,
@@ -309,217 +194,129 @@ static void encoder_state_recdata_to_bufs(encoder_state_t * const state,
 }
 
 /**
- * \brief Do SAO reconstuction for all available pixels.
+ * \brief Do SAO reconstruction for an LCU row.
  *
- * Does SAO reconstruction for all pixels that are available after the
- * given LCU has been deblocked. This means the following pixels:
- *  - bottom-right block of SAO_DELAY_PX times SAO_DELAY_PX in the lcu to
- *    the left and up
- *  - the rightmost SAO_DELAY_PX pixels of the LCU to the left (excluding
- *    the bottommost pixel)
- *  - the bottommost SAO_DELAY_PX pixels of the LCU above (excluding the
- *    rightmost pixels)
- *  - all pixels inside the LCU, excluding the rightmost SAO_DELAY_PX and
- *    bottommost SAO_DELAY_PX
+ * The LCU row is copied to the band buffer of the tile before filtering it
+ * in place. The SAO of the row reads the deblocked pixels of a line above
+ * and below the row, so it can be done when the LCU row below has been
+ * deblocked. The line above is the last line of the previous row, which
+ * the previous row left in the buffer before it was filtered. Therefore
+ * the rows of a tile must be filtered in order.
+ *
+ * \param state  State that coded the LCU row.
+ * \param lcu    Any LCU of the row.
  */
-static void encoder_sao_reconstruct(const encoder_state_t *const state,
-                                    const lcu_order_element_t *const lcu)
+static void encoder_sao_reconstruct_ctu_row(const encoder_state_t *const state,
+                                            const lcu_order_element_t *const lcu)
 {
   videoframe_t *const frame = state->tile->frame;
+  yuv_t *const band = state->tile->sao_band_buf;
+  const bool has_chroma = state->encoder_control->chroma_format != UVG_CSP_400;
 
+  const int width = frame->width;
+  const int width_c = frame->width / 2;
+  const int y = lcu->position_px.y;
+  const int height = lcu->size.y;
 
-  // Temporary buffers for SAO input pixels. The buffers cover the pixels
-  // inside the LCU (LCU_WIDTH x LCU_WIDTH), SAO_DELAY_PX wide bands to the
-  // left and above the LCU, and one pixel border on the left and top
-  // sides. We add two extra pixels to the buffers because the AVX2 SAO
-  // reconstruction reads up to two extra bytes when using edge SAO in the
-  // horizontal direction.
-#define SAO_BUF_WIDTH   (1 + SAO_DELAY_PX   + LCU_WIDTH)
-#define SAO_BUF_WIDTH_C (1 + SAO_DELAY_PX/2 + LCU_WIDTH_C)
-  uvg_pixel sao_buf_y_array[SAO_BUF_WIDTH   * SAO_BUF_WIDTH   + 2];
-  uvg_pixel sao_buf_u_array[SAO_BUF_WIDTH_C * SAO_BUF_WIDTH_C + 2];
-  uvg_pixel sao_buf_v_array[SAO_BUF_WIDTH_C * SAO_BUF_WIDTH_C + 2];
-
-  // Pointers to the top-left pixel of the LCU in the buffers.
-  uvg_pixel *const sao_buf_y = &sao_buf_y_array[(SAO_DELAY_PX + 1) * (SAO_BUF_WIDTH + 1)];
-  uvg_pixel *const sao_buf_u = &sao_buf_u_array[(SAO_DELAY_PX/2 + 1) * (SAO_BUF_WIDTH_C + 1)];
-  uvg_pixel *const sao_buf_v = &sao_buf_v_array[(SAO_DELAY_PX/2 + 1) * (SAO_BUF_WIDTH_C + 1)];
-
-  const int x_offsets[3] = {
-    // If there is an lcu to the left, we need to filter its rightmost
-    // pixels.
-    lcu->left ? -SAO_DELAY_PX : 0,
-    0,
-    // If there is an lcu to the right, the rightmost pixels of this LCU
-    // are filtered when filtering that LCU. Otherwise we filter them now.
-    lcu->size.x - (lcu->right ? SAO_DELAY_PX : 0),
-  };
-
-  const int y_offsets[3] = {
-    // If there is an lcu above, we need to filter its bottommost pixels.
-    lcu->above ? -SAO_DELAY_PX : 0,
-    0,
-    // If there is an lcu below, the bottommost pixels of this LCU are
-    // filtered when filtering that LCU. Otherwise we filter them now.
-    lcu->size.y - (lcu->below ? SAO_DELAY_PX : 0),
-  };
-
-  // Number of pixels around the block that need to be copied to the
-  // buffers.
-  const int border_left  = lcu->left  ? 1 : 0;
-  const int border_right = lcu->right ? 1 : 0;
-  const int border_above = lcu->above ? 1 : 0;
-  const int border_below = lcu->below ? 1 : 0;
-
-  // Index of the pixel at the intersection of the top and left borders.
-  const int border_index = (x_offsets[0] - border_left) +
-                           (y_offsets[0] - border_above) * SAO_BUF_WIDTH;
-  const int border_index_c = (x_offsets[0]/2 - border_left) +
-                             (y_offsets[0]/2 - border_above) * SAO_BUF_WIDTH_C;
-  // Width and height of the whole area to filter.
-  const int width  = x_offsets[2] - x_offsets[0];
-  const int height = y_offsets[2] - y_offsets[0];
+  // Pointers to the first line of the LCU row in the buffer.
+  uvg_pixel *const band_y = &band->y[width];
+  uvg_pixel *const band_u = has_chroma ? &band->u[width_c] : NULL;
+  uvg_pixel *const band_v = has_chroma ? &band->v[width_c] : NULL;
 
-  // Copy bordering pixels from above and left to buffers.
   if (lcu->above) {
-    const int from_index = (lcu->position_px.x + x_offsets[0] - border_left) +
-                           (lcu->position.y - 1) * frame->width;
-    uvg_pixels_blit(&state->tile->hor_buf_before_sao->y[from_index],
-                    &sao_buf_y[border_index],
-                    width + border_left + border_right,
-                    1,
-                    frame->width,
-                    SAO_BUF_WIDTH);
-    if (state->encoder_control->chroma_format != UVG_CSP_400) {
-      const int from_index_c = (lcu->position_px.x + x_offsets[0])/2 - border_left +
-                               (lcu->position.y - 1) * frame->width/2;
-      uvg_pixels_blit(&state->tile->hor_buf_before_sao->u[from_index_c],
-                      &sao_buf_u[border_index_c],
-                      width/2 + border_left + border_right,
-                      1,
-                      frame->width/2,
-                      SAO_BUF_WIDTH_C);
-      uvg_pixels_blit(&state->tile->hor_buf_before_sao->v[from_index_c],
-                      &sao_buf_v[border_index_c],
-                      width/2 + border_left + border_right,
-                      1,
-                      frame->width/2,
-                      SAO_BUF_WIDTH_C);
-    }
-  }
-  if (lcu->left) {
-    const int from_index = (lcu->position.x - 1) * frame->height +
-                           (lcu->position_px.y + y_offsets[0] - border_above);
-    uvg_pixels_blit(&state->tile->ver_buf_before_sao->y[from_index],
-                    &sao_buf_y[border_index],
-                    1,
-                    height + border_above + border_below,
-                    1,
-                    SAO_BUF_WIDTH);
-    if (state->encoder_control->chroma_format != UVG_CSP_400) {
-      const int from_index_c = (lcu->position.x - 1) * frame->height/2 +
-                               (lcu->position_px.y + y_offsets[0])/2 - border_above;
-      uvg_pixels_blit(&state->tile->ver_buf_before_sao->u[from_index_c],
-                      &sao_buf_u[border_index_c],
-                      1,
-                      height/2 + border_above + border_below,
-                      1,
-                      SAO_BUF_WIDTH_C);
-      uvg_pixels_blit(&state->tile->ver_buf_before_sao->v[from_index_c],
-                      &sao_buf_v[border_index_c],
-                      1,
-                      height/2 + border_above + border_below,
-                      1,
-                      SAO_BUF_WIDTH_C);
+    // The row above had the full height, so its last line is at the
+    // position of the last line of this row.
+    memcpy(&band_y[-width], &band_y[(LCU_WIDTH - 1) * width], width * sizeof(uvg_pixel));
+    if (has_chroma) {
+      memcpy(&band_u[-width_c], &band_u[(LCU_WIDTH_C - 1) * width_c], width_c * sizeof(uvg_pixel));
+      memcpy(&band_v[-width_c], &band_v[(LCU_WIDTH_C - 1) * width_c], width_c * sizeof(uvg_pixel));
     }
   }
-  // Copy pixels that will be filtered and bordering pixels from right and
-  // below.
-  const int from_index = (lcu->position_px.x + x_offsets[0]) +
-                         (lcu->position_px.y + y_offsets[0]) * frame->rec->stride;
-  const int to_index = x_offsets[0] + y_offsets[0] * SAO_BUF_WIDTH;
-  uvg_pixels_blit(&frame->rec->y[from_index],
-                  &sao_buf_y[to_index],
-                  width + border_right,
-                  height + border_below,
-                  frame->rec->stride,
-                  SAO_BUF_WIDTH);
-  if (state->encoder_control->chroma_format != UVG_CSP_400) {
-    const int from_index_c = (lcu->position_px.x + x_offsets[0])/2 +
-                             (lcu->position_px.y + y_offsets[0])/2 * frame->rec->stride/2;
-    const int to_index_c = x_offsets[0]/2 + y_offsets[0]/2 * SAO_BUF_WIDTH_C;
-    uvg_pixels_blit(&frame->rec->u[from_index_c],
-                    &sao_buf_u[to_index_c],
-                    width/2 + border_right,
-                    height/2 + border_below,
-                    frame->rec->stride/2,
-                    SAO_BUF_WIDTH_C);
-    uvg_pixels_blit(&frame->rec->v[from_index_c],
-                    &sao_buf_v[to_index_c],
-                    width/2 + border_right,
-                    height/2 + border_below,
-                    frame->rec->stride/2,
-                    SAO_BUF_WIDTH_C);
-  }
-
-  // We filter the pixels in four parts:
-  //  1. Pixels that belong to the LCU above and to the left
-  //  2. Pixels that belong to the LCU above
-  //  3. Pixels that belong to the LCU to the left
-  //  4. Pixels that belong to the current LCU
-  for (int y_offset_index = 0; y_offset_index < 2; y_offset_index++) {
-    for (int x_offset_index = 0; x_offset_index < 2; x_offset_index++) {
-      const int x = x_offsets[x_offset_index];
-      const int y = y_offsets[y_offset_index];
-      const int width = x_offsets[x_offset_index + 1] - x;
-      const int height = y_offsets[y_offset_index + 1] - y;
-
-      if (width == 0 || height == 0) continue;
-
-      const int lcu_x = (lcu->position_px.x + x) >> LOG2_LCU_WIDTH;
-      const int lcu_y = (lcu->position_px.y + y) >> LOG2_LCU_WIDTH;
-      const int lcu_index = lcu_x + lcu_y * frame->width_in_lcu;
-      const sao_info_t *sao_luma   = &frame->sao_luma[lcu_index];
-      const sao_info_t *sao_chroma = &frame->sao_chroma[lcu_index];
 
-      uvg_sao_reconstruct(state,
-                          &sao_buf_y[x + y * SAO_BUF_WIDTH],
-                          SAO_BUF_WIDTH,
-                          lcu->position_px.x + x,
-                          lcu->position_px.y + y,
-                          width,
-                          height,
-                          sao_luma,
-                          COLOR_Y);
+  // Copy the row and the line below it.
+  const int border_below = lcu->below ? 1 : 0;
+  uvg_pixels_blit(&frame->rec->y[y * frame->rec->stride],
+                  band_y,
+                  width, height + border_below,
+                  frame->rec->stride, width);
+  if (has_chroma) {
+    uvg_pixels_blit(&frame->rec->u[y / 2 * frame->rec->stride / 2],
+                    band_u,
+                    width_c, height / 2 + border_below,
+                    frame->rec->stride / 2, width_c);
+    uvg_pixels_blit(&frame->rec->v[y / 2 * frame->rec->stride / 2],
+                    band_v,
+                    width_c, height / 2 + border_below,
+                    frame->rec->stride / 2, width_c);
+  }
+
+  const int lcu_row_index = lcu->position.y * frame->width_in_lcu;
+  for (int x = 0; x < width; x += LCU_WIDTH) {
+    const int lcu_width = MIN(LCU_WIDTH, width - x);
+    const int lcu_index = lcu_row_index + x / LCU_WIDTH;
+    const sao_info_t *sao_luma   = &frame->sao_luma[lcu_index];
+    const sao_info_t *sao_chroma = &frame->sao_chroma[lcu_index];
+
+    uvg_sao_reconstruct(state,
+                        &band_y[x],
+                        width,
+                        x,
+                        y,
+                        lcu_width,
+                        height,
+                        sao_luma,
+                        COLOR_Y);
 
-      if (state->encoder_control->chroma_format != UVG_CSP_400) {
-        // Coordinates in chroma pixels.
-        int x_c = x >> 1;
-        int y_c = y >> 1;
-
-        uvg_sao_reconstruct(state,
-                            &sao_buf_u[x_c + y_c * SAO_BUF_WIDTH_C],
-                            SAO_BUF_WIDTH_C,
-                            lcu->position_px.x / 2 + x_c,
-                            lcu->position_px.y / 2 + y_c,
-                            width / 2,
-                            height / 2,
-                            sao_chroma,
-                            COLOR_U);
-        uvg_sao_reconstruct(state,
-                            &sao_buf_v[x_c + y_c * SAO_BUF_WIDTH_C],
-                            SAO_BUF_WIDTH_C,
-                            lcu->position_px.x / 2 + x_c,
-                            lcu->position_px.y / 2 + y_c,
-                            width / 2,
-                            height / 2,
-                            sao_chroma,
-                            COLOR_V);
-      }
+    if (has_chroma) {
+      uvg_sao_reconstruct(state,
+                          &band_u[x / 2],
+                          width_c,
+                          x / 2,
+                          y / 2,
+                          lcu_width / 2,
+                          height / 2,
+                          sao_chroma,
+                          COLOR_U);
+      uvg_sao_reconstruct(state,
+                          &band_v[x / 2],
+                          width_c,
+                          x / 2,
+                          y / 2,
+                          lcu_width / 2,
+                          height / 2,
+                          sao_chroma,
+                          COLOR_V);
     }
   }
 }
 
+/**
+ * \brief Extend the borders of the reconstruction of LCU rows for the frames
+ * referring to it.
+ *
+ * Must be called by the job that makes the pixels of the rows final, because
+ * the following frames wait for that job before reading the rows.
+ *
+ * \param state      State that coded the LCU rows.
+ * \param first_row  Index of the first LCU row in the tile.
+ * \param last_row   Index of the last LCU row in the tile.
+ */
+static void encoder_state_extend_ctu_rows(const encoder_state_t *const state,
+                                          const int first_row,
+                                          const int last_row)
+{
+  const videoframe_t *const frame = state->tile->frame;
+  const int y = first_row * LCU_WIDTH;
+  const int y_end = MIN((last_row + 1) * LCU_WIDTH, frame->height);
+
+  uvg_image_extend_borders(frame->rec->base_image,
+                           state->tile->offset_x,
+                           state->tile->offset_y + y,
+                           frame->width,
+                           y_end - y,
+                           state->encoder_control->ref_padding);
+}
+
 static void encode_sao_color(encoder_state_t * const state, sao_info_t *sao,
                              color_t color_i)
 {
@@ -826,16 +623,18 @@ static void encoder_state_worker_encode_lcu_search(void * opaque)
     set_cu_qps(state, &cu_loc, &last_qp, &prev_qp, 0);
   }
 
+  if (encoder->cfg.deblock_enable) {
+    // The CUs and the QPs of the LCU are final, so the boundary strengths
+    // and the filter lengths can be stored for the deblocking.
+    uvg_filter_deblock_map_lcu(state, lcu->position_px.x, lcu->position_px.y);
+  }
+
   if (state->tile->frame->lmcs_aps->m_sliceReshapeInfo.sliceReshaperEnableFlag) {
-    uvg_pixel* luma = &state->tile->frame->rec->y[lcu->position_px.x + lcu->position_px.y * state->tile->frame->rec->stride];
-    for (int y = 0; y < LCU_WIDTH; y++) {
-      if (lcu->position_px.y+y < state->tile->frame->rec->height) {
-        for (int x = 0; x < LCU_WIDTH; x++) {
-          if (lcu->position_px.x+x < state->tile->frame->rec->width) luma[x] = state->tile->frame->lmcs_aps->m_invLUT[luma[x]];
-        }
-      }
-      luma += state->tile->frame->rec->stride;
-    }
+    const uvg_picture *rec = state->tile->frame->rec;
+    uvg_pixel* luma = &rec->y[lcu->position_px.x + lcu->position_px.y * rec->stride];
+    const int width = MIN(LCU_WIDTH, rec->width - lcu->position_px.x);
+    const int height = MIN(LCU_WIDTH, rec->height - lcu->position_px.y);
+    uvg_lmcs_map_luma(luma, rec->stride, luma, rec->stride, width, height, state->tile->frame->lmcs_aps->m_invLUT);
   }
 
   if (encoder->cfg.deblock_enable) {
@@ -843,18 +642,17 @@ static void encoder_state_worker_encode_lcu_search(void * opaque)
   }
 
   if (encoder->cfg.sao_type) {
-    // Save the post-deblocking but pre-SAO pixels of the LCU to a buffer
-    // so that they can be used in SAO reconstruction later.
-    encoder_state_recdata_before_sao_to_bufs(state,
-      lcu,
-      state->tile->hor_buf_before_sao,
-      state->tile->ver_buf_before_sao);
+    // The SAO parameters are coded with the LCU, but the reconstruction is
+    // done for the whole LCU row when the row below has been deblocked.
     uvg_sao_search_lcu(state, lcu->position.x, lcu->position.y);
-    encoder_sao_reconstruct(state, lcu);
   }
 
-  // Do simulated bitstream writing to update the cabac contexts
-  if (encoder->cfg.alf_type) {
+  if (encoder->alf_low_latency) {
+    // The filters are known already, so the LCU is coded with real cabac
+    // contexts and only the ALF parameters of the LCU are decided here.
+    uvg_alf_enc_low_latency_ctu(state, lcu->position.x, lcu->position.y);
+  } else if (encoder->cfg.alf_type) {
+    // Do simulated bitstream writing to update the cabac contexts
     state->cabac.only_count = 1;
     encoder_state_worker_encode_lcu_bitstream(opaque);
   }
@@ -994,6 +792,89 @@ void uvg_alf_enc_process_job(void* opaque) {
   
   uvg_alf_enc_process(state);
 
+  if (state->encoder_control->ref_padding) {
+    encoder_state_extend_ctu_rows(state, 0, state->tile->frame->height_in_lcu - 1);
+  }
+
+  encoder_state_t* parent = state;
+  while (parent->parent) parent = parent->parent;
+
+  // If ALF was used the bitstream coding was simulated in search, reset the cabac/stream
+  encoder_state_init_children_after_simulation(parent);
+}
+
+/**
+ * \brief Filter an LCU row after the LCU row below it has been deblocked.
+ *
+ * Does the SAO reconstruction of the row. The pixels of the row above are
+ * final after that, so the ALF classification and statistics of the row
+ * above are derived by the same job, or the row is prepared for the
+ * filtering in the low latency mode. The last row does the ALF of its own
+ * row too. Without ALF row jobs the row is final and its borders are
+ * extended.
+ */
+static void encoder_state_worker_loop_filter_ctu_row(void *opaque)
+{
+  const lcu_order_element_t * const lcu = opaque;
+  encoder_state_t * const state = lcu->encoder_state;
+
+  if (state->encoder_control->cfg.sao_type) {
+    encoder_sao_reconstruct_ctu_row(state, lcu);
+  }
+
+  if (state->tile->alf_filter_jobs) {
+    const int first_row = lcu->above ? lcu->position.y - 1 : lcu->position.y;
+    const int last_row = lcu->below ? lcu->position.y - 1 : lcu->position.y;
+    for (int row = first_row; row <= last_row; ++row) {
+      if (state->encoder_control->alf_low_latency) {
+        uvg_alf_enc_low_latency_ctu_row(state, row);
+      } else {
+        uvg_alf_enc_ctu_row_stats(state, row);
+      }
+    }
+  } else if (state->encoder_control->ref_padding) {
+    encoder_state_extend_ctu_rows(state, lcu->position.y, lcu->position.y);
+  }
+}
+
+static void encoder_state_worker_alf_derive(void *opaque)
+{
+  uvg_alf_enc_derive((encoder_state_t *)opaque);
+}
+
+static void encoder_state_worker_alf_filter_ctu_row(void *opaque)
+{
+  const lcu_order_element_t * const lcu = opaque;
+  uvg_alf_enc_filter_ctu_row(lcu->encoder_state, lcu->position.y);
+
+  // With the cross component ALF the chroma of the row changes once more.
+  if (lcu->encoder_state->encoder_control->ref_padding && !lcu->encoder_state->tile->cc_alf_filter_jobs) {
+    encoder_state_extend_ctu_rows(lcu->encoder_state, lcu->position.y, lcu->position.y);
+  }
+}
+
+static void encoder_state_worker_cc_alf_filter_ctu_row(void *opaque)
+{
+  const lcu_order_element_t * const lcu = opaque;
+  uvg_alf_enc_cc_filter_ctu_row(lcu->encoder_state, lcu->position.y);
+
+  if (lcu->encoder_state->encoder_control->ref_padding) {
+    encoder_state_extend_ctu_rows(lcu->encoder_state, lcu->position.y, lcu->position.y);
+  }
+}
+
+static void encoder_state_worker_alf_low_latency_finish(void *opaque)
+{
+  // The bitstream was not simulated, so there is nothing to reset.
+  uvg_alf_enc_low_latency_finish((encoder_state_t *)opaque);
+}
+
+static void encoder_state_worker_alf_finish(void *opaque)
+{
+  encoder_state_t* const state = (encoder_state_t* const)opaque;
+
+  uvg_alf_enc_finish(state);
+
   encoder_state_t* parent = state;
   while (parent->parent) parent = parent->parent;
 
@@ -1001,6 +882,174 @@ void uvg_alf_enc_process_job(void* opaque) {
   encoder_state_init_children_after_simulation(parent);
 }
 
+/**
+ * \brief Add the dependencies of the ALF jobs of the LCU rows and submit them.
+ *
+ * The classification and statistics of an LCU row are derived by the loop
+ * filter job of the row below, because the filters read a few pixels over
+ * the row boundary. Only the filter derivation is done for the whole frame
+ * at once. The finishing job in tqj_alf_process waits for the filtering of
+ * every row and derives the cross component ALF. The cross component ALF of
+ * each row is then applied by a job of its own.
+ *
+ * In the low latency mode the filters are known before the frame is coded,
+ * so there is no derivation and a row is filtered as soon as it has been
+ * prepared. The rows are filtered in order so that the filtering of a row
+ * tells that the rows above it are final too.
+ *
+ * \param state        Frame level state.
+ * \param child_state  First leaf state, used for the frame level stages.
+ */
+static void encoder_state_submit_alf_jobs(encoder_state_t * const state, encoder_state_t * const child_state)
+{
+  encoder_state_config_tile_t * const tile = child_state->tile;
+  threadqueue_queue_t * const threadqueue = state->encoder_control->threadqueue;
+  const int height_in_lcu = tile->frame->height_in_lcu;
+
+  if (state->encoder_control->alf_low_latency) {
+    for (int row = 0; row < height_in_lcu; ++row) {
+      const int row_below = MIN(row + 1, height_in_lcu - 1);
+      uvg_threadqueue_job_dep_add(tile->alf_filter_jobs[row], tile->loop_filter_jobs[row_below]);
+      if (row > 0) {
+        uvg_threadqueue_job_dep_add(tile->alf_filter_jobs[row], tile->alf_filter_jobs[row - 1]);
+      }
+      uvg_threadqueue_submit(threadqueue, tile->alf_filter_jobs[row]);
+      uvg_threadqueue_job_dep_add(state->tqj_alf_process, tile->alf_filter_jobs[row]);
+    }
+    return;
+  }
+
+  threadqueue_job_t *derive_job = uvg_threadqueue_job_create(encoder_state_worker_alf_derive, child_state);
+  uvg_threadqueue_job_dep_add(derive_job, tile->loop_filter_jobs[height_in_lcu - 1]);
+  uvg_threadqueue_submit(threadqueue, derive_job);
+
+  for (int row = 0; row < height_in_lcu; ++row) {
+    uvg_threadqueue_job_dep_add(tile->alf_filter_jobs[row], derive_job);
+    uvg_threadqueue_submit(threadqueue, tile->alf_filter_jobs[row]);
+    uvg_threadqueue_job_dep_add(state->tqj_alf_process, tile->alf_filter_jobs[row]);
+  }
+  uvg_threadqueue_free_job(&derive_job);
+
+  if (tile->cc_alf_filter_jobs) {
+    for (int row = 0; row < height_in_lcu; ++row) {
+      uvg_threadqueue_job_dep_add(tile->cc_alf_filter_jobs[row], state->tqj_alf_process);
+      uvg_threadqueue_submit(threadqueue, tile->cc_alf_filter_jobs[row]);
+    }
+  }
+}
+
+/**
+ * \brief Return whether the ALF of the frame is done with the LCU row jobs.
+ *
+ * The row jobs are created by the wavefront jobs, so a frame with a single
+ * LCU row is filtered by the frame level job instead.
+ *
+ * \param leaf  First leaf state of the frame.
+ */
+static bool encoder_state_uses_alf_row_jobs(const encoder_state_t * const leaf)
+{
+  return leaf->tile->alf_filter_jobs &&
+         leaf->type == ENCODER_STATE_TYPE_WAVEFRONT_ROW &&
+         leaf->parent->children[1].encoder_control;
+}
+
+/**
+ * \brief Return whether the frames are divided into more than one tile.
+ */
+static bool encoder_state_has_tiles(const encoder_state_t * const state)
+{
+  return state->encoder_control->cfg.tiles_width_count > 1 ||
+         state->encoder_control->cfg.tiles_height_count > 1;
+}
+
+/**
+ * \brief Make a job wait until the pixels of a reference frame are final up
+ * to an LCU.
+ *
+ * With SAO or ALF the LCU rows are filtered in place by the row jobs after
+ * the reconstruction, so the reconstruction of an LCU is not final yet. The
+ * SAO of a row is done by its loop filter job, and the rows are filtered in
+ * order. With ALF the row is final after its ALF filter job. The low
+ * latency mode filters the rows in order, but otherwise the rows are
+ * filtered in parallel and the first LCU row waits for the rows above the
+ * LCU too. The rows after it get them through the wavefront dependencies.
+ *
+ * The cross component ALF of the rows is derived for the whole frame after
+ * the ALF, and then applied to the rows in parallel, so with it the rows
+ * are final after their cross component ALF jobs.
+ *
+ * The motion vectors may point to the other tiles of the reference frame,
+ * which the dependencies of the LCUs do not cover, so with tiles the job
+ * waits until the whole frame has been written.
+ *
+ * \param job        Job to add the dependencies to.
+ * \param ref_state  State coding the reference frame.
+ * \param lcu        LCU coded by the job.
+ * \param dep_lcu    LCU at the same position as the last LCU of the
+ *                   reference frame that the job refers to.
+ */
+static void encoder_state_add_ref_lcu_deps(threadqueue_job_t * const job,
+                                           const encoder_state_t * const ref_state,
+                                           const lcu_order_element_t * const lcu,
+                                           const lcu_order_element_t * const dep_lcu)
+{
+  threadqueue_job_t * const * const filter_jobs = ref_state->tile->cc_alf_filter_jobs ?
+    ref_state->tile->cc_alf_filter_jobs : ref_state->tile->alf_filter_jobs;
+
+  if (encoder_state_has_tiles(ref_state)) {
+    const encoder_state_t *frame_state = ref_state;
+    while (frame_state->parent) frame_state = frame_state->parent;
+    if (frame_state->tqj_bitstream_written) {
+      uvg_threadqueue_job_dep_add(job, frame_state->tqj_bitstream_written);
+    }
+    return;
+  }
+
+  if (!filter_jobs) {
+    if (ref_state->tile->loop_filter_jobs) {
+      uvg_threadqueue_job_dep_add(job, ref_state->tile->loop_filter_jobs[dep_lcu->position.y]);
+    } else {
+      uvg_threadqueue_job_dep_add(job, ref_state->tile->wf_recon_jobs[dep_lcu->id]);
+    }
+    return;
+  }
+
+  int first_row = dep_lcu->position.y;
+  if (!ref_state->encoder_control->alf_low_latency && lcu->above == NULL) {
+    first_row = 0;
+  }
+  for (int row = first_row; row <= dep_lcu->position.y; ++row) {
+    uvg_threadqueue_job_dep_add(job, filter_jobs[row]);
+  }
+}
+
+/**
+ * \brief Create and submit the loop filter job of an LCU row.
+ *
+ * The job waits for the reconstruction of the last LCU of the row below,
+ * which finishes the deblocking of the row, and for the job of the row
+ * above, which leaves the line above the row in the SAO buffer.
+ *
+ * \param lcu        Last LCU of the row.
+ * \param recon_job  Reconstruction job of the last LCU of the row below, or
+ *                   of the row itself for the last row.
+ */
+static void encoder_state_add_loop_filter_job(const lcu_order_element_t * const lcu,
+                                              threadqueue_job_t * const recon_job)
+{
+  encoder_state_t * const state = lcu->encoder_state;
+  threadqueue_job_t ** const jobs = state->tile->loop_filter_jobs;
+  const int row = lcu->position.y;
+
+  uvg_threadqueue_free_job(&jobs[row]);
+  jobs[row] = uvg_threadqueue_job_create(encoder_state_worker_loop_filter_ctu_row, (void*)lcu);
+  uvg_threadqueue_job_dep_add(jobs[row], recon_job);
+  if (lcu->above) {
+    uvg_threadqueue_job_dep_add(jobs[row], jobs[row - 1]);
+  }
+  uvg_threadqueue_submit(state->encoder_control->threadqueue, jobs[row]);
+}
+
 static void encoder_state_encode_leaf(encoder_state_t * const state)
 {
   const encoder_control_t * const encoder = state->encoder_control;
@@ -1030,18 +1079,37 @@ static void encoder_state_encode_leaf(encoder_state_t * const state)
   bool use_parallel_encoding = (wavefront && state->parent->children[1].encoder_control);
   if (!use_parallel_encoding) {
     
-    // Encode every LCU in order and perform SAO reconstruction after every
-    // frame is encoded. Deblocking and SAO search is done during LCU encoding.
+    // Encode every LCU in order and perform SAO reconstruction of an LCU row
+    // after the row below it is encoded. Deblocking and SAO search is done
+    // during LCU encoding.
     for (uint32_t i = 0; i < state->lcu_order_count; ++i) {
+      const lcu_order_element_t * const lcu = &state->lcu_order[i];
       encoder_state_worker_encode_lcu_search(&state->lcu_order[i]);
       // Without alf we can code the bitstream right after each LCU to update cabac contexts
-      if (encoder->cfg.alf_type == 0) {
+      if (encoder->cfg.alf_type == 0 || encoder->alf_low_latency) {
         encoder_state_worker_encode_lcu_bitstream(&state->lcu_order[i]);
       }
+
+      if (encoder->cfg.sao_type && lcu->right == NULL) {
+        if (lcu->above) {
+          encoder_sao_reconstruct_ctu_row(state, lcu->above);
+        }
+        if (lcu->below == NULL) {
+          encoder_sao_reconstruct_ctu_row(state, lcu);
+        }
+      }
     }
 
     //Encode ALF
-    if (encoder->cfg.alf_type) {
+    if (encoder->alf_low_latency) {
+      for (uint32_t i = 0; i < state->lcu_order_count; ++i) {
+        if (state->lcu_order[i].left == NULL) {
+          uvg_alf_enc_low_latency_ctu_row(state, state->lcu_order[i].position.y);
+          uvg_alf_enc_filter_ctu_row(state, state->lcu_order[i].position.y);
+        }
+      }
+      uvg_alf_enc_low_latency_finish(state);
+    } else if (encoder->cfg.alf_type) {
       uvg_alf_enc_process(state);
       // If ALF was used the bitstream coding was simulated in search, reset the cabac/stream
       // And write the actual bitstream
@@ -1051,6 +1119,12 @@ static void encoder_state_encode_leaf(encoder_state_t * const state)
       }
     }
 
+    if (encoder->ref_padding) {
+      // The loop filters do not cross the leaf, so its pixels are final.
+      encoder_state_extend_ctu_rows(state,
+                                    state->lcu_order[0].position.y,
+                                    state->lcu_order[state->lcu_order_count - 1].position.y);
+    }
     
   } else {
     // Add each LCU in the wavefront row as it's own job to the queue.
@@ -1113,11 +1187,11 @@ static void encoder_state_encode_leaf(encoder_state_t * const state)
           for (int i = 0; dep_lcu->right && i < ctrl->max_inter_ref_lcu.right + 1; i++) {
             dep_lcu = dep_lcu->right;
           }
-          uvg_threadqueue_job_dep_add(job[0], ref_state->tile->wf_recon_jobs[dep_lcu->id]);
+          encoder_state_add_ref_lcu_deps(job[0], ref_state, lcu, dep_lcu);
 
           //TODO: Preparation for the lock free implementation of the new rc
           if (ref_state->frame->slicetype == UVG_SLICE_I && ref_state->frame->num != 0 && state->encoder_control->cfg.owf > 1 && true) {
-            uvg_threadqueue_job_dep_add(job[0], ref_state->previous_encoder_state->tile->wf_recon_jobs[dep_lcu->id]);
+            encoder_state_add_ref_lcu_deps(job[0], ref_state->previous_encoder_state, lcu, dep_lcu);
           }
 
           // Very spesific bug that happens when owf length is longer than the
@@ -1132,11 +1206,11 @@ static void encoder_state_encode_leaf(encoder_state_t * const state)
             while (ref_state->frame->poc != state->frame->poc - state->encoder_control->cfg.gop_len){
               ref_state = ref_state->previous_encoder_state;
             }
-            uvg_threadqueue_job_dep_add(job[0], ref_state->tile->wf_recon_jobs[dep_lcu->id]);
+            encoder_state_add_ref_lcu_deps(job[0], ref_state, lcu, dep_lcu);
           }
         }
         
-        if (state->encoder_control->cfg.alf_type) {
+        if (state->encoder_control->cfg.alf_type && !ctrl->alf_low_latency) {
           encoder_state_t* parent = state;
           while (parent->parent) parent = parent->parent;
 
@@ -1155,6 +1229,17 @@ static void encoder_state_encode_leaf(encoder_state_t * const state)
 
           uvg_threadqueue_job_dep_add(state->tile->wf_jobs[lcu->id], parent->tqj_alf_process);
           uvg_threadqueue_job_dep_add(parent->tqj_alf_process, state->tile->wf_recon_jobs[lcu->id]);
+
+          // The row jobs get their dependencies when every row has been added.
+          if (state->tile->alf_filter_jobs && lcu->left == NULL) {
+            const int row = lcu->position.y;
+            uvg_threadqueue_free_job(&state->tile->alf_filter_jobs[row]);
+            state->tile->alf_filter_jobs[row] = uvg_threadqueue_job_create(encoder_state_worker_alf_filter_ctu_row, (void*)lcu);
+            if (state->tile->cc_alf_filter_jobs) {
+              uvg_threadqueue_free_job(&state->tile->cc_alf_filter_jobs[row]);
+              state->tile->cc_alf_filter_jobs[row] = uvg_threadqueue_job_create(encoder_state_worker_cc_alf_filter_ctu_row, (void*)lcu);
+            }
+          }
         } else {
 
           // Add local WPP dependancy to the LCU on the left.
@@ -1169,6 +1254,21 @@ static void encoder_state_encode_leaf(encoder_state_t * const state)
           uvg_threadqueue_submit(state->encoder_control->threadqueue, job[0]);
 
           uvg_threadqueue_job_dep_add(state->tile->wf_jobs[lcu->id], state->tile->wf_recon_jobs[lcu->id]);
+
+          if (ctrl->alf_low_latency) {
+            encoder_state_t* parent = state;
+            while (parent->parent) parent = parent->parent;
+
+            // The filters of the next frames are derived when every LCU has
+            // been written.
+            uvg_threadqueue_job_dep_add(parent->tqj_alf_process, state->tile->wf_jobs[lcu->id]);
+
+            if (lcu->left == NULL) {
+              const int row = lcu->position.y;
+              uvg_threadqueue_free_job(&state->tile->alf_filter_jobs[row]);
+              state->tile->alf_filter_jobs[row] = uvg_threadqueue_job_create(encoder_state_worker_alf_filter_ctu_row, (void*)lcu);
+            }
+          }
 #ifdef UVG_DEBUG_PRINT_CABAC
           // Ensures that the ctus are encoded in raster scan order
           if(i >= state->tile->frame->width_in_lcu) {
@@ -1177,6 +1277,25 @@ static void encoder_state_encode_leaf(encoder_state_t * const state)
 #endif
         }
 
+        if (state->tile->loop_filter_jobs && lcu->right == NULL) {
+          // The deblocking of the row finishes the pixels of the row above.
+          if (lcu->above) {
+            encoder_state_add_loop_filter_job(lcu->above, job[0]);
+          }
+          if (lcu->below == NULL) {
+            encoder_state_add_loop_filter_job(lcu, job[0]);
+
+            // The tile is done when the last row has been filtered.
+            threadqueue_job_t *last_job = state->tile->loop_filter_jobs[lcu->position.y];
+            uvg_threadqueue_job_dep_add(bitstream_job[0], last_job);
+            if (cfg->alf_type && !ctrl->alf_low_latency) {
+              encoder_state_t* parent = state;
+              while (parent->parent) parent = parent->parent;
+              uvg_threadqueue_job_dep_add(parent->tqj_alf_process, last_job);
+            }
+          }
+        }
+
         uvg_threadqueue_submit(state->encoder_control->threadqueue, state->tile->wf_jobs[lcu->id]);
 
         // The wavefront row is done when the last LCU in the row is done.
@@ -1192,6 +1311,11 @@ static void encoder_state_encode_leaf(encoder_state_t * const state)
 
 static void encoder_state_encode(encoder_state_t * const main_state);
 
+static void encoder_state_worker_encode_frame(void * opaque)
+{
+  encoder_state_encode((encoder_state_t *)opaque);
+}
+
 static void encoder_state_worker_encode_children(void * opaque)
 {
   encoder_state_t *sub_state = opaque;
@@ -1252,6 +1376,7 @@ static void encoder_state_encode(encoder_state_t * const main_state) {
         if(sub_state->tile->frame->chroma_cu_array) {
           uvg_cu_array_free(&sub_state->tile->frame->chroma_cu_array);
         }
+        uvg_motion_field_free(&sub_state->tile->frame->motion_field);
 
         sub_state->tile->frame->source = uvg_image_make_subimage(
             main_state->tile->frame->source,
@@ -1304,6 +1429,13 @@ static void encoder_state_encode(encoder_state_t * const main_state) {
             sub_state->tile->frame->width_in_lcu * LCU_WIDTH,
             sub_state->tile->frame->height_in_lcu * LCU_WIDTH
         );
+        sub_state->tile->frame->motion_field = uvg_motion_subfield(
+            main_state->tile->frame->motion_field,
+            offset_x,
+            offset_y,
+            sub_state->tile->frame->width_in_lcu * LCU_WIDTH,
+            sub_state->tile->frame->height_in_lcu * LCU_WIDTH
+        );
         if(main_state->encoder_control->cfg.dual_tree && main_state->frame->is_irap){
           sub_state->tile->frame->chroma_cu_array = uvg_cu_subarray(
               main_state->tile->frame->chroma_cu_array,
@@ -1356,7 +1488,23 @@ static void encoder_state_encode(encoder_state_t * const main_state) {
       }
     } else {
       for (int i = 0; main_state->children[i].encoder_control; ++i) {
-        encoder_state_worker_encode_children(&(main_state->children[i]));
+        encoder_state_t *sub_state = &main_state->children[i];
+        if (main_state->children[1].encoder_control &&
+            sub_state->type != ENCODER_STATE_TYPE_WAVEFRONT_ROW &&
+            encoder_state_tree_is_a_chain(sub_state) &&
+            sub_state->previous_encoder_state != sub_state &&
+            !sub_state->frame->is_irap)
+        {
+          // The child is coded here without jobs, for example a tile of a
+          // single LCU row next to tiles with wavefronts, so wait until the
+          // previous frames have been written.
+          const encoder_state_t *prev_frame = sub_state->previous_encoder_state;
+          while (prev_frame->parent) prev_frame = prev_frame->parent;
+          if (prev_frame->tqj_bitstream_written) {
+            uvg_threadqueue_waitfor(main_state->encoder_control->threadqueue, prev_frame->tqj_bitstream_written);
+          }
+        }
+        encoder_state_worker_encode_children(sub_state);
       }
     }
   } else {
@@ -1544,14 +1692,19 @@ static void encoder_set_source_picture(encoder_state_t * const state, uvg_pictur
     // In lossless mode, the reconstruction is equal to the source frame.
     state->tile->frame->rec = uvg_image_copy_ref(frame);
   } else {
-    state->tile->frame->rec = uvg_image_alloc(state->encoder_control->chroma_format, frame->width, frame->height);
+    // The borders of the reconstruction are extended for the motion
+    // compensation when the pixels are final.
+    const int padding = MAX(state->encoder_control->ref_padding, FRAME_PADDING_LUMA / 2);
+    state->tile->frame->rec = uvg_image_alloc_padded(state->encoder_control->chroma_format, frame->width, frame->height, padding);
     state->tile->frame->rec->dts = frame->dts;
     state->tile->frame->rec->pts = frame->pts;
   }
   state->tile->frame->rec_lmcs = state->tile->frame->rec;
 
   if (state->encoder_control->cfg.lmcs_enable) {
-    state->tile->frame->rec_lmcs = uvg_image_alloc(state->encoder_control->chroma_format, frame->width, frame->height);
+    // The LCUs are copied to both with the stride of the reconstruction.
+    state->tile->frame->rec_lmcs = uvg_image_alloc_padded(state->encoder_control->chroma_format, frame->width, frame->height,
+                                                          (state->tile->frame->rec->stride - frame->width) / 2);
     state->tile->frame->source_lmcs = uvg_image_alloc(state->encoder_control->chroma_format, frame->width, frame->height);
   }
   uvg_videoframe_set_poc(state->tile->frame, state->frame->poc);
@@ -1760,6 +1913,84 @@ static void next_roi_frame_from_file(uvg_picture *frame, FILE *file, enum uvg_ro
   }
 }
 
+// Maximum number of distinct luma values in a screen content 8x8 block
+#define SCREEN_CONTENT_MAX_COLORS 4
+
+/**
+ * \brief Detect whether a picture looks like screen content.
+ *
+ * Textured 8x8 luma blocks of camera captured video nearly always have more
+ * than a few distinct sample values, while text and graphics consist mostly
+ * of blocks with only a couple of colors. Flat blocks are ignored.
+ *
+ * \param pic  picture to analyze
+ * \return true if most of the textured blocks have only a few colors
+ */
+static bool detect_screen_content(const uvg_picture *pic)
+{
+  int few_color_blocks = 0;
+  int textured_blocks = 0;
+
+  for (int y = 0; y + 8 <= pic->height; y += 8) {
+    for (int x = 0; x + 8 <= pic->width; x += 8) {
+      uvg_pixel colors[SCREEN_CONTENT_MAX_COLORS + 1];
+      int num_colors = 0;
+
+      for (int yy = 0; yy < 8 && num_colors <= SCREEN_CONTENT_MAX_COLORS; ++yy) {
+        const uvg_pixel *row = &pic->y[(y + yy) * pic->stride + x];
+        for (int xx = 0; xx < 8 && num_colors <= SCREEN_CONTENT_MAX_COLORS; ++xx) {
+          int i = 0;
+          while (i < num_colors && colors[i] != row[xx]) ++i;
+          if (i == num_colors) colors[num_colors++] = row[xx];
+        }
+      }
+
+      if (num_colors == 1) continue;
+      if (num_colors <= SCREEN_CONTENT_MAX_COLORS) {
+        few_color_blocks++;
+      } else {
+        textured_blocks++;
+      }
+    }
+  }
+
+  return few_color_blocks > textured_blocks;
+}
+
+/**
+ * \brief Build the block hash of a picture for hash motion search.
+ *
+ * Luma 8x8 blocks are hashed at every UVG_BLOCK_HASH_STEP:th position.
+ * Blocks in which every row is the same are left out of the hashmap, since
+ * they match almost everywhere and the regular motion search finds them
+ * anyway.
+ *
+ * \param pic  picture to hash
+ * \return block hash of the picture
+ */
+static uvg_block_hash_t * build_block_hash(const uvg_picture *pic)
+{
+  uvg_block_hash_t *hash = uvg_block_hash_alloc(pic->width, pic->height);
+
+  for (int y = 0; y + UVG_HASHMAP_BLOCKSIZE <= pic->height; y += UVG_BLOCK_HASH_STEP) {
+    for (int x = 0; x + UVG_HASHMAP_BLOCKSIZE <= pic->width; x += UVG_BLOCK_HASH_STEP) {
+      const uvg_pixel *block = &pic->y[y * pic->stride + x];
+      const uint32_t crc = uvg_crc32c_8x8(block, pic->stride);
+      hash->pos_to_hash[(y / UVG_BLOCK_HASH_STEP) * hash->stride + x / UVG_BLOCK_HASH_STEP] = crc;
+
+      bool same_rows = true;
+      for (int yy = 1; yy < UVG_HASHMAP_BLOCKSIZE && same_rows; ++yy) {
+        same_rows = !memcmp(block, &block[yy * pic->stride], UVG_HASHMAP_BLOCKSIZE * sizeof(uvg_pixel));
+      }
+      if (same_rows) continue;
+
+      uvg_hashmap_insert(hash->map, crc, ((x & 0xffff) << 16) | (y & 0xffff));
+    }
+  }
+
+  return hash;
+}
+
 static void encoder_state_init_new_frame(encoder_state_t * const state, uvg_picture* frame) {
   assert(state->type == ENCODER_STATE_TYPE_MAIN);
 
@@ -1772,6 +2003,17 @@ static void encoder_state_init_new_frame(encoder_state_t * const state, uvg_pict
       state->tile->frame->width,
       state->tile->frame->height
   );
+  assert(!state->tile->frame->motion_field);
+  state->tile->frame->motion_field = uvg_motion_field_alloc(
+      state->tile->frame->width,
+      state->tile->frame->height
+  );
+
+  // The reconstruction of the frame is hashed in uvg_encoder_prepare when it
+  // is added as a reference. All-intra coding has no use for it.
+  state->frame->hash_me = cfg->intra_period != 1 &&
+    (cfg->hash_me == UVG_HASH_ME_ON ||
+     (cfg->hash_me == UVG_HASH_ME_AUTO && detect_screen_content(state->tile->frame->source)));
 
   if (!state->encoder_control->tiles_enable) {
     memset(state->tile->frame->hmvp_size, 0, sizeof(uint8_t) * state->tile->frame->height_in_lcu);
@@ -2015,15 +2257,9 @@ static void encoder_state_init_new_frame(encoder_state_t * const state, uvg_pict
     if (state->tile->frame->lmcs_aps->m_sliceReshapeInfo.sliceReshaperEnableFlag) {
       uvg_construct_reshaper_lmcs(state->tile->frame->lmcs_aps);
 
-      uvg_pixel* luma = state->tile->frame->source->y;
-      uvg_pixel* luma_lmcs = state->tile->frame->source_lmcs->y;
-      for (int y = 0; y < state->tile->frame->source->height; y++) {
-        for (int x = 0; x < state->tile->frame->source->width; x++) {
-          luma_lmcs[x] = state->tile->frame->lmcs_aps->m_fwdLUT[luma[x]];
-        }
-        luma += state->tile->frame->source->stride;
-        luma_lmcs += state->tile->frame->source->stride;
-      }
+      const uvg_picture *source = state->tile->frame->source;
+      uvg_lmcs_map_luma(source->y, source->stride, state->tile->frame->source_lmcs->y, source->stride,
+                        source->width, source->height, state->tile->frame->lmcs_aps->m_fwdLUT);
       state->tile->frame->source_lmcs_mapped = true;
       state->tile->frame->lmcs_top_level = true;
     }
@@ -2061,21 +2297,66 @@ void uvg_encode_one_frame(encoder_state_t * const state, uvg_picture* frame)
   if(state->encoder_control->cfg.jccr) set_joint_cb_cr_modes(state, frame);
   
   // Create a separate job for ALF done after everything else, and only then do final bitstream writing (for ALF parameters)
+  encoder_state_t* alf_state = NULL;
   if (state->encoder_control->cfg.alf_type && state->encoder_control->cfg.wpp) {
     uvg_threadqueue_free_job(&state->tqj_alf_process);
-    encoder_state_t* child_state = state;
-    while (child_state->lcu_order == NULL) child_state = &child_state->children[0];
-    state->tqj_alf_process = uvg_threadqueue_job_create(uvg_alf_enc_process_job, child_state);
+    alf_state = state;
+    while (alf_state->lcu_order == NULL) alf_state = &alf_state->children[0];
+    if (encoder_state_uses_alf_row_jobs(alf_state)) {
+      // The LCU rows are processed as separate jobs, this job finishes the frame.
+      state->tqj_alf_process = uvg_threadqueue_job_create(
+        state->encoder_control->alf_low_latency ? encoder_state_worker_alf_low_latency_finish : encoder_state_worker_alf_finish,
+        alf_state);
+      if (!state->encoder_control->alf_low_latency) {
+        // The loop filter jobs derive the statistics while the frame is coded.
+        // The leaf states get the ALF buffers of the frame only when they
+        // are coded, but the row jobs are used with a single tile so the
+        // frame level state has the same size.
+        uvg_alf_enc_init(state);
+      }
+    } else if (!state->encoder_control->alf_low_latency &&
+               alf_state->type == ENCODER_STATE_TYPE_WAVEFRONT_ROW &&
+               alf_state->parent->children[1].encoder_control) {
+      // A single LCU row is coded in one go and filtered by the leaf itself.
+      state->tqj_alf_process = uvg_threadqueue_job_create(uvg_alf_enc_process_job, alf_state);
+    }
   }
 
-  encoder_state_encode(state);
+  if (state->encoder_control->alf_low_latency) {
+    uvg_alf_enc_low_latency_init(state);
+  }
+
+  if (state->encoder_control->independent_frames && encoder_state_tree_is_a_chain(state)) {
+    // Without tiles or wavefronts the frame would be coded in this thread.
+    // All-intra frames do not depend on each other, so code the whole frame
+    // as a single job and let the frames in OWF run in parallel.
+    state->tqj_recon_done = uvg_threadqueue_job_create(encoder_state_worker_encode_frame, state);
+    uvg_threadqueue_submit(state->encoder_control->threadqueue, state->tqj_recon_done);
+  } else {
+    encoder_state_encode(state);
+  }
 
   threadqueue_job_t *job =
     uvg_threadqueue_job_create(uvg_encoder_state_worker_write_bitstream, state);
 
 
   if (state->encoder_control->cfg.alf_type && state->encoder_control->cfg.wpp) {
-    uvg_threadqueue_submit(state->encoder_control->threadqueue, state->tqj_alf_process);    
+    if (encoder_state_uses_alf_row_jobs(alf_state)) {
+      encoder_state_submit_alf_jobs(state, alf_state);
+      if (alf_state->tile->cc_alf_filter_jobs) {
+        // The pixels of the frame are final after the cross component ALF.
+        for (int row = 0; row < alf_state->tile->frame->height_in_lcu; ++row) {
+          uvg_threadqueue_job_dep_add(job, alf_state->tile->cc_alf_filter_jobs[row]);
+        }
+      }
+    }
+    if (state->tqj_alf_process) {
+      uvg_threadqueue_submit(state->encoder_control->threadqueue, state->tqj_alf_process);
+    }
+    if (state->encoder_control->alf_low_latency && state->tqj_alf_process) {
+      // The LCUs do not wait for the ALF, but the new APS is written with the frame.
+      uvg_threadqueue_job_dep_add(job, state->tqj_alf_process);
+    }
   }
 
   _encode_one_frame_add_bitstream_deps(state, job);
@@ -2113,6 +2394,8 @@ void uvg_encoder_prepare(encoder_state_t *state)
     assert(!state->tile->frame->source);
     assert(!state->tile->frame->rec);
     assert(!state->tile->frame->cu_array);
+    assert(!state->tile->frame->motion_field);
+    assert(!state->tile->frame->block_hash);
     state->frame->prepared = 1;
 
     return;
@@ -2141,10 +2424,21 @@ void uvg_encoder_prepare(encoder_state_t *state)
     // Store current list of POCs for use in TMVP derivation
     memcpy(prev_state->tile->frame->rec->ref_pocs, state->frame->ref->pocs, sizeof(int32_t)*state->frame->ref->used_size);
 
+    if (prev_state->frame->hash_me && !prev_state->tile->frame->block_hash) {
+      // Hash the reconstruction that motion compensation reads, so that the
+      // matches are exact. The whole frame has to be done for that, which
+      // keeps the next frame from overlapping with it.
+      if (prev_state->tqj_bitstream_written) {
+        uvg_threadqueue_waitfor(encoder->threadqueue, prev_state->tqj_bitstream_written);
+      }
+      prev_state->tile->frame->block_hash = build_block_hash(prev_state->tile->frame->rec);
+    }
+
     // Add previous reconstructed picture as a reference
     uvg_image_list_add(state->frame->ref,
                    prev_state->tile->frame->rec,
-                   prev_state->tile->frame->cu_array,
+                   prev_state->tile->frame->motion_field,
+                   prev_state->tile->frame->block_hash,
                    prev_state->frame->poc,
                    prev_state->frame->ref_LX);
     uvg_cu_array_free(&state->tile->frame->cu_array);
@@ -2175,6 +2469,8 @@ void uvg_encoder_prepare(encoder_state_t *state)
   if (state->tile->frame->chroma_cu_array) {
     uvg_cu_array_free(&state->tile->frame->chroma_cu_array);
   }
+  uvg_motion_field_free(&state->tile->frame->motion_field);
+  uvg_block_hash_free(&state->tile->frame->block_hash);
 
   // Update POC and frame count.
   state->frame->num = prev_state->frame->num + 1;
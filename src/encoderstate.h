@@ -194,6 +194,9 @@ typedef struct encoder_state_config_frame_t {
 
   bool jccr_sign; 
 
+  //! Whether hash motion search is used in the current frame.
+  bool hash_me;
+
 } encoder_state_config_frame_t;
 
 typedef struct encoder_state_config_tile_t {
@@ -222,20 +225,25 @@ typedef struct encoder_state_config_tile_t {
   // x-coordinate.
   yuv_t *ver_buf_search;
 
-  // This is a buffer for the deblocked bottom pixels of every LCU in the
-  // tile. They are packed such that each LCU-row index maps to the
-  // y-coordinate.
-  yuv_t *hor_buf_before_sao;
-
-  // This is a buffer for the deblocked right pixels of every LCU in the
-  // tile. They are packed such that each LCU-column index maps to the
-  // x-coordinate.
-  yuv_t *ver_buf_before_sao;
+  // This is a buffer for the deblocked pixels of the LCU row that is being
+  // filtered with SAO, with the line above and below the row. The line
+  // above is left in the buffer by the previous LCU row.
+  yuv_t *sao_band_buf;
 
   //Jobs for each individual LCU of a wavefront row.
   threadqueue_job_t **wf_jobs;
   threadqueue_job_t **wf_recon_jobs;
 
+  //Loop filter jobs for each LCU row, NULL without wavefronts or filters.
+  threadqueue_job_t **loop_filter_jobs;
+
+  //ALF jobs for each LCU row, NULL if ALF is done as a single job.
+  threadqueue_job_t **alf_filter_jobs;
+
+  //Cross component ALF jobs for each LCU row, NULL without ALF row jobs or
+  //cross component ALF.
+  threadqueue_job_t **cc_alf_filter_jobs;
+
 } encoder_state_config_tile_t;
 
 typedef struct encoder_state_config_alf_t {
@@ -297,6 +305,45 @@ typedef struct lcu_order_element {
   struct lcu_order_element *right;
 } lcu_order_element_t;
 
+#define MERGE_COST_CACHE_SIZE 32
+#define MERGE_COST_CACHE_BLOCKS ((LCU_WIDTH / 8) * (LCU_WIDTH / 8))
+
+/**
+ * \brief Luma SATD of a merge candidate prediction in the current LCU.
+ *
+ * The SATD is stored for each 8x8 block of the LCU that has been predicted
+ * with the motion of the candidate, so that PUs of other sizes and shapes
+ * covering the same blocks can reuse it.
+ */
+typedef struct {
+  mv_t mv[2][2];
+  uint8_t dir;
+  uint8_t ref[2]; // index to L0/L1
+  uint64_t valid; // one bit per 8x8 block in raster order
+  uint32_t satd[MERGE_COST_CACHE_BLOCKS];
+} merge_cost_cache_entry_t;
+
+static_assert(MERGE_COST_CACHE_BLOCKS <= 64, "The 8x8 blocks of an LCU must fit in the valid mask of the merge cost cache");
+
+typedef struct {
+  int size;
+  int next;
+  merge_cost_cache_entry_t entries[MERGE_COST_CACHE_SIZE];
+} merge_cost_cache_t;
+
+#define INTRA_GRAD_HIST_BINS 67 // one bin per intra mode
+#define INTRA_GRAD_HIST_BLOCKS ((LCU_WIDTH / 4) * (LCU_WIDTH / 4))
+
+/**
+ * \brief Gradient orientation histograms of the source luma of an LCU.
+ *
+ * Each 4x4 block has a histogram where the gradients are accumulated to the
+ * bin of the angular mode closest to the edge direction.
+ */
+typedef struct {
+  uint16_t bins[INTRA_GRAD_HIST_BLOCKS][INTRA_GRAD_HIST_BINS];
+} intra_grad_hist_t;
+
 typedef struct encoder_state_t {
   const encoder_control_t *encoder_control;
   encoder_state_type type;
@@ -369,6 +416,15 @@ typedef struct encoder_state_t {
 
   quant_block quant_blocks[3]; // luma, ISP, chroma
   rate_estimator_t rate_estimator[4]; // luma, cb, cr, isp
+
+  // Merge candidate costs of the LCU currently being searched.
+  merge_cost_cache_t merge_cost_cache;
+
+  // Gradient histograms of the LCU currently being searched.
+  intra_grad_hist_t intra_grad_hist;
+
+  // Intra references of the CU currently being searched, NULL if unused.
+  struct intra_ref_cache_t *intra_ref_cache;
 } encoder_state_t;
 
 void uvg_encode_one_frame(encoder_state_t * const state, uvg_picture* frame);
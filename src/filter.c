@@ -37,6 +37,7 @@
 #include "cu.h"
 #include "encoder.h"
 #include "intra.h"
+#include "strategies/strategies-filter.h"
 #include "uvg266.h"
 #include "transform.h"
 #include "videoframe.h"
@@ -118,85 +119,6 @@ const int8_t uvg_g_chroma_filter[32][4] =
 //////////////////////////////////////////////////////////////////////////
 // FUNCTIONS
 
-/**
- * \brief Perform in strong luma filtering in place.
- * \param line  line of 8 pixels, with center at index 4
- * \param tc  tc treshold
- * \return  Reach of the filter starting from center.
- */
-static INLINE int uvg_filter_deblock_luma_strong(
-    uvg_pixel *line,
-    int32_t tc)
-{
-  const uvg_pixel m0 = line[0];
-  const uvg_pixel m1 = line[1];
-  const uvg_pixel m2 = line[2];
-  const uvg_pixel m3 = line[3];
-  const uvg_pixel m4 = line[4];
-  const uvg_pixel m5 = line[5];
-  const uvg_pixel m6 = line[6];
-  const uvg_pixel m7 = line[7];
-  const uint8_t tcW[3] = { 3, 2, 1 }; //Wheights for tc
-
-  line[1] = CLIP(m1 - tcW[2]*tc, m1 + tcW[2]*tc, (2*m0 + 3*m1 +   m2 +   m3 +   m4 + 4) >> 3);
-  line[2] = CLIP(m2 - tcW[1]*tc, m2 + tcW[1]*tc, (  m1 +   m2 +   m3 +   m4        + 2) >> 2);
-  line[3] = CLIP(m3 - tcW[0]*tc, m3 + tcW[0]*tc, (  m1 + 2*m2 + 2*m3 + 2*m4 +   m5 + 4) >> 3);
-  line[4] = CLIP(m4 - tcW[0]*tc, m4 + tcW[0]*tc, (  m2 + 2*m3 + 2*m4 + 2*m5 +   m6 + 4) >> 3);
-  line[5] = CLIP(m5 - tcW[1]*tc, m5 + tcW[1]*tc, (  m3 +   m4 +   m5 +   m6        + 2) >> 2);
-  line[6] = CLIP(m6 - tcW[2]*tc, m6 + tcW[2]*tc, (  m3 +   m4 +   m5 + 3*m6 + 2*m7 + 4) >> 3);
-
-  return 3;
-}
-
-/**
- * \brief Perform in weak luma filtering in place.
- * \param encoder  Encoder
- * \param line  Line of 8 pixels, with center at index 4
- * \param tc  The tc treshold
- * \param p_2nd  Whether to filter the 2nd line of P
- * \param q_2nd  Whether to filter the 2nd line of Q
- */
-static INLINE int uvg_filter_deblock_luma_weak(
-    const encoder_control_t * const encoder,
-    uvg_pixel *line,
-    int32_t tc,
-    bool p_2nd,
-    bool q_2nd)
-{
-  const uvg_pixel m1 = line[1];
-  const uvg_pixel m2 = line[2];
-  const uvg_pixel m3 = line[3];
-  const uvg_pixel m4 = line[4];
-  const uvg_pixel m5 = line[5];
-  const uvg_pixel m6 = line[6];
-
-  int32_t delta = (9 * (m4 - m3) - 3 * (m5 - m2) + 8) >> 4;
-
-  if (abs(delta) >= tc * 10) {
-    return 0;
-  } else {
-    int32_t tc2 = tc >> 1;
-    delta = CLIP(-tc, tc, delta);
-    line[3] = CLIP(0, (1 << encoder->bitdepth) - 1, (m3 + delta));
-    line[4] = CLIP(0, (1 << encoder->bitdepth) - 1, (m4 - delta));
-
-    if (p_2nd) {
-      int32_t delta1 = CLIP(-tc2, tc2, (((m1 + m3 + 1) >> 1) - m2 + delta) >> 1);
-      line[2] = CLIP(0, (1 << encoder->bitdepth) - 1, m2 + delta1);
-    }
-    if (q_2nd) {
-      int32_t delta2 = CLIP(-tc2, tc2, (((m6 + m4 + 1) >> 1) - m5 - delta) >> 1);
-      line[5] = CLIP(0, (1 << encoder->bitdepth) - 1, m5 + delta2);
-    }
-    
-    if (p_2nd || q_2nd) {
-      return 2;
-    } else {
-      return 1;
-    }
-  }
-}
-
 /**
  * \brief Performe strong/weak filtering for chroma
  */
@@ -364,165 +286,6 @@ static INLINE void gather_deblock_pixels(
   }
 }
 
-/**
-* \brief Gather pixels from src to dst using a custom stride and step for src
-*/
-static INLINE void gather_pixels(
-    const uvg_pixel *src,
-    int step,
-    int stride,
-    int numel,
-    uvg_pixel *dst)
-{
-  for (int i = 0; i < numel; ++i) {
-    dst[i] = src[i * step + stride];
-  }
-}
-
-/**
-* \brief Scatter pixels
-*/
-static INLINE void scatter_deblock_pixels(
-    const uvg_pixel *src,
-    int step, 
-    int stride,
-    int reach,
-    uvg_pixel *dst)
-{
-  for (int i = -reach; i < +reach; ++i) {
-    dst[i * step + stride] = src[i + 4];
-  }
-}
-
-/**
- * \brief Perform large block strong luma filtering in place.
- * \param line  line of 8 pixels, with center at index 4
- * \param lineL extended pixels with P pixels in [0,3] and Q pixels in [4,7]
- * \param tc  tc treshold
- * \param filter_length_P filter length in the P block
- * \param filter_length_Q filter length in the Q block
- * \return  Reach of the filter starting from center.
- */
-static INLINE int uvg_filter_deblock_large_block(uvg_pixel *line, uvg_pixel *lineL, const int32_t tc,
-                                                 const uint8_t filter_length_P, const uint8_t filter_length_Q)
-{
-  int ref_P = 0;
-  int ref_Q = 0;
-  int ref_middle = 0;
-
-  const int coeffs7[7] = { 59, 50, 41, 32, 23, 14, 5 };
-  const int coeffs5[5] = { 58, 45, 32, 19, 6 };
-  const int coeffs3[3] = { 53, 32, 11 };
-
-  const int *coeffs_P = NULL;
-  const int *coeffs_Q = NULL;
-
-  //Form P/Q arrays that contain all of the samples to make things simpler later
-  const uvg_pixel lineP[8] = { line[3], line[2], line[1], line[0],
-                               lineL[3], lineL[2], lineL[1], lineL[0] };
-  const uvg_pixel lineQ[8] = { line[4], line[5], line[6], line[7],
-                               lineL[4], lineL[5], lineL[6], lineL[7] };
-  //Separate destination arrays with only six output pixels going in line and  rest to lineL to simplify things later
-  uvg_pixel* dstP[7] = { line + 3, line + 2, line + 1,
-                         lineL + 3, lineL + 2, lineL + 1, lineL + 0 };
-  uvg_pixel* dstQ[7] = { line + 4, line + 5, line + 6,
-                         lineL + 4, lineL + 5, lineL + 6, lineL + 7 };
-
-  //Get correct filter coeffs and Q/P end samples
-  switch (filter_length_P)
-  {
-  case 7:
-    ref_P = (lineP[6] + lineP[7] + 1) >> 1;
-    coeffs_P = coeffs7;
-    break;
-
-  case 5:
-    ref_P = (lineP[4] + lineP[5] + 1) >> 1;
-    coeffs_P = coeffs5;
-    break;
-
-  case 3:
-    ref_P = (lineP[2] + lineP[3] + 1) >> 1;
-    coeffs_P = coeffs3;
-    break;
-  }
-
-  switch (filter_length_Q)
-  {
-  case 7:
-    ref_Q = (lineQ[6] + lineQ[7] + 1) >> 1;
-    coeffs_Q = coeffs7;
-    break;
-
-  case 5:
-    ref_Q = (lineQ[4] + lineQ[5] + 1) >> 1;
-    coeffs_Q = coeffs5;
-    break;
-
-  case 3:
-    ref_Q = (lineQ[2] + lineQ[3] + 1) >> 1;
-    coeffs_Q = coeffs3;
-    break;
-  }
-
-  //Get middle samples
-  if (filter_length_P == filter_length_Q) {
-    if (filter_length_P == 7) {
-      ref_middle = (lineP[6] + lineP[5] + lineP[4] + lineP[3] + lineP[2] + lineP[1]
-                    + 2 * (lineP[0] + lineQ[0])
-                    + lineQ[1] + lineQ[2] + lineQ[3] + lineQ[4] + lineQ[5] + lineQ[6] + 8) >> 4;
-    }
-    else { //filter_length_P == 5
-      ref_middle = (lineP[4] + lineP[3]
-                    + 2 * (lineP[2] + lineP[1] + lineP[0] + lineQ[0] + lineQ[1] + lineQ[2])
-                    + lineQ[3] + lineQ[4] + 8) >> 4;
-    }
-  }
-  else {
-    const uint8_t lenS = MIN(filter_length_P, filter_length_Q);
-    const uint8_t lenL = MAX(filter_length_P, filter_length_Q);
-    const uvg_pixel *refS = filter_length_P < filter_length_Q ? lineP : lineQ;
-    const uvg_pixel *refL = filter_length_P < filter_length_Q ? lineQ : lineP;
-
-    if (lenL == 7 && lenS == 5) {
-      ref_middle = (lineP[5] + lineP[4] + lineP[3] + lineP[2]
-                    + 2 * (lineP[1] + lineP[0] + lineQ[0] + lineQ[1])
-                    + lineQ[2] + lineQ[3] + lineQ[4] + lineQ[5] + 8) >> 4;
-    }
-    else if (lenL == 7 && lenS == 3) {
-      ref_middle = (3 * refS[0] + 2 * refL[0] + 3 * refS[1] + refL[1] + 2 * refS[2]
-                    + refL[2] + refL[3] + refL[4] + refL[5] + refL[6] + 8) >> 4;
-    }
-    else { //lenL == 5 && lenS == 3
-    ref_middle = (lineP[3] + lineP[2] + lineP[1] + lineP[0]
-                  + lineQ[0] + lineQ[1] + lineQ[2] + lineQ[3] + 4) >> 3;
-
-    }
-  }
-
-  //Filter pixels in the line
-
-  const uint8_t tc7[7] = { 6, 5, 4, 3, 2, 1, 1 };
-  const uint8_t tc3[3] = { 6, 4, 2 };
-
-  const uint8_t *tc_coeff_P = (filter_length_P == 3) ? tc3 : tc7;
-  const uint8_t *tc_coeff_Q = (filter_length_Q == 3) ? tc3 : tc7;
-
-  for (size_t i = 0; i < filter_length_P; i++)
-  {
-    int range = (tc * tc_coeff_P[i]) >> 1;
-    *dstP[i] = CLIP(lineP[i] - range, lineP[i] + range, (ref_middle * coeffs_P[i] + ref_P * (64 - coeffs_P[i]) + 32) >> 6);
-  }
-
-  for (size_t i = 0; i < filter_length_Q; i++)
-  {
-    int range = (tc * tc_coeff_Q[i]) >> 1;
-    *dstQ[i] = CLIP(lineQ[i] - range, lineQ[i] + range, (ref_middle * coeffs_Q[i] + ref_Q * (64 - coeffs_Q[i]) + 32) >> 6);
-  }
-
-  return 3;
-}
-
 /**
 * \brief Determine if strong or weak filtering should be used
 */
@@ -644,368 +407,322 @@ static INLINE void get_max_filter_length(uint8_t *filt_len_P, uint8_t *filt_len_
 }
 
 /**
- * \brief Apply the deblocking filter to luma pixels on a single edge.
- *
- * The caller should check that the edge is a TU boundary or a PU boundary.
+ * \brief Get the deblocking map entry of an edge of a 4x4 luma block.
  *
- \verbatim
-
-         .-- filter this edge if dir == EDGE_HOR
-         v
-     +--------+
-     |o <-- pixel at (x, y)
-     |        |
-     |<-- filter this edge if dir == EDGE_VER
-     |        |
-     +--------+
+ * \param frame     frame
+ * \param x         x-coordinate of the block in pixels
+ * \param y         y-coordinate of the block in pixels
+ * \param dir       EDGE_VER for the left edge, EDGE_HOR for the top edge
+ */
+static INLINE deblock_edge_info_t *deblock_map_at(const videoframe_t *frame,
+                                                  int32_t x,
+                                                  int32_t y,
+                                                  edge_dir dir)
+{
+  const int32_t map_stride = frame->width_in_lcu * (LCU_WIDTH / 4);
+  return &frame->deblock_map[2 * ((y >> 2) * map_stride + (x >> 2)) + (dir == EDGE_HOR)];
+}
 
- \endverbatim
+/**
+ * \brief Derive the boundary strength, the filter lengths and the QP of
+ *        a luma edge segment.
+ *
+ * The caller should check that the edge is a TU boundary.
  *
  * \param state     encoder state
- * \param x         x-coordinate in pixels (see above)
- * \param y         y-coordinate in pixels (see above)
- * \param length    length of the edge in pixels
- * \param dir       direction of the edge to filter
- * \param tu_boundary   whether the edge is a TU boundary
+ * \param x         x-coordinate of the 4x4 block in pixels
+ * \param y         y-coordinate of the 4x4 block in pixels
+ * \param dir       EDGE_VER for the left edge, EDGE_HOR for the top edge
+ * \param info      returns the deblocking parameters of the edge
  */
-static void filter_deblock_edge_luma(encoder_state_t * const state,
-                                     int32_t x,
-                                     int32_t y,
-                                     int32_t length,
-                                     edge_dir dir,
-                                     bool tu_boundary)
+static void get_luma_edge_info(encoder_state_t * const state,
+                               int32_t x,
+                               int32_t y,
+                               edge_dir dir,
+                               deblock_edge_info_t *info)
 {
   videoframe_t * const frame = state->tile->frame;
-  const encoder_control_t * const encoder = state->encoder_control;
-  
-  {
-    int32_t stride = frame->rec->stride;
-    int32_t beta_offset_div2 = encoder->cfg.deblock_beta;
-    int32_t tc_offset_div2   = encoder->cfg.deblock_tc;
-    // TODO: support 10+bits
-    uvg_pixel *orig_src = &frame->rec->y[x + y*stride];
-    uvg_pixel *src = orig_src;
 
-    const int32_t qp = get_qp_y_pred(state, x, y, dir);
+  //Deblock adapted to halve pixel mvd.
+  const int16_t mvdThreashold = 1 << (INTERNAL_MV_PREC - 1);
 
-    const int MAX_QP = 63; //TODO: Make DEFAULT_INTRA_TC_OFFSET(=2) a define?
-    const int8_t lumaBitdepth = encoder->bitdepth;
+  // CUs on both sides of the edge
+  cu_info_t *cu_p;
+  cu_info_t *cu_q;
+  if (dir == EDGE_VER) {
+    cu_p = uvg_cu_array_at(frame->cu_array, x - 1, y);
+    cu_q = uvg_cu_array_at(frame->cu_array, x, y);
+  } else {
+    cu_p = uvg_cu_array_at(frame->cu_array, x, y - 1);
+    cu_q = uvg_cu_array_at(frame->cu_array, x, y);
+  }
 
-    int8_t strength = 0;
-    int32_t bitdepth_scale  = 1 << (lumaBitdepth - 8);
-    int32_t b_index         = CLIP(0, MAX_QP, qp + (beta_offset_div2 << 1));
-    int32_t beta            = uvg_g_beta_table_8x8[b_index] * bitdepth_scale;
-    int32_t side_threshold  = (beta + (beta >>1 )) >> 3;
-    int32_t tc_index;
-    int32_t tc;
+  // Filter strength
+  uint8_t strength = 0;
+  bool nonzero_coeffs = cbf_is_set(cu_q->cbf, COLOR_Y)
+    || cbf_is_set(cu_p->cbf, COLOR_Y);
 
-    //Deblock adapted to halve pixel mvd.
-    const int16_t mvdThreashold = 1 << (INTERNAL_MV_PREC - 1);
+  if (cu_q->type == CU_INTRA || cu_p->type == CU_INTRA) { // Intra is used
+    strength = 2;
+  }
+  else if (nonzero_coeffs) {
+    // Non-zero residual/coeffs and transform boundary
+    strength = 1;
+  }
+  else if(cu_p->inter.mv_dir == 3 || cu_q->inter.mv_dir == 3 || state->frame->slicetype == UVG_SLICE_B) { // B-slice related checks. TODO: Need to account for cu_p being in another slice?
 
-    uint32_t num_4px_parts  = length / 4;
+    // Zero all undefined motion vectors for easier usage
+    if(!(cu_q->inter.mv_dir & 1)) {
+      cu_q->inter.mv[0][0] = 0;
+      cu_q->inter.mv[0][1] = 0;
+    }
+    if(!(cu_q->inter.mv_dir & 2)) {
+      cu_q->inter.mv[1][0] = 0;
+      cu_q->inter.mv[1][1] = 0;
+    }
 
-    // Transpose the image by swapping x and y strides when doing horizontal
-    // edges.
-    const int32_t x_stride = (dir == EDGE_VER) ? 1 : stride;
-    const int32_t y_stride = (dir == EDGE_VER) ? stride : 1;
+    if(!(cu_p->inter.mv_dir & 1)) {
+      cu_p->inter.mv[0][0] = 0;
+      cu_p->inter.mv[0][1] = 0;
+    }
+    if(!(cu_p->inter.mv_dir & 2)) {
+      cu_p->inter.mv[1][0] = 0;
+      cu_p->inter.mv[1][1] = 0;
+    }
+    const int refP0 = (cu_p->type == CU_IBC)?-2:(cu_p->inter.mv_dir & 1) ? state->frame->ref_LX[0][cu_p->inter.mv_ref[0]] : -1;
+    const int refP1 = (cu_p->type == CU_IBC)?-2:(cu_p->inter.mv_dir & 2) ? state->frame->ref_LX[1][cu_p->inter.mv_ref[1]] : -1;
+    const int refQ0 = (cu_q->type == CU_IBC)?-2:(cu_q->inter.mv_dir & 1) ? state->frame->ref_LX[0][cu_q->inter.mv_ref[0]] : -1;
+    const int refQ1 = (cu_q->type == CU_IBC)?-2:(cu_q->inter.mv_dir & 2) ? state->frame->ref_LX[1][cu_q->inter.mv_ref[1]] : -1;
+    const mv_t* mvQ0 = cu_q->inter.mv[0];
+    const mv_t* mvQ1 = cu_q->inter.mv[1];
 
-    // TODO: add CU based QP calculation
-
-    // For each 4-pixel part in the edge
-    for (uint32_t block_idx = 0; block_idx < num_4px_parts; ++block_idx) {
-      
-      // CUs on both sides of the edge
-      cu_info_t *cu_p;
-      cu_info_t *cu_q;
-      int32_t y_coord = y;
-      int32_t x_coord = x;
-      {
-        if (dir == EDGE_VER) {
-          y_coord = y + 4 * block_idx;
-          cu_p = uvg_cu_array_at(frame->cu_array, x - 1, y_coord);
-          cu_q = uvg_cu_array_at(frame->cu_array, x, y_coord);
+    const mv_t* mvP0 = cu_p->inter.mv[0];
+    const mv_t* mvP1 = cu_p->inter.mv[1];
 
+    if(( refP0 == refQ0 &&  refP1 == refQ1 ) || ( refP0 == refQ1 && refP1==refQ0 ))
+    {
+      // Different L0 & L1
+      if ( refP0 != refP1 ) {          
+        if ( refP0 == refQ0 ) {
+          strength  = ((abs(mvQ0[0] - mvP0[0]) >= mvdThreashold) ||
+                       (abs(mvQ0[1] - mvP0[1]) >= mvdThreashold) ||
+                       (abs(mvQ1[0] - mvP1[0]) >= mvdThreashold) ||
+                       (abs(mvQ1[1] - mvP1[1]) >= mvdThreashold)) ? 1 : 0;
         } else {
-          x_coord = x + 4 * block_idx;
-          cu_p = uvg_cu_array_at(frame->cu_array, x_coord, y - 1);
-          cu_q = uvg_cu_array_at(frame->cu_array, x_coord, y);
+          strength  = ((abs(mvQ1[0] - mvP0[0]) >= mvdThreashold) ||
+                       (abs(mvQ1[1] - mvP0[1]) >= mvdThreashold) ||
+                       (abs(mvQ0[0] - mvP1[0]) >= mvdThreashold) ||
+                       (abs(mvQ0[1] - mvP1[1]) >= mvdThreashold)) ? 1 : 0;
         }
+      // Same L0 & L1
+      } else {  
+        strength  = ((abs(mvQ0[0] - mvP0[0]) >= mvdThreashold) ||
+                     (abs(mvQ0[1] - mvP0[1]) >= mvdThreashold) ||
+                     (abs(mvQ1[0] - mvP1[0]) >= mvdThreashold) ||
+                     (abs(mvQ1[1] - mvP1[1]) >= mvdThreashold)) &&
+                    ((abs(mvQ1[0] - mvP0[0]) >= mvdThreashold) ||
+                     (abs(mvQ1[1] - mvP0[1]) >= mvdThreashold) ||
+                     (abs(mvQ0[0] - mvP1[0]) >= mvdThreashold) ||
+                     (abs(mvQ0[1] - mvP1[1]) >= mvdThreashold)) ? 1 : 0;
+      }
+    } else {
+      strength = 1;
+    }
+  }
+  else /*if (cu_p->inter.mv_dir != 3 && cu_q->inter.mv_dir != 3)*/ { //is P-slice
+    const int refP = (cu_p->type == CU_IBC)?-2:state->frame->ref_LX[0][cu_p->inter.mv_ref[0]];
+    const int refQ = (cu_q->type == CU_IBC)?-2:state->frame->ref_LX[0][cu_q->inter.mv_ref[0]];
+    if (refP != refQ) {
+      // Reference pictures are different
+      strength = 1;
+    } else if (
+      ((abs(cu_q->inter.mv[0][0] - cu_p->inter.mv[0][0]) >= mvdThreashold) ||
+      (abs(cu_q->inter.mv[0][1] - cu_p->inter.mv[0][1]) >= mvdThreashold))) {
+      // Absolute motion vector diff between blocks >= 0.5 (Integer pixel)
+      strength = 1;
+    }
+  }
 
-        bool nonzero_coeffs = cbf_is_set(cu_q->cbf, COLOR_Y)
-          || cbf_is_set(cu_p->cbf, COLOR_Y);
-
-        // Filter strength
-        strength = 0;
-        if (cu_q->type == CU_INTRA || cu_p->type == CU_INTRA) { // Intra is used
-          strength = 2;
-        }
-        else if (tu_boundary && nonzero_coeffs) {
-          // Non-zero residual/coeffs and transform boundary
-          strength = 1;
-        }
-        else if(cu_p->inter.mv_dir == 3 || cu_q->inter.mv_dir == 3 || state->frame->slicetype == UVG_SLICE_B) { // B-slice related checks. TODO: Need to account for cu_p being in another slice?
+  info->bs = strength;
+  info->qp = get_qp_y_pred(state, x, y, dir);
+  info->max_filter_length_P = 0;
+  info->max_filter_length_Q = 0;
+  if (strength == 0) return;
+
+  uint8_t max_filter_length_P = 0;
+  uint8_t max_filter_length_Q = 0;
+
+  const int cu_width = 1 << cu_q->log2_width;
+  const int cu_height = 1 << cu_q->log2_height;
+  const int pu_size = dir == EDGE_HOR ? cu_height : cu_width;
+  const int pu_pos = dir == EDGE_HOR ? y : x;
+  int tu_size_q_side = 0;
+  if (cu_q->type == CU_INTRA && cu_q->intra.isp_mode != ISP_MODE_NO_ISP) {
+    if (cu_q->intra.isp_mode == ISP_MODE_VER && dir == EDGE_VER) {
+      tu_size_q_side = MAX(4, cu_width >> 2);
+    } else if (cu_q->intra.isp_mode == ISP_MODE_HOR && dir == EDGE_HOR) {
+      tu_size_q_side = MAX(4,  cu_height >> 2);
+    } else {
+      tu_size_q_side = dir == EDGE_HOR ?
+                         MIN(1 << cu_q->log2_height, TR_MAX_WIDTH) :
+                         MIN(1 << cu_q->log2_width, TR_MAX_WIDTH);
+    }
+  } else {
+    tu_size_q_side = dir == EDGE_HOR ?
+                       MIN(1 << cu_q->log2_height, TR_MAX_WIDTH) :
+                       MIN(1 << cu_q->log2_width, TR_MAX_WIDTH);
+  }
 
-          // Zero all undefined motion vectors for easier usage
-          if(!(cu_q->inter.mv_dir & 1)) {
-            cu_q->inter.mv[0][0] = 0;
-            cu_q->inter.mv[0][1] = 0;
-          }
-          if(!(cu_q->inter.mv_dir & 2)) {
-            cu_q->inter.mv[1][0] = 0;
-            cu_q->inter.mv[1][1] = 0;
-          }
+  int tu_size_p_side = 0;
+  if (cu_p->type == CU_INTRA && cu_p->intra.isp_mode != ISP_MODE_NO_ISP) {
+    if (cu_p->intra.isp_mode == ISP_MODE_VER && dir == EDGE_VER) {
+      tu_size_p_side = MAX(4, (1 << cu_p->log2_width) >> 2);
+    } else if (cu_p->intra.isp_mode == ISP_MODE_HOR && dir == EDGE_HOR) {
+      tu_size_p_side = MAX(4, (1 << cu_p->log2_height) >> 2);
+    } else {
+      tu_size_p_side = dir == EDGE_HOR ?
+                         MIN(1 << cu_p->log2_height, TR_MAX_WIDTH) :
+                         MIN(1 << cu_p->log2_width, TR_MAX_WIDTH);
+    }
+  } else {
+    tu_size_p_side = dir == EDGE_HOR ?
+                       MIN(1 << cu_p->log2_height, TR_MAX_WIDTH) :
+                       MIN(1 << cu_p->log2_width, TR_MAX_WIDTH);
+    
+  }
 
-          if(!(cu_p->inter.mv_dir & 1)) {
-            cu_p->inter.mv[0][0] = 0;
-            cu_p->inter.mv[0][1] = 0;
-          }
-          if(!(cu_p->inter.mv_dir & 2)) {
-            cu_p->inter.mv[1][0] = 0;
-            cu_p->inter.mv[1][1] = 0;
-          }
-          const int refP0 = (cu_p->type == CU_IBC)?-2:(cu_p->inter.mv_dir & 1) ? state->frame->ref_LX[0][cu_p->inter.mv_ref[0]] : -1;
-          const int refP1 = (cu_p->type == CU_IBC)?-2:(cu_p->inter.mv_dir & 2) ? state->frame->ref_LX[1][cu_p->inter.mv_ref[1]] : -1;
-          const int refQ0 = (cu_q->type == CU_IBC)?-2:(cu_q->inter.mv_dir & 1) ? state->frame->ref_LX[0][cu_q->inter.mv_ref[0]] : -1;
-          const int refQ1 = (cu_q->type == CU_IBC)?-2:(cu_q->inter.mv_dir & 2) ? state->frame->ref_LX[1][cu_q->inter.mv_ref[1]] : -1;
-          const mv_t* mvQ0 = cu_q->inter.mv[0];
-          const mv_t* mvQ1 = cu_q->inter.mv[1];
+  get_max_filter_length(&max_filter_length_P, &max_filter_length_Q, state, x, y,
+                        dir, true,
+                        tu_size_p_side,
+                        tu_size_q_side,
+                        pu_pos, pu_size, cu_q->merged, COLOR_Y,
+                        UVG_LUMA_T);
 
-          const mv_t* mvP0 = cu_p->inter.mv[0];
-          const mv_t* mvP1 = cu_p->inter.mv[1];
+  info->max_filter_length_P = max_filter_length_P;
+  info->max_filter_length_Q = max_filter_length_Q;
+}
 
-          if(( refP0 == refQ0 &&  refP1 == refQ1 ) || ( refP0 == refQ1 && refP1==refQ0 ))
-          {
-            // Different L0 & L1
-            if ( refP0 != refP1 ) {          
-              if ( refP0 == refQ0 ) {
-                strength  = ((abs(mvQ0[0] - mvP0[0]) >= mvdThreashold) ||
-                             (abs(mvQ0[1] - mvP0[1]) >= mvdThreashold) ||
-                             (abs(mvQ1[0] - mvP1[0]) >= mvdThreashold) ||
-                             (abs(mvQ1[1] - mvP1[1]) >= mvdThreashold)) ? 1 : 0;
-              } else {
-                strength  = ((abs(mvQ1[0] - mvP0[0]) >= mvdThreashold) ||
-                             (abs(mvQ1[1] - mvP0[1]) >= mvdThreashold) ||
-                             (abs(mvQ0[0] - mvP1[0]) >= mvdThreashold) ||
-                             (abs(mvQ0[1] - mvP1[1]) >= mvdThreashold)) ? 1 : 0;
-              }
-            // Same L0 & L1
-            } else {  
-              strength  = ((abs(mvQ0[0] - mvP0[0]) >= mvdThreashold) ||
-                           (abs(mvQ0[1] - mvP0[1]) >= mvdThreashold) ||
-                           (abs(mvQ1[0] - mvP1[0]) >= mvdThreashold) ||
-                           (abs(mvQ1[1] - mvP1[1]) >= mvdThreashold)) &&
-                          ((abs(mvQ1[0] - mvP0[0]) >= mvdThreashold) ||
-                           (abs(mvQ1[1] - mvP0[1]) >= mvdThreashold) ||
-                           (abs(mvQ0[0] - mvP1[0]) >= mvdThreashold) ||
-                           (abs(mvQ0[1] - mvP1[1]) >= mvdThreashold)) ? 1 : 0;
-            }
-          } else {
-            strength = 1;
-          }
-        }
-        else /*if (cu_p->inter.mv_dir != 3 && cu_q->inter.mv_dir != 3)*/ { //is P-slice
-          const int refP = (cu_p->type == CU_IBC)?-2:state->frame->ref_LX[0][cu_p->inter.mv_ref[0]];
-          const int refQ = (cu_q->type == CU_IBC)?-2:state->frame->ref_LX[0][cu_q->inter.mv_ref[0]];
-          if (refP != refQ) {
-            // Reference pictures are different
-            strength = 1;
-          } else if (
-            ((abs(cu_q->inter.mv[0][0] - cu_p->inter.mv[0][0]) >= mvdThreashold) ||
-            (abs(cu_q->inter.mv[0][1] - cu_p->inter.mv[0][1]) >= mvdThreashold))) {
-            // Absolute motion vector diff between blocks >= 0.5 (Integer pixel)
-            strength = 1;
-          }
-        }
-      
-        tc_index        = CLIP(0, MAX_QP + 2, (int32_t)(qp + 2*(strength - 1) + (tc_offset_div2 << 1)));
-        tc              = lumaBitdepth < 10 ? ((uvg_g_tc_table_8x8[tc_index] + (1 << (9 - lumaBitdepth))) >> (10 - lumaBitdepth))
-                                            : ((uvg_g_tc_table_8x8[tc_index] << (lumaBitdepth - 10)));
-      }
+/**
+ * \brief Fill the deblocking map of an LCU.
+ *
+ * Store the boundary strength, the filter lengths and the QP of the left
+ * and the top edge of each 4x4 luma block of the LCU. This has to be done
+ * once the CUs and the QPs of the LCU are final and before the LCU or the
+ * LCU to the right of it are deblocked.
+ *
+ * \param state   encoder state
+ * \param x_px    x-coordinate of the left edge of the LCU in pixels
+ * \param y_px    y-coordinate of the top edge of the LCU in pixels
+ */
+void uvg_filter_deblock_map_lcu(encoder_state_t * const state, int x_px, int y_px)
+{
+  const videoframe_t * const frame = state->tile->frame;
+  const int end_x = MIN(x_px + LCU_WIDTH, frame->width);
+  const int end_y = MIN(y_px + LCU_WIDTH, frame->height);
 
-      if (strength == 0) continue;
+  const enum uvg_tree_type luma_tree = state->frame->is_irap && state->encoder_control->cfg.dual_tree ? UVG_LUMA_T : UVG_BOTH_T;
 
-      bool is_side_P_large = false;
-      bool is_side_Q_large = false;
-      uint8_t max_filter_length_P = 0;
-      uint8_t max_filter_length_Q = 0;
+  for (int y = y_px; y < end_y; y += 4) {
+    for (int x = x_px; x < end_x; x += 4) {
+      deblock_edge_info_t *ver = deblock_map_at(frame, x, y, EDGE_VER);
+      deblock_edge_info_t *hor = deblock_map_at(frame, x, y, EDGE_HOR);
+      *ver = (deblock_edge_info_t){ 0 };
+      *hor = (deblock_edge_info_t){ 0 };
 
-      const int cu_width = 1 << cu_q->log2_width;
-      const int cu_height = 1 << cu_q->log2_height;
-      const int pu_size = dir == EDGE_HOR ? cu_height : cu_width;
-      const int pu_pos = dir == EDGE_HOR ? y_coord : x_coord;
-      int tu_size_q_side = 0;
-      if (cu_q->type == CU_INTRA && cu_q->intra.isp_mode != ISP_MODE_NO_ISP) {
-        if (cu_q->intra.isp_mode == ISP_MODE_VER && dir == EDGE_VER) {
-          tu_size_q_side = MAX(4, cu_width >> 2);
-        } else if (cu_q->intra.isp_mode == ISP_MODE_HOR && dir == EDGE_HOR) {
-          tu_size_q_side = MAX(4,  cu_height >> 2);
-        } else {
-          tu_size_q_side = dir == EDGE_HOR ?
-                             MIN(1 << cu_q->log2_height, TR_MAX_WIDTH) :
-                             MIN(1 << cu_q->log2_width, TR_MAX_WIDTH);
-        }
-      } else {
-        tu_size_q_side = dir == EDGE_HOR ?
-                           MIN(1 << cu_q->log2_height, TR_MAX_WIDTH) :
-                           MIN(1 << cu_q->log2_width, TR_MAX_WIDTH);
+      // No filtering on the left and the top edge of the frame.
+      if (x > 0 && is_tu_boundary(state, x, y, EDGE_VER, COLOR_Y, luma_tree)) {
+        get_luma_edge_info(state, x, y, EDGE_VER, ver);
       }
-
-      int tu_size_p_side = 0;
-      if (cu_p->type == CU_INTRA && cu_p->intra.isp_mode != ISP_MODE_NO_ISP) {
-        if (cu_p->intra.isp_mode == ISP_MODE_VER && dir == EDGE_VER) {
-          tu_size_p_side = MAX(4, (1 << cu_p->log2_width) >> 2);
-        } else if (cu_p->intra.isp_mode == ISP_MODE_HOR && dir == EDGE_HOR) {
-          tu_size_p_side = MAX(4, (1 << cu_p->log2_height) >> 2);
-        } else {
-          tu_size_p_side = dir == EDGE_HOR ?
-                             MIN(1 << cu_p->log2_height, TR_MAX_WIDTH) :
-                             MIN(1 << cu_p->log2_width, TR_MAX_WIDTH);
-        }
-      } else {
-        tu_size_p_side = dir == EDGE_HOR ?
-                           MIN(1 << cu_p->log2_height, TR_MAX_WIDTH) :
-                           MIN(1 << cu_p->log2_width, TR_MAX_WIDTH);
-        
+      if (y > 0 && is_tu_boundary(state, x, y, EDGE_HOR, COLOR_Y, luma_tree)) {
+        get_luma_edge_info(state, x, y, EDGE_HOR, hor);
       }
+    }
+  }
+}
 
-      get_max_filter_length(&max_filter_length_P, &max_filter_length_Q, state, x_coord, y_coord,
-                            dir, tu_boundary,
-                            tu_size_p_side,
-                            tu_size_q_side,
-                            pu_pos, pu_size, cu_q->merged, COLOR_Y,
-                            UVG_LUMA_T);
-
-      if (max_filter_length_P > 3) {
-        is_side_P_large = dir == EDGE_HOR && y % LCU_WIDTH == 0 ? false : true;
-        //TODO: Add affine/ATMVP related stuff
-        /*if (max_filter_length_P > 5 && cu_p->affine) {
-          max_filter_length_P = MIN(max_filter_length_P, 5);
-        }*/
-      }
-      if (max_filter_length_Q > 3) {
-        is_side_Q_large = true;
-      }
-      //                               +-- edge_src
-      //                               v
-      // line0 p7 p6 p5 p4 p3 p2 p1 p0 q0 q1 q2 q3 q4 q5 q6 q7
-      uvg_pixel *edge_src = &src[block_idx * 4 * y_stride];
-
-      // Gather the lines of pixels required for the filter on/off decision.
-      //TODO: May need to limit reach in small blocks?
-      uvg_pixel b[4][8];
-      gather_deblock_pixels(edge_src, x_stride, 0 * y_stride, 4, &b[0][0]);
-      gather_deblock_pixels(edge_src, x_stride, 3 * y_stride, 4, &b[3][0]);
-
-      int_fast32_t dp0 = abs(b[0][1] - 2 * b[0][2] + b[0][3]);
-      int_fast32_t dq0 = abs(b[0][4] - 2 * b[0][5] + b[0][6]);
-      int_fast32_t dp3 = abs(b[3][1] - 2 * b[3][2] + b[3][3]);
-      int_fast32_t dq3 = abs(b[3][4] - 2 * b[3][5] + b[3][6]);
-      int_fast32_t dp = dp0 + dp3;
-      int_fast32_t dq = dq0 + dq3;
-
-      bool sw = false;
-
-      if (is_side_P_large || is_side_Q_large) {
-        int_fast32_t dp0L = dp0;
-        int_fast32_t dq0L = dq0;
-        int_fast32_t dp3L = dp3;
-        int_fast32_t dq3L = dq3;
-        
-        //In case of large blocks, need to gather extra pixels
-        //bL:
-        //line0 p7 p6 p5 p4 q4 q5 q6 q7
-        uvg_pixel bL[4][8];
-
-        if (is_side_P_large) {
-          gather_pixels(edge_src - 8 * x_stride, x_stride, 0 * y_stride, 4, &bL[0][0]);
-          gather_pixels(edge_src - 8 * x_stride, x_stride, 3 * y_stride, 4, &bL[3][0]);
-          dp0L = (dp0L + abs(bL[0][2] - 2 * bL[0][3] + b[0][0]) + 1) >> 1;
-          dp3L = (dp3L + abs(bL[3][2] - 2 * bL[3][3] + b[3][0]) + 1) >> 1;
-        }
-        if (is_side_Q_large) {
-          gather_pixels(edge_src + 4 * x_stride, x_stride, 0 * y_stride, 4, &bL[0][4]);
-          gather_pixels(edge_src + 4 * x_stride, x_stride, 3 * y_stride, 4, &bL[3][4]);
-          dq0L = (dq0L + abs(b[0][7] - 2 * bL[0][4] + bL[0][5]) + 1) >> 1;
-          dq3L = (dq3L + abs(b[3][7] - 2 * bL[3][4] + bL[3][5]) + 1) >> 1;
-        }
-        
-        int_fast32_t dpL = dp0L + dp3L;
-        int_fast32_t dqL = dq0L + dq3L;
-
-        if (dpL + dqL < beta) {
-          sw = use_strong_filtering(&b[0][0], &b[3][0], &bL[0][0], &bL[3][0],
-                                    dp0L, dq0L, dp3L, dq3L, tc, beta,
-                                    is_side_P_large, is_side_Q_large,
-                                    max_filter_length_P, max_filter_length_Q, false);
-          if (sw) {
-            gather_deblock_pixels(edge_src, x_stride, 1 * y_stride, 4, &b[1][0]);
-            gather_deblock_pixels(edge_src, x_stride, 2 * y_stride, 4, &b[2][0]);
-            if (is_side_P_large)
-            {
-              gather_pixels(edge_src - 8 * x_stride, x_stride, 1 * y_stride, 4, &bL[1][0]);
-              gather_pixels(edge_src - 8 * x_stride, x_stride, 2 * y_stride, 4, &bL[2][0]);
-            }
-            if (is_side_Q_large)
-            {
-              gather_pixels(edge_src + 4 * x_stride, x_stride, 1 * y_stride, 4, &bL[1][4]);
-              gather_pixels(edge_src + 4 * x_stride, x_stride, 2 * y_stride, 4, &bL[2][4]);
-            }
+/**
+ * \brief Apply the deblocking filter to luma pixels on a single edge.
+ *
+ * The filter parameters of each 4-pixel segment of the edge are taken from
+ * the deblocking map and the segments are then filtered together by the
+ * deblocking strategy.
+ *
+ \verbatim
 
-            for (int i = 0; i < 4; ++i) {
-              int filter_reach;
-              filter_reach = uvg_filter_deblock_large_block(&b[i][0], &bL[i][0], tc,
-                                                            is_side_P_large ? max_filter_length_P : 3, 
-                                                            is_side_Q_large ? max_filter_length_Q : 3);
-              scatter_deblock_pixels(&b[i][0], x_stride, i * y_stride, filter_reach, edge_src);
-              if (is_side_P_large) {
-                const int diff_reach = (max_filter_length_P - filter_reach) >> 1;
-                const int dst_offset = (filter_reach + diff_reach) * x_stride;
-                scatter_deblock_pixels(&bL[i][0] - diff_reach, x_stride, i * y_stride, diff_reach, edge_src - dst_offset);
-              }
-              if (is_side_Q_large) {
-                const int diff_reach = (max_filter_length_Q - filter_reach) >> 1;
-                const int dst_offset = (filter_reach + diff_reach) * x_stride;
-                scatter_deblock_pixels(&bL[i][0] + diff_reach, x_stride, i * y_stride, diff_reach, edge_src + dst_offset);
-              }
-            }
-          }
-        }
-      }
+         .-- filter this edge if dir == EDGE_HOR
+         v
+     +--------+
+     |o <-- pixel at (x, y)
+     |        |
+     |<-- filter this edge if dir == EDGE_VER
+     |        |
+     +--------+
 
-      if (!sw)
-      {
-        if (dp + dq < beta) {
-          if (max_filter_length_P > 2 && max_filter_length_Q > 2) {
-            // Strong filtering flag checking.
-            sw = use_strong_filtering(b[0], b[3], NULL, NULL,
-                                      dp0, dq0, dp3, dq3, tc, beta,
-                                      false, false, 7, 7, false);
-          }
+ \endverbatim
+ *
+ * \param state     encoder state
+ * \param x         x-coordinate in pixels (see above)
+ * \param y         y-coordinate in pixels (see above)
+ * \param length    length of the edge in pixels
+ * \param dir       direction of the edge to filter
+ */
+static void filter_deblock_edge_luma(encoder_state_t * const state,
+                                     int32_t x,
+                                     int32_t y,
+                                     int32_t length,
+                                     edge_dir dir)
+{
+  videoframe_t * const frame = state->tile->frame;
+  const encoder_control_t * const encoder = state->encoder_control;
 
-          // Read lines 1 and 2. Weak filtering doesn't use the outermost pixels
-          // but let's give them anyway to simplify control flow.
-          gather_deblock_pixels(edge_src, x_stride, 1 * y_stride, 4, &b[1][0]);
-          gather_deblock_pixels(edge_src, x_stride, 2 * y_stride, 4, &b[2][0]);
-
-          for (int i = 0; i < 4; ++i) {
-            int filter_reach;
-            if (sw) {
-              filter_reach = uvg_filter_deblock_luma_strong(&b[i][0], tc);
-            } else {
-              bool p_2nd = false;
-              bool q_2nd = false;
-              if (max_filter_length_P > 1 && max_filter_length_Q > 1) {
-                p_2nd = dp < side_threshold;
-                q_2nd = dq < side_threshold;
-              }
-              filter_reach = uvg_filter_deblock_luma_weak(encoder, &b[i][0], tc, p_2nd, q_2nd);
-            }
-            scatter_deblock_pixels(&b[i][0], x_stride, i * y_stride, filter_reach, edge_src);
-          }
-        }
-      }
+  const int32_t stride = frame->rec->stride;
+  const int32_t beta_offset_div2 = encoder->cfg.deblock_beta;
+  const int32_t tc_offset_div2   = encoder->cfg.deblock_tc;
+  // TODO: support 10+bits
+  uvg_pixel *src = &frame->rec->y[x + y*stride];
+
+  const int MAX_QP = 63; //TODO: Make DEFAULT_INTRA_TC_OFFSET(=2) a define?
+  const int8_t lumaBitdepth = encoder->bitdepth;
+  const int32_t bitdepth_scale = 1 << (lumaBitdepth - 8);
+
+  const uint32_t num_4px_parts = length / 4;
+  deblock_segment_t segments[LCU_WIDTH / 4];
+
+  // Transpose the image by swapping x and y strides when doing horizontal
+  // edges.
+  const int32_t x_stride = (dir == EDGE_VER) ? 1 : stride;
+  const int32_t y_stride = (dir == EDGE_VER) ? stride : 1;
+
+  // For each 4-pixel part in the edge
+  for (uint32_t block_idx = 0; block_idx < num_4px_parts; ++block_idx) {
+    const int32_t x_coord = dir == EDGE_VER ? x : x + 4 * block_idx;
+    const int32_t y_coord = dir == EDGE_VER ? y + 4 * block_idx : y;
+    const deblock_edge_info_t *info = deblock_map_at(frame, x_coord, y_coord, dir);
+    deblock_segment_t *seg = &segments[block_idx];
+
+    if (info->bs == 0) {
+      seg->tc = 0;
+      continue;
     }
+
+    const int32_t qp = info->qp;
+    const int32_t b_index  = CLIP(0, MAX_QP, qp + (beta_offset_div2 << 1));
+    const int32_t tc_index = CLIP(0, MAX_QP + 2, (int32_t)(qp + 2 * (info->bs - 1) + (tc_offset_div2 << 1)));
+    seg->beta = uvg_g_beta_table_8x8[b_index] * bitdepth_scale;
+    seg->tc   = lumaBitdepth < 10 ? ((uvg_g_tc_table_8x8[tc_index] + (1 << (9 - lumaBitdepth))) >> (10 - lumaBitdepth))
+                                  : ((uvg_g_tc_table_8x8[tc_index] << (lumaBitdepth - 10)));
+
+    seg->max_filter_length_P = info->max_filter_length_P;
+    seg->max_filter_length_Q = info->max_filter_length_Q;
+    //TODO: Add affine/ATMVP related stuff
+    /*if (max_filter_length_P > 5 && cu_p->affine) {
+      max_filter_length_P = MIN(max_filter_length_P, 5);
+    }*/
+    seg->is_side_P_large = info->max_filter_length_P > 3 && !(dir == EDGE_HOR && y % LCU_WIDTH == 0);
+    seg->is_side_Q_large = info->max_filter_length_Q > 3;
   }
+
+  uvg_deblock_luma_edge(src, x_stride, y_stride, segments, num_4px_parts);
 }
 
 /**
@@ -1194,7 +911,7 @@ static void filter_deblock_edge_chroma(encoder_state_t * const state,
 
 
 /**
- * \brief Filter edge of a single PU or TU
+ * \brief Filter chroma edge of a single PU or TU
  *
  * \param state     encoder state
  * \param x         block x-position in pixels
@@ -1239,10 +956,6 @@ static void filter_deblock_unit(
     length   = height;
   }
 
-  if(tree_type != UVG_CHROMA_T) {
-    filter_deblock_edge_luma(state, x, y, length, dir, tu_boundary);
-  }
-
   // Chroma pixel coordinates.
   const int32_t x_c = x >> 1;
   const int32_t y_c = y >> 1;
@@ -1256,6 +969,62 @@ static void filter_deblock_unit(
 }
 
 
+/**
+ * \brief Filter a luma edge in runs of consecutive segments with a nonzero
+ *        boundary strength in the deblocking map.
+ *
+ * The pixels of the segments of a run are only modified by the filtering of
+ * the run itself, so all the segments of the run are filtered together.
+ *
+ * \param state     encoder state
+ * \param pos       x-coordinate of a vertical edge or y-coordinate of a
+ *                  horizontal edge in pixels
+ * \param start     first pixel of the edge along its direction
+ * \param end       end of the edge along its direction (exclusive)
+ * \param dir       direction of the edge to filter
+ * \param defer_rightmost  whether to leave the rightmost 8 pixels of an LCU
+ *                         to be filtered with the next LCU
+ */
+static void filter_deblock_edge_luma_runs(encoder_state_t * const state,
+                                          int32_t pos,
+                                          int32_t start,
+                                          int32_t end,
+                                          edge_dir dir,
+                                          bool defer_rightmost)
+{
+  const videoframe_t * const frame = state->tile->frame;
+  const int32_t frame_width = frame->width;
+  int32_t run_start = start;
+  int32_t run_length = 0;
+
+  for (int32_t along = start; along <= end; along += 4) {
+    const int32_t x = dir == EDGE_VER ? pos : along;
+    const int32_t y = dir == EDGE_VER ? along : pos;
+
+    bool filtered = along < end && deblock_map_at(frame, x, y, dir)->bs != 0;
+    if (filtered && defer_rightmost) {
+      // The last 8 pixels will be deblocked when processing the next LCU.
+      const int32_t x_right = x + 4;
+      const bool rightmost_8px_of_lcu = x_right % LCU_WIDTH == 0 || x_right % LCU_WIDTH == LCU_WIDTH - 4;
+      const bool rightmost_8px_of_frame = x_right == frame_width || x_right + 4 == frame_width;
+      filtered = !rightmost_8px_of_lcu || rightmost_8px_of_frame;
+    }
+
+    if (filtered) {
+      if (run_length == 0) run_start = along;
+      run_length += 4;
+    } else if (run_length > 0) {
+      if (dir == EDGE_VER) {
+        filter_deblock_edge_luma(state, pos, run_start, run_length, dir);
+      } else {
+        filter_deblock_edge_luma(state, run_start, pos, run_length, dir);
+      }
+      run_length = 0;
+    }
+  }
+}
+
+
 /**
  * \brief Deblock PU and TU boundaries inside an LCU.
  *
@@ -1264,9 +1033,11 @@ static void filter_deblock_unit(
  * \param y_px      block y-position in pixels
  * \param dir       direction of the edges to filter
  *
- * Recursively traverse the CU/TU quadtree. At the lowest level, apply the
- * deblocking filter to the left edge (when dir == EDGE_VER) or the top edge
- * (when dir == EDGE_HOR) as needed. Both luma and chroma are filtered.
+ * Luma edges are filtered along the whole LCU in runs of TU boundaries.
+ * Vertical edges only modify their own rows and horizontal edges their own
+ * columns, so this gives the same result as the unit by unit order.
+ * Chroma edges are filtered at the left edge (when dir == EDGE_VER) or the
+ * top edge (when dir == EDGE_HOR) of each 4x4 unit as needed.
  */
 static void filter_deblock_lcu_inside(encoder_state_t * const state,
                                       int32_t x,
@@ -1279,6 +1050,16 @@ static void filter_deblock_lcu_inside(encoder_state_t * const state,
   const enum uvg_tree_type luma_tree = state->frame->is_irap && state->encoder_control->cfg.dual_tree ? UVG_LUMA_T : UVG_BOTH_T;
   const enum uvg_tree_type chroma_tree = state->frame->is_irap && state->encoder_control->cfg.dual_tree ? UVG_CHROMA_T : UVG_BOTH_T;
 
+  if (dir == EDGE_VER) {
+    for (int edge_x = x; edge_x < end_x; edge_x += 4) {
+      filter_deblock_edge_luma_runs(state, edge_x, y, end_y, dir, false);
+    }
+  } else {
+    for (int edge_y = y; edge_y < end_y; edge_y += 4) {
+      filter_deblock_edge_luma_runs(state, edge_y, x, end_x, dir, true);
+    }
+  }
+
   for (int edge_y = y; edge_y < end_y; edge_y += 4) {
     for (int edge_x = x; edge_x < end_x; edge_x += 4) {
       bool tu_boundary = is_tu_boundary(state, edge_x, edge_y, dir, COLOR_Y, luma_tree);
@@ -1309,14 +1090,9 @@ static void filter_deblock_lcu_rightmost(encoder_state_t * const state,
   const enum uvg_tree_type chroma_tree = state->frame->is_irap && state->encoder_control->cfg.dual_tree ? UVG_CHROMA_T : UVG_BOTH_T;
 
   const int end = MIN(y_px + LCU_WIDTH, state->tile->frame->height);
-  for (int x = x_px - 8; x < x_px; x += 4) {
-    for (int y = y_px; y < end; y += 4) {
-      // The top edge of the whole frame is not filtered.
-      bool tu_boundary = is_tu_boundary(state, x, y, EDGE_HOR, COLOR_Y, luma_tree);
-      if (y > 0 && (tu_boundary || is_pu_boundary(state, x, y, EDGE_HOR))) {
-        filter_deblock_edge_luma(state, x, y, 4, EDGE_HOR, tu_boundary);
-      }
-    }
+  for (int y = y_px; y < end; y += 4) {
+    // The top edge of the whole frame is not filtered.
+    filter_deblock_edge_luma_runs(state, y, x_px - 8, x_px, EDGE_HOR, false);
   }
 
   // Chroma
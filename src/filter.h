@@ -50,7 +50,30 @@ typedef enum edge_dir {
   EDGE_HOR = 2, // horizontal
 } edge_dir;
 
+/**
+ * \brief Filter parameters of a 4-sample segment of a luma edge.
+ */
+typedef struct deblock_segment_t {
+  int32_t tc;                   //!< tc threshold, 0 when the segment is not filtered
+  int32_t beta;                 //!< beta threshold
+  uint8_t max_filter_length_P;  //!< maximum filter length in the P block
+  uint8_t max_filter_length_Q;  //!< maximum filter length in the Q block
+  bool is_side_P_large;         //!< whether the P side uses the long filters
+  bool is_side_Q_large;         //!< whether the Q side uses the long filters
+} deblock_segment_t;
+
+/**
+ * \brief Deblocking parameters of the left or the top edge of a 4x4 luma block.
+ */
+typedef struct deblock_edge_info_t {
+  uint8_t bs : 2;                   //!< \brief boundary strength, 0 when the edge is not filtered
+  uint8_t max_filter_length_P : 3;  //!< \brief maximum filter length in the P block
+  uint8_t max_filter_length_Q : 3;  //!< \brief maximum filter length in the Q block
+  int8_t qp;                        //!< \brief average luma QP of the P and Q blocks
+} deblock_edge_info_t;
+
 
+void uvg_filter_deblock_map_lcu(encoder_state_t *state, int x_px, int y_px);
 void uvg_filter_deblock_lcu(encoder_state_t *state, int x_px, int y_px);
 
 #endif
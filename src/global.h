@@ -209,6 +209,16 @@ typedef int32_t mv_t;
 #define FRAME_PADDING_LUMA 8
 #define FRAME_PADDING_CHROMA (FRAME_PADDING_LUMA/2)
 
+/**
+ * \brief Number of pixels the reconstructed pictures are extended by on
+ * each side with --ref-padding.
+ *
+ * Covers the 96 pixel range of the TZ search and the eight taps of the
+ * luma interpolation filter. Blocks further outside the picture are still
+ * extrapolated by uvg_get_extended_block.
+ */
+#define REF_PADDING_LUMA 112
+
 
 /**
  * \brief Number of Most Probable Modes in Intra coding
@@ -240,11 +250,12 @@ typedef int32_t mv_t;
  * \brief Number of pixels to delay SAO in horizontal and vertical
  * directions.
  *
- * Number of pixels at the bottom and right side of the LCU that are not
- * filtered with SAO until when filtering the neighboring LCU. SAO
+ * Number of pixels at the bottom and right side of the LCU that cannot be
+ * filtered with SAO until the neighboring LCU has been deblocked. SAO
  * reconstruction requires that a one pixels border has been deblocked for
  * both luma and chroma.  Therefore, SAO_DELAY_PX is set to
- * DEBLOCK_DELAY_PX + 2.
+ * DEBLOCK_DELAY_PX + 2. The SAO is done for whole LCU rows, but the motion
+ * vectors of the frames coded in parallel keep this margin.
  */
 #define SAO_DELAY_PX (DEBLOCK_DELAY_PX + 2)
 
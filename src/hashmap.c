@@ -32,6 +32,8 @@
 
 #include "hashmap.h"
 
+#include "threads.h"
+
 /**
  * \brief This function creates a node for the uvg_hashmap.
  * 
@@ -148,3 +150,57 @@ void uvg_hashmap_free(uvg_hashmap_t* map) {
   free(map->table);
   free(map);
 }
+
+/**
+ * \brief This function allocates a block hash for a picture.
+ *
+ * \param width  width of the picture
+ * \param height height of the picture
+ * \return uvg_block_hash an empty block hash with one reference
+ */
+uvg_block_hash_t* uvg_block_hash_alloc(int32_t width, int32_t height)
+{
+  uvg_block_hash_t* hash = (uvg_block_hash_t*)malloc(sizeof(uvg_block_hash_t));
+  const uint32_t rows = height / UVG_BLOCK_HASH_STEP;
+  hash->stride = width / UVG_BLOCK_HASH_STEP;
+  hash->map = uvg_hashmap_create(MAX(1, rows * hash->stride));
+  hash->pos_to_hash = (uint32_t*)calloc(MAX(1, rows * hash->stride), sizeof(uint32_t));
+  hash->refcount = 1;
+  return hash;
+}
+
+/**
+ * \brief This function adds a reference to a block hash.
+ *
+ * \param hash the block hash to reference
+ * \return the same block hash
+ */
+uvg_block_hash_t* uvg_block_hash_copy_ref(uvg_block_hash_t* hash)
+{
+  int32_t new_refcount = UVG_ATOMIC_INC(&hash->refcount);
+  // The caller should have had another reference.
+  assert(new_refcount > 1);
+  return hash;
+}
+
+/**
+ * \brief This function releases a reference to a block hash and frees the
+ *        memory when the last reference is released.
+ *
+ * Sets the pointer to NULL. Does nothing if the pointer is already NULL.
+ *
+ * \param hash_ptr pointer to the block hash to release
+ */
+void uvg_block_hash_free(uvg_block_hash_t** hash_ptr)
+{
+  uvg_block_hash_t* hash = *hash_ptr;
+  if (hash == NULL) return;
+  *hash_ptr = NULL;
+
+  int32_t new_refcount = UVG_ATOMIC_DEC(&hash->refcount);
+  if (new_refcount > 0) return;
+
+  uvg_hashmap_free(hash->map);
+  free(hash->pos_to_hash);
+  free(hash);
+}
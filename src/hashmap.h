@@ -40,6 +40,8 @@
 #define UVG_HASHMAP_RATIO 12.0
 // Use Hashmap for 4x4 blocks
 #define UVG_HASHMAP_BLOCKSIZE 8
+// Distance between the hashed blocks of a uvg_block_hash
+#define UVG_BLOCK_HASH_STEP (UVG_HASHMAP_BLOCKSIZE >> 1)
 
 typedef struct uvg_hashmap_node {
     void*    next;  
@@ -68,3 +70,19 @@ uint32_t uvg_hashmap_search_return_first(uvg_hashmap_t* map, uint32_t key);
 void uvg_hashmap_node_free(uvg_hashmap_node_t* node);
 
 void uvg_hashmap_free(uvg_hashmap_t* map);
+
+/**
+ * \brief Hash of the 8x8 luma blocks of a picture for hash motion search.
+ */
+typedef struct uvg_block_hash {
+  uvg_hashmap_t* map;     //!< \brief Block CRC to packed block position
+  uint32_t* pos_to_hash;  //!< \brief Block CRC at every UVG_BLOCK_HASH_STEP:th position
+  uint32_t stride;        //!< \brief Stride of pos_to_hash
+  int32_t refcount;       //!< \brief Number of references to the block hash
+} uvg_block_hash_t;
+
+uvg_block_hash_t* uvg_block_hash_alloc(int32_t width, int32_t height);
+
+uvg_block_hash_t* uvg_block_hash_copy_ref(uvg_block_hash_t* hash);
+
+void uvg_block_hash_free(uvg_block_hash_t** hash_ptr);
@@ -54,19 +54,35 @@ uvg_picture * uvg_image_alloc_420(const int32_t width, const int32_t height)
  * \return image pointer or NULL on failure
  */
 uvg_picture * uvg_image_alloc(enum uvg_chroma_format chroma_format, const int32_t width, const int32_t height)
+{
+  //Add 4 pixel boundary to each side of luma for ALF
+  //This results also 2 pixel boundary for chroma
+  return uvg_image_alloc_padded(chroma_format, width, height, FRAME_PADDING_LUMA / 2);
+}
+
+/**
+ * \brief Allocate a new image with a border around it.
+ *
+ * \param padding  Number of luma pixels on each side of the picture. The
+ *                 chroma planes get half of it.
+ * \return image pointer or NULL on failure
+ */
+uvg_picture * uvg_image_alloc_padded(enum uvg_chroma_format chroma_format,
+                                     const int32_t width,
+                                     const int32_t height,
+                                     const int32_t padding)
 {
   //Assert that we have a well defined image
   assert((width % 2) == 0);
   assert((height % 2) == 0);
+  assert((padding % 2) == 0);
 
   const size_t simd_padding_width = 64;
 
   uvg_picture *im = MALLOC(uvg_picture, 1);
   if (!im) return NULL;
 
-  //Add 4 pixel boundary to each side of luma for ALF
-  //This results also 2 pixel boundary for chroma
-  unsigned int luma_size = (width + FRAME_PADDING_LUMA) * (height + FRAME_PADDING_LUMA);
+  unsigned int luma_size = (width + 2 * padding) * (height + 2 * padding);
 
   unsigned chroma_sizes[] = { 0, luma_size / 4, luma_size / 2, luma_size };
   unsigned chroma_size = chroma_sizes[chroma_format];
@@ -84,10 +100,10 @@ uvg_picture * uvg_image_alloc(enum uvg_chroma_format chroma_format, const int32_
   im->refcount = 1; //We give a reference to caller
   im->width = width;
   im->height = height;
-  im->stride = width + FRAME_PADDING_LUMA;
+  im->stride = width + 2 * padding;
   im->chroma_format = chroma_format;
-  const int padding_before_first_pixel_luma = (FRAME_PADDING_LUMA / 2) * (im->stride) + FRAME_PADDING_LUMA / 2;
-  const int padding_before_first_pixel_chroma = (FRAME_PADDING_CHROMA / 2) * (im->stride/2) + FRAME_PADDING_CHROMA / 2;
+  const int padding_before_first_pixel_luma = padding * (im->stride) + padding;
+  const int padding_before_first_pixel_chroma = (padding / 2) * (im->stride/2) + padding / 2;
   im->fulldata = &im->fulldata_buf[padding_before_first_pixel_luma] + simd_padding_width / sizeof(uvg_pixel);
   im->base_image = im;
 
@@ -202,6 +218,88 @@ uvg_picture *uvg_image_make_subimage(uvg_picture *const orig_image,
   return im;
 }
 
+/**
+ * \brief Extend the borders of a rectangle of one plane by replicating the
+ * edge pixels, if the rectangle touches the edges of the plane.
+ */
+static void extend_plane_borders(uvg_pixel *const data,
+                                 const int stride,
+                                 const int plane_width,
+                                 const int plane_height,
+                                 const int x,
+                                 const int y,
+                                 const int width,
+                                 const int height,
+                                 const int padding)
+{
+  const bool left = x == 0;
+  const bool right = x + width == plane_width;
+
+  if (left || right) {
+    for (int row = y; row < y + height; ++row) {
+      uvg_pixel *const line = &data[row * stride];
+      if (left) {
+        for (int i = -padding; i < 0; ++i) line[i] = line[0];
+      }
+      if (right) {
+        for (int i = plane_width; i < plane_width + padding; ++i) line[i] = line[plane_width - 1];
+      }
+    }
+  }
+
+  // The lines above and below the picture include the corners.
+  const int x_start = left ? -padding : x;
+  const int x_end = right ? plane_width + padding : x + width;
+  if (y == 0) {
+    for (int row = -padding; row < 0; ++row) {
+      memcpy(&data[row * stride + x_start], &data[x_start], (x_end - x_start) * sizeof(uvg_pixel));
+    }
+  }
+  if (y + height == plane_height) {
+    const uvg_pixel *const last = &data[(plane_height - 1) * stride];
+    for (int row = plane_height; row < plane_height + padding; ++row) {
+      memcpy(&data[row * stride + x_start], &last[x_start], (x_end - x_start) * sizeof(uvg_pixel));
+    }
+  }
+}
+
+/**
+ * \brief Extend the borders of a picture around a rectangle of it.
+ *
+ * The pixels on the edges of the picture are replicated to the border for
+ * the part of the edges covered by the rectangle. The borders are then the
+ * same as what uvg_get_extended_block makes for the blocks outside the
+ * picture, so the pictures can be read directly up to the padding. The
+ * rectangles can be extended in any order once their pixels are final.
+ *
+ * \param im       Picture allocated with at least the padding.
+ * \param x        Left edge of the rectangle in luma pixels.
+ * \param y        Top edge of the rectangle in luma pixels.
+ * \param width    Width of the rectangle in luma pixels.
+ * \param height   Height of the rectangle in luma pixels.
+ * \param padding  Number of luma pixels to extend on each side.
+ */
+void uvg_image_extend_borders(uvg_picture *const im,
+                              const int x,
+                              const int y,
+                              const int width,
+                              const int height,
+                              const int padding)
+{
+  assert(x >= 0 && x + width <= im->width);
+  assert(y >= 0 && y + height <= im->height);
+
+  extend_plane_borders(im->y, im->stride, im->width, im->height,
+                       x, y, width, height, padding);
+  if (im->chroma_format != UVG_CSP_400) {
+    const int stride_c = im->stride / 2;
+    extend_plane_borders(im->u, stride_c, im->width / 2, im->height / 2,
+                         x / 2, y / 2, width / 2, height / 2, padding / 2);
+    extend_plane_borders(im->v, stride_c, im->width / 2, im->height / 2,
+                         x / 2, y / 2, width / 2, height / 2, padding / 2);
+  }
+}
+
 yuv_t * uvg_yuv_t_alloc(int luma_size, int chroma_size)
 {
   yuv_t *yuv = (yuv_t *)malloc(sizeof(*yuv));
@@ -430,8 +528,9 @@ static unsigned image_interpolated_sad(const uvg_picture *pic, const uvg_picture
 /**
 * \brief Calculate interpolated SAD between two blocks.
 *
-* \param pic        Image for the block we are trying to find.
-* \param ref        Image where we are trying to find the block.
+* \param pic          Image for the block we are trying to find.
+* \param ref          Image where we are trying to find the block.
+* \param ref_padding  Number of pixels the borders of ref have been extended by.
 *
 * \returns          Sum of absolute differences
 */
@@ -443,18 +542,20 @@ unsigned uvg_image_calc_sad(const uvg_picture *pic,
                             int ref_y,
                             int block_width,
                             int block_height,
-                            optimized_sad_func_ptr_t optimized_sad)
+                            optimized_sad_func_ptr_t optimized_sad,
+                            int ref_padding)
 {
   assert(pic_x >= 0 && pic_x <= pic->width - block_width);
   assert(pic_y >= 0 && pic_y <= pic->height - block_height);
 
   uint32_t res;
 
-  if (ref_x >= 0 && ref_x <= ref->width  - block_width &&
-      ref_y >= 0 && ref_y <= ref->height - block_height)
+  if (ref_x >= -ref_padding && ref_x <= ref->width  - block_width + ref_padding &&
+      ref_y >= -ref_padding && ref_y <= ref->height - block_height + ref_padding)
   {
-    // Reference block is completely inside the frame, so just calculate the
-    // SAD directly. This is the most common case, which is why it's first.
+    // Reference block is completely inside the frame or its extended
+    // borders, so just calculate the SAD directly. This is the most common
+    // case, which is why it's first.
     const uvg_pixel *pic_data = &pic->y[pic_y * pic->stride + pic_x];
     const uvg_pixel *ref_data = &ref->y[ref_y * ref->stride + ref_x];
 
@@ -476,8 +577,9 @@ unsigned uvg_image_calc_sad(const uvg_picture *pic,
 /**
 * \brief Calculate interpolated SATD between two blocks.
 *
-* \param pic        Image for the block we are trying to find.
-* \param ref        Image where we are trying to find the block.
+* \param pic          Image for the block we are trying to find.
+* \param ref          Image where we are trying to find the block.
+* \param ref_padding  Number of pixels the borders of ref have been extended by.
 */
 unsigned uvg_image_calc_satd(const uvg_picture *pic,
                              const uvg_picture *ref,
@@ -487,16 +589,18 @@ unsigned uvg_image_calc_satd(const uvg_picture *pic,
                              int ref_y,
                              int block_width,
                              int block_height,
-                             uint8_t ref_wraparound)
+                             uint8_t ref_wraparound,
+                             int ref_padding)
 {
   assert(pic_x >= 0 && pic_x <= pic->width - block_width);
   assert(pic_y >= 0 && pic_y <= pic->height - block_height);
 
-  if (ref_x >= 0 && ref_x <= ref->width  - block_width &&
-      ref_y >= 0 && ref_y <= ref->height - block_height)
+  if (ref_x >= -ref_padding && ref_x <= ref->width  - block_width + ref_padding &&
+      ref_y >= -ref_padding && ref_y <= ref->height - block_height + ref_padding)
   {
-    // Reference block is completely inside the frame, so just calculate the
-    // SAD directly. This is the most common case, which is why it's first.
+    // Reference block is completely inside the frame or its extended
+    // borders, so just calculate the SAD directly. This is the most common
+    // case, which is why it's first.
     const uvg_pixel *pic_data = &pic->y[pic_y * pic->stride + pic_x];
     const uvg_pixel *ref_data = &ref->y[ref_y * ref->stride + ref_x];
     return uvg_satd_any_size(block_width,
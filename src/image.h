@@ -78,6 +78,10 @@ typedef struct {
 
 uvg_picture *uvg_image_alloc_420(const int32_t width, const int32_t height);
 uvg_picture *uvg_image_alloc(enum uvg_chroma_format chroma_format, const int32_t width, const int32_t height);
+uvg_picture *uvg_image_alloc_padded(enum uvg_chroma_format chroma_format,
+                                    const int32_t width,
+                                    const int32_t height,
+                                    const int32_t padding);
 
 void uvg_image_free(uvg_picture *im);
 
@@ -89,6 +93,13 @@ uvg_picture *uvg_image_make_subimage(uvg_picture *const orig_image,
                              const unsigned width,
                              const unsigned height);
 
+void uvg_image_extend_borders(uvg_picture *const im,
+                              const int x,
+                              const int y,
+                              const int width,
+                              const int height,
+                              const int padding);
+
 yuv_t * uvg_yuv_t_alloc(int luma_size, int chroma_size);
 void uvg_yuv_t_free(yuv_t * yuv);
 
@@ -102,7 +113,8 @@ unsigned uvg_image_calc_sad(const uvg_picture *pic,
                             int ref_y,
                             int block_width,
                             int block_height,
-                            optimized_sad_func_ptr_t optimized_sad);
+                            optimized_sad_func_ptr_t optimized_sad,
+                            int ref_padding);
 
 
 unsigned uvg_image_calc_satd(const uvg_picture *pic,
@@ -113,7 +125,8 @@ unsigned uvg_image_calc_satd(const uvg_picture *pic,
                              int ref_y,
                              int block_width,
                              int block_height,
-                             uint8_t ref_wraparound);
+                             uint8_t ref_wraparound,
+                             int ref_padding);
 
 
 void uvg_pixels_blit(const uvg_pixel* orig, uvg_pixel *dst,
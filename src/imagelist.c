@@ -49,7 +49,8 @@ image_list_t * uvg_image_list_alloc(int size)
   image_list_t *list = (image_list_t *)malloc(sizeof(image_list_t));
   list->size      = size;
   list->images    = malloc(sizeof(uvg_picture*)  * size);
-  list->cu_arrays = malloc(sizeof(cu_array_t*)   * size);
+  list->motion_fields = malloc(sizeof(motion_field_t*) * size);
+  list->block_hashes = malloc(sizeof(uvg_block_hash_t*) * size);
   list->pocs      = malloc(sizeof(int32_t)       * size);
   list->ref_LXs   = malloc(sizeof(*list->ref_LXs) * size);
   list->used_size = 0;
@@ -66,11 +67,12 @@ image_list_t * uvg_image_list_alloc(int size)
 int uvg_image_list_resize(image_list_t *list, unsigned size)
 {
   list->images = (uvg_picture**)realloc(list->images, sizeof(uvg_picture*) * size);
-  list->cu_arrays = (cu_array_t**)realloc(list->cu_arrays, sizeof(cu_array_t*) * size);
+  list->motion_fields = (motion_field_t**)realloc(list->motion_fields, sizeof(motion_field_t*) * size);
+  list->block_hashes = (uvg_block_hash_t**)realloc(list->block_hashes, sizeof(uvg_block_hash_t*) * size);
   list->pocs = realloc(list->pocs, sizeof(int32_t) * size);
   list->ref_LXs = realloc(list->ref_LXs, sizeof(*list->ref_LXs) * size);
   list->size = size;
-  return size == 0 || (list->images && list->cu_arrays && list->pocs);
+  return size == 0 || (list->images && list->motion_fields && list->block_hashes && list->pocs);
 }
 
 /**
@@ -85,8 +87,9 @@ int uvg_image_list_destroy(image_list_t *list)
     for (i = 0; i < list->used_size; ++i) {
       uvg_image_free(list->images[i]);
       list->images[i] = NULL;
-      uvg_cu_array_free(&list->cu_arrays[i]);
-      list->cu_arrays[i] = NULL;
+      uvg_motion_field_free(&list->motion_fields[i]);
+      list->motion_fields[i] = NULL;
+      uvg_block_hash_free(&list->block_hashes[i]);
       list->pocs[i] = 0;
       for (int j = 0; j < 16; j++) {
         list->ref_LXs[i][0][j] = 0;
@@ -97,12 +100,14 @@ int uvg_image_list_destroy(image_list_t *list)
 
   if (list->size > 0) {
     free(list->images);
-    free(list->cu_arrays);
+    free(list->motion_fields);
+    free(list->block_hashes);
     free(list->pocs);
     free(list->ref_LXs);
   }
   list->images = NULL;
-  list->cu_arrays = NULL;
+  list->motion_fields = NULL;
+  list->block_hashes = NULL;
   list->pocs = NULL;
   list->ref_LXs = NULL;
   free(list);
@@ -115,7 +120,7 @@ int uvg_image_list_destroy(image_list_t *list)
  * \param picture_list list to use
  * \return 1 on success
  */
-int uvg_image_list_add(image_list_t *list, uvg_picture *im, cu_array_t *cua, int32_t poc, uint8_t ref_LX[2][16])
+int uvg_image_list_add(image_list_t *list, uvg_picture *im, motion_field_t *mf, uvg_block_hash_t *block_hash, int32_t poc, uint8_t ref_LX[2][16])
 {
   int i = 0;
   if (UVG_ATOMIC_INC(&(im->refcount)) == 1) {
@@ -124,12 +129,16 @@ int uvg_image_list_add(image_list_t *list, uvg_picture *im, cu_array_t *cua, int
     return 0;
   }
   
-  if (UVG_ATOMIC_INC(&(cua->refcount)) == 1) {
-    fprintf(stderr, "Tried to add an unreferenced cu_array. This is a bug!\n");
+  if (UVG_ATOMIC_INC(&(mf->refcount)) == 1) {
+    fprintf(stderr, "Tried to add an unreferenced motion field. This is a bug!\n");
     assert(0); //Stop for debugging
     return 0;
   }
 
+  if (block_hash) {
+    block_hash = uvg_block_hash_copy_ref(block_hash);
+  }
+
   if (list->size == list->used_size) {
     unsigned new_size = MAX(list->size + 1, list->size * 2);
     if (!uvg_image_list_resize(list, new_size)) return 0;
@@ -137,7 +146,8 @@ int uvg_image_list_add(image_list_t *list, uvg_picture *im, cu_array_t *cua, int
   
   for (i = list->used_size; i > 0; i--) {
     list->images[i] = list->images[i - 1];
-    list->cu_arrays[i] = list->cu_arrays[i - 1];
+    list->motion_fields[i] = list->motion_fields[i - 1];
+    list->block_hashes[i] = list->block_hashes[i - 1];
     list->pocs[i] = list->pocs[i - 1];
     for (int j = 0; j < 16; j++) {
       list->ref_LXs[i][0][j] = list->ref_LXs[i - 1][0][j];
@@ -146,7 +156,8 @@ int uvg_image_list_add(image_list_t *list, uvg_picture *im, cu_array_t *cua, int
   }
 
   list->images[0] = im;
-  list->cu_arrays[0] = cua;
+  list->motion_fields[0] = mf;
+  list->block_hashes[0] = block_hash;
   list->pocs[0] = poc;
   for (int j = 0; j < 16; j++) {
     list->ref_LXs[0][0][j] = ref_LX[0][j];
@@ -173,12 +184,14 @@ int uvg_image_list_rem(image_list_t * const list, const unsigned n)
 
   uvg_image_free(list->images[n]);
 
-  uvg_cu_array_free(&list->cu_arrays[n]);
+  uvg_motion_field_free(&list->motion_fields[n]);
+
+  uvg_block_hash_free(&list->block_hashes[n]);
 
   // The last item is easy to remove
   if (n == list->used_size - 1) {
     list->images[n] = NULL;
-    list->cu_arrays[n] = NULL;
+    list->motion_fields[n] = NULL;
     list->pocs[n] = 0;
     for (int j = 0; j < 16; j++) {
       list->ref_LXs[n][0][j] = 0;
@@ -190,7 +203,8 @@ int uvg_image_list_rem(image_list_t * const list, const unsigned n)
     // Shift all following pics one backward in the list
     for (i = n; i < list->used_size - 1; ++i) {
       list->images[i] = list->images[i + 1];
-      list->cu_arrays[i] = list->cu_arrays[i + 1];
+      list->motion_fields[i] = list->motion_fields[i + 1];
+      list->block_hashes[i] = list->block_hashes[i + 1];
       list->pocs[i] = list->pocs[i + 1];
       for (uint32_t j = 0; j < 16; j++) {
         list->ref_LXs[i][0][j] = list->ref_LXs[i + 1][0][j];
@@ -198,7 +212,8 @@ int uvg_image_list_rem(image_list_t * const list, const unsigned n)
       }
     }
     list->images[list->used_size - 1] = NULL;
-    list->cu_arrays[list->used_size - 1] = NULL;
+    list->motion_fields[list->used_size - 1] = NULL;
+    list->block_hashes[list->used_size - 1] = NULL;
     list->pocs[list->used_size - 1] = 0;
     for (int j = 0; j < 16; j++) {
       list->ref_LXs[list->used_size - 1][0][j] = 0;
@@ -217,7 +232,7 @@ int uvg_image_list_copy_contents(image_list_t *target, image_list_t *source) {
   }
   
   for (i = source->used_size - 1; i >= 0; --i) {
-    uvg_image_list_add(target, source->images[i], source->cu_arrays[i], source->pocs[i], source->ref_LXs[i]);
+    uvg_image_list_add(target, source->images[i], source->motion_fields[i], source->block_hashes[i], source->pocs[i], source->ref_LXs[i]);
   }
   return 1;
 }
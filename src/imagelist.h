@@ -40,6 +40,7 @@
 
 #include "cu.h"
 #include "global.h" // IWYU pragma: keep
+#include "hashmap.h"
 #include "uvg266.h"
 
 
@@ -49,7 +50,8 @@
 typedef struct
 {
   struct uvg_picture* *images;          //!< \brief Pointer to array of picture pointers.
-  cu_array_t* *cu_arrays;
+  motion_field_t* *motion_fields; //!< \brief Compressed motion of each image for TMVP.
+  uvg_block_hash_t* *block_hashes; //!< \brief Block hash of each image for hash motion search or NULL.
   int32_t *pocs;
   uint8_t (*ref_LXs)[2][16]; //!< L0 and L1 reference index list for each image
   uint32_t size;       //!< \brief Array size.
@@ -61,7 +63,7 @@ typedef struct
 image_list_t * uvg_image_list_alloc(int size);
 int uvg_image_list_resize(image_list_t *list, unsigned size);
 int uvg_image_list_destroy(image_list_t *list);
-int uvg_image_list_add(image_list_t *list, uvg_picture *im, cu_array_t* cua, int32_t poc, uint8_t ref_LX[2][16]);
+int uvg_image_list_add(image_list_t *list, uvg_picture *im, motion_field_t* mf, uvg_block_hash_t* block_hash, int32_t poc, uint8_t ref_LX[2][16]);
 int uvg_image_list_rem(image_list_t *list, unsigned n);
 
 int uvg_image_list_copy_contents(image_list_t *target, image_list_t *source);
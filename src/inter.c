@@ -50,8 +50,8 @@ const int8_t uvg_g_imv_to_prec[4] = { 2, 0, -2, 1 }; // Convert AMVR imv to prec
 typedef struct {
   const cu_info_t *a[2];
   const cu_info_t *b[3];
-  const cu_info_t *c0;
-  const cu_info_t *c1;
+  const motion_info_t *c0;
+  const motion_info_t *c1;
 
 } merge_candidates_t;
 
@@ -81,6 +81,7 @@ static void inter_recon_frac_luma(const encoder_state_t * const state,
     .src_w = ref->width,
     .src_h = ref->height,
     .src_s = ref->stride,
+    .src_pad = state->encoder_control->ref_padding,
     .blk_x = state->tile->offset_x + xpos + (mv_param[0] >> INTERNAL_MV_PREC),
     .blk_y = state->tile->offset_y + ypos + (mv_param[1] >> INTERNAL_MV_PREC),
     .blk_w = block_width,
@@ -141,6 +142,7 @@ static void inter_recon_frac_luma_hi(const encoder_state_t *const state,
     .src_w = ref->width,
     .src_h = ref->height,
     .src_s = ref->stride,
+    .src_pad = state->encoder_control->ref_padding,
     .blk_x = state->tile->offset_x + xpos + (mv_param[0] >> INTERNAL_MV_PREC),
     .blk_y = state->tile->offset_y + ypos + (mv_param[1] >> INTERNAL_MV_PREC),
     .blk_w = block_width,
@@ -208,6 +210,7 @@ static void inter_recon_frac_chroma(const encoder_state_t *const state,
     .src_w = ref->width / 2,
     .src_h = ref->height / 2,
     .src_s = ref->stride / 2,
+    .src_pad = state->encoder_control->ref_padding / 2,
     .blk_x = (state->tile->offset_x + pu_x) / 2 + (mv_param[0] >> (INTERNAL_MV_PREC + 1) ),
     .blk_y = (state->tile->offset_y + pu_y) / 2 + (mv_param[1] >> (INTERNAL_MV_PREC + 1) ),
     .blk_w = pb_w,
@@ -293,6 +296,7 @@ static void inter_recon_frac_chroma_hi(const encoder_state_t *const state,
     .src_w = ref->width / 2,
     .src_h = ref->height / 2,
     .src_s = ref->stride / 2,
+    .src_pad = state->encoder_control->ref_padding / 2,
     .blk_x = (state->tile->offset_x + pu_x) / 2 + (mv_param[0] >> (INTERNAL_MV_PREC + 1) ),
     .blk_y = (state->tile->offset_y + pu_y) / 2 + (mv_param[1] >> (INTERNAL_MV_PREC + 1) ),
     .blk_w = pb_w,
@@ -367,19 +371,31 @@ static void inter_cp_with_ext_border(const uvg_pixel *ref_buf, int ref_stride,
                                      const vector2d_t *mv_in_frame,
                                      const int mv_wrap)
 {
-  for (int y = mv_in_frame->y; y < mv_in_frame->y + height; ++y) {
-    for (int x = mv_in_frame->x; x < mv_in_frame->x + width; ++x) {
-      vector2d_t in_frame = {
-        mv_wrap?((x<0)?x+ref_width:x%ref_width):CLIP(0, ref_width - 1, x),
-        CLIP(0, ref_height - 1, y),
-      };
-      vector2d_t in_pu = {
-        x - mv_in_frame->x,
-        y - mv_in_frame->y,
-      };
-      int pu_index = in_pu.y * rec_stride + in_pu.x;
-      int frame_index = in_frame.y * ref_stride + in_frame.x;
-      rec_buf[pu_index] = ref_buf[frame_index];
+  const int x0 = mv_in_frame->x;
+
+  // Number of pixels from the left edge, the picture and the right edge.
+  const int cnt_l = CLIP(0, width, -x0);
+  const int cnt_r = CLIP(0, width, x0 + width - ref_width);
+  const int cnt_m = MAX(0, width - cnt_l - cnt_r);
+
+  for (int y = 0; y < height; ++y) {
+    const uvg_pixel *ref_row = &ref_buf[CLIP(0, ref_height - 1, mv_in_frame->y + y) * ref_stride];
+    uvg_pixel *rec_row = &rec_buf[y * rec_stride];
+
+    if (mv_wrap) {
+      // Copy the row in parts that end at the right edge of the picture.
+      int x = 0;
+      int ref_x = ((x0 % ref_width) + ref_width) % ref_width;
+      while (x < width) {
+        const int count = MIN(width - x, ref_width - ref_x);
+        memcpy(&rec_row[x], &ref_row[ref_x], count * sizeof(uvg_pixel));
+        x += count;
+        ref_x = 0;
+      }
+    } else {
+      for (int x = 0; x < cnt_l; ++x) rec_row[x] = ref_row[0];
+      memcpy(&rec_row[cnt_l], &ref_row[MAX(0, x0)], cnt_m * sizeof(uvg_pixel));
+      for (int x = cnt_l + cnt_m; x < width; ++x) rec_row[x] = ref_row[ref_width - 1];
     }
   }
 }
@@ -595,6 +611,98 @@ void uvg_inter_recon_bipred(
 }
 
 
+void uvg_inter_unipred_cache_reset(inter_unipred_cache_t *cache)
+{
+  cache->size = 0;
+  cache->next = 0;
+}
+
+
+/**
+ * \brief Find or generate the luma unipred prediction for a (ref, mv) pair.
+ *
+ * When the cache is full, the oldest entry is replaced.
+ */
+static inter_unipred_cache_entry_t *get_cached_unipred_luma(
+  const encoder_state_t *const state,
+  inter_unipred_cache_t *cache,
+  const uvg_picture *ref,
+  const mv_t mv_param[2],
+  const cu_loc_t *const cu_loc)
+{
+  for (int i = 0; i < cache->size; ++i) {
+    inter_unipred_cache_entry_t *entry = &cache->entries[i];
+    if (entry->ref == ref && entry->mv[0] == mv_param[0] && entry->mv[1] == mv_param[1]) {
+      return entry;
+    }
+  }
+
+  inter_unipred_cache_entry_t *entry = &cache->entries[cache->next];
+  cache->next = (cache->next + 1) % UVG_UNIPRED_CACHE_SIZE;
+  cache->size = MIN(cache->size + 1, UVG_UNIPRED_CACHE_SIZE);
+
+  entry->ref = ref;
+  entry->mv[0] = mv_param[0];
+  entry->mv[1] = mv_param[1];
+
+  // Only one of the buffers is written for luma, so they can share memory.
+  yuv_t px;
+  px.size = cu_loc->width * cu_loc->height;
+  px.y = (uvg_pixel *)entry->buf;
+  px.u = NULL;
+  px.v = NULL;
+
+  yuv_im_t im;
+  im.size = cu_loc->width * cu_loc->height;
+  im.y = entry->buf;
+  im.u = NULL;
+  im.v = NULL;
+
+  entry->im_flags = inter_recon_unipred(state, ref, cu_loc->width, mv_param, &px, &im, true, false, cu_loc);
+  return entry;
+}
+
+
+/**
+ * \brief Reconstruct bi-pred luma of a PU using cached unipred predictions
+ *
+ * Produces the same luma samples as uvg_inter_recon_bipred, but each
+ * unipred prediction is interpolated only once for all the bipred
+ * candidates of the PU that use it.
+ *
+ * \param state          encoder state
+ * \param cache          unipred predictions of the current PU
+ * \param ref1           reference picture for L0
+ * \param ref2           reference picture for L1
+ * \param mv_param       motion vectors
+ * \param lcu            destination lcu
+ * \param cu_loc         location of the PU
+ */
+void uvg_inter_recon_bipred_luma_cached(
+  const encoder_state_t *const state,
+  inter_unipred_cache_t *cache,
+  const uvg_picture *ref1,
+  const uvg_picture *ref2,
+  mv_t mv_param[2][2],
+  lcu_t *lcu,
+  const cu_loc_t *const cu_loc)
+{
+  const inter_unipred_cache_entry_t *L0 = get_cached_unipred_luma(state, cache, ref1, mv_param[0], cu_loc);
+  const inter_unipred_cache_entry_t *L1 = get_cached_unipred_luma(state, cache, ref2, mv_param[1], cu_loc);
+
+  const int size = cu_loc->width * cu_loc->height;
+  yuv_t px_L0 = { size, (uvg_pixel *)L0->buf, NULL, NULL };
+  yuv_t px_L1 = { size, (uvg_pixel *)L1->buf, NULL, NULL };
+  yuv_im_t im_L0 = { size, (uvg_pixel_im *)L0->buf, NULL, NULL };
+  yuv_im_t im_L1 = { size, (uvg_pixel_im *)L1->buf, NULL, NULL };
+
+  uvg_bipred_average(lcu, &px_L0, &px_L1, &im_L0, &im_L1,
+                     cu_loc->x, cu_loc->y, cu_loc->width, cu_loc->height,
+                     L0->im_flags, L1->im_flags,
+                     true, false);
+}
+
+
 /**
  * Reconstruct a single CU.
  *
@@ -955,8 +1063,7 @@ static void get_temporal_merge_candidates(
       return;
     }
 
-    cu_array_t *ref_cu_array = state->frame->ref->cu_arrays[colocated_ref];
-    int cu_per_width = ref_cu_array->width / SCU_WIDTH;
+    const motion_field_t *ref_motion = state->frame->ref->motion_fields[colocated_ref];
 
     int32_t xColBr = cu_loc->x + cu_loc->width;
     int32_t yColBr = cu_loc->y + cu_loc->height;
@@ -964,18 +1071,12 @@ static void get_temporal_merge_candidates(
     // C0 must be available
     if (xColBr < state->encoder_control->in.width &&
         yColBr < state->encoder_control->in.height) {
-      int32_t C0_offset = -1;
-
       // Y inside the current CTU / LCU
       if (yColBr % LCU_WIDTH != 0) {
-        C0_offset = ((xColBr >> 3) << 3) / SCU_WIDTH +
-                  (((yColBr >> 3) << 3) / SCU_WIDTH) * cu_per_width;
-      }
-
-      if (C0_offset >= 0) {
+        const motion_info_t *c0 = uvg_motion_field_at_const(ref_motion, xColBr, yColBr);
         // Only use when it's inter block
-        if (ref_cu_array->data[C0_offset].type == CU_INTER) {
-          cand_out->c0 = &ref_cu_array->data[C0_offset];
+        if (c0->mv_dir) {
+          cand_out->c0 = c0;
         }
       }
     }
@@ -984,9 +1085,9 @@ static void get_temporal_merge_candidates(
 
     // C1 must be inside the LCU, in the center position of current CU
     if (xColCtr < state->encoder_control->in.width && yColCtr < state->encoder_control->in.height) {
-      uint32_t C1_offset = ((xColCtr >> 3) << 3) / SCU_WIDTH + ((((yColCtr >> 3) << 3) / SCU_WIDTH) * cu_per_width);
-      if (ref_cu_array->data[C1_offset].type == CU_INTER) {
-        cand_out->c1 = &ref_cu_array->data[C1_offset];
+      const motion_info_t *c1 = uvg_motion_field_at_const(ref_motion, xColCtr, yColCtr);
+      if (c1->mv_dir) {
+        cand_out->c1 = c1;
       }
     }
   }
@@ -1430,7 +1531,7 @@ static void get_spatial_merge_candidates_cua(
  *
  * \param state         encoder state
  * \param current_ref   index of the picture referenced by the current CU
- * \param colocated     colocated CU
+ * \param colocated     motion of the colocated block
  * \param reflist       either 0 (for L0) or 1 (for L1)
  * \param[out] mv_out   Returns the motion vector
  *
@@ -1438,7 +1539,7 @@ static void get_spatial_merge_candidates_cua(
  */
 static bool add_temporal_candidate(const encoder_state_t *state,
                                    uint8_t current_ref,
-                                   const cu_info_t *colocated,
+                                   const motion_info_t *colocated,
                                    int32_t reflist,
                                    mv_t mv_out[2])
 {
@@ -1467,14 +1568,14 @@ static bool add_temporal_candidate(const encoder_state_t *state,
     }
   }
   
-  if ((colocated->inter.mv_dir & (col_list + 1)) == 0) {
+  if ((colocated->mv_dir & (col_list + 1)) == 0) {
     // Use the other list if the colocated PU does not have a MV for the
     // primary list.
     col_list = 1 - col_list;
   }
 
-  mv_out[0] = colocated->inter.mv[col_list][0];
-  mv_out[1] = colocated->inter.mv[col_list][1];
+  mv_out[0] = colocated->mv[col_list][0];
+  mv_out[1] = colocated->mv[col_list][1];
 
   mv_out[0] = round_mv_comp(mv_out[0]);
   mv_out[1] = round_mv_comp(mv_out[1]);
@@ -1485,7 +1586,7 @@ static bool add_temporal_candidate(const encoder_state_t *state,
     state->frame->ref->pocs[colocated_ref],
     state->frame->ref->images[colocated_ref]->ref_pocs[
       state->frame->ref->ref_LXs[colocated_ref]
-        [col_list][colocated->inter.mv_ref[col_list]]],
+        [col_list][colocated->mv_ref[col_list]]],
     mv_out
   );
 
@@ -1505,8 +1606,8 @@ static void get_mv_cand_from_candidates(
 {
   const cu_info_t *const *a = merge_cand->a;
   const cu_info_t *const *b = merge_cand->b;
-  const cu_info_t *c0 = merge_cand->c0;
-  const cu_info_t *c1  = merge_cand->c1;
+  const motion_info_t *c0 = merge_cand->c0;
+  const motion_info_t *c1 = merge_cand->c1;
 
   uint8_t candidates = 0;
   uint8_t b_candidates = 0;
@@ -1947,7 +2048,7 @@ uint8_t uvg_inter_get_merge_cand(
       // TODO: enable L1 TMVP candidate
       // get_temporal_merge_candidates(state, x, y, width, height, 2, 0, &merge_cand);
 
-      const cu_info_t *temporal_cand =
+      const motion_info_t *temporal_cand =
         (merge_cand.c0 != NULL) ? merge_cand.c0 : merge_cand.c1;
 
       if (add_temporal_candidate(state,
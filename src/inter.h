@@ -53,6 +53,32 @@ typedef struct {
   uint8_t ref[2]; // index to L0/L1
 } inter_merge_cand_t;
 
+#define UVG_UNIPRED_CACHE_SIZE 8
+
+/**
+ * \brief Luma unipred prediction of the current PU for one (ref, mv) pair.
+ *
+ * The samples are stored either as pixels or in high precision, depending
+ * on whether the mv is fractional. Both views share the same buffer.
+ */
+typedef struct {
+  const uvg_picture *ref;
+  mv_t mv[2];
+  unsigned im_flags;
+  ALIGNED(64) uvg_pixel_im buf[LCU_LUMA_SIZE];
+} inter_unipred_cache_entry_t;
+
+/**
+ * \brief Unipred predictions shared by the bipred candidates of a PU.
+ *
+ * Must be reset with uvg_inter_unipred_cache_reset whenever the PU changes.
+ */
+typedef struct {
+  int size;
+  int next;
+  inter_unipred_cache_entry_t entries[UVG_UNIPRED_CACHE_SIZE];
+} inter_unipred_cache_t;
+
 void uvg_change_precision(int src, int dst, mv_t* hor, mv_t* ver);
 void uvg_change_precision_vector2d(int src, int dst, vector2d_t* mv);
 void uvg_round_precision(int src, int dst, mv_t* hor, mv_t* ver);
@@ -84,6 +110,17 @@ void uvg_inter_recon_bipred(
   bool predict_chroma,
   const cu_loc_t* const cu_loc);
 
+void uvg_inter_unipred_cache_reset(inter_unipred_cache_t *cache);
+
+void uvg_inter_recon_bipred_luma_cached(
+  const encoder_state_t * const state,
+  inter_unipred_cache_t *cache,
+  const uvg_picture * ref1,
+  const uvg_picture * ref2,
+  mv_t mv_param[2][2],
+  lcu_t* lcu,
+  const cu_loc_t* const cu_loc);
+
 
 void uvg_inter_get_mv_cand(
   const encoder_state_t * const state,
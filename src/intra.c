@@ -36,7 +36,6 @@
 
 #include "image.h"
 #include "uvg_math.h"
-#include "mip_data.h"
 #include "rdo.h"
 #include "search.h"
 #include "search_intra.h"
@@ -87,16 +86,6 @@ static const uint8_t num_ref_pixels_left[16][16] = {
 };
 
 
-static void mip_predict(
-  const encoder_state_t* const state,
-  const uvg_intra_references* const refs,
-  const uint16_t pred_block_width,
-  const uint16_t pred_block_height,
-  uvg_pixel* dst,
-  const int mip_mode,
-  const bool mip_transp);
-
-
 int8_t uvg_intra_get_dir_luma_predictor(
   const uint32_t x,
   const uint32_t y,
@@ -504,22 +493,6 @@ static void get_cclm_parameters(
   }
 }
 
-static void linear_transform_cclm(const cclm_parameters_t* cclm_params, uvg_pixel * src, uvg_pixel * dst, int stride, int height) {
-  int scale = cclm_params->a;
-  int shift = cclm_params->shift;
-  int offset = cclm_params->b;
-  for (int y = 0; y < height; ++y) {
-    for (int x=0; x < stride; ++x) {
-      int val = src[x + y * stride] * scale;
-      val >>= shift;
-      val += offset;
-      val = CLIP_TO_PIXEL(val);
-      dst[x + y * stride] = val;
-    }
-  }
-}
-
-
 static void predict_cclm(
   encoder_state_t const* const state,
   const color_t color,
@@ -566,17 +539,14 @@ static void predict_cclm(
       memcpy(sampled_luma_ref.top, &state->tile->frame->cclm_luma_rec_top_line[x0 / 2 + (y0 / 64 - 1) * (stride2 / 2)], sizeof(uvg_pixel) * (width + available_above_right * 2));
     }
     else {
-      for (int x = 0; x < width * (available_above_right ? 4 : 2); x += 2) {
-        bool left_padding = x0 || x;
-        int s = 4;
-        s += y_scu ? y_rec[x - LCU_WIDTH * 2] * 2            : state->tile->frame->rec->y[x0 + x + (y0 - 2) * stride] * 2;
-        s += y_scu ? y_rec[x - LCU_WIDTH * 2 + 1]            : state->tile->frame->rec->y[x0 + x + 1 + (y0 - 2) * stride];
-        s += y_scu && !(x0 && !x && !x_scu) ? y_rec[x - LCU_WIDTH * 2 - left_padding] : state->tile->frame->rec->y[x0 + x - left_padding + (y0 - 2) * stride];
-        s += y_scu ? y_rec[x - LCU_WIDTH] * 2                : state->tile->frame->rec->y[x0 + x + (y0 - 1) * stride] * 2;
-        s += y_scu ? y_rec[x - LCU_WIDTH + 1]                : state->tile->frame->rec->y[x0 + x + 1 + (y0 - 1) * stride];
-        s += y_scu && !(x0 && !x && !x_scu) ? y_rec[x - LCU_WIDTH - left_padding]     : state->tile->frame->rec->y[x0 + x - left_padding + (y0 - 1) * stride];
-        sampled_luma_ref.top[x / 2] = s >> 3;
+      // The left neighbour of the first sample is outside the LCU on its left edge.
+      uvg_pixel left[2];
+      for (int i = 0; i < 2; ++i) {
+        left[i] = x0 && !x_scu
+          ? state->tile->frame->rec->y[x0 - 1 + (y0 - 2 + i) * stride]
+          : y_rec[(i - 2) * LCU_WIDTH - (x0 ? 1 : 0)];
       }
+      uvg_cclm_downsample(y_rec - 2 * LCU_WIDTH, LCU_WIDTH, left, sampled_luma_ref.top, 0, width * (available_above_right ? 2 : 1), 1);
     }
   }
 
@@ -603,7 +573,7 @@ static void predict_cclm(
   cclm_params->b = b;
 
   if(dst)
-    linear_transform_cclm(cclm_params, sampled_luma, dst, width, height);
+    uvg_cclm_linear_transform(cclm_params, sampled_luma, dst, width, height);
 }
 
 
@@ -646,298 +616,6 @@ uint8_t uvg_get_mip_flag_context(
 }
 
 
-void uvg_mip_boundary_downsampling_1D(int* reduced_dst, const int* const ref_src, int src_len, int dst_len)
-{
-  if (dst_len < src_len)
-  {
-    // Create reduced boundary by downsampling
-    uint16_t down_smp_factor = src_len / dst_len;
-    const int log2_factor = uvg_math_floor_log2(down_smp_factor);
-    const int rounding_offset = (1 << (log2_factor - 1));
-
-    uint16_t src_idx = 0;
-    for (uint16_t dst_idx = 0; dst_idx < dst_len; dst_idx++)
-    {
-      int sum = 0;
-      for (int k = 0; k < down_smp_factor; k++)
-      {
-        sum += ref_src[src_idx++];
-      }
-      reduced_dst[dst_idx] = (sum + rounding_offset) >> log2_factor;
-    }
-  }
-  else
-  {
-    // Copy boundary if no downsampling is needed
-    for (uint16_t i = 0; i < dst_len; ++i)
-    {
-      reduced_dst[i] = ref_src[i];
-    }
-  }
-}
-
-
-void uvg_mip_reduced_pred(int* const output,
-                          const int* const input,
-                          const uint8_t* matrix,
-                          const bool transpose,
-                          const int red_bdry_size,
-                          const int red_pred_size,
-                          const int size_id,
-                          const int in_offset,
-                          const int in_offset_tr)
-{
-  const int input_size = 2 * red_bdry_size;
-
-  // Use local buffer for transposed result
-  int out_buf_transposed[LCU_WIDTH * LCU_WIDTH];
-  int* const out_ptr = transpose ? out_buf_transposed : output;
-
-  int sum = 0;
-  for (int i = 0; i < input_size; i++) { 
-    sum += input[i];
-  }
-  const int offset = (1 << (MIP_SHIFT_MATRIX - 1)) - MIP_OFFSET_MATRIX * sum;
-  assert((input_size == 4 * (input_size >> 2)) && "MIP input size must be divisible by four");
-
-  const uint8_t* weight = matrix;
-  const int input_offset = transpose ? in_offset_tr : in_offset;
-
-  const bool red_size = (size_id == 2);
-  int pos_res = 0;
-  for (int y = 0; y < red_pred_size; y++) {
-    for (int x = 0; x < red_pred_size; x++) {
-      if (red_size) {
-        weight -= 1;
-      }
-      int tmp0 = red_size ? 0 : (input[0] * weight[0]);
-      int tmp1 = input[1] * weight[1];
-      int tmp2 = input[2] * weight[2];
-      int tmp3 = input[3] * weight[3];
-      for (int i = 4; i < input_size; i += 4) {
-        tmp0 += input[i] * weight[i];
-        tmp1 += input[i + 1] * weight[i + 1];
-        tmp2 += input[i + 2] * weight[i + 2];
-        tmp3 += input[i + 3] * weight[i + 3];
-      }
-      out_ptr[pos_res] = CLIP_TO_PIXEL(((tmp0 + tmp1 + tmp2 + tmp3 + offset) >> MIP_SHIFT_MATRIX) + input_offset);
-      pos_res++;
-      weight += input_size;
-    }
-  }
-
-  if (transpose) {
-    for (int y = 0; y < red_pred_size; y++) {
-      for (int x = 0; x < red_pred_size; x++) {
-        output[y * red_pred_size + x] = out_ptr[x * red_pred_size + y];
-      }
-    }
-  }
-}
-
-
-void uvg_mip_pred_upsampling_1D(int* const dst, const int* const src, const int* const boundary,
-                                const uint16_t src_size_ups_dim, const uint16_t src_size_orth_dim,
-                                const uint16_t src_step, const uint16_t src_stride,
-                                const uint16_t dst_step, const uint16_t dst_stride,
-                                const uint16_t boundary_step,
-                                const uint16_t ups_factor)
-{
-  const int log2_factor = uvg_math_floor_log2(ups_factor);
-  assert(ups_factor >= 2 && "Upsampling factor must be at least 2.");
-  const int rounding_offset = 1 << (log2_factor - 1);
-
-  uint16_t idx_orth_dim = 0;
-  const int* src_line = src;
-  int* dst_line = dst;
-  const int* boundary_line = boundary + boundary_step - 1;
-  while (idx_orth_dim < src_size_orth_dim)
-  {
-    uint16_t idx_upsample_dim = 0;
-    const int* before = boundary_line;
-    const int* behind = src_line;
-    int* cur_dst = dst_line;
-    while (idx_upsample_dim < src_size_ups_dim)
-    {
-      uint16_t pos = 1;
-      int scaled_before = (*before) << log2_factor;
-      int scaled_behind = 0;
-      while (pos <= ups_factor)
-      {
-        scaled_before -= *before;
-        scaled_behind += *behind;
-        *cur_dst = (scaled_before + scaled_behind + rounding_offset) >> log2_factor;
-
-        pos++;
-        cur_dst += dst_step;
-      }
-
-      idx_upsample_dim++;
-      before = behind;
-      behind += src_step;
-    }
-
-    idx_orth_dim++;
-    src_line += src_stride;
-    dst_line += dst_stride;
-    boundary_line += boundary_step;
-  }
-}
-
-
-
-/** \brief Matrix weighted intra prediction.
-*/
-static void mip_predict(
-  const encoder_state_t* const state,
-  const uvg_intra_references* const refs,
-  const uint16_t pred_block_width,
-  const uint16_t pred_block_height,
-  uvg_pixel* dst,
-  const int mip_mode,
-  const bool mip_transp)
-{
-  // MIP prediction uses int values instead of uvg_pixel as some temp values may be negative
-  
-  uvg_pixel* out = dst;
-  int result[32*32] = {0};
-  const int mode_idx = mip_mode;
-
-  // *** INPUT PREP ***
-
-  // Initialize prediction parameters START
-  uint16_t width = pred_block_width;
-  uint16_t height = pred_block_height;
-
-  int size_id; // Prediction block type
-  if (width == 4 && height == 4) {
-    size_id = 0;
-  }
-  else if (width == 4 || height == 4 || (width == 8 && height == 8)) {
-    size_id = 1;
-  }
-  else {
-    size_id = 2;
-  }
-
-  // Reduced boundary and prediction sizes
-  int red_bdry_size = (size_id == 0) ? 2 : 4;
-  int red_pred_size = (size_id < 2) ? 4 : 8;
-
-  // Upsampling factors
-  uint16_t ups_hor_factor = width / red_pred_size;
-  uint16_t ups_ver_factor = height / red_pred_size;
-
-  // Upsampling factors must be powers of two
-  assert(!((ups_hor_factor < 1) || ((ups_hor_factor & (ups_hor_factor - 1))) != 0) && "Horizontal upsampling factor must be power of two.");
-  assert(!((ups_ver_factor < 1) || ((ups_ver_factor & (ups_ver_factor - 1))) != 0) && "Vertical upsampling factor must be power of two.");
-
-  // Initialize prediction parameters END
-
-  int ref_samples_top[INTRA_REF_LENGTH]; 
-  int ref_samples_left[INTRA_REF_LENGTH];
-
-  for (int i = 1; i < INTRA_REF_LENGTH; i++) {
-    ref_samples_top[i-1] =  (int)refs->ref.top[i]; // NOTE: in VTM code these are indexed as x + 1 & y + 1 during init
-    ref_samples_left[i-1] = (int)refs->ref.left[i];
-  }
-
-  // Compute reduced boundary with Haar-downsampling
-  const int input_size = 2 * red_bdry_size;
-
-  int red_bdry[MIP_MAX_INPUT_SIZE];
-  int red_bdry_trans[MIP_MAX_INPUT_SIZE];
-
-  int* const top_reduced = &red_bdry[0];
-  int* const left_reduced = &red_bdry[red_bdry_size];
-
-  uvg_mip_boundary_downsampling_1D(top_reduced, ref_samples_top, width, red_bdry_size);
-  uvg_mip_boundary_downsampling_1D(left_reduced, ref_samples_left, height, red_bdry_size);
-
-  // Transposed reduced boundaries
-  int* const left_reduced_trans = &red_bdry_trans[0];
-  int* const top_reduced_trans = &red_bdry_trans[red_bdry_size];
-
-  for (int x = 0; x < red_bdry_size; x++) {
-    top_reduced_trans[x] = top_reduced[x];
-  }
-  for (int y = 0; y < red_bdry_size; y++) {
-    left_reduced_trans[y] = left_reduced[y];
-  }
-
-  int input_offset = red_bdry[0];
-  int input_offset_trans = red_bdry_trans[0];
-
-  const bool has_first_col = (size_id < 2);
-  // First column of matrix not needed for large blocks
-  red_bdry[0] = has_first_col ? ((1 << (UVG_BIT_DEPTH - 1)) - input_offset) : 0;
-  red_bdry_trans[0] = has_first_col ? ((1 << (UVG_BIT_DEPTH - 1)) - input_offset_trans) : 0;
-
-  for (int i = 1; i < input_size; ++i) {
-    red_bdry[i] -= input_offset;
-    red_bdry_trans[i] -= input_offset_trans;
-  }
-
-  // *** INPUT PREP *** END
-
-  // *** BLOCK PREDICT ***
-
-  const bool need_upsampling = (ups_hor_factor > 1) || (ups_ver_factor > 1);
-  const bool transpose = mip_transp;
-
-  const uint8_t* matrix;
-  switch (size_id) {
-    case 0: 
-      matrix = &uvg_mip_matrix_4x4[mode_idx][0][0];
-      break;
-    case 1: 
-      matrix = &uvg_mip_matrix_8x8[mode_idx][0][0];
-      break;
-    case 2: 
-      matrix = &uvg_mip_matrix_16x16[mode_idx][0][0];
-      break;
-    default:
-      assert(false && "Invalid MIP size id.");
-  }
-
-  // Max possible size is red_pred_size * red_pred_size, red_pred_size can be either 4 or 8
-  int red_pred_buffer[8*8];
-  int* const reduced_pred = need_upsampling ? red_pred_buffer : result;
-
-  const int* const reduced_bdry = transpose ? red_bdry_trans : red_bdry;
-
-  uvg_mip_reduced_pred(reduced_pred, reduced_bdry, matrix, transpose, red_bdry_size, red_pred_size, size_id, input_offset, input_offset_trans);
-  if (need_upsampling) {
-    const int* ver_src = reduced_pred;
-    uint16_t ver_src_step = width;
-    
-    if (ups_hor_factor > 1) {
-      int* const hor_dst = result + (ups_ver_factor - 1) * width;
-      ver_src = hor_dst;
-      ver_src_step *= ups_ver_factor;
-
-      uvg_mip_pred_upsampling_1D(hor_dst, reduced_pred, ref_samples_left,
-        red_pred_size, red_pred_size,
-        1, red_pred_size, 1, ver_src_step,
-        ups_ver_factor, ups_hor_factor);
-    }
-
-    if (ups_ver_factor > 1) {
-      uvg_mip_pred_upsampling_1D(result, ver_src, ref_samples_top,
-        red_pred_size, width,
-        ver_src_step, 1, width, 1,
-        1, ups_ver_factor);
-    }
-  }
-
-  // Assign and cast values from temp array to output
-  for (int i = 0; i < 32 * 32; i++) {
-    out[i] = (uvg_pixel)result[i];
-  }
-  // *** BLOCK PREDICT *** END
-}
-
-
 int8_t uvg_wide_angle_correction(
   int_fast8_t mode,
   const int log2_width,
@@ -961,35 +639,26 @@ int8_t uvg_wide_angle_correction(
   return pred_mode;
 }
 
-static void intra_predict_regular(
-  const encoder_state_t* const state,
+/**
+ * \brief Select the reference used for predicting a block with a mode.
+ *
+ * The filtered reference is generated on first use.
+ *
+ * \param pred_mode  Wide angle corrected mode.
+ */
+static const uvg_intra_ref* intra_select_reference(
+  const uvg_config *cfg,
   uvg_intra_references *refs,
-  const cu_info_t* const       cur_cu,
-  const cu_loc_t* const cu_loc,
-  const cu_loc_t* const pu_loc,
   int_fast8_t mode,
+  int8_t pred_mode,
   color_t color,
-  uvg_pixel *dst,
-  const uint8_t multi_ref_idx,
+  const int width,
+  const int height,
+  const uint8_t multi_ref_index,
   const uint8_t isp_mode)
 {
-  const int width = color == COLOR_Y ? pu_loc->width : pu_loc->chroma_width;
-  const int height = color == COLOR_Y ? pu_loc->height : pu_loc->chroma_height;
   const int log2_width = uvg_g_convert_to_log2[width];
   const int log2_height = uvg_g_convert_to_log2[height];
-  const uvg_config *cfg = &state->encoder_control->cfg;
-
-  // MRL only for luma
-  uint8_t multi_ref_index = color == COLOR_Y ? multi_ref_idx : 0;
-  uint8_t isp = color == COLOR_Y ? isp_mode : 0;
-
-  // Wide angle correction
-  int8_t pred_mode = uvg_wide_angle_correction(
-    mode,
-    color == COLOR_Y ? cur_cu->log2_width : log2_width,
-    color == COLOR_Y ? cur_cu->log2_height : log2_height,
-    false
-    );
 
   const uvg_intra_ref *used_ref = &refs->ref;
   if (cfg->intra_smoothing_disabled || color != COLOR_Y || mode == 1 || (width == 4 && height == 4) || multi_ref_index || isp_mode /*ISP_TODO: replace this fake ISP check*/) {
@@ -1020,6 +689,42 @@ static void intra_predict_regular(
     intra_filter_reference(log2_width, log2_height, refs);
   }
 
+
+  return used_ref;
+}
+
+static void intra_predict_regular(
+  const encoder_state_t* const state,
+  uvg_intra_references *refs,
+  const cu_info_t* const       cur_cu,
+  const cu_loc_t* const cu_loc,
+  const cu_loc_t* const pu_loc,
+  int_fast8_t mode,
+  color_t color,
+  uvg_pixel *dst,
+  const uint8_t multi_ref_idx,
+  const uint8_t isp_mode)
+{
+  const int width = color == COLOR_Y ? pu_loc->width : pu_loc->chroma_width;
+  const int height = color == COLOR_Y ? pu_loc->height : pu_loc->chroma_height;
+  const int log2_width = uvg_g_convert_to_log2[width];
+  const int log2_height = uvg_g_convert_to_log2[height];
+  const uvg_config *cfg = &state->encoder_control->cfg;
+
+  // MRL only for luma
+  uint8_t multi_ref_index = color == COLOR_Y ? multi_ref_idx : 0;
+  uint8_t isp = color == COLOR_Y ? isp_mode : 0;
+
+  // Wide angle correction
+  int8_t pred_mode = uvg_wide_angle_correction(
+    mode,
+    color == COLOR_Y ? cur_cu->log2_width : log2_width,
+    color == COLOR_Y ? cur_cu->log2_height : log2_height,
+    false
+    );
+
+  const uvg_intra_ref *used_ref = intra_select_reference(cfg, refs, mode, pred_mode, color, width, height, multi_ref_index, isp_mode);
+
   if (mode == 0) {
     uvg_intra_pred_planar(pu_loc, color, used_ref->top, used_ref->left, dst);
   } else if (mode == 1) {
@@ -1048,6 +753,38 @@ static void intra_predict_regular(
 }
 
 
+
+/**
+ * \brief Predict a batch of angular luma modes for the rough mode search.
+ *
+ * Only regular prediction is supported, i.e. no MRL, ISP or MIP.
+ *
+ * \param modes      Angular modes in range 2..66.
+ * \param dsts       Buffers of size width*height for each mode.
+ */
+void uvg_intra_predict_angular_multi(
+  const encoder_state_t* const state,
+  uvg_intra_references* const refs,
+  const cu_info_t* const cur_cu,
+  const cu_loc_t* const cu_loc,
+  const int8_t* const modes,
+  const int num_modes,
+  uvg_pixel* const* const dsts)
+{
+  assert(num_modes <= UVG_NUM_INTRA_MODES);
+  const uvg_config *cfg = &state->encoder_control->cfg;
+  int8_t pred_modes[UVG_NUM_INTRA_MODES];
+  const uvg_intra_ref *used_refs[UVG_NUM_INTRA_MODES];
+
+  for (int i = 0; i < num_modes; ++i) {
+    assert(modes[i] >= 2 && modes[i] <= 66);
+    pred_modes[i] = uvg_wide_angle_correction(modes[i], cur_cu->log2_width, cur_cu->log2_height, false);
+    used_refs[i] = intra_select_reference(cfg, refs, modes[i], pred_modes[i], COLOR_Y, cu_loc->width, cu_loc->height, 0, 0);
+  }
+
+  uvg_angular_pred_multi(cu_loc, pred_modes, num_modes, used_refs, dsts);
+}
+
 void uvg_intra_build_reference_any(
   const encoder_state_t* const state,
   const cu_loc_t* const pu_loc,
@@ -1618,7 +1355,7 @@ void uvg_intra_predict(
   if (intra_mode < 68) {
     if (use_mip) {
       assert(intra_mode >= 0 && intra_mode < 16 && "MIP mode must be between [0, 15]");
-      mip_predict(state, refs, width, height, dst, intra_mode, data->pred_cu.intra.mip_is_transposed);
+      uvg_mip_predict(refs, width, height, dst, intra_mode, data->pred_cu.intra.mip_is_transposed);
     }
     else {
       intra_predict_regular(state, refs, &data->pred_cu, cu_loc, pu_loc, intra_mode, color, dst, data->pred_cu.intra.multi_ref_idx, data->pred_cu.intra.isp_mode);
@@ -1632,7 +1369,7 @@ void uvg_intra_predict(
         (cclm_parameters_t*)&data->cclm_parameters[color == COLOR_U ? 0 : 1]);
     }
     else {
-      linear_transform_cclm(&data->cclm_parameters[color == COLOR_U ? 0 : 1], dst, dst, width, height);
+      uvg_cclm_linear_transform(&data->cclm_parameters[color == COLOR_U ? 0 : 1], dst, dst, width, height);
     }
   }
 }
@@ -1751,6 +1488,81 @@ void uvg_get_isp_split_loc(cu_loc_t *loc, const int x, const int y, const int bl
 }
 
 
+/**
+ * \brief Start caching the references of a CU.
+ *
+ * References stay valid until uvg_intra_ref_cache_end because only the
+ * pixels inside the CU are reconstructed in between.
+ */
+void uvg_intra_ref_cache_begin(
+  encoder_state_t* const state,
+  const lcu_t* const lcu,
+  const cu_loc_t* const cu_loc,
+  const cu_loc_t* const chroma_loc)
+{
+  intra_ref_cache_t *cache = state->intra_ref_cache;
+  if (cache == NULL) return;
+
+  cache->lcu = lcu;
+  cache->cu_loc = *cu_loc;
+  cache->chroma_loc = *chroma_loc;
+  memset(cache->valid, 0, sizeof(cache->valid));
+}
+
+
+void uvg_intra_ref_cache_end(encoder_state_t* const state)
+{
+  if (state->intra_ref_cache) {
+    state->intra_ref_cache->lcu = NULL;
+  }
+}
+
+
+static bool same_loc(const cu_loc_t* const a, const cu_loc_t* const b)
+{
+  return a->x == b->x && a->y == b->y && a->width == b->width && a->height == b->height;
+}
+
+
+/**
+ * \brief Get the cache entry for a block.
+ *
+ * \return  Entry of the block or NULL if the block is not the cached CU.
+ */
+static uvg_intra_references* intra_ref_cache_entry(
+  const encoder_state_t* const state,
+  const cu_loc_t* const pu_loc,
+  const color_t color,
+  const lcu_t* const lcu,
+  const uint8_t multi_ref_idx,
+  bool** valid)
+{
+  intra_ref_cache_t *cache = state->intra_ref_cache;
+  if (cache == NULL || cache->lcu != lcu || multi_ref_idx >= MAX_REF_LINE_IDX) return NULL;
+  if (!same_loc(pu_loc, color == COLOR_Y ? &cache->cu_loc : &cache->chroma_loc)) return NULL;
+
+  *valid = &cache->valid[color][multi_ref_idx];
+  return &cache->refs[color][multi_ref_idx];
+}
+
+
+void uvg_intra_ref_cache_store(
+  encoder_state_t* const state,
+  const cu_loc_t* const pu_loc,
+  const color_t color,
+  const lcu_t* const lcu,
+  const uint8_t multi_ref_idx,
+  const uvg_intra_references* const refs)
+{
+  bool *valid = NULL;
+  uvg_intra_references *entry = intra_ref_cache_entry(state, pu_loc, color, lcu, multi_ref_idx, &valid);
+  if (entry == NULL || *valid) return;
+
+  *entry = *refs;
+  *valid = true;
+}
+
+
 static void intra_recon_tb_leaf(
   encoder_state_t* const state,
   const cu_loc_t* pu_loc,
@@ -1781,30 +1593,41 @@ static void intra_recon_tb_leaf(
   uint8_t multi_ref_index = color == COLOR_Y ? search_data->pred_cu.intra.multi_ref_idx: 0;
   uint8_t isp_mode = color == COLOR_Y ? search_data->pred_cu.intra.isp_mode : 0;
 
-  uvg_intra_references refs;
-
-  // Extra reference lines for use with MRL. Extra lines needed only for left edge.
-  uvg_pixel extra_refs[128 * MAX_REF_LINE_IDX] = { 0 };
-
-  if (luma_px.x > 0 && lcu_px.x == 0 && lcu_px.y > 0 && multi_ref_index != 0) {
-    videoframe_t* const frame = state->tile->frame;
-
-    // Copy extra ref lines, including ref line 1 and top left corner.
-    for (int i = 0; i < MAX_REF_LINE_IDX; ++i) {
-      int ref_height = height * 2 + MAX_REF_LINE_IDX;
-      ref_height = MIN(ref_height, (LCU_WIDTH - lcu_px.y + MAX_REF_LINE_IDX)); // Cut short if on bottom LCU edge. Cannot take references from below since they don't exist.
-      ref_height = MIN(ref_height, pic_px.y - luma_px.y + MAX_REF_LINE_IDX);
-      uvg_pixels_blit(&frame->rec->y[(luma_px.y - MAX_REF_LINE_IDX) * frame->rec->stride + luma_px.x - (1 + i)],
-        &extra_refs[i * 128],
-        1, ref_height,
-        frame->rec->stride, 1);
+  // ISP splits depend on the reconstruction of the previous split, so
+  // only whole blocks can use the references built during the search.
+  bool *cache_valid = NULL;
+  uvg_intra_references local_refs;
+  uvg_intra_references *refs = NULL;
+  if (isp_mode == ISP_MODE_NO_ISP && same_loc(pu_loc, cu_loc)) {
+    refs = intra_ref_cache_entry(state, pu_loc, color, lcu, multi_ref_index, &cache_valid);
+  }
+  if (refs == NULL) refs = &local_refs;
+
+  if (cache_valid == NULL || !*cache_valid) {
+    // Extra reference lines for use with MRL. Extra lines needed only for left edge.
+    uvg_pixel extra_refs[128 * MAX_REF_LINE_IDX] = { 0 };
+
+    if (luma_px.x > 0 && lcu_px.x == 0 && lcu_px.y > 0 && multi_ref_index != 0) {
+      videoframe_t* const frame = state->tile->frame;
+
+      // Copy extra ref lines, including ref line 1 and top left corner.
+      for (int i = 0; i < MAX_REF_LINE_IDX; ++i) {
+        int ref_height = height * 2 + MAX_REF_LINE_IDX;
+        ref_height = MIN(ref_height, (LCU_WIDTH - lcu_px.y + MAX_REF_LINE_IDX)); // Cut short if on bottom LCU edge. Cannot take references from below since they don't exist.
+        ref_height = MIN(ref_height, pic_px.y - luma_px.y + MAX_REF_LINE_IDX);
+        uvg_pixels_blit(&frame->rec->y[(luma_px.y - MAX_REF_LINE_IDX) * frame->rec->stride + luma_px.x - (1 + i)],
+          &extra_refs[i * 128],
+          1, ref_height,
+          frame->rec->stride, 1);
+      }
     }
-  }
 
-  uvg_intra_build_reference(state, pu_loc, cu_loc, color, &luma_px, &pic_px, lcu, &refs, cfg->wpp, extra_refs, multi_ref_index, isp_mode);
+    uvg_intra_build_reference(state, pu_loc, cu_loc, color, &luma_px, &pic_px, lcu, refs, cfg->wpp, extra_refs, multi_ref_index, isp_mode);
+    if (cache_valid) *cache_valid = true;
+  }
 
   uvg_pixel pred[32 * 32];
-  uvg_intra_predict(state, &refs, cu_loc, pu_loc, color, pred, search_data, lcu);
+  uvg_intra_predict(state, refs, cu_loc, pu_loc, color, pred, search_data, lcu);
 
   const int index = lcu_px.x + lcu_px.y * lcu_width;
   uvg_pixel *block = NULL;
@@ -2004,6 +1827,14 @@ bool uvg_can_use_isp_with_lfnst(const int width, const int height, const int isp
 }
 
 
+/**
+ * \brief Reconstruct the ISP sub-partitions of a block and estimate the cost.
+ *
+ * \param cost_treshold  Stop after the sub-partition where the cost exceeds
+ *                       this. The block is then only partially reconstructed.
+ *
+ * \return  Distortion plus lambda weighted coefficient bits.
+ */
 double uvg_recon_and_estimate_cost_isp(encoder_state_t* const state,
                                        const cu_loc_t* const cu_loc,
                                        double cost_treshold,
@@ -2060,6 +1891,11 @@ double uvg_recon_and_estimate_cost_isp(encoder_state_t* const state,
     search_data->best_isp_cbfs |= cbf << i;
     search_data->pred_cu.intra.isp_cbfs = search_data->best_isp_cbfs;
 
+    // The cost only grows with the remaining sub-partitions, so this mode
+    // can no longer beat the threshold.
+    if (cost > cost_treshold && i + 1 != split_limit) {
+      break;
+    }
   }
   search_data->pred_cu.intra.isp_index = 0;
   return cost;
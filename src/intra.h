@@ -56,6 +56,20 @@ typedef struct
   bool filtered_initialized;
 } uvg_intra_references;
 
+/**
+ * \brief References built for the CU currently being searched.
+ *
+ * Filled when the references are built during the mode search and reused
+ * by the reconstruction of the same block. Only valid while lcu is set.
+ */
+typedef struct intra_ref_cache_t {
+  const lcu_t *lcu;
+  cu_loc_t cu_loc;
+  cu_loc_t chroma_loc;
+  bool valid[3][MAX_REF_LINE_IDX];
+  uvg_intra_references refs[3][MAX_REF_LINE_IDX];
+} intra_ref_cache_t;
+
 typedef struct
 {
   int16_t a;
@@ -141,6 +155,31 @@ void uvg_intra_predict(
   const lcu_t* lcu
 );
 
+void uvg_intra_predict_angular_multi(
+  const encoder_state_t* const state,
+  uvg_intra_references* const refs,
+  const cu_info_t* const cur_cu,
+  const cu_loc_t* const cu_loc,
+  const int8_t* const modes,
+  const int num_modes,
+  uvg_pixel* const* const dsts);
+
+void uvg_intra_ref_cache_begin(
+  encoder_state_t* const state,
+  const lcu_t* const lcu,
+  const cu_loc_t* const cu_loc,
+  const cu_loc_t* const chroma_loc);
+
+void uvg_intra_ref_cache_end(encoder_state_t* const state);
+
+void uvg_intra_ref_cache_store(
+  encoder_state_t* const state,
+  const cu_loc_t* const pu_loc,
+  const color_t color,
+  const lcu_t* const lcu,
+  const uint8_t multi_ref_idx,
+  const uvg_intra_references* const refs);
+
 void uvg_intra_recon_cu(
   encoder_state_t* const state,
   intra_search_data_t* search_data,
@@ -68,6 +68,11 @@ typedef struct {
 	/*!< Matrix used to store the upper and lower QT prediction*/
 	uint8_t* _mat_upper_depth; 
 	uint8_t* _mat_lower_depth;
+	/*!< Sum and sum of squares of the luma samples of each 4*4 block */
+	uint32_t arr_sum_4x4[256];
+	uint32_t arr_sum_sq_4x4[256];
+	/*!< QP used for the last prediction */
+	int8_t   qp;
 } ml_intra_ctu_pred_t;
 
 
@@ -99,5 +104,6 @@ ml_intra_ctu_pred_t* uvg_init_ml_intra_depth_const(void);
 void uvg_end_ml_intra_depth_const(ml_intra_ctu_pred_t * ml_intra_depth_ctu);
 
 void uvg_lcu_luma_depth_pred(ml_intra_ctu_pred_t* ml_intra_depth_ctu, uvg_pixel* luma_px, int8_t qp);
+void uvg_ml_intra_mtt_pruning(const ml_intra_ctu_pred_t* ml_intra_depth_ctu, int x, int y, int width, int height, bool can_split[6]);
 
 #endif
@@ -118,165 +118,107 @@ void uvg_init_lmcs_aps(lmcs_aps* aps, int picWidth, int picHeight, uint32_t maxC
 From VTM 12.1
 */
 
-void uvg_calc_seq_stats(struct encoder_state_t* const state, const videoframe_t* frame, lmcs_seq_info* stats, lmcs_aps* aps)
-{
-  const encoder_control_t* const encoder = state->encoder_control;
+/**
+ * \brief Partial statistics of a band of luma rows.
+ */
+typedef struct lmcs_stats_band_t {
+  const videoframe_t* frame;
+  const lmcs_aps* aps;
+  uint32_t winLens;
+  uint32_t yBegin;
+  uint32_t yEnd;
+  bool chroma;
+
+  double binVar[PIC_CODE_CW_BINS];
+  uint32_t binCnt[PIC_CODE_CW_BINS];
+  int64_t sumY, sumSqY;
+  int64_t sumU, sumSqU;
+  int64_t sumV, sumSqV;
+} lmcs_stats_band_t;
 
-  int32_t m_binNum = PIC_CODE_CW_BINS;
-  uvg_pixel* picY = &frame->source->y[0];
-  const uint32_t width = frame->source->width;
-  const uint32_t height = frame->source->height;
-  const uint32_t stride = frame->source->stride;
-  uint32_t winLens = (aps->m_binNum == PIC_CODE_CW_BINS) ? (MIN(height, width) / 240) : 2;
-  winLens = winLens > 0 ? winLens : 1;
+/**
+ * \brief Collect the statistics of the rows [yBegin, yEnd) of the frame.
+ *
+ * The local variance of each luma sample is computed over a window of
+ * 2 * winLens + 1 samples in both directions, clipped to the frame. The
+ * window sums are kept as column sums that slide down the rows of the band.
+ */
+static void lmcs_stats_band_worker(void* opaque)
+{
+  lmcs_stats_band_t* band = opaque;
+  const lmcs_aps* aps = band->aps;
+  const uvg_picture* source = band->frame->source;
+  const int32_t m_binNum = PIC_CODE_CW_BINS;
+  const int32_t width = source->width;
+  const int32_t height = source->height;
+  const int32_t stride = source->stride;
+  const int32_t winLens = band->winLens;
+  const int binLen = aps->m_reshapeLUTSize / m_binNum;
+
+  int64_t* colSum = calloc(width, sizeof(int64_t));
+  int64_t* colSumSq = calloc(width, sizeof(int64_t));
+
+  for (int32_t by = MAX((int32_t)band->yBegin - winLens, 0); by <= MIN((int32_t)band->yBegin + winLens, height - 1); by++) {
+    const uvg_pixel* pWinY = &source->y[by * stride];
+    for (int32_t x = 0; x < width; x++) {
+      colSum[x] += pWinY[x];
+      colSumSq[x] += (int64_t)pWinY[x] * (int64_t)pWinY[x];
+    }
+  }
 
-  int64_t tempSq = 0;
-  int64_t topSum = 0, topSumSq = 0;
-  int64_t leftSum = 0, leftSumSq = 0;
-  int64_t* leftColSum = malloc(sizeof(int64_t)*width);
-  int64_t* leftColSumSq = malloc(sizeof(int64_t) * width);
-  int64_t* topRowSum = malloc(sizeof(int64_t) * height);
-  int64_t* topRowSumSq = malloc(sizeof(int64_t) * height);
-  int64_t* topColSum = malloc(sizeof(int64_t) * width);
-  int64_t* topColSumSq = malloc(sizeof(int64_t) * width);
-  uint32_t* binCnt = malloc(sizeof(uint32_t)*m_binNum);
-  memset(leftColSum, 0, width * sizeof(int64_t));
-  memset(leftColSumSq, 0, width * sizeof(int64_t));
-  memset(topRowSum, 0, height * sizeof(int64_t));
-  memset(topRowSumSq, 0, height * sizeof(int64_t));
-  memset(topColSum, 0, width * sizeof(int64_t));
-  memset(topColSumSq, 0, width * sizeof(int64_t));
-  memset(binCnt, 0, m_binNum * sizeof(uint32_t));
-    
-  uvg_init_lmcs_seq_stats(stats,m_binNum);
-  for (uint32_t y = 0; y < height; y++)
+  for (int32_t y = band->yBegin; y < (int32_t)band->yEnd; y++)
   {
-    for (uint32_t x = 0; x < width; x++)
+    const uvg_pixel* picY = &source->y[y * stride];
+    if (y > (int32_t)band->yBegin)
     {
-      const uvg_pixel pxlY = picY[x];
-      int64_t sum = 0, sumSq = 0;
-      uint32_t numPixInPart = 0;
-      uint32_t y1 = MAX((int)(y - winLens), 0);
-      uint32_t y2 = MIN((int)(y + winLens), (height - 1));
-      uint32_t x1 = MAX((int)(x - winLens), 0);
-      uint32_t x2 = MIN((int)(x + winLens), (width - 1));
-      uint32_t bx = 0, by = 0;
-      const uvg_pixel* pWinY = &picY[0];
-      numPixInPart = (x2 - x1 + 1) * (y2 - y1 + 1);
-
-      if (x == 0 && y == 0)
+      if (y + winLens < height)
       {
-        for (by = y1; by <= y2; by++)
+        const uvg_pixel* pWinY = &source->y[(y + winLens) * stride];
+        for (int32_t x = 0; x < width; x++)
         {
-          for (bx = x1; bx <= x2; bx++)
-          {
-            tempSq = (int64_t)pWinY[bx] * (int64_t)pWinY[bx];
-            leftSum += pWinY[bx];
-            leftSumSq += tempSq;
-            leftColSum[bx] += pWinY[bx];
-            leftColSumSq[bx] += tempSq;
-            topColSum[bx] += pWinY[bx];
-            topColSumSq[bx] += tempSq;
-            topRowSum[by] += pWinY[bx];
-            topRowSumSq[by] += tempSq;
-          }
-          pWinY += stride;
+          colSum[x] += pWinY[x];
+          colSumSq[x] += (int64_t)pWinY[x] * (int64_t)pWinY[x];
         }
-        topSum = leftSum;
-        topSumSq = leftSumSq;
-        sum = leftSum;
-        sumSq = leftSumSq;
       }
-      else if (x == 0 && y > 0)
+      if (y > winLens)
       {
-        if (y < height - winLens)
+        const uvg_pixel* pWinY = &source->y[(y - 1 - winLens) * stride];
+        for (int32_t x = 0; x < width; x++)
         {
-          pWinY += winLens * stride;
-          topRowSum[y + winLens] = 0;
-          topRowSumSq[y + winLens] = 0;
-          for (bx = x1; bx <= x2; bx++)
-          {
-            topRowSum[y + winLens] += pWinY[bx];
-            topRowSumSq[y + winLens] += (int64_t)pWinY[bx] * (int64_t)pWinY[bx];
-          }
-          topSum += topRowSum[y + winLens];
-          topSumSq += topRowSumSq[y + winLens];
+          colSum[x] -= pWinY[x];
+          colSumSq[x] -= (int64_t)pWinY[x] * (int64_t)pWinY[x];
         }
-        if (y > winLens)
-        {
-          topSum -= topRowSum[y - 1 - winLens];
-          topSumSq -= topRowSumSq[y - 1 - winLens];
-        }
-        memset(leftColSum, 0, width * sizeof(int64_t));
-        memset(leftColSumSq, 0, width * sizeof(int64_t));
-        pWinY = &picY[0];
-        pWinY -= (y <= winLens ? y : winLens) * stride;
-        for (by = y1; by <= y2; by++)
-        {
-          for (bx = x1; bx <= x2; bx++)
-          {
-            leftColSum[bx] += pWinY[bx];
-            leftColSumSq[bx] += (int64_t)pWinY[bx] * (int64_t)pWinY[bx];
-          }
-          pWinY += stride;
-        }
-        leftSum = topSum;
-        leftSumSq = topSumSq;
-        sum = topSum;
-        sumSq = topSumSq;
       }
-      else if (x > 0)
+    }
+    const uint32_t winHeight = MIN(y + winLens, height - 1) - MAX(y - winLens, 0) + 1;
+
+    int64_t sum = 0, sumSq = 0;
+    for (int32_t x = 0; x <= MIN(winLens, width - 1); x++)
+    {
+      sum += colSum[x];
+      sumSq += colSumSq[x];
+    }
+
+    for (int32_t x = 0; x < width; x++)
+    {
+      const uvg_pixel pxlY = picY[x];
+      if (x > 0)
       {
-        if (x < width - winLens)
+        if (x + winLens < width)
         {
-          pWinY -= (y <= winLens ? y : winLens) * stride;
-          if (y == 0)
-          {
-            leftColSum[x + winLens] = 0;
-            leftColSumSq[x + winLens] = 0;
-            for (by = y1; by <= y2; by++)
-            {
-              leftColSum[x + winLens] += pWinY[x + winLens];
-              leftColSumSq[x + winLens] += (int64_t)pWinY[x + winLens] * (int64_t)pWinY[x + winLens];
-              pWinY += stride;
-            }
-          }
-          else
-          {
-            leftColSum[x + winLens] = topColSum[x + winLens];
-            leftColSumSq[x + winLens] = topColSumSq[x + winLens];
-            if (y < height - winLens)
-            {
-              pWinY = &picY[0];
-              pWinY += winLens * stride;
-              leftColSum[x + winLens] += pWinY[x + winLens];
-              leftColSumSq[x + winLens] += (int64_t)pWinY[x + winLens] * (int64_t)pWinY[x + winLens];
-            }
-            if (y > winLens)
-            {
-              pWinY = &picY[0];
-              pWinY -= (winLens + 1) * stride;
-              leftColSum[x + winLens] -= pWinY[x + winLens];
-              leftColSumSq[x + winLens] -= (int64_t)pWinY[x + winLens] * (int64_t)pWinY[x + winLens];
-            }
-          }
-          topColSum[x + winLens] = leftColSum[x + winLens];
-          topColSumSq[x + winLens] = leftColSumSq[x + winLens];
-          leftSum += leftColSum[x + winLens];
-          leftSumSq += leftColSumSq[x + winLens];
+          sum += colSum[x + winLens];
+          sumSq += colSumSq[x + winLens];
         }
         if (x > winLens)
         {
-          leftSum -= leftColSum[x - 1 - winLens];
-          leftSumSq -= leftColSumSq[x - 1 - winLens];
+          sum -= colSum[x - 1 - winLens];
+          sumSq -= colSumSq[x - 1 - winLens];
         }
-        sum = leftSum;
-        sumSq = leftSumSq;
       }
+      const uint32_t numPixInPart = (MIN(x + winLens, width - 1) - MAX(x - winLens, 0) + 1) * winHeight;
 
       double average = (double)(sum) / numPixInPart;
       double variance = (double)(sumSq) / numPixInPart - average * average;
-      int binLen = aps->m_reshapeLUTSize / m_binNum;
       uint32_t binIdx = (uint32_t)(pxlY / binLen);
       if (aps->m_lumaBD > 10)
       {
@@ -289,24 +231,136 @@ void uvg_calc_seq_stats(struct encoder_state_t* const state, const videoframe_t*
         variance = variance * (double)(1 << (20 - 2 * aps->m_lumaBD));
       }
       double varLog10 = log10(variance + 1.0);
-      stats->binVar[binIdx] += varLog10;
-      binCnt[binIdx]++;
+      band->binVar[binIdx] += varLog10;
+      band->binCnt[binIdx]++;
+
+      band->sumY += pxlY;
+      band->sumSqY += (int64_t)pxlY * (int64_t)pxlY;
+    }
+  }
+
+  FREE_POINTER(colSum);
+  FREE_POINTER(colSumSq);
+
+  if (band->chroma)
+  {
+    const int strideC = stride / 2;
+    for (uint32_t y = band->yBegin / 2; y < band->yEnd / 2; y++)
+    {
+      const uvg_pixel* picU = &source->u[y * strideC];
+      const uvg_pixel* picV = &source->v[y * strideC];
+      for (int32_t x = 0; x < width / 2; x++)
+      {
+        band->sumU += picU[x];
+        band->sumV += picV[x];
+        band->sumSqU += (int64_t)picU[x] * (int64_t)picU[x];
+        band->sumSqV += (int64_t)picV[x] * (int64_t)picV[x];
+      }
+    }
+  }
+}
+
+/**
+ * \brief Set up the band of LCU row band_idx with zero statistics.
+ */
+static void init_stats_band(lmcs_stats_band_t* band, const videoframe_t* frame, const lmcs_aps* aps,
+                            uint32_t winLens, uint32_t band_idx, bool chroma)
+{
+  memset(band, 0, sizeof(*band));
+  band->frame = frame;
+  band->aps = aps;
+  band->winLens = winLens;
+  band->yBegin = band_idx * LCU_WIDTH;
+  band->yEnd = MIN((band_idx + 1) * LCU_WIDTH, frame->source->height);
+  band->chroma = chroma;
+}
+
+void uvg_calc_seq_stats(struct encoder_state_t* const state, const videoframe_t* frame, lmcs_seq_info* stats, lmcs_aps* aps)
+{
+  const encoder_control_t* const encoder = state->encoder_control;
+
+  int32_t m_binNum = PIC_CODE_CW_BINS;
+  const uint32_t width = frame->source->width;
+  const uint32_t height = frame->source->height;
+  uint32_t winLens = (aps->m_binNum == PIC_CODE_CW_BINS) ? (MIN(height, width) / 240) : 2;
+  winLens = winLens > 0 ? winLens : 1;
+
+  if (encoder->chroma_format != UVG_CSP_400)
+  {
+    // ToDo: Handle other than YUV 4:2:0
+    assert(encoder->chroma_format == UVG_CSP_420);
+  }
+
+  uvg_init_lmcs_seq_stats(stats, m_binNum);
+
+  // Analyze the frame in bands of LCU rows in parallel. The partial sums
+  // are combined in the band order, so the result does not depend on the
+  // number of threads. If the buffers cannot be allocated, the bands are
+  // analyzed one at a time in this thread.
+  const uint32_t num_bands = (height + LCU_WIDTH - 1) / LCU_WIDTH;
+  lmcs_stats_band_t* bands = calloc(num_bands, sizeof(lmcs_stats_band_t));
+  threadqueue_job_t** jobs = calloc(num_bands, sizeof(threadqueue_job_t*));
+  const bool parallel = bands != NULL && jobs != NULL;
+  lmcs_stats_band_t serial_band;
+  if (parallel)
+  {
+    for (uint32_t i = 0; i < num_bands; i++)
+    {
+      init_stats_band(&bands[i], frame, aps, winLens, i, encoder->chroma_format != UVG_CSP_400);
+      jobs[i] = uvg_threadqueue_job_create(lmcs_stats_band_worker, &bands[i]);
+      if (jobs[i])
+      {
+        uvg_threadqueue_submit(encoder->threadqueue, jobs[i]);
+      }
+      else
+      {
+        lmcs_stats_band_worker(&bands[i]);
+      }
     }
-    picY += stride;
   }
 
+  uint32_t binCnt[PIC_CODE_CW_BINS] = { 0 };
+  int64_t sumY = 0, sumSqY = 0;
+  int64_t sumU = 0, sumSqU = 0;
+  int64_t sumV = 0, sumSqV = 0;
+  for (uint32_t i = 0; i < num_bands; i++)
+  {
+    const lmcs_stats_band_t* band;
+    if (parallel)
+    {
+      if (jobs[i])
+      {
+        uvg_threadqueue_waitfor(encoder->threadqueue, jobs[i]);
+        uvg_threadqueue_free_job(&jobs[i]);
+      }
+      band = &bands[i];
+    }
+    else
+    {
+      init_stats_band(&serial_band, frame, aps, winLens, i, encoder->chroma_format != UVG_CSP_400);
+      lmcs_stats_band_worker(&serial_band);
+      band = &serial_band;
+    }
+    for (int b = 0; b < m_binNum; b++)
+    {
+      stats->binVar[b] += band->binVar[b];
+      binCnt[b] += band->binCnt[b];
+    }
+    sumY += band->sumY;
+    sumSqY += band->sumSqY;
+    sumU += band->sumU;
+    sumSqU += band->sumSqU;
+    sumV += band->sumV;
+    sumSqV += band->sumSqV;
+  }
+  FREE_POINTER(jobs);
+  FREE_POINTER(bands);
+
   for (int b = 0; b < m_binNum; b++)
   {
     stats->binHist[b] = (double)binCnt[b] / (double)(aps->m_reshapeCW.rspPicSize);
     stats->binVar[b] = (binCnt[b] > 0) ? (stats->binVar[b] / binCnt[b]) : 0.0;
   }
-  FREE_POINTER(binCnt);
-  FREE_POINTER(topColSum);
-  FREE_POINTER(topColSumSq);
-  FREE_POINTER(topRowSum);
-  FREE_POINTER(topRowSumSq);
-  FREE_POINTER(leftColSum);
-  FREE_POINTER(leftColSumSq);
 
   stats->minBinVar = 5.0;
   stats->maxBinVar = 0.0;
@@ -333,51 +387,18 @@ void uvg_calc_seq_stats(struct encoder_state_t* const state, const videoframe_t*
     stats->weightNorm += stats->binHist[b] * stats->normVar[b];
   }
 
-  picY = &frame->source->y[CU_TO_PIXEL(0, 0, 0, frame->source->stride)];
-  double avgY = 0.0;
-  double varY = 0.0;
-  for (uint32_t y = 0; y < height; y++)
-  {
-    for (uint32_t x = 0; x < width; x++)
-    {
-      avgY += picY[x];
-      varY += (double)picY[x] * (double)picY[x];
-    }
-    picY += stride;
-  }
-  avgY = avgY / (width * height);
-  varY = varY / (width * height) - avgY * avgY;
+  double avgY = (double)sumY / (width * height);
+  double varY = (double)sumSqY / (width * height) - avgY * avgY;
 
   if (encoder->chroma_format != UVG_CSP_400)
   {
-    // ToDo: Handle other than YUV 4:2:0
-    assert(encoder->chroma_format == UVG_CSP_420);
-
-    uvg_pixel* picU = &frame->source->u[CU_TO_PIXEL(0, 0, 0, frame->source->stride/2)];
-    uvg_pixel* picV = &frame->source->v[CU_TO_PIXEL(0, 0, 0, frame->source->stride / 2)];
     const int widthC = frame->source->width/2;
     const int heightC = frame->source->height/2;
-    const int strideC = frame->source->stride/2;
-
 
-    double avgU = 0.0, avgV = 0.0;
-    double varU = 0.0, varV = 0.0;
-    for (int y = 0; y < heightC; y++)
-    {
-      for (int x = 0; x < widthC; x++)
-      {
-        avgU += picU[x];
-        avgV += picV[x];
-        varU += (int64_t)picU[x] * (int64_t)picU[x];
-        varV += (int64_t)picV[x] * (int64_t)picV[x];
-      }
-      picU += strideC;
-      picV += strideC;
-    }
-    avgU = avgU / (widthC * heightC);
-    avgV = avgV / (widthC * heightC);
-    varU = varU / (widthC * heightC) - avgU * avgU;
-    varV = varV / (widthC * heightC) - avgV * avgV;
+    double avgU = (double)sumU / (widthC * heightC);
+    double avgV = (double)sumV / (widthC * heightC);
+    double varU = (double)sumSqU / (widthC * heightC) - avgU * avgU;
+    double varV = (double)sumSqV / (widthC * heightC) - avgV * avgV;
     if (varY > 0)
     {
       stats->ratioStdU = sqrt(varU) / sqrt(varY);
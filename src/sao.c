@@ -206,7 +206,7 @@ void uvg_calc_sao_offset_array(const encoder_control_t * const encoder, const sa
  * \param rec_data  Reconstructed pixel data. 64x64 for luma, 32x32 for chroma.
  * \param sao_bands an array of bands for original and reconstructed block
  */
-static int calc_sao_band_offsets(int sao_bands[2][32], int offsets[4],
+static int calc_sao_band_offsets(const int sao_bands[2][32], int offsets[4],
                                  int *band_position)
 {
   int band;
@@ -261,27 +261,40 @@ static int calc_sao_band_offsets(int sao_bands[2][32], int offsets[4],
 }
 
 /**
- * \param orig_data  Original pixel data. 64x64 for luma, 32x32 for chroma.
- * \param rec_data  Reconstructed pixel data. 64x64 for luma, 32x32 for chroma.
- * \param sao_bands an array of bands for original and reconstructed block
+ * \brief Calculate the change in SSE caused by edge offsets.
+ *
+ * \param stats     statistics of the block
+ * \param eo_class  edge offset class
+ * \param offsets   offsets of the edge categories
  */
-static void calc_sao_bands(const encoder_state_t * const state, const uvg_pixel *orig_data, const uvg_pixel *rec_data,
-                           int block_width, int block_height,
-                           int sao_bands[2][32])
+int uvg_sao_edge_ddistortion_stats(const sao_stats_t *stats, sao_eo_class eo_class,
+                                    const int offsets[NUM_SAO_EDGE_CATEGORIES])
 {
-  int y, x;
-  int shift = state->encoder_control->bitdepth-5;
-
-  //Loop pixels and take top 5 bits to classify different bands
-  for (y = 0; y < block_height; ++y) {
-    for (x = 0; x < block_width; ++x) {
-      int32_t curr_pos = y * block_width + x;
+  int ddistortion = 0;
+  for (int edge_cat = SAO_EO_CAT0; edge_cat < NUM_SAO_EDGE_CATEGORIES; ++edge_cat) {
+    const int offset = offsets[edge_cat];
+    ddistortion += stats->edge[eo_class][1][edge_cat] * offset * offset -
+                   2 * offset * stats->edge[eo_class][0][edge_cat];
+  }
+  return ddistortion;
+}
 
-      uvg_pixel sb_index = rec_data[curr_pos] >> shift;
-      sao_bands[0][sb_index] += orig_data[curr_pos] - rec_data[curr_pos];
-      sao_bands[1][sb_index]++;
-    }
+/**
+ * \brief Calculate the change in SSE caused by band offsets.
+ *
+ * \param stats     statistics of the block
+ * \param band_pos  first of the four bands with an offset
+ * \param offsets   offsets of the four bands
+ */
+int uvg_sao_band_ddistortion_stats(const sao_stats_t *stats, int band_pos, const int offsets[4])
+{
+  int ddistortion = 0;
+  for (int i = 0; i < 4 && band_pos + i < 32; ++i) {
+    const int offset = offsets[i];
+    ddistortion += stats->band[1][band_pos + i] * offset * offset -
+                   2 * offset * stats->band[0][band_pos + i];
   }
+  return ddistortion;
 }
 
 
@@ -361,18 +374,14 @@ void uvg_sao_reconstruct(const encoder_state_t *state,
 }
 
 
-static void sao_search_edge_sao(const encoder_state_t * const state, 
-                                const uvg_pixel * data[], const uvg_pixel * recdata[],
-                                int block_width, int block_height,
+static void sao_search_edge_sao(const encoder_state_t * const state,
+                                const sao_stats_t stats[],
                                 unsigned buf_cnt,
                                 sao_info_t *sao_out, sao_info_t *sao_top,
                                 sao_info_t *sao_left)
 {
   sao_eo_class edge_class;
-  // This array is used to calculate the mean offset used to minimize distortion.
-  int cat_sum_cnt[2][NUM_SAO_EDGE_CATEGORIES];
   unsigned i = 0;
-  
 
   sao_out->type = SAO_TYPE_EDGE;
   sao_out->ddistortion = INT_MAX;
@@ -382,12 +391,11 @@ static void sao_search_edge_sao(const encoder_state_t * const state,
     int sum_ddistortion = 0;
     sao_eo_cat edge_cat;
 
-    // Call calc_sao_edge_dir once for luma and twice for chroma.
+    // Once for luma and twice for chroma.
     for (i = 0; i < buf_cnt; ++i) {
-      FILL(cat_sum_cnt, 0);
-      uvg_calc_sao_edge_dir(data[i], recdata[i], edge_class,
-                        block_width, block_height, cat_sum_cnt);
-    
+      // The sums and counts are used to calculate the mean offset used to
+      // minimize distortion.
+      const int32_t (*cat_sum_cnt)[NUM_SAO_EDGE_CATEGORIES] = stats[i].edge[edge_class];
 
       for (edge_cat = SAO_EO_CAT1; edge_cat <= SAO_EO_CAT4; ++edge_cat) {
         int cat_sum = cat_sum_cnt[0][edge_cat];
@@ -440,8 +448,7 @@ static void sao_search_edge_sao(const encoder_state_t * const state,
 }
 
 
-static void sao_search_band_sao(const encoder_state_t * const state, const uvg_pixel * data[], const uvg_pixel * recdata[],
-                               int block_width, int block_height,
+static void sao_search_band_sao(const encoder_state_t * const state, const sao_stats_t stats[],
                                unsigned buf_cnt,
                                sao_info_t *sao_out, sao_info_t *sao_top,
                                sao_info_t *sao_left)
@@ -453,18 +460,12 @@ static void sao_search_band_sao(const encoder_state_t * const state, const uvg_p
 
   // Band offset
   {
-    int sao_bands[2][32];
     int temp_offsets[10];
     int ddistortion = 0;
     double temp_rate = 0.0;
     
     for (i = 0; i < buf_cnt; ++i) {
-      FILL(sao_bands, 0);
-      calc_sao_bands(state, data[i], recdata[i],block_width,
-                     block_height,sao_bands);
-    
-
-      ddistortion += calc_sao_band_offsets(sao_bands, &temp_offsets[1+5*i], &sao_out->band_position[i]);      
+      ddistortion += calc_sao_band_offsets(stats[i].band, &temp_offsets[1+5*i], &sao_out->band_position[i]);
     }
 
     temp_rate = sao_mode_bits_band(state, sao_out->band_position, temp_offsets, sao_top, sao_left, buf_cnt);
@@ -496,6 +497,15 @@ static void sao_search_best_mode(const encoder_state_t * const state, const uvg_
 {
   sao_info_t edge_sao;
   sao_info_t band_sao;
+  sao_stats_t stats[2];
+
+  // Collect the statistics of all the modes in a single pass over the
+  // samples, the costs of the modes are calculated from them.
+  for (unsigned buf_i = 0; buf_i < buf_cnt; ++buf_i) {
+    FILL(stats[buf_i], 0);
+    uvg_calc_sao_stats(data[buf_i], recdata[buf_i], block_width, block_height,
+                       state->encoder_control->bitdepth, &stats[buf_i]);
+  }
 
   init_sao_info(&edge_sao);
   init_sao_info(&band_sao);
@@ -508,15 +518,13 @@ static void sao_search_best_mode(const encoder_state_t * const state, const uvg_
   band_sao.eo_class = SAO_EO0;
 
   if (state->encoder_control->cfg.sao_type & 1){
-    sao_search_edge_sao(state, data, recdata, block_width, block_height, buf_cnt, &edge_sao, sao_top, sao_left);
+    sao_search_edge_sao(state, stats, buf_cnt, &edge_sao, sao_top, sao_left);
     double mode_bits = sao_mode_bits_edge(state, edge_sao.eo_class, edge_sao.offsets, sao_top, sao_left, buf_cnt);
     int ddistortion = (int)(mode_bits * state->lambda + 0.5);
     unsigned buf_i;
     
     for (buf_i = 0; buf_i < buf_cnt; ++buf_i) {
-      ddistortion += uvg_sao_edge_ddistortion(data[buf_i], recdata[buf_i], 
-                                          block_width, block_height,
-                                          edge_sao.eo_class, &edge_sao.offsets[5 * buf_i]);
+      ddistortion += uvg_sao_edge_ddistortion_stats(&stats[buf_i], edge_sao.eo_class, &edge_sao.offsets[5 * buf_i]);
     }
     
     edge_sao.ddistortion = ddistortion;
@@ -526,15 +534,13 @@ static void sao_search_best_mode(const encoder_state_t * const state, const uvg_
   }
 
   if (state->encoder_control->cfg.sao_type & 2){
-    sao_search_band_sao(state, data, recdata, block_width, block_height, buf_cnt, &band_sao, sao_top, sao_left);
+    sao_search_band_sao(state, stats, buf_cnt, &band_sao, sao_top, sao_left);
     double mode_bits = sao_mode_bits_band(state, band_sao.band_position, band_sao.offsets, sao_top, sao_left, buf_cnt);
     int ddistortion = (int)(mode_bits * state->lambda + 0.5);
     unsigned buf_i;
     
     for (buf_i = 0; buf_i < buf_cnt; ++buf_i) {
-      ddistortion += uvg_sao_band_ddistortion(state, data[buf_i], recdata[buf_i], 
-                                          block_width, block_height, 
-                                          band_sao.band_position[buf_i], &band_sao.offsets[1 + 5 * buf_i]);
+      ddistortion += uvg_sao_band_ddistortion_stats(&stats[buf_i], band_sao.band_position[buf_i], &band_sao.offsets[1 + 5 * buf_i]);
     }
     
     band_sao.ddistortion = ddistortion;
@@ -577,16 +583,14 @@ static void sao_search_best_mode(const encoder_state_t * const state, const uvg_
         switch (merge_cand->type) {
           case SAO_TYPE_EDGE:
                 for (buf_i = 0; buf_i < buf_cnt; ++buf_i) {
-                  ddistortion += uvg_sao_edge_ddistortion(data[buf_i], recdata[buf_i],
-                    block_width, block_height,
+                  ddistortion += uvg_sao_edge_ddistortion_stats(&stats[buf_i],
                     merge_cand->eo_class, &merge_cand->offsets[5 * buf_i]);
                 }
                 merge_cost[i + 1] = ddistortion;
             break;
           case SAO_TYPE_BAND:
               for (buf_i = 0; buf_i < buf_cnt; ++buf_i) {
-                ddistortion += uvg_sao_band_ddistortion(state, data[buf_i], recdata[buf_i],
-                  block_width, block_height,
+                ddistortion += uvg_sao_band_ddistortion_stats(&stats[buf_i],
                   merge_cand->band_position[buf_i], &merge_cand->offsets[1 + 5 * buf_i]);
               }
               merge_cost[i + 1] = ddistortion;
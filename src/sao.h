@@ -62,6 +62,18 @@ typedef struct sao_info_t {
   int offsets[NUM_SAO_EDGE_CATEGORIES * 2];
 } sao_info_t;
 
+/**
+ * \brief Sums of orig - rec and sample counts of a block.
+ *
+ * Collected for the categories of every edge offset class and for every
+ * band, so that the costs of all SAO modes can be evaluated without going
+ * through the samples again.
+ */
+typedef struct sao_stats_t {
+  int32_t edge[SAO_NUM_EO][2][NUM_SAO_EDGE_CATEGORIES];
+  int32_t band[2][32];
+} sao_stats_t;
+
 
 // Offsets of a and b in relation to c.
 // dir_offset[dir][a or b]
@@ -96,5 +108,8 @@ void uvg_sao_reconstruct(const encoder_state_t *state,
 
 void uvg_sao_search_lcu(const encoder_state_t* const state, int lcu_x, int lcu_y);
 void uvg_calc_sao_offset_array(const encoder_control_t * const encoder, const sao_info_t *sao, int *offset, color_t color_i);
+int uvg_sao_edge_ddistortion_stats(const sao_stats_t *stats, sao_eo_class eo_class,
+                                    const int offsets[NUM_SAO_EDGE_CATEGORIES]);
+int uvg_sao_band_ddistortion_stats(const sao_stats_t *stats, int band_pos, const int offsets[4]);
 
 #endif
@@ -52,6 +52,7 @@
 #include "threadqueue.h"
 #include "transform.h"
 #include "videoframe.h"
+#include "strategies/strategies-intra.h"
 #include "strategies/strategies-picture.h"
 #include "strategies/strategies-quant.h"
 #include "reshape.h"
@@ -458,23 +459,19 @@ static void downsample_cclm_rec(encoder_state_t *state, int x, int y, int width,
   const int stride = state->tile->frame->rec->stride;
   const int stride2 = (((state->tile->frame->width + 7) & ~7) + FRAME_PADDING_LUMA);
 
-  for (int y_ = 0; y_ < height && y_ * 2 + y < state->tile->frame->height; y_++) {
-    for (int x_ = 0; x_ < width; x_++) {
-      int s = 4;
-      s += y_rec[2 * x_] * 2;
-      s += y_rec[2 * x_ + 1];
-      // If we are at the edge of the CTU read the pixel from the frame reconstruct buffer,
-      // *except* when we are also at the edge of the frame, in which case we want to duplicate
-      // the edge pixel
-      s += !x_scu && !x_ && x ? state->tile->frame->rec->y[x - 1 + (y + y_ * 2) * stride] : y_rec[2 * x_ - ((x_ + x) > 0)];
-      s += y_rec[2 * x_ + LCU_WIDTH] * 2;
-      s += y_rec[2 * x_ + 1 + LCU_WIDTH];
-      s += !x_scu && !x_ && x ? state->tile->frame->rec->y[x - 1 + (y + y_ * 2 + 1) * stride] : y_rec[2 * x_ - ((x_ + x) > 0) + LCU_WIDTH];
-      int index = x / 2 + x_ + (y / 2 + y_ )* stride2 / 2;
-      state->tile->frame->cclm_luma_rec[index] = s >> 3;
-    }
-    y_rec += LCU_WIDTH * 2;
+  const int rows = CLIP(0, height, (state->tile->frame->height - y + 1) / 2);
+
+  // If we are at the edge of the CTU read the left pixels from the frame reconstruct buffer,
+  // *except* when we are also at the edge of the frame, in which case we want to duplicate
+  // the edge pixel
+  uvg_pixel left[LCU_WIDTH];
+  for (int i = 0; i < rows * 2; ++i) {
+    left[i] = !x_scu && x ? state->tile->frame->rec->y[x - 1 + (y + i) * stride] : y_rec[i * LCU_WIDTH - (x > 0)];
   }
+  uvg_cclm_downsample(y_rec, LCU_WIDTH, left,
+    &state->tile->frame->cclm_luma_rec[x / 2 + (y / 2) * stride2 / 2], stride2 / 2,
+    width, rows);
+  y_rec += LCU_WIDTH * 2 * rows;
   if((y + height * 2) % 64 == 0) {
     int line = y / 64 * stride2 / 2;
     y_rec -= LCU_WIDTH;
@@ -1264,9 +1261,18 @@ static double search_cu(
 
   // Assign correct depth limit
   constraint_t* constr = state->constraint;
+  // The ML prediction gives quad-tree depths, so the CUs of a multi-type
+  // tree use the depth and the position of their quad-tree leaf.
+  const int intra_depth = constr->ml_intra_depth_ctu ? split_tree.current_depth - split_tree.mtt_depth : split_tree.current_depth;
   if(constr->ml_intra_depth_ctu) {
-    pu_depth_intra.min = constr->ml_intra_depth_ctu->_mat_upper_depth[(x_local >> 3) + (y_local >> 3) * 8];
-    pu_depth_intra.max = constr->ml_intra_depth_ctu->_mat_lower_depth[(x_local >> 3) + (y_local >> 3) * 8];
+    const int qt_leaf_mask = ~((LCU_WIDTH >> intra_depth) - 1);
+    const int ml_idx = ((x_local & qt_leaf_mask) >> 3) + ((y_local & qt_leaf_mask) >> 3) * 8;
+    pu_depth_intra.min = constr->ml_intra_depth_ctu->_mat_upper_depth[ml_idx];
+    pu_depth_intra.max = constr->ml_intra_depth_ctu->_mat_lower_depth[ml_idx];
+    if (split_tree.mtt_depth > 0) {
+      // The predicted depth can no longer be reached inside a multi-type tree
+      pu_depth_intra.min = MIN(pu_depth_intra.min, intra_depth);
+    }
   }
   else {
     pu_depth_intra.min = ctrl->cfg.pu_depth_intra.min[gop_layer] >= 0 ? ctrl->cfg.pu_depth_intra.min[gop_layer] : ctrl->cfg.pu_depth_intra.min[0];
@@ -1334,7 +1340,7 @@ static double search_cu(
 
     int32_t cu_width_intra_min = LCU_WIDTH >> pu_depth_intra.max;
     bool can_use_intra =
-      (WITHIN(split_tree.current_depth, pu_depth_intra.min, pu_depth_intra.max) ||
+      (WITHIN(intra_depth, pu_depth_intra.min, pu_depth_intra.max) ||
         // When the split was forced because the CTU is partially outside
         // the frame, we permit intra coding even if pu_depth_intra would
         // otherwise forbid it.
@@ -1343,6 +1349,7 @@ static double search_cu(
       !(state->encoder_control->cfg.force_inter && state->frame->slicetype != UVG_SLICE_I);
 
     intra_search.cost = 0;
+    uvg_intra_ref_cache_begin(state, lcu, cu_loc, chroma_loc);
     if (can_use_intra && !skip_intra) {
       intra_search.pred_cu = *cur_cu;
       if(tree_type != UVG_CHROMA_T) {
@@ -1374,7 +1381,7 @@ static double search_cu(
           uvg_recon_and_estimate_cost_isp(
             state,
             cu_loc,
-            0,
+            MAX_DOUBLE,
             &intra_search,
             lcu,
             NULL
@@ -1482,7 +1489,7 @@ static double search_cu(
         uvg_recon_and_estimate_cost_isp(
           state,
           cu_loc,
-          0,
+          MAX_DOUBLE,
           &intra_search,
           lcu,
           NULL
@@ -1592,6 +1599,7 @@ static double search_cu(
       lcu_fill_cbf(lcu, x_local, y_local, cu_width, cu_height, cur_cu, UVG_BOTH_T);
     }
   }
+  uvg_intra_ref_cache_end(state);
   
   // The cabac functions assume chroma locations whereas the search uses luma locations
   // for the chroma tree, therefore we need to shift the chroma coordinates here for
@@ -1680,7 +1688,7 @@ static double search_cu(
     // If the CU is partially outside the frame, we need to split it even
     // if pu_depth_intra and pu_depth_inter would not permit it.
     cur_cu->type == CU_NOTSET ||
-    (split_tree.current_depth < pu_depth_intra.max && !(state->encoder_control->cfg.force_inter&& state->frame->slicetype != UVG_SLICE_I)) ||
+    (intra_depth < pu_depth_intra.max && !(state->encoder_control->cfg.force_inter&& state->frame->slicetype != UVG_SLICE_I)) ||
     (state->frame->slicetype != UVG_SLICE_I &&
       split_tree.current_depth < pu_depth_inter.max);
 
@@ -1696,9 +1704,9 @@ static double search_cu(
   const int max_btd = state->encoder_control->cfg.max_btt_depth[slice_type];
   int minimum_split_amount;
   switch (slice_type) {
-  case 0: minimum_split_amount = pu_depth_intra.min - split_tree.current_depth; break;
-  case 1: minimum_split_amount = MIN(pu_depth_intra.min, pu_depth_inter.min) - split_tree.current_depth; break;
-  case 2: minimum_split_amount = pu_depth_intra.min - split_tree.current_depth; break;
+  case 0: minimum_split_amount = pu_depth_intra.min - intra_depth; break;
+  case 1: minimum_split_amount = MIN(pu_depth_intra.min - intra_depth, pu_depth_inter.min - split_tree.current_depth); break;
+  case 2: minimum_split_amount = pu_depth_intra.min - intra_depth; break;
     default:
       assert(0 && "Incorrect_slice_type");
   }
@@ -1708,6 +1716,17 @@ static double search_cu(
     can_split[2] = can_split[3] = can_split[4] = can_split[5] = false;
   }
 
+  if (constr->ml_intra_depth_ctu && state->frame->slicetype == UVG_SLICE_I && !is_implicit && tree_type != UVG_CHROMA_T) {
+    if (intra_depth == pu_depth_intra.max && cur_cu->type != CU_NOTSET) {
+      // The predicted quad-tree leaf may still be divided by the multi-type tree
+      can_split_cu = true;
+      can_split[QT_SPLIT] = false;
+    }
+    if (cur_cu->type != CU_NOTSET) {
+      uvg_ml_intra_mtt_pruning(constr->ml_intra_depth_ctu, x_local, y_local, cu_width, cu_height, can_split);
+    }
+  }
+
   can_split_cu &= can_split[1] || can_split[2] || can_split[3] || can_split[4] || can_split[5];
 
   bool improved[6] = {false};
@@ -1881,7 +1900,14 @@ static double search_cu(
 
         cur_cu->intra = cu_d1->intra;
         cur_cu->type = CU_INTRA;
-        if (cur_cu->intra.mode_chroma > 79) {
+        // The chroma mode of a local dual tree may be derived from another
+        // luma CU, use DM if the mode cannot be signaled with this luma mode.
+        const int8_t luma_dm = cur_cu->intra.mip_flag ? 0 : cur_cu->intra.mode;
+        const int8_t mode_chroma = cur_cu->intra.mode_chroma;
+        const bool luma_in_list = luma_dm == 0 || luma_dm == 1 || luma_dm == 18 || luma_dm == 50;
+        if (mode_chroma > 79 ||
+            (mode_chroma != luma_dm && mode_chroma != 0 && mode_chroma != 1 && mode_chroma != 18 && mode_chroma != 50 &&
+             !(mode_chroma == 66 && luma_in_list))) {
           cur_cu->intra.mode_chroma = cur_cu->intra.mode;
         }
 
@@ -2113,6 +2139,9 @@ static void copy_lcu_to_cu_data(const encoder_state_t * const state, int x_px, i
     x_px,
     y_px,
     lcu);
+  if (tree_type != UVG_CHROMA_T) {
+    uvg_motion_field_copy_from_lcu(state->tile->frame->motion_field, x_px, y_px, lcu);
+  }
 
   // Copy pixels to picture.
   {
@@ -2159,6 +2188,21 @@ void uvg_search_lcu(encoder_state_t * const state, const int x, const int y, con
   lcu_t work_tree;
   init_lcu_t(state, x, y, &work_tree, hor_buf, ver_buf);
 
+  intra_ref_cache_t intra_ref_cache;
+  intra_ref_cache.lcu = NULL;
+  state->intra_ref_cache = &intra_ref_cache;
+
+  state->merge_cost_cache.size = 0;
+  state->merge_cost_cache.next = 0;
+
+  if (state->encoder_control->cfg.intra_gradient_presel) {
+    uvg_intra_gradient_histogram(
+      work_tree.ref.y,
+      MIN(LCU_WIDTH, state->tile->frame->width - x),
+      MIN(LCU_WIDTH, state->tile->frame->height - y),
+      &state->intra_grad_hist);
+  }
+
   // If the ML depth prediction is enabled, 
   // generate the depth prediction interval 
   // for the current lcu
@@ -2216,4 +2260,6 @@ void uvg_search_lcu(encoder_state_t * const state, const int x, const int y, con
   if (state->encoder_control->cfg.jccr) {
     copy_coeffs(work_tree.coeff.joint_uv, coeff->joint_uv, LCU_WIDTH_C, LCU_WIDTH_C, LCU_WIDTH_C);
   }
+
+  state->intra_ref_cache = NULL;
 }
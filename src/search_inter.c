@@ -49,6 +49,9 @@
 #include "transform.h"
 #include "videoframe.h"
 
+// Maximum number of distinct motion vectors checked by hash motion search
+#define HASH_ME_MAX_CANDS 16
+
 typedef struct {
   encoder_state_t *state;
 
@@ -220,7 +223,8 @@ static bool check_mv_cost(inter_search_info_t *info,
       info->state->tile->offset_y + info->origin.y + y,
       info->width,
       info->height,
-      info->optimized_sad
+      info->optimized_sad,
+      info->state->encoder_control->ref_padding
   );
 
   if (cost >= *best_cost) return false;
@@ -375,6 +379,108 @@ static void select_starting_point(inter_search_info_t *info,
 }
 
 
+/**
+ * \brief Check whether the source blocks of the PU match the reference.
+ *
+ * The 8x8 blocks that fit in the PU at the same grid as the matched block
+ * at (dx, dy) are compared to the block hash of the reference
+ * reconstruction.
+ */
+static bool hash_match_pu(const inter_search_info_t *info,
+                          const uvg_block_hash_t *ref_hash,
+                          int dx,
+                          int dy,
+                          vector2d_t mv)
+{
+  const uvg_picture *pic = info->pic;
+  const int ref_x = info->state->tile->offset_x + info->origin.x + dx + mv.x;
+  const int ref_y = info->state->tile->offset_y + info->origin.y + dy + mv.y;
+  const int ref_cols = ref_hash->stride;
+  const int ref_rows = info->ref->height / UVG_BLOCK_HASH_STEP;
+
+  for (int y = dy; y + UVG_HASHMAP_BLOCKSIZE <= info->height; y += UVG_HASHMAP_BLOCKSIZE) {
+    for (int x = dx; x + UVG_HASHMAP_BLOCKSIZE <= info->width; x += UVG_HASHMAP_BLOCKSIZE) {
+      const int grid_x = (ref_x + x - dx) / UVG_BLOCK_HASH_STEP;
+      const int grid_y = (ref_y + y - dy) / UVG_BLOCK_HASH_STEP;
+      if (grid_x >= ref_cols || grid_y >= ref_rows) return false;
+      const uint32_t crc = uvg_crc32c_8x8(&pic->y[(info->origin.y + y) * pic->stride + info->origin.x + x], pic->stride);
+      if (crc != ref_hash->pos_to_hash[grid_y * ref_cols + grid_x]) return false;
+    }
+  }
+  return true;
+}
+
+
+/**
+ * \brief Check motion vectors to exactly matching blocks of the reference.
+ *
+ * The source 8x8 blocks at the positions next to the top-left corner of the
+ * PU are looked up from the block hash of the reference frame. Since the
+ * hash has a block at every UVG_BLOCK_HASH_STEP:th position, one of the
+ * lookups hits for any displacement. Vectors for which the rest of the PU
+ * matches as well are checked with check_mv_cost.
+ *
+ * \return true if a matching vector was selected as best_mv
+ */
+static bool hash_motion_search(inter_search_info_t *info,
+                               double *best_cost,
+                               double* best_bits,
+                               vector2d_t *best_mv)
+{
+  const uvg_block_hash_t *ref_hash = info->state->frame->ref->block_hashes[info->ref_idx];
+  if (!info->state->frame->hash_me || !ref_hash) return false;
+  if (info->width < UVG_HASHMAP_BLOCKSIZE || info->height < UVG_HASHMAP_BLOCKSIZE) return false;
+
+  const uvg_picture *pic = info->pic;
+
+  vector2d_t checked[HASH_ME_MAX_CANDS];
+  int num_checked = 0;
+  bool found = false;
+
+  for (int dy = 0; dy < UVG_BLOCK_HASH_STEP; ++dy) {
+    for (int dx = 0; dx < UVG_BLOCK_HASH_STEP; ++dx) {
+      const int x = info->origin.x + dx;
+      const int y = info->origin.y + dy;
+      if (x + UVG_HASHMAP_BLOCKSIZE > pic->width || y + UVG_HASHMAP_BLOCKSIZE > pic->height) continue;
+
+      // Blocks with identical rows are not in the hashmap.
+      const uvg_pixel *block = &pic->y[y * pic->stride + x];
+      bool same_rows = true;
+      for (int yy = 1; yy < UVG_HASHMAP_BLOCKSIZE && same_rows; ++yy) {
+        same_rows = !memcmp(block, &block[yy * pic->stride], UVG_HASHMAP_BLOCKSIZE * sizeof(uvg_pixel));
+      }
+      if (same_rows) continue;
+
+      const uint32_t crc = uvg_crc32c_8x8(block, pic->stride);
+      for (uvg_hashmap_node_t *node = uvg_hashmap_search(ref_hash->map, crc); node != NULL; node = node->next) {
+        if (node->key != crc) continue;
+
+        const vector2d_t mv = {
+          (int)(node->value >> 16) - (info->state->tile->offset_x + x),
+          (int)(node->value & 0xffff) - (info->state->tile->offset_y + y),
+        };
+
+        bool duplicate = false;
+        for (int i = 0; i < num_checked && !duplicate; ++i) {
+          duplicate = checked[i].x == mv.x && checked[i].y == mv.y;
+        }
+        if (duplicate) continue;
+        if (num_checked == HASH_ME_MAX_CANDS) return found;
+        checked[num_checked++] = mv;
+
+        if (!hash_match_pu(info, ref_hash, dx, dy, mv)) continue;
+
+        if (check_mv_cost(info, mv.x, mv.y, best_cost, best_bits, best_mv)) {
+          found = true;
+        }
+      }
+    }
+  }
+
+  return found;
+}
+
+
 static double get_mvd_coding_cost(const encoder_state_t* state,
   const cabac_data_t* cabac,
   const int32_t mvd_hor,
@@ -1084,6 +1190,7 @@ static void search_frac(inter_search_info_t *info,
     .src_w = ref->width,
     .src_h = ref->height,
     .src_s = ref->stride,
+    .src_pad = state->encoder_control->ref_padding,
     .blk_x = state->tile->offset_x + orig.x + mv.x - 1,
     .blk_y = state->tile->offset_y + orig.y + mv.y - 1,
     .blk_w = internal_width + 1,  // TODO: real width
@@ -1348,16 +1455,16 @@ static void search_pu_inter_ref(
   // no point to this anymore, but for now it helps.
   const int mid_x = info->state->tile->offset_x + info->origin.x + (info->width >> 1);
   const int mid_y = info->state->tile->offset_y + info->origin.y + (info->height >> 1);
-  const cu_array_t* ref_array = info->state->frame->ref->cu_arrays[info->ref_idx];
-  const cu_info_t* ref_cu = uvg_cu_array_at_const(ref_array, mid_x, mid_y);
-  if (ref_cu->type == CU_INTER) {
+  const motion_field_t* ref_motion = info->state->frame->ref->motion_fields[info->ref_idx];
+  const motion_info_t* ref_cu = uvg_motion_field_at_const(ref_motion, mid_x, mid_y);
+  if (ref_cu->mv_dir) {
     vector2d_t mv_previous = { 0, 0 };
-    if (ref_cu->inter.mv_dir & 1) {
-      mv_previous.x = ref_cu->inter.mv[0][0];
-      mv_previous.y = ref_cu->inter.mv[0][1];
+    if (ref_cu->mv_dir & 1) {
+      mv_previous.x = ref_cu->mv[0][0];
+      mv_previous.y = ref_cu->mv[0][1];
     } else {
-      mv_previous.x = ref_cu->inter.mv[1][0];
-      mv_previous.y = ref_cu->inter.mv[1][1];
+      mv_previous.x = ref_cu->mv[1][0];
+      mv_previous.y = ref_cu->mv[1][1];
     }
     // Apply mv scaling if neighbor poc is available
     if (info->state->frame->ref_LX_size[ref_list] > 0) {
@@ -1374,7 +1481,7 @@ static void search_pu_inter_ref(
           break;
         }
       }
-      if ((ref_cu->inter.mv_dir & (col_list + 1)) == 0) {
+      if ((ref_cu->mv_dir & (col_list + 1)) == 0) {
         // Use the other list if the colocated PU does not have a MV for the
         // primary list.
         col_list = 1 - col_list;
@@ -1389,7 +1496,7 @@ static void search_pu_inter_ref(
         info->state->frame->ref->images[neighbor_poc_index]->ref_pocs[
           info->state->frame->ref->ref_LXs[neighbor_poc_index]
             [col_list]
-          [ref_cu->inter.mv_ref[col_list]]
+          [ref_cu->mv_ref[col_list]]
         ],
         &mv_previous
           );
@@ -1416,9 +1523,15 @@ static void search_pu_inter_ref(
   // Select starting point from among merge candidates. These should
   // include both mv_cand vectors and (0, 0).
   select_starting_point(info, best_mv, &best_cost, &best_bits, &best_mv);
-  bool skip_me = early_terminate(info, &best_cost, &best_bits, &best_mv);
-      
-  if (!(info->state->encoder_control->cfg.me_early_termination && skip_me)) {
+
+  // An exact match makes the integer motion search unnecessary.
+  bool skip_me = hash_motion_search(info, &best_cost, &best_bits, &best_mv);
+  if (!skip_me) {
+    skip_me = early_terminate(info, &best_cost, &best_bits, &best_mv) &&
+              info->state->encoder_control->cfg.me_early_termination;
+  }
+
+  if (!skip_me) {
 
     switch (cfg->ime_algorithm) {
       case UVG_IME_TZ:
@@ -1456,7 +1569,8 @@ static void search_pu_inter_ref(
       info->state->tile->offset_y + info->origin.y + (best_mv.y >> INTERNAL_MV_PREC),
       info->width,
       info->height,
-      cfg->ref_wraparound);
+      cfg->ref_wraparound,
+      info->state->encoder_control->ref_padding);
     best_cost += best_bits * info->state->lambda_sqrt;
   }
 
@@ -1506,6 +1620,7 @@ static void search_pu_inter_ref(
 static void search_pu_inter_bipred(
   inter_search_info_t *info,
   lcu_t *lcu,
+  inter_unipred_cache_t *unipred_cache,
   unit_stats_map_t *amvp_bipred)
 {
   cu_loc_t cu_loc;
@@ -1568,14 +1683,13 @@ static void search_pu_inter_bipred(
       continue;
     }
 
-    uvg_inter_recon_bipred(info->state,
-                           ref->images[ref_LX[0][merge_cand[i].ref[0]]],
-                           ref->images[ref_LX[1][merge_cand[j].ref[1]]],
-                           mv,
-                           lcu,
-                           true,
-                           false,
-                           &cu_loc);
+    uvg_inter_recon_bipred_luma_cached(info->state,
+                                       unipred_cache,
+                                       ref->images[ref_LX[0][merge_cand[i].ref[0]]],
+                                       ref->images[ref_LX[1][merge_cand[j].ref[1]]],
+                                       mv,
+                                       lcu,
+                                       &cu_loc);
 
     const uvg_pixel *rec = &lcu->rec.y[SUB_SCU(y) * LCU_WIDTH + SUB_SCU(x)];
     const uvg_pixel *src = &frame->source->y[x + y * frame->source->stride];
@@ -1657,6 +1771,88 @@ static bool merge_candidate_in_list(inter_merge_cand_t *all_cands,
   return found;
 }
 
+/**
+ * \brief Calculate luma SATD of the prediction of a merge candidate.
+ *
+ * The SATD of each 8x8 block is cached for the LCU, so PUs of other shapes
+ * with the same motion only predict the blocks that have not been seen.
+ * SATD is only additive over 8x8 blocks when the bit depth is 8 and the PU
+ * is aligned to the 8x8 grid, otherwise the whole PU is evaluated.
+ *
+ * \param state     encoder state
+ * \param cand      merge candidate, already set to the PU in lcu
+ * \param cu_loc    location of the PU
+ * \param lcu       containing LCU
+ *
+ * \return          SATD of the luma prediction
+ */
+static unsigned merge_candidate_satd(
+  encoder_state_t *const state,
+  const inter_merge_cand_t *cand,
+  const cu_loc_t *const cu_loc,
+  lcu_t *lcu)
+{
+  const int x_local = SUB_SCU(cu_loc->x);
+  const int y_local = SUB_SCU(cu_loc->y);
+  const uvg_pixel *rec = &lcu->rec.y[y_local * LCU_WIDTH + x_local];
+  const uvg_pixel *src = &lcu->ref.y[y_local * LCU_WIDTH + x_local];
+
+  if (UVG_BIT_DEPTH != 8 || (x_local | y_local | cu_loc->width | cu_loc->height) % 8 != 0) {
+    uvg_inter_pred_pu(state, lcu, true, false, cu_loc);
+    return uvg_satd_any_size(cu_loc->width, cu_loc->height, rec, LCU_WIDTH, src, LCU_WIDTH);
+  }
+
+  merge_cost_cache_t *cache = &state->merge_cost_cache;
+  merge_cost_cache_entry_t *entry = NULL;
+  for (int i = 0; i < cache->size; ++i) {
+    merge_cost_cache_entry_t *e = &cache->entries[i];
+    if (e->dir == cand->dir &&
+        (!(cand->dir & 1) || (e->ref[0] == cand->ref[0] && e->mv[0][0] == cand->mv[0][0] && e->mv[0][1] == cand->mv[0][1])) &&
+        (!(cand->dir & 2) || (e->ref[1] == cand->ref[1] && e->mv[1][0] == cand->mv[1][0] && e->mv[1][1] == cand->mv[1][1])))
+    {
+      entry = e;
+      break;
+    }
+  }
+  if (entry == NULL) {
+    entry = &cache->entries[cache->next];
+    cache->next = (cache->next + 1) % MERGE_COST_CACHE_SIZE;
+    cache->size = MIN(cache->size + 1, MERGE_COST_CACHE_SIZE);
+    memcpy(entry->mv, cand->mv, sizeof(entry->mv));
+    entry->dir = cand->dir;
+    entry->ref[0] = cand->ref[0];
+    entry->ref[1] = cand->ref[1];
+    entry->valid = 0;
+  }
+
+  const int blocks_per_row = LCU_WIDTH / 8;
+  const int x_blk = x_local / 8;
+  const int y_blk = y_local / 8;
+  const int w_blk = cu_loc->width / 8;
+  const int h_blk = cu_loc->height / 8;
+  const uint64_t row_mask = ((1ULL << w_blk) - 1) << x_blk;
+
+  bool predicted = false;
+  unsigned satd = 0;
+  for (int y = 0; y < h_blk; ++y) {
+    const int row_start = (y_blk + y) * blocks_per_row;
+    if ((entry->valid & (row_mask << row_start)) != (row_mask << row_start) && !predicted) {
+      uvg_inter_pred_pu(state, lcu, true, false, cu_loc);
+      predicted = true;
+    }
+    for (int x = 0; x < w_blk; ++x) {
+      const int blk = row_start + x_blk + x;
+      if (!(entry->valid & (1ULL << blk))) {
+        const int offset = y * 8 * LCU_WIDTH + x * 8;
+        entry->satd[blk] = uvg_satd_any_size(8, 8, rec + offset, LCU_WIDTH, src + offset, LCU_WIDTH);
+        entry->valid |= 1ULL << blk;
+      }
+      satd += entry->satd[blk];
+    }
+  }
+  return satd;
+}
+
 /**
  * \brief Collect PU parameters and costs at this depth.
  *
@@ -1758,7 +1954,6 @@ static void search_pu_inter(
     {
       continue;
     }
-    uvg_inter_pred_pu(state, lcu, true, false, cu_loc);
     merge->unit[merge->size] = *cur_pu;
     merge->unit[merge->size].type = CU_INTER;
     merge->unit[merge->size].merge_idx = merge_idx;
@@ -1767,12 +1962,11 @@ static void search_pu_inter(
 
     double bits = merge_flag_cost + merge_idx + CTX_ENTROPY_FBITS(&(state->search_cabac.ctx.cu_merge_idx_ext_model), merge_idx != 0);
     if(state->encoder_control->cfg.rdo >= 2) {
+      uvg_inter_pred_pu(state, lcu, true, false, cu_loc);
       uvg_cu_cost_inter_rd2(state, &merge->unit[merge->size], lcu, &merge->cost[merge->size], &bits, cu_loc);
     }
     else {
-      merge->cost[merge->size] = uvg_satd_any_size(cu_loc->width, cu_loc->height,
-        lcu->rec.y + y_local * LCU_WIDTH + x_local, LCU_WIDTH,
-        lcu->ref.y + y_local * LCU_WIDTH + x_local, LCU_WIDTH);
+      merge->cost[merge->size] = merge_candidate_satd(state, cur_cand, cu_loc, lcu);
       bits += no_skip_flag;
       merge->cost[merge->size] += bits * info->state->lambda_sqrt;
     }
@@ -1992,6 +2186,11 @@ static void search_pu_inter(
     *bipred_pu = *cur_pu;
     double   best_bipred_cost = MAX_DOUBLE;
 
+    // The same unipred predictions are used by several bipred candidates,
+    // so interpolate each of them only once.
+    inter_unipred_cache_t unipred_cache;
+    uvg_inter_unipred_cache_reset(&unipred_cache);
+
     // Try biprediction from valid acquired unipreds.
     if (amvp[0].size > 0 && amvp[1].size > 0) {
 
@@ -2018,14 +2217,12 @@ static void search_pu_inter(
         uvg_inter_get_mv_cand(info->state, info->mv_cand, bipred_pu, lcu, reflist, cu_loc);
       }
 
-      uvg_inter_recon_bipred(info->state,
-                             ref->images[ref_LX[0][bipred_pu->inter.mv_ref[0]]],
-                             ref->images[ref_LX[1][bipred_pu->inter.mv_ref[1]]],
-                             mv, lcu,
-                             true,
-                             false,
-                             cu_loc
-        );
+      uvg_inter_recon_bipred_luma_cached(info->state,
+                                         &unipred_cache,
+                                         ref->images[ref_LX[0][bipred_pu->inter.mv_ref[0]]],
+                                         ref->images[ref_LX[1][bipred_pu->inter.mv_ref[1]]],
+                                         mv, lcu,
+                                         cu_loc);
 
       const uvg_pixel *rec = &lcu->rec.y[SUB_SCU(cu_loc->y) * LCU_WIDTH + SUB_SCU(cu_loc->x)];
       const uvg_pixel *src = &lcu->ref.y[SUB_SCU(cu_loc->y) * LCU_WIDTH + SUB_SCU(cu_loc->x)];
@@ -2078,7 +2275,7 @@ static void search_pu_inter(
     }
 
     // TODO: this probably should have a separate command line option
-    if (cfg->rdo >= 3) search_pu_inter_bipred(info, lcu, &amvp[2]);
+    if (cfg->rdo >= 3) search_pu_inter_bipred(info, lcu, &unipred_cache, &amvp[2]);
     
     assert(amvp[2].size <= MAX_UNIT_STATS_MAP_SIZE);
     uvg_sort_keys_by_cost(&amvp[2]);
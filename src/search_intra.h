@@ -59,6 +59,12 @@ int8_t uvg_search_cu_intra_chroma(
   enum uvg_tree_type tree_type,
   bool is_separate);
 
+void uvg_intra_gradient_histogram(
+  const uvg_pixel *lcu_ref_y,
+  int width,
+  int height,
+  intra_grad_hist_t *hist);
+
 void uvg_search_cu_intra(
   encoder_state_t * const state,
   intra_search_data_t* search_data,
@@ -298,6 +298,274 @@ static void alf_get_blk_stats_avx2(encoder_state_t* const state,
   }
 }
 
+/**
+ * \brief Load 16 luma samples at the chroma sample positions.
+ *
+ * With horizontal subsampling every second luma sample is taken, starting
+ * from the first one.
+ */
+static INLINE __m256i cc_alf_load_luma_avx2(const uvg_pixel *src, const int scale_x)
+{
+  if (scale_x) {
+    return _mm256_and_si256(_mm256_loadu_si256((const __m256i*)src), _mm256_set1_epi16(0xff));
+  }
+  return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)src));
+}
+
+/**
+ * \brief Differences of the CC-ALF taps to the center luma sample for 16
+ * chroma samples.
+ */
+static INLINE void cc_alf_diffs_avx2(__m256i diff[MAX_NUM_CC_ALF_CHROMA_COEFF - 1],
+  const uvg_pixel *rec_y_m1,
+  const uvg_pixel *rec_y_0,
+  const uvg_pixel *rec_y_p1,
+  const uvg_pixel *rec_y_p2,
+  const int scale_x)
+{
+  const __m256i center = cc_alf_load_luma_avx2(rec_y_0, scale_x);
+  diff[0] = _mm256_sub_epi16(cc_alf_load_luma_avx2(rec_y_m1, scale_x), center);
+  diff[1] = _mm256_sub_epi16(cc_alf_load_luma_avx2(rec_y_0 - 1, scale_x), center);
+  diff[2] = _mm256_sub_epi16(cc_alf_load_luma_avx2(rec_y_0 + 1, scale_x), center);
+  diff[3] = _mm256_sub_epi16(cc_alf_load_luma_avx2(rec_y_p1 - 1, scale_x), center);
+  diff[4] = _mm256_sub_epi16(cc_alf_load_luma_avx2(rec_y_p1, scale_x), center);
+  diff[5] = _mm256_sub_epi16(cc_alf_load_luma_avx2(rec_y_p1 + 1, scale_x), center);
+  diff[6] = _mm256_sub_epi16(cc_alf_load_luma_avx2(rec_y_p2, scale_x), center);
+}
+
+static void alf_filter_cc_blk_avx2(uvg_pixel *chroma,
+  const int chroma_stride,
+  const uvg_pixel *luma,
+  const int luma_stride,
+  const int16_t *filter_coeff,
+  clp_rng clp_rng,
+  const int scale_x,
+  const int scale_y,
+  const int y_pos,
+  const int width,
+  const int height,
+  const int vb_ctu_height,
+  const int vb_pos)
+{
+  // Pairs of coefficients for the multiply-adds of interleaved differences.
+  const __m256i coeff01 = _mm256_set1_epi32((uint16_t)filter_coeff[0] | ((uint32_t)(uint16_t)filter_coeff[1] << 16));
+  const __m256i coeff23 = _mm256_set1_epi32((uint16_t)filter_coeff[2] | ((uint32_t)(uint16_t)filter_coeff[3] << 16));
+  const __m256i coeff45 = _mm256_set1_epi32((uint16_t)filter_coeff[4] | ((uint32_t)(uint16_t)filter_coeff[5] << 16));
+  const __m256i coeff6 = _mm256_set1_epi32((uint16_t)filter_coeff[6]);
+  const __m256i round = _mm256_set1_epi32(1 << 6);
+  const __m256i min_val = _mm256_set1_epi16(-128);
+  const __m256i max_val = _mm256_set1_epi16(127);
+  const __m256i zero = _mm256_setzero_si256();
+
+  for (int i = 0; i < height; i++)
+  {
+    uvg_pixel *src_self = chroma + i * chroma_stride;
+    const uvg_pixel *rec_y_0 = luma + (i << scale_y) * luma_stride;
+    const uvg_pixel *rec_y_m1 = rec_y_0 - luma_stride;
+    const uvg_pixel *rec_y_p1 = rec_y_0 + luma_stride;
+    const uvg_pixel *rec_y_p2 = rec_y_0 + 2 * luma_stride;
+
+    const int pos = ((y_pos + i) << scale_y) & (vb_ctu_height - 1);
+    if (scale_y == 0 && (pos == vb_pos || pos == vb_pos + 1))
+    {
+      continue;
+    }
+    if (pos == (vb_pos - 2) || pos == (vb_pos + 1))
+    {
+      rec_y_p2 = rec_y_p1;
+    }
+    else if (pos == (vb_pos - 1) || pos == vb_pos)
+    {
+      rec_y_m1 = rec_y_p1 = rec_y_p2 = rec_y_0;
+    }
+
+    int j = 0;
+    for (; j + 16 <= width; j += 16)
+    {
+      const int j2 = j << scale_x;
+      __m256i diff[MAX_NUM_CC_ALF_CHROMA_COEFF - 1];
+      cc_alf_diffs_avx2(diff, rec_y_m1 + j2, rec_y_0 + j2, rec_y_p1 + j2, rec_y_p2 + j2, scale_x);
+
+      __m256i sum_lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(diff[0], diff[1]), coeff01);
+      __m256i sum_hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(diff[0], diff[1]), coeff01);
+      sum_lo = _mm256_add_epi32(sum_lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(diff[2], diff[3]), coeff23));
+      sum_hi = _mm256_add_epi32(sum_hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(diff[2], diff[3]), coeff23));
+      sum_lo = _mm256_add_epi32(sum_lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(diff[4], diff[5]), coeff45));
+      sum_hi = _mm256_add_epi32(sum_hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(diff[4], diff[5]), coeff45));
+      sum_lo = _mm256_add_epi32(sum_lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(diff[6], zero), coeff6));
+      sum_hi = _mm256_add_epi32(sum_hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(diff[6], zero), coeff6));
+
+      sum_lo = _mm256_srai_epi32(_mm256_add_epi32(sum_lo, round), 7);
+      sum_hi = _mm256_srai_epi32(_mm256_add_epi32(sum_hi, round), 7);
+
+      // The unpacks and the pack work within the 128-bit lanes, so the
+      // samples are back in order.
+      __m256i sum = _mm256_packs_epi32(sum_lo, sum_hi);
+      sum = _mm256_min_epi16(_mm256_max_epi16(sum, min_val), max_val);
+      sum = _mm256_add_epi16(sum, _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)&src_self[j])));
+
+      const __m128i result = _mm_packus_epi16(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+      _mm_storeu_si128((__m128i*)&src_self[j], result);
+    }
+
+    for (; j < width; j++)
+    {
+      const int j2 = j << scale_x;
+      const int curr = rec_y_0[j2];
+      int sum = filter_coeff[0] * (rec_y_m1[j2] - curr);
+      sum += filter_coeff[1] * (rec_y_0[j2 - 1] - curr);
+      sum += filter_coeff[2] * (rec_y_0[j2 + 1] - curr);
+      sum += filter_coeff[3] * (rec_y_p1[j2 - 1] - curr);
+      sum += filter_coeff[4] * (rec_y_p1[j2] - curr);
+      sum += filter_coeff[5] * (rec_y_p1[j2 + 1] - curr);
+      sum += filter_coeff[6] * (rec_y_p2[j2] - curr);
+      sum = CLIP(-128, 127, (sum + (1 << 6)) >> 7);
+      src_self[j] = CLIP(0, 255, src_self[j] + sum);
+    }
+  }
+}
+
+static int64_t hsum_epi32_to_epi64_avx2(const __m256i v)
+{
+  const __m256i sum = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)),
+                                       _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+  ALIGNED(32) int64_t lanes[4];
+  _mm256_store_si256((__m256i*)lanes, sum);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+static void alf_get_blk_stats_cc_avx2(alf_covariance *alf_covariance,
+  const uvg_pixel *org,
+  const int org_stride,
+  const uvg_pixel *rec,
+  const int rec_stride,
+  const uvg_pixel *rec_luma,
+  const int rec_luma_stride,
+  const int scale_x,
+  const int scale_y,
+  const int width,
+  const int height,
+  const int vb_ctu_height,
+  const int vb_pos)
+{
+  enum { NUM_COEFF = MAX_NUM_CC_ALF_CHROMA_COEFF - 1 };
+
+  // The products of the differences of 8-bit samples fit in 17 bits, so the
+  // 32-bit lanes do not overflow within a block of up to LCU_WIDTH x LCU_WIDTH
+  // samples.
+  __m256i ee_acc[NUM_COEFF][NUM_COEFF];
+  __m256i y_acc[NUM_COEFF];
+  __m256i pix_acc = _mm256_setzero_si256();
+  for (int k = 0; k < NUM_COEFF; k++)
+  {
+    for (int l = k; l < NUM_COEFF; l++)
+    {
+      ee_acc[k][l] = _mm256_setzero_si256();
+    }
+    y_acc[k] = _mm256_setzero_si256();
+  }
+
+  int64_t ee_tail[NUM_COEFF][NUM_COEFF] = { { 0 } };
+  int32_t y_tail[NUM_COEFF] = { 0 };
+  int64_t pix_tail = 0;
+
+  for (int i = 0; i < height; i++)
+  {
+    const int vb_distance = ((i << scale_y) % vb_ctu_height) - vb_pos;
+    if (scale_y == 0 && (vb_distance == 0 || vb_distance == 1))
+    {
+      org += org_stride;
+      rec += rec_stride;
+      rec_luma += rec_luma_stride << scale_y;
+      continue;
+    }
+
+    const uvg_pixel *rec_y_m1 = rec_luma - rec_luma_stride;
+    const uvg_pixel *rec_y_0 = rec_luma;
+    const uvg_pixel *rec_y_p1 = rec_luma + rec_luma_stride;
+    const uvg_pixel *rec_y_p2 = rec_luma + 2 * rec_luma_stride;
+    if (vb_distance == -2 || vb_distance == +1)
+    {
+      rec_y_p2 = rec_y_p1;
+    }
+    else if (vb_distance == -1 || vb_distance == 0)
+    {
+      rec_y_m1 = rec_y_p1 = rec_y_p2 = rec_y_0;
+    }
+
+    int j = 0;
+    for (; j + 16 <= width; j += 16)
+    {
+      const int j2 = j << scale_x;
+      __m256i diff[NUM_COEFF];
+      cc_alf_diffs_avx2(diff, rec_y_m1 + j2, rec_y_0 + j2, rec_y_p1 + j2, rec_y_p2 + j2, scale_x);
+
+      const __m256i y_local = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)&org[j])),
+                                               _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)&rec[j])));
+
+      for (int k = 0; k < NUM_COEFF; k++)
+      {
+        for (int l = k; l < NUM_COEFF; l++)
+        {
+          ee_acc[k][l] = _mm256_add_epi32(ee_acc[k][l], _mm256_madd_epi16(diff[k], diff[l]));
+        }
+        y_acc[k] = _mm256_add_epi32(y_acc[k], _mm256_madd_epi16(diff[k], y_local));
+      }
+      pix_acc = _mm256_add_epi32(pix_acc, _mm256_madd_epi16(y_local, y_local));
+    }
+
+    for (; j < width; j++)
+    {
+      const int j2 = j << scale_x;
+      const int curr = rec_y_0[j2];
+      const int e_local[NUM_COEFF] = {
+        rec_y_m1[j2] - curr,
+        rec_y_0[j2 - 1] - curr,
+        rec_y_0[j2 + 1] - curr,
+        rec_y_p1[j2 - 1] - curr,
+        rec_y_p1[j2] - curr,
+        rec_y_p1[j2 + 1] - curr,
+        rec_y_p2[j2] - curr,
+      };
+      const int y_local = org[j] - rec[j];
+
+      for (int k = 0; k < NUM_COEFF; k++)
+      {
+        for (int l = k; l < NUM_COEFF; l++)
+        {
+          ee_tail[k][l] += e_local[k] * e_local[l];
+        }
+        y_tail[k] += e_local[k] * y_local;
+      }
+      pix_tail += y_local * y_local;
+    }
+
+    org += org_stride;
+    rec += rec_stride;
+    rec_luma += rec_luma_stride << scale_y;
+  }
+
+  for (int k = 0; k < NUM_COEFF; k++)
+  {
+    for (int l = k; l < NUM_COEFF; l++)
+    {
+      alf_covariance->ee[k][l][0][0] += hsum_epi32_to_epi64_avx2(ee_acc[k][l]) + ee_tail[k][l];
+    }
+    alf_covariance->y[k][0] += (int32_t)hsum_epi32_to_epi64_avx2(y_acc[k]) + y_tail[k];
+  }
+  // The sums are integers, so adding them at once gives the same result as
+  // adding each sample.
+  alf_covariance->pix_acc += (double)(hsum_epi32_to_epi64_avx2(pix_acc) + pix_tail);
+
+  for (int k = 1; k < NUM_COEFF; k++)
+  {
+    for (int l = 0; l < k; l++)
+    {
+      alf_covariance->ee[k][l][0][0] = alf_covariance->ee[l][k][0][0];
+    }
+  }
+}
+
 #endif // UVG_BIT_DEPTH == 8
 #endif //COMPILE_INTEL_AVX2
 
@@ -308,6 +576,8 @@ int uvg_strategy_register_alf_avx2(void* opaque, uint8_t bitdepth) {
 #if UVG_BIT_DEPTH == 8
   if (bitdepth == 8){
     success &= uvg_strategyselector_register(opaque, "alf_get_blk_stats", "avx2", 40, &alf_get_blk_stats_avx2);
+    success &= uvg_strategyselector_register(opaque, "alf_filter_cc_blk", "avx2", 40, &alf_filter_cc_blk_avx2);
+    success &= uvg_strategyselector_register(opaque, "alf_get_blk_stats_cc", "avx2", 40, &alf_get_blk_stats_cc_avx2);
   }
 #endif // UVG_BIT_DEPTH == 8
 #endif
@@ -0,0 +1,333 @@
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+#include "global.h"
+
+#include "strategies/avx2/filter-avx2.h"
+
+#if COMPILE_INTEL_AVX2
+#include "uvg266.h"
+#if UVG_BIT_DEPTH == 8
+
+#include <immintrin.h>
+
+#include "strategies/generic/filter-generic.h"
+#include "strategyselector.h"
+
+
+/**
+ * \brief Broadcast the value of the first line of each 4-line segment.
+ */
+static INLINE __m256i broadcast_line0(__m256i v)
+{
+  return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, 0x00), 0x00);
+}
+
+/**
+ * \brief Broadcast the value of the last line of each 4-line segment.
+ */
+static INLINE __m256i broadcast_line3(__m256i v)
+{
+  return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, 0xFF), 0xFF);
+}
+
+static INLINE __m256i clip_epi16(__m256i v, __m256i low, __m256i high)
+{
+  return _mm256_max_epi16(low, _mm256_min_epi16(high, v));
+}
+
+static INLINE __m128i pack_line(__m256i v)
+{
+  return _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+/**
+ * \brief Load samples p3..q3 of 16 lines crossing a vertical edge and
+ *        transpose them to one vector per sample position.
+ */
+static INLINE void load_ver_edge(const uvg_pixel *src, int32_t stride, __m128i cols[8])
+{
+  __m128i a[8];
+  for (int i = 0; i < 8; ++i) {
+    const __m128i l0 = _mm_loadl_epi64((const __m128i *)&src[(2 * i + 0) * stride - 4]);
+    const __m128i l1 = _mm_loadl_epi64((const __m128i *)&src[(2 * i + 1) * stride - 4]);
+    a[i] = _mm_unpacklo_epi8(l0, l1);
+  }
+  for (int half = 0; half < 2; ++half) {
+    const __m128i *h = &a[4 * half];
+    const __m128i b0_lo = _mm_unpacklo_epi16(h[0], h[1]);
+    const __m128i b0_hi = _mm_unpackhi_epi16(h[0], h[1]);
+    const __m128i b1_lo = _mm_unpacklo_epi16(h[2], h[3]);
+    const __m128i b1_hi = _mm_unpackhi_epi16(h[2], h[3]);
+
+    // Samples of 8 lines for two sample positions in each vector.
+    __m128i *c = &cols[4 * half];
+    c[0] = _mm_unpacklo_epi32(b0_lo, b1_lo);
+    c[1] = _mm_unpackhi_epi32(b0_lo, b1_lo);
+    c[2] = _mm_unpacklo_epi32(b0_hi, b1_hi);
+    c[3] = _mm_unpackhi_epi32(b0_hi, b1_hi);
+  }
+  __m128i c[8];
+  for (int i = 0; i < 8; ++i) c[i] = cols[i];
+  for (int i = 0; i < 4; ++i) {
+    cols[2 * i + 0] = _mm_unpacklo_epi64(c[i], c[4 + i]);
+    cols[2 * i + 1] = _mm_unpackhi_epi64(c[i], c[4 + i]);
+  }
+}
+
+/**
+ * \brief Transpose the sample positions p3..q3 back to 16 lines and store
+ *        them across a vertical edge.
+ */
+static INLINE void store_ver_edge(uvg_pixel *src, int32_t stride, const __m128i cols[8])
+{
+  for (int half = 0; half < 2; ++half) {
+    __m128i e[4];
+    for (int i = 0; i < 4; ++i) {
+      e[i] = half == 0 ? _mm_unpacklo_epi8(cols[2 * i], cols[2 * i + 1])
+                       : _mm_unpackhi_epi8(cols[2 * i], cols[2 * i + 1]);
+    }
+    const __m128i f0_lo = _mm_unpacklo_epi16(e[0], e[1]);
+    const __m128i f0_hi = _mm_unpackhi_epi16(e[0], e[1]);
+    const __m128i f1_lo = _mm_unpacklo_epi16(e[2], e[3]);
+    const __m128i f1_hi = _mm_unpackhi_epi16(e[2], e[3]);
+
+    // Two full lines in each vector.
+    const __m128i g[4] = {
+      _mm_unpacklo_epi32(f0_lo, f1_lo),
+      _mm_unpackhi_epi32(f0_lo, f1_lo),
+      _mm_unpacklo_epi32(f0_hi, f1_hi),
+      _mm_unpackhi_epi32(f0_hi, f1_hi),
+    };
+    uvg_pixel *dst = &src[8 * half * stride - 4];
+    for (int i = 0; i < 4; ++i) {
+      _mm_storel_epi64((__m128i *)&dst[(2 * i + 0) * stride], g[i]);
+      _mm_storel_epi64((__m128i *)&dst[(2 * i + 1) * stride], _mm_unpackhi_epi64(g[i], g[i]));
+    }
+  }
+}
+
+/**
+ * \brief Decide and filter four 4-sample segments of a luma edge.
+ *
+ * The 16 lines of the segments are processed in the 16-bit lanes of the
+ * vectors. Segments using the long filters are left for the caller.
+ *
+ * \return  false, if no samples were modified
+ */
+static bool deblock_luma_4_segments_avx2(uvg_pixel *src,
+                                         int32_t x_stride,
+                                         int32_t y_stride,
+                                         const deblock_segment_t *segments)
+{
+  int16_t tc_lanes[16];
+  int16_t beta_lanes[16];
+  int16_t active_lanes[16];
+  int16_t strong_allowed_lanes[16];
+  int16_t side_allowed_lanes[16];
+  bool any_active = false;
+
+  for (int s = 0; s < 4; ++s) {
+    const deblock_segment_t *seg = &segments[s];
+    const bool active = seg->tc > 0 && !seg->is_side_P_large && !seg->is_side_Q_large;
+    any_active |= active;
+    for (int i = 4 * s; i < 4 * s + 4; ++i) {
+      tc_lanes[i] = seg->tc;
+      beta_lanes[i] = seg->beta;
+      active_lanes[i] = active ? -1 : 0;
+      strong_allowed_lanes[i] = seg->max_filter_length_P > 2 && seg->max_filter_length_Q > 2 ? -1 : 0;
+      side_allowed_lanes[i] = seg->max_filter_length_P > 1 && seg->max_filter_length_Q > 1 ? -1 : 0;
+    }
+  }
+  if (!any_active) return false;
+
+  const __m256i tc = _mm256_loadu_si256((const __m256i *)tc_lanes);
+  const __m256i beta = _mm256_loadu_si256((const __m256i *)beta_lanes);
+  const __m256i active = _mm256_loadu_si256((const __m256i *)active_lanes);
+
+  // Samples p3, p2, p1, p0, q0, q1, q2 and q3 of the 16 lines.
+  __m128i cols[8];
+  if (x_stride == 1) {
+    load_ver_edge(src, y_stride, cols);
+  } else {
+    for (int i = 0; i < 8; ++i) {
+      cols[i] = _mm_loadu_si128((const __m128i *)&src[(i - 4) * x_stride]);
+    }
+  }
+  const __m256i p3 = _mm256_cvtepu8_epi16(cols[0]);
+  const __m256i p2 = _mm256_cvtepu8_epi16(cols[1]);
+  const __m256i p1 = _mm256_cvtepu8_epi16(cols[2]);
+  const __m256i p0 = _mm256_cvtepu8_epi16(cols[3]);
+  const __m256i q0 = _mm256_cvtepu8_epi16(cols[4]);
+  const __m256i q1 = _mm256_cvtepu8_epi16(cols[5]);
+  const __m256i q2 = _mm256_cvtepu8_epi16(cols[6]);
+  const __m256i q3 = _mm256_cvtepu8_epi16(cols[7]);
+
+  // Filter on/off decision from the first and the last line of the segments.
+  const __m256i dp_line = _mm256_abs_epi16(_mm256_sub_epi16(_mm256_add_epi16(p2, p0), _mm256_slli_epi16(p1, 1)));
+  const __m256i dq_line = _mm256_abs_epi16(_mm256_sub_epi16(_mm256_add_epi16(q2, q0), _mm256_slli_epi16(q1, 1)));
+  const __m256i dp = _mm256_add_epi16(broadcast_line0(dp_line), broadcast_line3(dp_line));
+  const __m256i dq = _mm256_add_epi16(broadcast_line0(dq_line), broadcast_line3(dq_line));
+  const __m256i filter_on = _mm256_and_si256(active, _mm256_cmpgt_epi16(beta, _mm256_add_epi16(dp, dq)));
+
+  if (_mm256_testz_si256(filter_on, filter_on)) return false;
+
+  // Strong filtering decision.
+  const __m256i tc5 = _mm256_srai_epi16(_mm256_add_epi16(_mm256_mullo_epi16(tc, _mm256_set1_epi16(5)), _mm256_set1_epi16(1)), 1);
+  const __m256i strong_d = _mm256_cmpgt_epi16(_mm256_srai_epi16(beta, 2), _mm256_slli_epi16(_mm256_add_epi16(dp_line, dq_line), 1));
+  const __m256i strong_tc = _mm256_cmpgt_epi16(tc5, _mm256_abs_epi16(_mm256_sub_epi16(p0, q0)));
+  const __m256i strong_s = _mm256_cmpgt_epi16(_mm256_srai_epi16(beta, 3),
+                                              _mm256_add_epi16(_mm256_abs_epi16(_mm256_sub_epi16(p3, p0)),
+                                                               _mm256_abs_epi16(_mm256_sub_epi16(q0, q3))));
+  const __m256i strong_line = _mm256_and_si256(strong_d, _mm256_and_si256(strong_tc, strong_s));
+  __m256i strong = _mm256_and_si256(broadcast_line0(strong_line), broadcast_line3(strong_line));
+  strong = _mm256_and_si256(strong, _mm256_loadu_si256((const __m256i *)strong_allowed_lanes));
+  strong = _mm256_and_si256(strong, filter_on);
+
+  // Strong filtering.
+  const __m256i two = _mm256_set1_epi16(2);
+  const __m256i four = _mm256_set1_epi16(4);
+  const __m256i tc2 = _mm256_slli_epi16(tc, 1);
+  const __m256i tc3 = _mm256_add_epi16(tc2, tc);
+  const __m256i p0q0 = _mm256_add_epi16(p0, q0);
+  const __m256i p1p0q0 = _mm256_add_epi16(p1, p0q0);
+  const __m256i p0q0q1 = _mm256_add_epi16(p0q0, q1);
+
+  __m256i sum;
+  sum = _mm256_add_epi16(_mm256_add_epi16(_mm256_slli_epi16(p3, 1), _mm256_mullo_epi16(p2, _mm256_set1_epi16(3))), p1p0q0);
+  const __m256i p2_strong = clip_epi16(_mm256_srai_epi16(_mm256_add_epi16(sum, four), 3),
+                                       _mm256_sub_epi16(p2, tc), _mm256_add_epi16(p2, tc));
+  sum = _mm256_add_epi16(p2, p1p0q0);
+  const __m256i p1_strong = clip_epi16(_mm256_srai_epi16(_mm256_add_epi16(sum, two), 2),
+                                       _mm256_sub_epi16(p1, tc2), _mm256_add_epi16(p1, tc2));
+  sum = _mm256_add_epi16(_mm256_add_epi16(p2, q1), _mm256_slli_epi16(_mm256_add_epi16(p1, p0q0), 1));
+  const __m256i p0_strong = clip_epi16(_mm256_srai_epi16(_mm256_add_epi16(sum, four), 3),
+                                       _mm256_sub_epi16(p0, tc3), _mm256_add_epi16(p0, tc3));
+  sum = _mm256_add_epi16(_mm256_add_epi16(p1, q2), _mm256_slli_epi16(_mm256_add_epi16(p0q0, q1), 1));
+  const __m256i q0_strong = clip_epi16(_mm256_srai_epi16(_mm256_add_epi16(sum, four), 3),
+                                       _mm256_sub_epi16(q0, tc3), _mm256_add_epi16(q0, tc3));
+  sum = _mm256_add_epi16(p0q0q1, q2);
+  const __m256i q1_strong = clip_epi16(_mm256_srai_epi16(_mm256_add_epi16(sum, two), 2),
+                                       _mm256_sub_epi16(q1, tc2), _mm256_add_epi16(q1, tc2));
+  sum = _mm256_add_epi16(_mm256_add_epi16(p0q0q1, _mm256_mullo_epi16(q2, _mm256_set1_epi16(3))), _mm256_slli_epi16(q3, 1));
+  const __m256i q2_strong = clip_epi16(_mm256_srai_epi16(_mm256_add_epi16(sum, four), 3),
+                                       _mm256_sub_epi16(q2, tc), _mm256_add_epi16(q2, tc));
+
+  // Weak filtering. The results are clipped to the sample range when packing.
+  const __m256i neg_tc = _mm256_sub_epi16(_mm256_setzero_si256(), tc);
+  __m256i delta = _mm256_sub_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(q0, p0), _mm256_set1_epi16(9)),
+                                   _mm256_mullo_epi16(_mm256_sub_epi16(q1, p1), _mm256_set1_epi16(3)));
+  delta = _mm256_srai_epi16(_mm256_add_epi16(delta, _mm256_set1_epi16(8)), 4);
+  const __m256i weak_line = _mm256_cmpgt_epi16(_mm256_mullo_epi16(tc, _mm256_set1_epi16(10)), _mm256_abs_epi16(delta));
+  const __m256i weak = _mm256_andnot_si256(strong, _mm256_and_si256(filter_on, weak_line));
+  delta = clip_epi16(delta, neg_tc, tc);
+
+  const __m256i p0_weak = _mm256_add_epi16(p0, delta);
+  const __m256i q0_weak = _mm256_sub_epi16(q0, delta);
+
+  const __m256i half_tc = _mm256_srai_epi16(tc, 1);
+  const __m256i neg_half_tc = _mm256_sub_epi16(_mm256_setzero_si256(), half_tc);
+  const __m256i side_threshold = _mm256_srai_epi16(_mm256_add_epi16(beta, _mm256_srai_epi16(beta, 1)), 3);
+  const __m256i side_allowed = _mm256_and_si256(weak, _mm256_loadu_si256((const __m256i *)side_allowed_lanes));
+  const __m256i p_2nd = _mm256_and_si256(side_allowed, _mm256_cmpgt_epi16(side_threshold, dp));
+  const __m256i q_2nd = _mm256_and_si256(side_allowed, _mm256_cmpgt_epi16(side_threshold, dq));
+
+  const __m256i one = _mm256_set1_epi16(1);
+  __m256i delta1 = _mm256_srai_epi16(_mm256_add_epi16(p2, _mm256_add_epi16(p0, one)), 1);
+  delta1 = _mm256_srai_epi16(_mm256_add_epi16(_mm256_sub_epi16(delta1, p1), delta), 1);
+  const __m256i p1_weak = _mm256_add_epi16(p1, clip_epi16(delta1, neg_half_tc, half_tc));
+  __m256i delta2 = _mm256_srai_epi16(_mm256_add_epi16(q2, _mm256_add_epi16(q0, one)), 1);
+  delta2 = _mm256_srai_epi16(_mm256_sub_epi16(_mm256_sub_epi16(delta2, q1), delta), 1);
+  const __m256i q1_weak = _mm256_add_epi16(q1, clip_epi16(delta2, neg_half_tc, half_tc));
+
+  cols[1] = pack_line(_mm256_blendv_epi8(p2, p2_strong, strong));
+  cols[2] = pack_line(_mm256_blendv_epi8(_mm256_blendv_epi8(p1, p1_weak, p_2nd), p1_strong, strong));
+  cols[3] = pack_line(_mm256_blendv_epi8(_mm256_blendv_epi8(p0, p0_weak, weak), p0_strong, strong));
+  cols[4] = pack_line(_mm256_blendv_epi8(_mm256_blendv_epi8(q0, q0_weak, weak), q0_strong, strong));
+  cols[5] = pack_line(_mm256_blendv_epi8(_mm256_blendv_epi8(q1, q1_weak, q_2nd), q1_strong, strong));
+  cols[6] = pack_line(_mm256_blendv_epi8(q2, q2_strong, strong));
+
+  if (x_stride == 1) {
+    store_ver_edge(src, y_stride, cols);
+  } else {
+    for (int i = 1; i < 7; ++i) {
+      _mm_storeu_si128((__m128i *)&src[(i - 4) * x_stride], cols[i]);
+    }
+  }
+  return true;
+}
+
+/**
+ * \brief Decide and filter the 4-sample segments of a luma edge four at a
+ *        time.
+ *
+ * Segments using the long filters and the segments left over from the
+ * groups of four are filtered with the generic implementation.
+ */
+static void deblock_luma_edge_avx2(uvg_pixel *src,
+                                   int32_t x_stride,
+                                   int32_t y_stride,
+                                   const deblock_segment_t *segments,
+                                   int num_segments)
+{
+  int i = 0;
+  for (; i + 4 <= num_segments; i += 4) {
+    uvg_pixel *group_src = &src[i * 4 * y_stride];
+    deblock_luma_4_segments_avx2(group_src, x_stride, y_stride, &segments[i]);
+
+    for (int s = i; s < i + 4; ++s) {
+      if (segments[s].is_side_P_large || segments[s].is_side_Q_large) {
+        uvg_deblock_luma_segment_generic(&src[s * 4 * y_stride], x_stride, y_stride, &segments[s]);
+      }
+    }
+  }
+  for (; i < num_segments; ++i) {
+    uvg_deblock_luma_segment_generic(&src[i * 4 * y_stride], x_stride, y_stride, &segments[i]);
+  }
+}
+
+#endif // UVG_BIT_DEPTH == 8
+#endif // COMPILE_INTEL_AVX2
+
+
+int uvg_strategy_register_filter_avx2(void* opaque, uint8_t bitdepth)
+{
+  bool success = true;
+#if COMPILE_INTEL_AVX2
+#if UVG_BIT_DEPTH == 8
+  if (bitdepth == 8) {
+    success &= uvg_strategyselector_register(opaque, "deblock_luma_edge", "avx2", 40, &deblock_luma_edge_avx2);
+  }
+#endif // UVG_BIT_DEPTH == 8
+#endif // COMPILE_INTEL_AVX2
+  return success;
+}
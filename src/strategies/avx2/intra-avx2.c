@@ -39,29 +39,139 @@
 #include <immintrin.h>
 #include <stdlib.h>
 
+#include "mip_data.h"
 #include "strategyselector.h"
+#include "strategies/generic/intra-generic.h"
 #include "strategies/missing-intel-intrinsics.h"
+#include "uvg_math.h"
 
- /**
- * \brief Generate angular predictions.
- * \param cu_loc        CU locationand size data.
- * \param intra_mode    Angular mode in range 2..34.
+static const int16_t modedisp2sampledisp[32] = { 0,    1,    2,    3,    4,    6,     8,   10,   12,   14,   16,   18,   20,   23,   26,   29,   32,   35,   39,  45,  51,  57,  64,  73,  86, 102, 128, 171, 256, 341, 512, 1024 };
+static const int16_t modedisp2invsampledisp[32] = { 0, 16384, 8192, 5461, 4096, 2731, 2048, 1638, 1365, 1170, 1024, 910, 819, 712, 630, 565, 512, 468, 420, 364, 321, 287, 256, 224, 191, 161, 128, 96, 64, 48, 32, 16 }; // (512 * 32) / sampledisp
+
+/**
+ * \brief Build the main and side references for an angular mode.
+ * \param width         Block width.
+ * \param mode_disp     Modes distance to horizontal or vertical mode.
+ * \param vertical_mode Whether the above reference is the main reference.
+ * \param in_ref_above  Pointer to -1 index of above reference.
+ * \param in_ref_left   Pointer to -1 index of left reference.
+ * \param multi_ref_index Reference line index for use with MRL.
+ * \param temp_main     Zero initialized buffer for the main reference.
+ * \param temp_side     Zero initialized buffer for the side reference.
+ * \param out_ref_main  Returns index 0 of the main reference in block coordinates.
+ * \param out_ref_side  Returns index 0 of the side reference in block coordinates.
+ */
+static void angular_pred_build_refs_avx2(
+  const int width,
+  const int_fast8_t mode_disp,
+  const bool vertical_mode,
+  const uvg_pixel *const in_ref_above,
+  const uvg_pixel *const in_ref_left,
+  const uint8_t multi_ref_index,
+  uvg_pixel *const temp_main,
+  uvg_pixel *const temp_side,
+  uvg_pixel **const out_ref_main,
+  const uvg_pixel **const out_ref_side)
+{
+  // Pointer for the reference we are interpolating from.
+  uvg_pixel *ref_main;
+  // Pointer for the other reference.
+  const uvg_pixel *ref_side;
+
+  // Set ref_main and ref_side such that, when indexed with 0, they point to
+  // index 0 in block coordinates.
+  if (mode_disp < 0) {
+    memcpy(&temp_main[width], vertical_mode ? in_ref_above : in_ref_left, sizeof(uvg_pixel) * (width + 1 + multi_ref_index + 1));
+    memcpy(&temp_side[width], vertical_mode ? in_ref_left : in_ref_above, sizeof(uvg_pixel) * (width + 1 + multi_ref_index + 1));
+
+    ref_main = temp_main + width;
+    ref_side = temp_side + width;
+
+    for (int i = -width; i <= -1; i++) {
+      ref_main[i] = ref_side[MIN((-i * modedisp2invsampledisp[abs(mode_disp)] + 256) >> 9, width)];
+    }
+
+    
+
+    //const uint32_t index_offset = width + 1;
+    //const int32_t last_index = width;
+    //const int_fast32_t most_negative_index = (width * sample_disp) >> 5;
+    //// Negative sample_disp means, we need to use both references.
+
+    //// TODO: update refs to take into account variating block size and shapes
+    ////       (height is not always equal to width)
+    //ref_side = (vertical_mode ? in_ref_left : in_ref_above) + 1;
+    //ref_main = (vertical_mode ? in_ref_above : in_ref_left) + 1;
+
+    //// Move the reference pixels to start from the middle to the later half of
+    //// the tmp_ref, so there is room for negative indices.
+    //for (int_fast32_t x = -1; x < width; ++x) {
+    //  tmp_ref[x + index_offset] = ref_main[x];
+    //}
+    //// Get a pointer to block index 0 in tmp_ref.
+    //ref_main = &tmp_ref[index_offset];
+    //tmp_ref[index_offset -1] = tmp_ref[index_offset];
+
+    //// Extend the side reference to the negative indices of main reference.
+    //int_fast32_t col_sample_disp = 128; // rounding for the ">> 8"
+    //int_fast16_t inv_abs_sample_disp = modedisp2invsampledisp[abs(mode_disp)];
+    //// TODO: add 'vertical_mode ? height : width' instead of 'width'
+    //
+    //for (int_fast32_t x = -1; x > most_negative_index; x--) {
+    //  col_sample_disp += inv_abs_sample_disp;
+    //  int_fast32_t side_index = col_sample_disp >> 8;
+    //  tmp_ref[x + index_offset - 1] = ref_side[side_index - 1];
+    //}
+    //tmp_ref[last_index + index_offset] = tmp_ref[last_index + index_offset - 1];
+    //tmp_ref[most_negative_index + index_offset - 1] = tmp_ref[most_negative_index + index_offset];
+  }
+  else {
+
+    memcpy(temp_main, vertical_mode ? in_ref_above : in_ref_left, sizeof(uvg_pixel)* (width * 2 + multi_ref_index + 1));
+    memcpy(temp_side, vertical_mode ? in_ref_left : in_ref_above, sizeof(uvg_pixel)* (width * 2 + multi_ref_index + 1));
+
+    const int s = 0;
+    const int max_index = (multi_ref_index << s) + 2;
+    const int ref_length = width << 1;
+    const uvg_pixel val = temp_main[ref_length + multi_ref_index];
+    memset(temp_main + ref_length + multi_ref_index, val, max_index + 1);
+
+    ref_main = temp_main;
+    ref_side = temp_side;
+    //// sample_disp >= 0 means we don't need to refer to negative indices,
+    //// which means we can just use the references as is.
+    //ref_main = (vertical_mode ? in_ref_above : in_ref_left) + 1;
+    //ref_side = (vertical_mode ? in_ref_left : in_ref_above) + 1;
+
+    //memcpy(tmp_ref + width, ref_main, (width*2) * sizeof(uvg_pixel));
+    //ref_main = &tmp_ref[width];
+    //tmp_ref[width-1] = tmp_ref[width];
+    //int8_t last_index = 1 + width*2;
+    //tmp_ref[width + last_index] = tmp_ref[width + last_index - 1];
+  }
+
+  *out_ref_main = ref_main;
+  *out_ref_side = ref_side;
+}
+
+/**
+ * \brief Generate angular prediction from prebuilt references.
+ * \param cu_loc        CU location and size data.
+ * \param intra_mode    Angular mode in range 2..66.
  * \param channel_type  Color channel.
- * \param in_ref_above  Pointer to -1 index of above reference, length=width*2+1.
- * \param in_ref_left   Pointer to -1 index of left reference, length=width*2+1.
+ * \param ref_main      Main reference from angular_pred_build_refs_avx2.
+ * \param ref_side      Side reference from angular_pred_build_refs_avx2.
  * \param dst           Buffer of size width*width.
- * \param multi_ref_idx Reference line index for use with MRL.
+ * \param multi_ref_index Reference line index for use with MRL.
  */
-static void uvg_angular_pred_avx2(
+static void angular_pred_kernel_avx2(
   const cu_loc_t* const cu_loc,
   const int_fast8_t intra_mode,
   const int_fast8_t channel_type,
-  const uvg_pixel *const in_ref_above,
-  const uvg_pixel *const in_ref_left,
+  uvg_pixel *ref_main,
+  const uvg_pixel *ref_side,
   uvg_pixel *const dst,
-  const uint8_t multi_ref_idx,
-  const uint8_t isp_mode,
-  const int cu_dim)
+  const uint8_t multi_ref_index)
 {
   // ISP_TODO: non-square block implementation, height is passed but not used
   const int width = channel_type == COLOR_Y ? cu_loc->width : cu_loc->chroma_width;
@@ -72,10 +182,6 @@ static void uvg_angular_pred_avx2(
   assert((log2_width >= 2 && log2_width <= 5) && (log2_height >= 2 && log2_height <= 5));
   assert(intra_mode >= 2 && intra_mode <= 66);
 
-  // TODO: implement handling of MRL
-  uint8_t multi_ref_index = channel_type == COLOR_Y ? multi_ref_idx : 0;
-  uint8_t isp = isp_mode;
-
   __m256i p_shuf_01 = _mm256_setr_epi8(
     0x00, 0x01, 0x01, 0x02, 0x02, 0x03, 0x03, 0x04,
     0x08, 0x09, 0x09, 0x0a, 0x0a, 0x0b, 0x0b, 0x0c,
@@ -104,8 +210,6 @@ static void uvg_angular_pred_avx2(
     0x0c, 0x0e, 0x0c, 0x0e, 0x0c, 0x0e, 0x0c, 0x0e
   );
 
-  static const int16_t modedisp2sampledisp[32] = { 0,    1,    2,    3,    4,    6,     8,   10,   12,   14,   16,   18,   20,   23,   26,   29,   32,   35,   39,  45,  51,  57,  64,  73,  86, 102, 128, 171, 256, 341, 512, 1024 };
-  static const int16_t modedisp2invsampledisp[32] = { 0, 16384, 8192, 5461, 4096, 2731, 2048, 1638, 1365, 1170, 1024, 910, 819, 712, 630, 565, 512, 468, 420, 364, 321, 287, 256, 224, 191, 161, 128, 96, 64, 48, 32, 16 }; // (512 * 32) / sampledisp
   static const int32_t pre_scale[] = { 8, 7, 6, 5, 5, 4, 4, 4, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 0, 0, 0, -1, -1, -2, -3 };
   
   static const int16_t cubic_filter[32][4] =
@@ -144,12 +248,6 @@ static void uvg_angular_pred_avx2(
     { 0,  2, 63, -1 },
   };
 
-                                                    // Temporary buffer for modes 11-25.
-                                                    // It only needs to be big enough to hold indices from -width to width-1.
-  //uvg_pixel tmp_ref[2 * 128 + 3 + 33 * MAX_REF_LINE:IDX] = { 0 };
-  uvg_pixel temp_main[2 * 128 + 3 + 33 * MAX_REF_LINE_IDX] = { 0 };
-  uvg_pixel temp_side[2 * 128 + 3 + 33 * MAX_REF_LINE_IDX] = { 0 };
-
   int32_t pred_mode = intra_mode; // ToDo: handle WAIP
 
   // Whether to swap references to always project on the left reference row.
@@ -164,83 +262,6 @@ static void uvg_angular_pred_avx2(
   // TODO: replace latter width with height
   int scale = MIN(2, log2_width - pre_scale[abs(mode_disp)]);
 
-  // Pointer for the reference we are interpolating from.
-  uvg_pixel *ref_main;
-  // Pointer for the other reference.
-  const uvg_pixel *ref_side;
-
-  // Set ref_main and ref_side such that, when indexed with 0, they point to
-  // index 0 in block coordinates.
-  if (sample_disp < 0) {
-    memcpy(&temp_main[width], vertical_mode ? in_ref_above : in_ref_left, sizeof(uvg_pixel) * (width + 1 + multi_ref_index + 1));
-    memcpy(&temp_side[width], vertical_mode ? in_ref_left : in_ref_above, sizeof(uvg_pixel) * (width + 1 + multi_ref_index + 1));
-
-    ref_main = temp_main + width;
-    ref_side = temp_side + width;
-
-    for (int i = -width; i <= -1; i++) {
-      ref_main[i] = ref_side[MIN((-i * modedisp2invsampledisp[abs(mode_disp)] + 256) >> 9, width)];
-    }
-
-    
-
-    //const uint32_t index_offset = width + 1;
-    //const int32_t last_index = width;
-    //const int_fast32_t most_negative_index = (width * sample_disp) >> 5;
-    //// Negative sample_disp means, we need to use both references.
-
-    //// TODO: update refs to take into account variating block size and shapes
-    ////       (height is not always equal to width)
-    //ref_side = (vertical_mode ? in_ref_left : in_ref_above) + 1;
-    //ref_main = (vertical_mode ? in_ref_above : in_ref_left) + 1;
-
-    //// Move the reference pixels to start from the middle to the later half of
-    //// the tmp_ref, so there is room for negative indices.
-    //for (int_fast32_t x = -1; x < width; ++x) {
-    //  tmp_ref[x + index_offset] = ref_main[x];
-    //}
-    //// Get a pointer to block index 0 in tmp_ref.
-    //ref_main = &tmp_ref[index_offset];
-    //tmp_ref[index_offset -1] = tmp_ref[index_offset];
-
-    //// Extend the side reference to the negative indices of main reference.
-    //int_fast32_t col_sample_disp = 128; // rounding for the ">> 8"
-    //int_fast16_t inv_abs_sample_disp = modedisp2invsampledisp[abs(mode_disp)];
-    //// TODO: add 'vertical_mode ? height : width' instead of 'width'
-    //
-    //for (int_fast32_t x = -1; x > most_negative_index; x--) {
-    //  col_sample_disp += inv_abs_sample_disp;
-    //  int_fast32_t side_index = col_sample_disp >> 8;
-    //  tmp_ref[x + index_offset - 1] = ref_side[side_index - 1];
-    //}
-    //tmp_ref[last_index + index_offset] = tmp_ref[last_index + index_offset - 1];
-    //tmp_ref[most_negative_index + index_offset - 1] = tmp_ref[most_negative_index + index_offset];
-  }
-  else {
-
-    memcpy(temp_main, vertical_mode ? in_ref_above : in_ref_left, sizeof(uvg_pixel)* (width * 2 + multi_ref_index + 1));
-    memcpy(temp_side, vertical_mode ? in_ref_left : in_ref_above, sizeof(uvg_pixel)* (width * 2 + multi_ref_index + 1));
-
-    const int s = 0;
-    const int max_index = (multi_ref_index << s) + 2;
-    const int ref_length = width << 1;
-    const uvg_pixel val = temp_main[ref_length + multi_ref_index];
-    memset(temp_main + ref_length + multi_ref_index, val, max_index + 1);
-
-    ref_main = temp_main;
-    ref_side = temp_side;
-    //// sample_disp >= 0 means we don't need to refer to negative indices,
-    //// which means we can just use the references as is.
-    //ref_main = (vertical_mode ? in_ref_above : in_ref_left) + 1;
-    //ref_side = (vertical_mode ? in_ref_left : in_ref_above) + 1;
-
-    //memcpy(tmp_ref + width, ref_main, (width*2) * sizeof(uvg_pixel));
-    //ref_main = &tmp_ref[width];
-    //tmp_ref[width-1] = tmp_ref[width];
-    //int8_t last_index = 1 + width*2;
-    //tmp_ref[width + last_index] = tmp_ref[width + last_index - 1];
-  }
-
   // compensate for line offset in reference line buffers
   ref_main += multi_ref_index;
   ref_side += multi_ref_index;
@@ -501,6 +522,114 @@ static void uvg_angular_pred_avx2(
   }
 }
 
+/**
+ * \brief Generate angular predictions.
+ * \param cu_loc        CU locationand size data.
+ * \param intra_mode    Angular mode in range 2..34.
+ * \param channel_type  Color channel.
+ * \param in_ref_above  Pointer to -1 index of above reference, length=width*2+1.
+ * \param in_ref_left   Pointer to -1 index of left reference, length=width*2+1.
+ * \param dst           Buffer of size width*width.
+ * \param multi_ref_idx Reference line index for use with MRL.
+ */
+static void uvg_angular_pred_avx2(
+  const cu_loc_t* const cu_loc,
+  const int_fast8_t intra_mode,
+  const int_fast8_t channel_type,
+  const uvg_pixel *const in_ref_above,
+  const uvg_pixel *const in_ref_left,
+  uvg_pixel *const dst,
+  const uint8_t multi_ref_idx,
+  const uint8_t isp_mode,
+  const int cu_dim)
+{
+  const int width = channel_type == COLOR_Y ? cu_loc->width : cu_loc->chroma_width;
+  const int height = channel_type == COLOR_Y ? cu_loc->height : cu_loc->chroma_height;
+
+  // The kernel only handles square blocks, which have no wide angle modes.
+  if (width != height) {
+    uvg_angular_pred_generic(cu_loc, intra_mode, channel_type, in_ref_above, in_ref_left, dst, multi_ref_idx, isp_mode, cu_dim);
+    return;
+  }
+
+  // TODO: implement handling of MRL
+  uint8_t multi_ref_index = channel_type == COLOR_Y ? multi_ref_idx : 0;
+
+  // Temporary buffer for modes 11-25.
+  // It only needs to be big enough to hold indices from -width to width-1.
+  uvg_pixel temp_main[2 * 128 + 3 + 33 * MAX_REF_LINE_IDX] = { 0 };
+  uvg_pixel temp_side[2 * 128 + 3 + 33 * MAX_REF_LINE_IDX] = { 0 };
+
+  const bool vertical_mode = intra_mode >= 34;
+  const int_fast8_t mode_disp = vertical_mode ? intra_mode - 50 : -(intra_mode - 18);
+
+  uvg_pixel *ref_main;
+  const uvg_pixel *ref_side;
+  angular_pred_build_refs_avx2(width, mode_disp, vertical_mode, in_ref_above, in_ref_left, multi_ref_index, temp_main, temp_side, &ref_main, &ref_side);
+  angular_pred_kernel_avx2(cu_loc, intra_mode, channel_type, ref_main, ref_side, dst, multi_ref_index);
+}
+
+/**
+ * \brief Generate angular predictions for a batch of luma modes.
+ *
+ * Modes that project onto the same non-negative reference share one copy of
+ * the extended reference, so only modes with a negative displacement need to
+ * build their own.
+ *
+ * \param cu_loc        CU location and size data.
+ * \param modes         Wide angle corrected angular modes.
+ * \param num_modes     Number of modes in the batch.
+ * \param used_refs     Reference used for each mode.
+ * \param dsts          Buffers of size width*height for each mode.
+ */
+static void uvg_angular_pred_multi_avx2(
+  const cu_loc_t* const cu_loc,
+  const int8_t *const modes,
+  const int num_modes,
+  const uvg_intra_ref *const *const used_refs,
+  uvg_pixel *const *const dsts)
+{
+  const int width = cu_loc->width;
+
+  if (width != cu_loc->height) {
+    for (int i = 0; i < num_modes; ++i) {
+      uvg_angular_pred_generic(cu_loc, modes[i], COLOR_Y, used_refs[i]->top, used_refs[i]->left, dsts[i], 0, 0, width);
+    }
+    return;
+  }
+
+  uvg_pixel shared_main[2 * 128 + 3 + 33 * MAX_REF_LINE_IDX] = { 0 };
+  uvg_pixel shared_side[2 * 128 + 3 + 33 * MAX_REF_LINE_IDX] = { 0 };
+  uvg_pixel *shared_ref_main = NULL;
+  const uvg_pixel *shared_ref_side = NULL;
+  const uvg_intra_ref *shared_ref = NULL;
+  bool shared_vertical = false;
+
+  for (int i = 0; i < num_modes; ++i) {
+    const int_fast8_t intra_mode = modes[i];
+    const bool vertical_mode = intra_mode >= 34;
+    const int_fast8_t mode_disp = vertical_mode ? intra_mode - 50 : -(intra_mode - 18);
+
+    if (mode_disp < 0) {
+      uvg_pixel temp_main[2 * 128 + 3 + 33 * MAX_REF_LINE_IDX] = { 0 };
+      uvg_pixel temp_side[2 * 128 + 3 + 33 * MAX_REF_LINE_IDX] = { 0 };
+      uvg_pixel *ref_main;
+      const uvg_pixel *ref_side;
+      angular_pred_build_refs_avx2(width, mode_disp, vertical_mode, used_refs[i]->top, used_refs[i]->left, 0, temp_main, temp_side, &ref_main, &ref_side);
+      angular_pred_kernel_avx2(cu_loc, intra_mode, COLOR_Y, ref_main, ref_side, dsts[i], 0);
+      continue;
+    }
+
+    if (shared_ref != used_refs[i] || shared_vertical != vertical_mode) {
+      angular_pred_build_refs_avx2(width, mode_disp, vertical_mode, used_refs[i]->top, used_refs[i]->left, 0, shared_main, shared_side, &shared_ref_main, &shared_ref_side);
+      shared_ref = used_refs[i];
+      shared_vertical = vertical_mode;
+    }
+    angular_pred_kernel_avx2(cu_loc, intra_mode, COLOR_Y, shared_ref_main, shared_ref_side, dsts[i], 0);
+  }
+}
+
+
 /**
  * \brief Generate planar prediction.
  * \param cu_loc        CU location and size data.
@@ -1066,6 +1195,414 @@ static void uvg_pdpc_planar_dc_avx2(
   }
 }
 
+/**
+ * \brief Matrix multiplication of the reduced MIP boundary.
+ *
+ * Eight outputs are computed at a time by multiplying the 16-bit input with
+ * the weights of two outputs per register. The matrices of the largest
+ * blocks lack the first column, so their rows are loaded starting one byte
+ * early and the zero first input cancels the extra weight.
+ */
+static void mip_reduced_pred_avx2(
+  int *const output,
+  const int *const input,
+  const uint8_t *matrix,
+  const bool transpose,
+  const int red_bdry_size,
+  const int red_pred_size,
+  const int size_id,
+  const int in_offset,
+  const int in_offset_tr)
+{
+  const int input_size = 2 * red_bdry_size;
+  const int num_outputs = red_pred_size * red_pred_size;
+
+  int out_buf_transposed[8 * 8];
+  int *const out_ptr = transpose ? out_buf_transposed : output;
+
+  int sum = 0;
+  for (int i = 0; i < input_size; i++) {
+    sum += input[i];
+  }
+  const __m256i offset = _mm256_set1_epi32((1 << (MIP_SHIFT_MATRIX - 1)) - MIP_OFFSET_MATRIX * sum);
+  const __m256i input_offset = _mm256_set1_epi32(transpose ? in_offset_tr : in_offset);
+  const __m256i pixel_max = _mm256_set1_epi32(PIXEL_MAX);
+
+  // The input is repeated for every output sharing a register.
+  const __m128i in_lo = _mm_loadu_si128((const __m128i *)&input[0]);
+  const __m128i in_hi = input_size == 8 ? _mm_loadu_si128((const __m128i *)&input[4]) : in_lo;
+  const __m256i in16 = _mm256_broadcastsi128_si256(_mm_packs_epi32(in_lo, in_hi));
+
+  for (int i = 0; i < num_outputs; i += 8) {
+    __m256i sums;
+    if (size_id == 0) {
+      // Four weights per output, four outputs per 16 bytes.
+      const __m256i w0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)&matrix[i * 4]));
+      const __m256i w1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)&matrix[i * 4 + 16]));
+      sums = _mm256_hadd_epi32(_mm256_madd_epi16(w0, in16), _mm256_madd_epi16(w1, in16));
+      sums = _mm256_permutevar8x32_epi32(sums, _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7));
+    } else {
+      __m256i w[4];
+      for (int k = 0; k < 4; ++k) {
+        const int out_idx = i + 2 * k;
+        __m128i rows;
+        if (size_id == 1) {
+          rows = _mm_loadu_si128((const __m128i *)&matrix[out_idx * 8]);
+        } else {
+          const __m128i first = out_idx == 0
+            ? _mm_slli_epi64(_mm_loadl_epi64((const __m128i *)&matrix[0]), 8)
+            : _mm_loadl_epi64((const __m128i *)&matrix[out_idx * 7 - 1]);
+          const __m128i second = _mm_loadl_epi64((const __m128i *)&matrix[out_idx * 7 + 6]);
+          rows = _mm_unpacklo_epi64(first, second);
+        }
+        w[k] = _mm256_cvtepu8_epi16(rows);
+      }
+      const __m256i h0 = _mm256_hadd_epi32(_mm256_madd_epi16(w[0], in16), _mm256_madd_epi16(w[1], in16));
+      const __m256i h1 = _mm256_hadd_epi32(_mm256_madd_epi16(w[2], in16), _mm256_madd_epi16(w[3], in16));
+      sums = _mm256_hadd_epi32(h0, h1);
+      sums = _mm256_permutevar8x32_epi32(sums, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+    }
+
+    __m256i result = _mm256_srai_epi32(_mm256_add_epi32(sums, offset), MIP_SHIFT_MATRIX);
+    result = _mm256_add_epi32(result, input_offset);
+    result = _mm256_min_epi32(_mm256_max_epi32(result, _mm256_setzero_si256()), pixel_max);
+    _mm256_storeu_si256((__m256i *)&out_ptr[i], result);
+  }
+
+  if (transpose) {
+    for (int y = 0; y < red_pred_size; y++) {
+      for (int x = 0; x < red_pred_size; x++) {
+        output[y * red_pred_size + x] = out_ptr[x * red_pred_size + y];
+      }
+    }
+  }
+}
+
+
+/**
+ * \brief Horizontal upsampling of the reduced MIP prediction.
+ *
+ * Every output sample of a row is interpolated between the two reduced
+ * samples it falls between, which are gathered with a permute.
+ *
+ * \param dst            First row of the output.
+ * \param src            Reduced prediction.
+ * \param boundary       Left reference samples.
+ * \param red_pred_size  Width and height of the reduced prediction.
+ * \param dst_stride     Distance between the output rows.
+ * \param boundary_step  Distance between the used left reference samples.
+ * \param ups_factor     Upsampling factor.
+ */
+static void mip_upsampling_hor_avx2(
+  int *const dst,
+  const int *const src,
+  const int *const boundary,
+  const int red_pred_size,
+  const int dst_stride,
+  const int boundary_step,
+  const int ups_factor)
+{
+  const int log2_factor = uvg_math_floor_log2(ups_factor);
+  const __m128i shift = _mm_cvtsi32_si128(log2_factor);
+  const __m256i rounding = _mm256_set1_epi32(1 << (log2_factor - 1));
+  const __m256i pos_mask = _mm256_set1_epi32(ups_factor - 1);
+  const __m256i ones = _mm256_set1_epi32(1);
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i before_idx = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+  const int width = red_pred_size * ups_factor;
+
+  for (int y = 0; y < red_pred_size; ++y) {
+    const int *const src_row = &src[y * red_pred_size];
+    const __m256i behind = red_pred_size == 8
+      ? _mm256_loadu_si256((const __m256i *)src_row)
+      : _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)src_row));
+    const __m256i bdry = _mm256_set1_epi32(boundary[y * boundary_step + boundary_step - 1]);
+    const __m256i before = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(behind, before_idx), bdry, 0x01);
+    const __m256i scaled_before = _mm256_add_epi32(_mm256_sll_epi32(before, shift), rounding);
+    const __m256i diff = _mm256_sub_epi32(behind, before);
+
+    int *const dst_row = &dst[y * dst_stride];
+    for (int x = 0; x < width; x += 8) {
+      const __m256i pos = _mm256_add_epi32(lanes, _mm256_set1_epi32(x));
+      const __m256i idx = _mm256_srl_epi32(pos, shift);
+      const __m256i weight = _mm256_add_epi32(_mm256_and_si256(pos, pos_mask), ones);
+      __m256i result = _mm256_mullo_epi32(_mm256_permutevar8x32_epi32(diff, idx), weight);
+      result = _mm256_add_epi32(result, _mm256_permutevar8x32_epi32(scaled_before, idx));
+      _mm256_storeu_si256((__m256i *)&dst_row[x], _mm256_sra_epi32(result, shift));
+    }
+  }
+}
+
+
+/**
+ * \brief Vertical upsampling of the reduced MIP prediction.
+ *
+ * The rows between two source rows are interpolated for the full width at
+ * once. The last interpolated row equals the source row, so the source may
+ * be located inside the output.
+ *
+ * \param dst            Output block.
+ * \param src            First source row.
+ * \param boundary       Above reference samples.
+ * \param width          Width of the block.
+ * \param red_pred_size  Number of source rows.
+ * \param src_step       Distance between the source rows.
+ * \param ups_factor     Upsampling factor.
+ */
+static void mip_upsampling_ver_avx2(
+  int *const dst,
+  const int *const src,
+  const int *const boundary,
+  const int width,
+  const int red_pred_size,
+  const int src_step,
+  const int ups_factor)
+{
+  const int log2_factor = uvg_math_floor_log2(ups_factor);
+  const __m128i shift = _mm_cvtsi32_si128(log2_factor);
+  const int rounding = 1 << (log2_factor - 1);
+
+  for (int y = 0; y < red_pred_size; ++y) {
+    const int *const before_row = y == 0 ? boundary : &src[(y - 1) * src_step];
+    const int *const behind_row = &src[y * src_step];
+    int *const dst_rows = &dst[y * ups_factor * width];
+
+    if (width == 4) {
+      const __m128i before = _mm_loadu_si128((const __m128i *)before_row);
+      const __m128i behind = _mm_loadu_si128((const __m128i *)behind_row);
+      const __m128i diff = _mm_sub_epi32(behind, before);
+      __m128i acc = _mm_add_epi32(_mm_sll_epi32(before, shift), _mm_set1_epi32(rounding));
+      for (int pos = 0; pos < ups_factor; ++pos) {
+        acc = _mm_add_epi32(acc, diff);
+        _mm_storeu_si128((__m128i *)&dst_rows[pos * width], _mm_sra_epi32(acc, shift));
+      }
+      continue;
+    }
+
+    for (int x = 0; x < width; x += 8) {
+      const __m256i before = _mm256_loadu_si256((const __m256i *)&before_row[x]);
+      const __m256i behind = _mm256_loadu_si256((const __m256i *)&behind_row[x]);
+      const __m256i diff = _mm256_sub_epi32(behind, before);
+      __m256i acc = _mm256_add_epi32(_mm256_sll_epi32(before, shift), _mm256_set1_epi32(rounding));
+      for (int pos = 0; pos < ups_factor; ++pos) {
+        acc = _mm256_add_epi32(acc, diff);
+        _mm256_storeu_si256((__m256i *)&dst_rows[pos * width + x], _mm256_sra_epi32(acc, shift));
+      }
+    }
+  }
+}
+
+
+/** \brief Matrix weighted intra prediction.
+*/
+static void uvg_mip_predict_avx2(
+  const uvg_intra_references *const refs,
+  const uint16_t pred_block_width,
+  const uint16_t pred_block_height,
+  uvg_pixel *dst,
+  const int mip_mode,
+  const bool mip_transp)
+{
+  const int width = pred_block_width;
+  const int height = pred_block_height;
+
+  int size_id; // Prediction block type
+  if (width == 4 && height == 4) {
+    size_id = 0;
+  }
+  else if (width == 4 || height == 4 || (width == 8 && height == 8)) {
+    size_id = 1;
+  }
+  else {
+    size_id = 2;
+  }
+
+  const int red_bdry_size = (size_id == 0) ? 2 : 4;
+  const int red_pred_size = (size_id < 2) ? 4 : 8;
+  const int ups_hor_factor = width / red_pred_size;
+  const int ups_ver_factor = height / red_pred_size;
+
+  int ref_samples_top[MIP_MAX_WIDTH];
+  int ref_samples_left[MIP_MAX_HEIGHT];
+  for (int i = 0; i < width; i += 4) {
+    _mm_storeu_si128((__m128i *)&ref_samples_top[i], _mm_cvtepu8_epi32(_mm_cvtsi32_si128(*(const int32_t *)&refs->ref.top[i + 1])));
+  }
+  for (int i = 0; i < height; i += 4) {
+    _mm_storeu_si128((__m128i *)&ref_samples_left[i], _mm_cvtepu8_epi32(_mm_cvtsi32_si128(*(const int32_t *)&refs->ref.left[i + 1])));
+  }
+
+  // Reduced boundaries in normal and transposed order.
+  const int input_size = 2 * red_bdry_size;
+  int red_bdry[MIP_MAX_INPUT_SIZE];
+  int red_bdry_trans[MIP_MAX_INPUT_SIZE];
+  uvg_mip_boundary_downsampling_1D(&red_bdry[0], ref_samples_top, width, red_bdry_size);
+  uvg_mip_boundary_downsampling_1D(&red_bdry[red_bdry_size], ref_samples_left, height, red_bdry_size);
+  for (int i = 0; i < red_bdry_size; ++i) {
+    red_bdry_trans[i] = red_bdry[red_bdry_size + i];
+    red_bdry_trans[red_bdry_size + i] = red_bdry[i];
+  }
+
+  const int input_offset = red_bdry[0];
+  const int input_offset_trans = red_bdry_trans[0];
+
+  // First column of matrix not needed for large blocks
+  const bool has_first_col = (size_id < 2);
+  red_bdry[0] = has_first_col ? ((1 << (UVG_BIT_DEPTH - 1)) - input_offset) : 0;
+  red_bdry_trans[0] = has_first_col ? ((1 << (UVG_BIT_DEPTH - 1)) - input_offset_trans) : 0;
+  for (int i = 1; i < input_size; ++i) {
+    red_bdry[i] -= input_offset;
+    red_bdry_trans[i] -= input_offset_trans;
+  }
+
+  const uint8_t *matrix;
+  switch (size_id) {
+    case 0:
+      matrix = &uvg_mip_matrix_4x4[mip_mode][0][0];
+      break;
+    case 1:
+      matrix = &uvg_mip_matrix_8x8[mip_mode][0][0];
+      break;
+    default:
+      matrix = &uvg_mip_matrix_16x16[mip_mode][0][0];
+      break;
+  }
+
+  ALIGNED(32) int result[32 * 32];
+  int red_pred_buffer[8 * 8];
+  const bool need_upsampling = (ups_hor_factor > 1) || (ups_ver_factor > 1);
+  int *const reduced_pred = need_upsampling ? red_pred_buffer : result;
+
+  mip_reduced_pred_avx2(reduced_pred, mip_transp ? red_bdry_trans : red_bdry, matrix, mip_transp,
+                        red_bdry_size, red_pred_size, size_id, input_offset, input_offset_trans);
+
+  if (need_upsampling) {
+    const int *ver_src = reduced_pred;
+    int ver_src_step = width;
+
+    if (ups_hor_factor > 1) {
+      int *const hor_dst = result + (ups_ver_factor - 1) * width;
+      ver_src = hor_dst;
+      ver_src_step *= ups_ver_factor;
+      mip_upsampling_hor_avx2(hor_dst, reduced_pred, ref_samples_left, red_pred_size, ver_src_step, ups_ver_factor, ups_hor_factor);
+    }
+
+    if (ups_ver_factor > 1) {
+      mip_upsampling_ver_avx2(result, ver_src, ref_samples_top, width, red_pred_size, ver_src_step, ups_ver_factor);
+    }
+  }
+
+  // All values are within the pixel range, so saturating packs are exact.
+  for (int i = 0; i < width * height; i += 16) {
+    const __m256i lo = _mm256_load_si256((const __m256i *)&result[i]);
+    const __m256i hi = _mm256_load_si256((const __m256i *)&result[i + 8]);
+    const __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+    const __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+    _mm_storeu_si128((__m128i *)&dst[i], bytes);
+  }
+}
+
+
+/**
+ * \brief Downsample 8 CCLM samples from two luma rows.
+ *
+ * \param cur   16 luma samples of each row, row0 in the low lane.
+ * \param prev  The same samples shifted right by one.
+ */
+static INLINE __m128i cclm_downsample_8_avx2(const __m256i cur, const __m256i prev)
+{
+  const __m256i w_cur = _mm256_set1_epi16(0x0102);
+  const __m256i w_prev = _mm256_set1_epi16(0x0001);
+  const __m256i sum = _mm256_add_epi16(_mm256_maddubs_epi16(cur, w_cur), _mm256_maddubs_epi16(prev, w_prev));
+  __m128i res = _mm_add_epi16(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  res = _mm_srli_epi16(_mm_add_epi16(res, _mm_set1_epi16(4)), 3);
+  return _mm_packus_epi16(res, res);
+}
+
+
+static void uvg_cclm_downsample_avx2(
+  const uvg_pixel *y_rec,
+  const int rec_stride,
+  const uvg_pixel *left,
+  uvg_pixel *dst,
+  const int dst_stride,
+  const int width,
+  const int height)
+{
+  if (width < 4) {
+    for (int y = 0; y < height; ++y) {
+      const uvg_pixel *row0 = &y_rec[2 * y * rec_stride];
+      const uvg_pixel *row1 = row0 + rec_stride;
+      for (int x = 0; x < width; ++x) {
+        int s = 4;
+        s += row0[2 * x] * 2 + row0[2 * x + 1] + (x ? row0[2 * x - 1] : left[2 * y]);
+        s += row1[2 * x] * 2 + row1[2 * x + 1] + (x ? row1[2 * x - 1] : left[2 * y + 1]);
+        dst[y * dst_stride + x] = s >> 3;
+      }
+    }
+    return;
+  }
+
+  for (int y = 0; y < height; ++y) {
+    const uvg_pixel *row0 = &y_rec[2 * y * rec_stride];
+    const uvg_pixel *row1 = row0 + rec_stride;
+
+    // The first samples use the left neighbours instead of reading before the rows.
+    __m128i cur0, cur1;
+    if (width == 4) {
+      cur0 = _mm_loadl_epi64((const __m128i *)row0);
+      cur1 = _mm_loadl_epi64((const __m128i *)row1);
+    } else {
+      cur0 = _mm_loadu_si128((const __m128i *)row0);
+      cur1 = _mm_loadu_si128((const __m128i *)row1);
+    }
+    const __m128i prev0 = _mm_alignr_epi8(cur0, _mm_set1_epi8(left[2 * y]), 15);
+    const __m128i prev1 = _mm_alignr_epi8(cur1, _mm_set1_epi8(left[2 * y + 1]), 15);
+    __m128i res = cclm_downsample_8_avx2(_mm256_setr_m128i(cur0, cur1), _mm256_setr_m128i(prev0, prev1));
+    if (width == 4) {
+      *(int32_t *)&dst[y * dst_stride] = _mm_cvtsi128_si32(res);
+      continue;
+    }
+    _mm_storel_epi64((__m128i *)&dst[y * dst_stride], res);
+
+    for (int x = 8; x < width; x += 8) {
+      const __m256i cur = _mm256_loadu2_m128i((const __m128i *)&row1[2 * x], (const __m128i *)&row0[2 * x]);
+      const __m256i prev = _mm256_loadu2_m128i((const __m128i *)&row1[2 * x - 1], (const __m128i *)&row0[2 * x - 1]);
+      res = cclm_downsample_8_avx2(cur, prev);
+      _mm_storel_epi64((__m128i *)&dst[y * dst_stride + x], res);
+    }
+  }
+}
+
+
+static void uvg_cclm_linear_transform_avx2(
+  const cclm_parameters_t *const cclm_params,
+  const uvg_pixel *src,
+  uvg_pixel *dst,
+  const int width,
+  const int height)
+{
+  const int size = width * height;
+  const __m256i scale = _mm256_set1_epi32(cclm_params->a);
+  const __m128i shift = _mm_cvtsi32_si128(cclm_params->shift);
+  const __m256i offset = _mm256_set1_epi32(cclm_params->b);
+
+  int i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i pixels = _mm_loadu_si128((const __m128i *)&src[i]);
+    __m256i lo = _mm256_cvtepu8_epi32(pixels);
+    __m256i hi = _mm256_cvtepu8_epi32(_mm_srli_si128(pixels, 8));
+    lo = _mm256_add_epi32(_mm256_sra_epi32(_mm256_mullo_epi32(lo, scale), shift), offset);
+    hi = _mm256_add_epi32(_mm256_sra_epi32(_mm256_mullo_epi32(hi, scale), shift), offset);
+    const __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+    const __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+    _mm_storeu_si128((__m128i *)&dst[i], bytes);
+  }
+  for (; i < size; ++i) {
+    const int val = ((src[i] * cclm_params->a) >> cclm_params->shift) + cclm_params->b;
+    dst[i] = CLIP_TO_PIXEL(val);
+  }
+}
+
 #endif //UVG_BIT_DEPTH == 8
 #endif //COMPILE_INTEL_AVX2 && defined X86_64
 
@@ -1076,9 +1613,13 @@ int uvg_strategy_register_intra_avx2(void* opaque, uint8_t bitdepth)
 #if UVG_BIT_DEPTH == 8
   if (bitdepth == 8) {
     success &= uvg_strategyselector_register(opaque, "angular_pred", "avx2", 40, &uvg_angular_pred_avx2);
+    success &= uvg_strategyselector_register(opaque, "angular_pred_multi", "avx2", 40, &uvg_angular_pred_multi_avx2);
     success &= uvg_strategyselector_register(opaque, "intra_pred_planar", "avx2", 40, &uvg_intra_pred_planar_avx2);
     success &= uvg_strategyselector_register(opaque, "intra_pred_filtered_dc", "avx2", 40, &uvg_intra_pred_filtered_dc_avx2);
     success &= uvg_strategyselector_register(opaque, "pdpc_planar_dc", "avx2", 40, &uvg_pdpc_planar_dc_avx2);
+    success &= uvg_strategyselector_register(opaque, "mip_predict", "avx2", 40, &uvg_mip_predict_avx2);
+    success &= uvg_strategyselector_register(opaque, "cclm_downsample", "avx2", 40, &uvg_cclm_downsample_avx2);
+    success &= uvg_strategyselector_register(opaque, "cclm_linear_transform", "avx2", 40, &uvg_cclm_linear_transform_avx2);
   }
 #endif //UVG_BIT_DEPTH == 8
 #endif //COMPILE_INTEL_AVX2 && defined X86_64
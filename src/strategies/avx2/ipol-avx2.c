@@ -1243,6 +1243,183 @@ static void uvg_sample_octpel_chroma_hi_avx2(const encoder_control_t *const enco
   uvg_ipol_4tap_ver_im_hi_avx2(ver_fir, width, height, hor_intermediate, hor_stride, dst, dst_stride);
 }
 
+/**
+ * \brief Copy a row of pixels.
+ *
+ * Tails are handled with overlapping loads and stores.
+ */
+static INLINE void copy_row_avx2(uvg_pixel *dst, const uvg_pixel *src, int count)
+{
+  uint8_t *dst_b = (uint8_t *)dst;
+  const uint8_t *src_b = (const uint8_t *)src;
+  const int bytes = count * sizeof(uvg_pixel);
+
+  if (bytes >= 32) {
+    int i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+      _mm256_storeu_si256((__m256i *)&dst_b[i], _mm256_loadu_si256((const __m256i *)&src_b[i]));
+    }
+    if (i < bytes) {
+      _mm256_storeu_si256((__m256i *)&dst_b[bytes - 32], _mm256_loadu_si256((const __m256i *)&src_b[bytes - 32]));
+    }
+  } else if (bytes >= 16) {
+    _mm_storeu_si128((__m128i *)dst_b, _mm_loadu_si128((const __m128i *)src_b));
+    _mm_storeu_si128((__m128i *)&dst_b[bytes - 16], _mm_loadu_si128((const __m128i *)&src_b[bytes - 16]));
+  } else if (bytes > 0) {
+    memcpy(dst_b, src_b, bytes);
+  }
+}
+
+/**
+ * \brief Fill a row of pixels with a single value.
+ *
+ * Tails are handled with overlapping stores.
+ */
+static INLINE void fill_row_avx2(uvg_pixel *dst, uvg_pixel value, int count)
+{
+  uint8_t *dst_b = (uint8_t *)dst;
+  const int bytes = count * sizeof(uvg_pixel);
+#if UVG_BIT_DEPTH == 8
+  const __m256i v = _mm256_set1_epi8(value);
+#else
+  const __m256i v = _mm256_set1_epi16(value);
+#endif
+
+  if (bytes >= 32) {
+    int i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+      _mm256_storeu_si256((__m256i *)&dst_b[i], v);
+    }
+    if (i < bytes) {
+      _mm256_storeu_si256((__m256i *)&dst_b[bytes - 32], v);
+    }
+  } else if (bytes >= 16) {
+    _mm_storeu_si128((__m128i *)dst_b, _mm256_castsi256_si128(v));
+    _mm_storeu_si128((__m128i *)&dst_b[bytes - 16], _mm256_castsi256_si128(v));
+  } else {
+    for (int i = 0; i < count; ++i) dst[i] = value;
+  }
+}
+
+static void uvg_get_extended_block_avx2(uvg_epol_args *args)
+{
+  int min_y = args->blk_y - args->pad_t;
+  int max_y = args->blk_y + args->blk_h + args->pad_b + args->pad_b_simd - 1;
+  bool out_of_bounds_y = (min_y < -args->src_pad) || (max_y >= args->src_h + args->src_pad);
+
+  int min_x = args->blk_x - args->pad_l;
+  int max_x = args->blk_x + args->blk_w + args->pad_r - 1;
+  bool out_of_bounds_x = (min_x < -args->src_pad) || (max_x >= args->src_w + args->src_pad);
+
+  if (!out_of_bounds_y && !out_of_bounds_x) {
+    *args->ext = args->src + (args->blk_y - args->pad_t) * args->src_s + (args->blk_x - args->pad_l);
+    *args->ext_origin = args->src + args->blk_y * args->src_s + args->blk_x;
+    *args->ext_s = args->src_s;
+    return;
+  }
+
+  const int ext_s = args->pad_l + args->blk_w + args->pad_r;
+  *args->ext = args->buf;
+  *args->ext_s = ext_s;
+  *args->ext_origin = args->buf + args->pad_t * ext_s + args->pad_l;
+
+  // Note that stride equals width here.
+  const int cnt_l = CLIP(0, ext_s, -min_x);
+  const int cnt_r = CLIP(0, ext_s, max_x - (args->src_w - 1));
+  const int cnt_m = CLIP(0, ext_s, ext_s - cnt_l - cnt_r);
+
+  // Rows above and below the picture are copies of the edge rows, so each
+  // row is built only once and then copied.
+  int prev_y = -1;
+  uvg_pixel *prev_dst = NULL;
+  int y;
+  for (y = -args->pad_t; y < args->blk_h + args->pad_b; ++y) {
+    const int clipped_y = CLIP(0, args->src_h - 1, args->blk_y + y);
+    uvg_pixel *dst = args->buf + (y + args->pad_t) * ext_s;
+
+    if (clipped_y == prev_y) {
+      copy_row_avx2(dst, prev_dst, ext_s);
+    } else {
+      const uvg_pixel *row = args->src + clipped_y * args->src_s;
+      fill_row_avx2(dst, row[0], cnt_l);
+      copy_row_avx2(dst + cnt_l, row + MAX(min_x, 0), cnt_m);
+      fill_row_avx2(dst + cnt_l + cnt_m, row[args->src_w - 1], cnt_r);
+    }
+    prev_y = clipped_y;
+    prev_dst = dst;
+  }
+
+  // Don't read "don't care" values (SIMD padding). Zero them out.
+  for (int y_simd = 0; y_simd < args->pad_b_simd; ++y_simd) {
+    uvg_pixel *dst = args->buf + (y + args->pad_t + y_simd) * ext_s;
+    FILL_ARRAY(dst, 0, ext_s);
+  }
+}
+
+static void uvg_get_extended_block_wraparound_avx2(uvg_epol_args *args)
+{
+  int  min_y = args->blk_y - args->pad_t;
+  int  max_y = args->blk_y + args->blk_h + args->pad_b + args->pad_b_simd - 1;
+  bool out_of_bounds_y = (min_y < 0) || (max_y >= args->src_h);
+
+  int  min_x = args->blk_x - args->pad_l;
+  int  max_x = args->blk_x + args->blk_w + args->pad_r;
+  bool out_of_bounds_x = (min_x < 0) || (max_x >= args->src_w);
+
+  if (!out_of_bounds_y && !out_of_bounds_x) {
+    *args->ext = args->src + (args->blk_y - args->pad_t) * args->src_s + (args->blk_x - args->pad_l);
+    *args->ext_origin = args->src + args->blk_y * args->src_s + args->blk_x;
+    *args->ext_s = args->src_s;
+    return;
+  }
+
+  // Split the row into at most two parts at the wraparound point.
+  int first_x_start = min_x;
+  int first_x_count = max_x - min_x;
+  int second_x_count = 0;
+  if (out_of_bounds_x) {
+    if (min_x < 0) {
+      first_x_start = args->src_w + min_x;
+      first_x_count = -min_x;
+      if (max_x >= 0) second_x_count = max_x;
+    } else if (min_x >= args->src_w) {
+      first_x_start = min_x - args->src_w;
+    } else {
+      first_x_count = args->src_w - min_x;
+      second_x_count = max_x - args->src_w;
+    }
+  }
+
+  const int ext_s = args->pad_l + args->blk_w + args->pad_r;
+  *args->ext = args->buf;
+  *args->ext_s = ext_s;
+  *args->ext_origin = args->buf + args->pad_t * ext_s + args->pad_l;
+
+  int prev_y = -1;
+  uvg_pixel *prev_dst = NULL;
+  int y;
+  for (y = -args->pad_t; y < args->blk_h + args->pad_b; ++y) {
+    const int clipped_y = CLIP(0, args->src_h - 1, args->blk_y + y);
+    uvg_pixel *dst = args->buf + (y + args->pad_t) * ext_s;
+
+    if (clipped_y == prev_y) {
+      copy_row_avx2(dst, prev_dst, first_x_count + second_x_count);
+    } else {
+      const uvg_pixel *row = args->src + clipped_y * args->src_s;
+      copy_row_avx2(dst, row + first_x_start, first_x_count);
+      copy_row_avx2(dst + first_x_count, row, second_x_count);
+    }
+    prev_y = clipped_y;
+    prev_dst = dst;
+  }
+
+  // Don't read "don't care" values (SIMD padding). Zero them out.
+  for (int y_simd = 0; y_simd < args->pad_b_simd; ++y_simd) {
+    uvg_pixel *dst = args->buf + (y + args->pad_t + y_simd) * ext_s;
+    FILL_ARRAY(dst, 0, ext_s);
+  }
+}
+
 #endif //COMPILE_INTEL_AVX2 && defined X86_64
 
 int uvg_strategy_register_ipol_avx2(void* opaque, uint8_t bitdepth)
@@ -1258,6 +1435,8 @@ int uvg_strategy_register_ipol_avx2(void* opaque, uint8_t bitdepth)
     success &= uvg_strategyselector_register(opaque, "sample_octpel_chroma", "avx2", 40, &uvg_sample_octpel_chroma_avx2);
     success &= uvg_strategyselector_register(opaque, "sample_quarterpel_luma_hi", "avx2", 40, &uvg_sample_quarterpel_luma_hi_avx2);
     success &= uvg_strategyselector_register(opaque, "sample_octpel_chroma_hi", "avx2", 40, &uvg_sample_octpel_chroma_hi_avx2);
+    success &= uvg_strategyselector_register(opaque, "get_extended_block", "avx2", 40, &uvg_get_extended_block_avx2);
+    success &= uvg_strategyselector_register(opaque, "get_extended_block_wraparound", "avx2", 40, &uvg_get_extended_block_wraparound_avx2);
   }
 #endif //COMPILE_INTEL_AVX2 && defined X86_64
   return success;
@@ -598,6 +598,120 @@ SATD_NxN(8bit_avx2, 32)
 SATD_NxN(8bit_avx2, 64)
 SATD_ANY_SIZE(8bit_avx2)
 
+/**
+* \brief  Calculate the sum of the SATDs of U and V 4x4 blocks.
+*
+* Each register holds a row of the U block in the low half and the same row
+* of the V block in the high half.
+*/
+static unsigned satd_4x4_subblock_uv_8bit_avx2(const uint8_t *pred_u, const uint8_t *pred_v, const int pred_stride,
+                                               const uint8_t *orig_u, const uint8_t *orig_v, const int orig_stride)
+{
+  __m128i rows[4];
+  for (int i = 0; i < 4; ++i) {
+    const __m128i pred = _mm_unpacklo_epi32(_mm_cvtsi32_si128(*(const int32_t *)&pred_u[i * pred_stride]),
+                                            _mm_cvtsi32_si128(*(const int32_t *)&pred_v[i * pred_stride]));
+    const __m128i orig = _mm_unpacklo_epi32(_mm_cvtsi32_si128(*(const int32_t *)&orig_u[i * orig_stride]),
+                                            _mm_cvtsi32_si128(*(const int32_t *)&orig_v[i * orig_stride]));
+    __m128i row = _mm_sub_epi16(_mm_cvtepu8_epi16(pred), _mm_cvtepu8_epi16(orig));
+
+    // Horizontal transform within the four samples of each plane.
+    __m128i swapped = _mm_shufflehi_epi16(_mm_shufflelo_epi16(row, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+    row = _mm_add_epi16(_mm_sign_epi16(row, _mm_set_epi16(-1, 1, -1, 1, -1, 1, -1, 1)), swapped);
+    swapped = _mm_shufflehi_epi16(_mm_shufflelo_epi16(row, _MM_SHUFFLE(1, 0, 3, 2)), _MM_SHUFFLE(1, 0, 3, 2));
+    rows[i] = _mm_add_epi16(_mm_sign_epi16(row, _mm_set_epi16(-1, -1, 1, 1, -1, -1, 1, 1)), swapped);
+  }
+
+  // Vertical transform.
+  const __m128i t0 = _mm_add_epi16(rows[0], rows[1]);
+  const __m128i t1 = _mm_sub_epi16(rows[0], rows[1]);
+  const __m128i t2 = _mm_add_epi16(rows[2], rows[3]);
+  const __m128i t3 = _mm_sub_epi16(rows[2], rows[3]);
+  const __m128i c0 = _mm_add_epi16(t0, t2);
+  const __m128i c1 = _mm_add_epi16(t1, t3);
+  const __m128i c2 = _mm_sub_epi16(t0, t2);
+  const __m128i c3 = _mm_sub_epi16(t1, t3);
+
+  __m128i sum = _mm_add_epi16(_mm_abs_epi16(c0), _mm_abs_epi16(c1));
+  sum = _mm_madd_epi16(sum, _mm_set1_epi16(1));
+  sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_add_epi16(_mm_abs_epi16(c2), _mm_abs_epi16(c3)), _mm_set1_epi16(1)));
+  // Sums of U in the low and V in the high 64 bits.
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+  const int dc_u = abs((int16_t)_mm_extract_epi16(c0, 0));
+  const int dc_v = abs((int16_t)_mm_extract_epi16(c0, 4));
+  const int satd_u = _mm_cvtsi128_si32(sum) - dc_u + (dc_u >> 2);
+  const int satd_v = _mm_extract_epi32(sum, 2) - dc_v + (dc_v >> 2);
+
+  return ((satd_u + 1) >> 1) + ((satd_v + 1) >> 1);
+}
+
+/**
+* \brief  Calculate the sum of the SATDs of U and V 8x8 blocks.
+*
+* The U block is transformed in the low and the V block in the high lane.
+*/
+static unsigned satd_8x8_subblock_uv_8bit_avx2(const uint8_t *pred_u, const uint8_t *pred_v, const int pred_stride,
+                                               const uint8_t *orig_u, const uint8_t *orig_v, const int orig_stride)
+{
+  __m256i rows[8];
+  for (int i = 0; i < 8; ++i) {
+    const __m128i pred = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)&pred_u[i * pred_stride]),
+                                            _mm_loadl_epi64((const __m128i *)&pred_v[i * pred_stride]));
+    const __m128i orig = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)&orig_u[i * orig_stride]),
+                                            _mm_loadl_epi64((const __m128i *)&orig_v[i * orig_stride]));
+    rows[i] = _mm256_sub_epi16(_mm256_cvtepu8_epi16(pred), _mm256_cvtepu8_epi16(orig));
+  }
+  hor_transform_block_dual_avx2(&rows);
+  ver_transform_block_dual_avx2(&rows);
+
+  unsigned sad_u, sad_v;
+  sum_block_dual_avx2(rows, &sad_u, &sad_v);
+  const int dc_u = abs((int16_t)_mm256_extract_epi16(rows[0], 0));
+  const int dc_v = abs((int16_t)_mm256_extract_epi16(rows[0], 8));
+
+  return ((sad_u - (dc_u - (dc_u >> 2)) + 2) >> 2) + ((sad_v - (dc_v - (dc_v >> 2)) + 2) >> 2);
+}
+
+static unsigned satd_any_size_uv_8bit_avx2(int width, int height,
+                                           const uint8_t *pred_u, const uint8_t *pred_v, const int pred_stride,
+                                           const uint8_t *orig_u, const uint8_t *orig_v, const int orig_stride)
+{
+  unsigned sum = 0;
+  if (width % 8 != 0) {
+    // Process the first column using 4x4 blocks.
+    for (int y = 0; y < height; y += 4) {
+      sum += satd_4x4_subblock_uv_8bit_avx2(&pred_u[y * pred_stride], &pred_v[y * pred_stride], pred_stride,
+                                            &orig_u[y * orig_stride], &orig_v[y * orig_stride], orig_stride);
+    }
+    pred_u += 4;
+    pred_v += 4;
+    orig_u += 4;
+    orig_v += 4;
+    width -= 4;
+  }
+  if (height % 8 != 0) {
+    // Process the first row using 4x4 blocks.
+    for (int x = 0; x < width; x += 4) {
+      sum += satd_4x4_subblock_uv_8bit_avx2(&pred_u[x], &pred_v[x], pred_stride,
+                                            &orig_u[x], &orig_v[x], orig_stride);
+    }
+    pred_u += 4 * pred_stride;
+    pred_v += 4 * pred_stride;
+    orig_u += 4 * orig_stride;
+    orig_v += 4 * orig_stride;
+    height -= 4;
+  }
+  // The rest can now be processed with 8x8 blocks.
+  for (int y = 0; y < height; y += 8) {
+    for (int x = 0; x < width; x += 8) {
+      sum += satd_8x8_subblock_uv_8bit_avx2(&pred_u[y * pred_stride + x], &pred_v[y * pred_stride + x], pred_stride,
+                                            &orig_u[y * orig_stride + x], &orig_v[y * orig_stride + x], orig_stride);
+    }
+  }
+  return sum;
+}
+
 // Function macro for defining hadamard calculating functions
 // for fixed size blocks. They calculate hadamard for integer
 // multiples of 8x8 with the 8x8 hadamard function.
@@ -718,7 +832,6 @@ static unsigned pixels_calc_ssd_avx2(const uint8_t *const ref, const uint8_t *co
                  const int ref_stride, const int rec_stride,
                  const int width, const int height)
 {
-  assert(width == height && "Non square not yet implemented");
   __m256i ssd_part;
   __m256i diff = _mm256_setzero_si256();
   __m128i sum;
@@ -731,6 +844,55 @@ static unsigned pixels_calc_ssd_avx2(const uint8_t *const ref, const uint8_t *co
 
   int ssd;
 
+  if (width < 4) {
+    // Thin ISP partitions, 1xN and 2xN.
+    ssd = 0;
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        int diff = ref[x + y * ref_stride] - rec[x + y * rec_stride];
+        ssd += diff * diff;
+      }
+    }
+    return ssd >> (2*(UVG_BIT_DEPTH-8));
+  }
+
+  if (width != height) {
+    ssd_part = _mm256_setzero_si256();
+    if (width == 4) {
+      for (int y = 0; y < height; y += 2) {
+        ref_row0 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(*(int32_t*)&(ref[y * ref_stride])), _mm_cvtsi32_si128(*(int32_t*)&(ref[(y + 1) * ref_stride])));
+        rec_row0 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(*(int32_t*)&(rec[y * rec_stride])), _mm_cvtsi32_si128(*(int32_t*)&(rec[(y + 1) * rec_stride])));
+        __m128i diff_epi16 = _mm_sub_epi16(_mm_cvtepu8_epi16(ref_row0), _mm_cvtepu8_epi16(rec_row0));
+        ssd_part = _mm256_add_epi32(ssd_part, _mm256_castsi128_si256(_mm_madd_epi16(diff_epi16, diff_epi16)));
+      }
+    } else if (width == 8) {
+      for (int y = 0; y < height; y += 2) {
+        ref_epi16 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(_mm_loadl_epi64((__m128i*)&(ref[y * ref_stride])), _mm_loadl_epi64((__m128i*)&(ref[(y + 1) * ref_stride]))));
+        rec_epi16 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(_mm_loadl_epi64((__m128i*)&(rec[y * rec_stride])), _mm_loadl_epi64((__m128i*)&(rec[(y + 1) * rec_stride]))));
+        diff = _mm256_sub_epi16(ref_epi16, rec_epi16);
+        ssd_part = _mm256_add_epi32(ssd_part, _mm256_madd_epi16(diff, diff));
+      }
+    } else {
+      // Wide blocks, including the Nx1 and Nx2 ISP partitions.
+      for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; x += 16) {
+          ref_epi16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)&(ref[x + y * ref_stride])));
+          rec_epi16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)&(rec[x + y * rec_stride])));
+          diff = _mm256_sub_epi16(ref_epi16, rec_epi16);
+          ssd_part = _mm256_add_epi32(ssd_part, _mm256_madd_epi16(diff, diff));
+        }
+      }
+    }
+
+    sum = _mm_add_epi32(_mm256_castsi256_si128(ssd_part), _mm256_extracti128_si256(ssd_part, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(0, 1, 0, 1)));
+
+    ssd = _mm_cvtsi128_si32(sum);
+
+    return ssd >> (2*(UVG_BIT_DEPTH-8));
+  }
+
   switch (width) {
 
   case 4:
@@ -1729,6 +1891,49 @@ static double pixel_var_avx2(const uint8_t *buf, const uint32_t len)
 }
 #endif // !INACCURATE_VARIANCE_CALCULATION
 
+static void pixel_sums_4x4_avx2(const uint8_t *buf, const int stride, const int width, const int height, uint32_t *sums, uint32_t *sums_sq)
+{
+  const int blocks_per_row = width >> 2;
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones_8 = _mm256_set1_epi8(1);
+  const __m256i ones_16 = _mm256_set1_epi16(1);
+
+  for (int y = 0; y < height; y += 4) {
+    uint32_t *sum_row = &sums[(y >> 2) * blocks_per_row];
+    uint32_t *sum_sq_row = &sums_sq[(y >> 2) * blocks_per_row];
+    int x = 0;
+    // Eight blocks at a time, each 32-bit lane holds one block.
+    for (; x + 32 <= width; x += 32) {
+      __m256i sum = zero;
+      __m256i sum_sq = zero;
+      for (int i = 0; i < 4; ++i) {
+        const __m256i row = _mm256_loadu_si256((const __m256i *)&buf[(y + i) * stride + x]);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(row, ones_8), ones_16));
+
+        const __m256i lo = _mm256_unpacklo_epi8(row, zero);
+        const __m256i hi = _mm256_unpackhi_epi8(row, zero);
+        // The in-lane unpack and hadd restore the original block order.
+        sum_sq = _mm256_add_epi32(sum_sq, _mm256_hadd_epi32(_mm256_madd_epi16(lo, lo), _mm256_madd_epi16(hi, hi)));
+      }
+      _mm256_storeu_si256((__m256i *)&sum_row[x >> 2], sum);
+      _mm256_storeu_si256((__m256i *)&sum_sq_row[x >> 2], sum_sq);
+    }
+    for (; x < width; x += 4) {
+      uint32_t sum = 0;
+      uint32_t sum_sq = 0;
+      for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+          const uint32_t px = buf[(y + i) * stride + x + j];
+          sum += px;
+          sum_sq += px * px;
+        }
+      }
+      sum_row[x >> 2] = sum;
+      sum_sq_row[x >> 2] = sum_sq;
+    }
+  }
+}
+
 
 static INLINE __m128i get_residual_4x1_avx2(const uint8_t* a_in, const uint8_t* b_in) {
   __m128i a = _mm_cvtsi32_si128(*(int32_t*)a_in);
@@ -1814,6 +2019,7 @@ int uvg_strategy_register_picture_avx2(void* opaque, uint8_t bitdepth)
     success &= uvg_strategyselector_register(opaque, "satd_32x32_dual", "avx2", 40, &satd_8bit_32x32_dual_avx2);
     success &= uvg_strategyselector_register(opaque, "satd_64x64_dual", "avx2", 40, &satd_8bit_64x64_dual_avx2);
     success &= uvg_strategyselector_register(opaque, "satd_any_size", "avx2", 40, &satd_any_size_8bit_avx2);
+    success &= uvg_strategyselector_register(opaque, "satd_any_size_uv", "avx2", 40, &satd_any_size_uv_8bit_avx2);
     success &= uvg_strategyselector_register(opaque, "satd_any_size_quad", "avx2", 40, &satd_any_size_quad_avx2);
 
     success &= uvg_strategyselector_register(opaque, "pixels_calc_ssd", "avx2", 40, &pixels_calc_ssd_avx2);
@@ -1823,6 +2029,7 @@ int uvg_strategy_register_picture_avx2(void* opaque, uint8_t bitdepth)
     success &= uvg_strategyselector_register(opaque, "hor_sad", "avx2", 40, &hor_sad_avx2);
 
     success &= uvg_strategyselector_register(opaque, "pixel_var", "avx2", 40, &pixel_var_avx2);
+    success &= uvg_strategyselector_register(opaque, "pixel_sums_4x4", "avx2", 40, &pixel_sums_4x4_avx2);
 
     success &= uvg_strategyselector_register(opaque, "generate_residual", "avx2", 0, &generate_residual_avx2);
 
@@ -0,0 +1,179 @@
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+#include "global.h"
+
+#include "strategies/avx2/reshape-avx2.h"
+
+#if COMPILE_INTEL_AVX2
+#include "uvg266.h"
+#if UVG_BIT_DEPTH == 8
+
+#include <immintrin.h>
+
+#include "strategies/generic/reshape-generic.h"
+#include "strategyselector.h"
+
+
+/**
+ * \brief Map 32 samples through a 256 entry lookup table.
+ *
+ * The table is split into two halves of 8 rows of 16 entries, and each row
+ * is stored XORed with the previous row of its half. Subtracting 16 from the
+ * samples for each row leaves the sign bit clear for the rows up to the row
+ * of the sample, so XORing the shuffles of those rows gives the entry of the
+ * sample. The sign bit of the sample selects the half.
+ */
+static INLINE __m256i map_32_samples(__m256i v, const __m256i lut_rows[16])
+{
+  const __m256i row_step = _mm256_set1_epi8(16);
+  __m256i idx = v;
+  __m256i lo_half = _mm256_shuffle_epi8(lut_rows[0], idx);
+  for (int row = 1; row < 8; ++row) {
+    idx = _mm256_sub_epi8(idx, row_step);
+    lo_half = _mm256_xor_si256(lo_half, _mm256_shuffle_epi8(lut_rows[row], idx));
+  }
+  idx = _mm256_sub_epi8(idx, row_step);
+  __m256i hi_half = _mm256_shuffle_epi8(lut_rows[8], idx);
+  for (int row = 9; row < 16; ++row) {
+    idx = _mm256_sub_epi8(idx, row_step);
+    hi_half = _mm256_xor_si256(hi_half, _mm256_shuffle_epi8(lut_rows[row], idx));
+  }
+  return _mm256_blendv_epi8(lo_half, hi_half, v);
+}
+
+static void lmcs_map_luma_avx2(const uvg_pixel *src,
+  int32_t src_stride,
+  uvg_pixel *dst,
+  int32_t dst_stride,
+  int width,
+  int height,
+  const uvg_pixel *lut)
+{
+  __m256i lut_rows[16];
+  for (int row = 0; row < 16; ++row) {
+    __m128i entries = _mm_loadu_si128((const __m128i *)&lut[row * 16]);
+    if (row % 8 != 0) {
+      entries = _mm_xor_si128(entries, _mm_loadu_si128((const __m128i *)&lut[(row - 1) * 16]));
+    }
+    lut_rows[row] = _mm256_broadcastsi128_si256(entries);
+  }
+
+  const int width_simd = width & ~31;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width_simd; x += 32) {
+      __m256i v = _mm256_loadu_si256((const __m256i *)&src[x]);
+      _mm256_storeu_si256((__m256i *)&dst[x], map_32_samples(v, lut_rows));
+    }
+    for (int x = width_simd; x < width; x++) {
+      dst[x] = lut[src[x]];
+    }
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
+
+/**
+ * \brief Divide the residual magnitudes by the chroma scale.
+ *
+ * The dividends fit in 24 bits, so the float quotient truncates to the same
+ * integer as the integer division.
+ */
+static void lmcs_scale_chroma_fwd_avx2(int16_t *residual, int count, int adj)
+{
+  const __m256i max_abs = _mm256_set1_epi16((1 << UVG_BIT_DEPTH) - 1);
+  const __m256i rounding = _mm256_set1_epi32(adj >> 1);
+  const __m256 divisor = _mm256_set1_ps((float)adj);
+
+  const int count_simd = count & ~15;
+  for (int i = 0; i < count_simd; i += 16) {
+    __m256i res = _mm256_loadu_si256((const __m256i *)&residual[i]);
+    __m256i abs_val = _mm256_abs_epi16(res);
+
+    __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(abs_val));
+    __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(abs_val, 1));
+    lo = _mm256_add_epi32(_mm256_slli_epi32(lo, CSCALE_FP_PREC), rounding);
+    hi = _mm256_add_epi32(_mm256_slli_epi32(hi, CSCALE_FP_PREC), rounding);
+    lo = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(lo), divisor));
+    hi = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(hi), divisor));
+
+    __m256i scaled = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+    scaled = _mm256_min_epi16(scaled, max_abs);
+    _mm256_storeu_si256((__m256i *)&residual[i], _mm256_sign_epi16(scaled, res));
+  }
+
+  uvg_lmcs_scale_chroma_fwd_generic(&residual[count_simd], count - count_simd, adj);
+}
+
+static void lmcs_scale_chroma_inv_avx2(int16_t *residual, int count, int adj)
+{
+  const __m256i max_val = _mm256_set1_epi16((1 << UVG_BIT_DEPTH) - 1);
+  const __m256i min_val = _mm256_set1_epi16(-(1 << UVG_BIT_DEPTH));
+  const __m256i rounding = _mm256_set1_epi32(1 << (CSCALE_FP_PREC - 1));
+  const __m256i scale = _mm256_set1_epi32(adj);
+
+  const int count_simd = count & ~15;
+  for (int i = 0; i < count_simd; i += 16) {
+    __m256i res = _mm256_loadu_si256((const __m256i *)&residual[i]);
+    res = _mm256_min_epi16(_mm256_max_epi16(res, min_val), max_val);
+    __m256i abs_val = _mm256_abs_epi16(res);
+
+    __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(abs_val));
+    __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(abs_val, 1));
+    lo = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(lo, scale), rounding), CSCALE_FP_PREC);
+    hi = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(hi, scale), rounding), CSCALE_FP_PREC);
+
+    __m256i scaled = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256((__m256i *)&residual[i], _mm256_sign_epi16(scaled, res));
+  }
+
+  uvg_lmcs_scale_chroma_inv_generic(&residual[count_simd], count - count_simd, adj);
+}
+
+#endif // UVG_BIT_DEPTH == 8
+#endif // COMPILE_INTEL_AVX2
+
+
+int uvg_strategy_register_reshape_avx2(void* opaque, uint8_t bitdepth)
+{
+  bool success = true;
+#if COMPILE_INTEL_AVX2
+#if UVG_BIT_DEPTH == 8
+  if (bitdepth == 8) {
+    success &= uvg_strategyselector_register(opaque, "lmcs_map_luma", "avx2", 40, &lmcs_map_luma_avx2);
+    success &= uvg_strategyselector_register(opaque, "lmcs_scale_chroma_fwd", "avx2", 40, &lmcs_scale_chroma_fwd_avx2);
+    success &= uvg_strategyselector_register(opaque, "lmcs_scale_chroma_inv", "avx2", 40, &lmcs_scale_chroma_inv_avx2);
+  }
+#endif // UVG_BIT_DEPTH == 8
+#endif // COMPILE_INTEL_AVX2
+  return success;
+}
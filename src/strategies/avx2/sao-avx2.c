@@ -38,8 +38,6 @@
 #include <immintrin.h>
 #include <nmmintrin.h>
 
-// Use a couple generic functions from here as a worst-case fallback
-#include "strategies/generic/sao_shared_generics.h"
 #include "strategies/avx2/avx2_common_functions.h"
 #include "strategies/missing-intel-intrinsics.h"
 #include "cu.h"
@@ -84,18 +82,6 @@ static __m256i FIX_W32 calc_eo_cat(const __m256i a,
   return                     _mm256_shuffle_epi8(idx_to_cat, eo_idx);
 }
 
-static INLINE __m256i srli_epi8(const __m256i  v,
-                                const uint32_t shift)
-{
-  const uint8_t hibit_mask     = 0xff >> shift;
-  const __m256i hibit_mask_256 = _mm256_set1_epi8(hibit_mask);
-
-  __m256i v_shifted = _mm256_srli_epi32(v,         shift);
-  __m256i v_masked  = _mm256_and_si256 (v_shifted, hibit_mask_256);
-
-  return v_masked;
-}
-
 static INLINE void cvt_epu8_epi16(const __m256i  v,
                                         __m256i *res_lo,
                                         __m256i *res_hi)
@@ -105,30 +91,6 @@ static INLINE void cvt_epu8_epi16(const __m256i  v,
              *res_hi  = _mm256_unpackhi_epi8(v, zero);
 }
 
-static INLINE void cvt_epi8_epi16(const __m256i  v,
-                                        __m256i *res_lo,
-                                        __m256i *res_hi)
-{
-  const __m256i zero  = _mm256_setzero_si256();
-        __m256i signs = _mm256_cmpgt_epi8   (zero, v);
-             *res_lo  = _mm256_unpacklo_epi8(v,    signs);
-             *res_hi  = _mm256_unpackhi_epi8(v,    signs);
-}
-
-static INLINE void diff_epi8_epi16(const __m256i  a,
-                                   const __m256i  b,
-                                         __m256i *res_lo,
-                                         __m256i *res_hi)
-{
-  const __m256i invmask = _mm256_set1_epi16(0xff01);
-
-  __m256i composite_lo  = _mm256_unpacklo_epi8(a, b);
-  __m256i composite_hi  = _mm256_unpackhi_epi8(a, b);
-
-         *res_lo        = _mm256_maddubs_epi16(composite_lo, invmask);
-         *res_hi        = _mm256_maddubs_epi16(composite_hi, invmask);
-}
-
 // Convert a byte-addressed mask for VPSHUFB into two word-addressed ones, for
 // example:
 // 7 3 6 2 5 1 4 0 => e f 6 7 c d 4 5 a b 2 3 8 9 0 1
@@ -151,28 +113,6 @@ static INLINE void cvt_shufmask_epi8_epi16(const __m256i  v,
           *res_hi    = _mm256_unpackhi_epi8(v_lobytes, v_hibytes);
 }
 
-// Check if all 4 dwords of v are in [-128, 127] and can be truncated to
-// 8 bits each. Returns -1 if everything is fine
-static INLINE uint16_t epi32v_fits_in_epi8s(const __m128i v)
-{
-  // Compare most significant 25 bits of SAO bands to the sign bit to assert
-  // that the i32's are between -128 and 127 (only comparing 24 would fail to
-  // detect values of 128...255)
-  __m128i  v_ms25b = _mm_srai_epi32   (v,  7);
-  __m128i  v_signs = _mm_srai_epi32   (v, 31);
-  __m128i  ok_i32s = _mm_cmpeq_epi32  (v_ms25b, v_signs);
-  return             _mm_movemask_epi8(ok_i32s);
-}
-
-static INLINE __m128i truncate_epi32_epi8(const __m128i v)
-{
-  // LSBs of each dword, the values values must fit in 8 bits anyway for
-  // what this intended for (use epi32v_fits_in_epi8s to check if needed)
-  const __m128i trunc_shufmask = _mm_set1_epi32  (0x0c080400);
-        __m128i sbs_8          = _mm_shuffle_epi8(v, trunc_shufmask);
-  return        sbs_8;
-}
-
 // Read 0-3 bytes (pixels) into uint32_t
 static INLINE uint32_t load_border_bytes(const uint8_t *buf,
                                          const int32_t  start_pos,
@@ -219,219 +159,72 @@ static INLINE __m256i broadcast_xmm2ymm(const __m128i v)
   return        _mm256_inserti128_si256(res, v, 1);
 }
 
-// Used for edge_ddistortion and band_ddistortion
-static __m256i FIX_W32 calc_diff_off_delta(const __m256i diff_lo,
-                                           const __m256i diff_hi,
-                                           const __m256i offsets,
-                                           const __m256i orig)
-{
-  const __m256i zero          = _mm256_setzero_si256();
-  const __m256i negate_hiword = _mm256_set1_epi32(0xffff0001);
-
-  __m256i orig_lo, orig_hi, offsets_lo, offsets_hi;
-
-  cvt_epu8_epi16(orig,    &orig_lo,    &orig_hi);
-  cvt_epi8_epi16(offsets, &offsets_lo, &offsets_hi);
-
-  __m256i offsets_0_lo = _mm256_cmpeq_epi16   (offsets_lo,   zero);
-  __m256i offsets_0_hi = _mm256_cmpeq_epi16   (offsets_hi,   zero);
-
-  __m256i delta_lo     = _mm256_sub_epi16     (diff_lo,      offsets_lo);
-  __m256i delta_hi     = _mm256_sub_epi16     (diff_hi,      offsets_hi);
-
-  __m256i diff_lo_m    = _mm256_andnot_si256  (offsets_0_lo, diff_lo);
-  __m256i diff_hi_m    = _mm256_andnot_si256  (offsets_0_hi, diff_hi);
-  __m256i delta_lo_m   = _mm256_andnot_si256  (offsets_0_lo, delta_lo);
-  __m256i delta_hi_m   = _mm256_andnot_si256  (offsets_0_hi, delta_hi);
-
-  __m256i dd0_lo       = _mm256_unpacklo_epi16(delta_lo_m,   diff_lo_m);
-  __m256i dd0_hi       = _mm256_unpackhi_epi16(delta_lo_m,   diff_lo_m);
-  __m256i dd1_lo       = _mm256_unpacklo_epi16(delta_hi_m,   diff_hi_m);
-  __m256i dd1_hi       = _mm256_unpackhi_epi16(delta_hi_m,   diff_hi_m);
-
-  __m256i dd0_lo_n     = _mm256_sign_epi16    (dd0_lo,       negate_hiword);
-  __m256i dd0_hi_n     = _mm256_sign_epi16    (dd0_hi,       negate_hiword);
-  __m256i dd1_lo_n     = _mm256_sign_epi16    (dd1_lo,       negate_hiword);
-  __m256i dd1_hi_n     = _mm256_sign_epi16    (dd1_hi,       negate_hiword);
-
-  __m256i sum0_lo      = _mm256_madd_epi16    (dd0_lo,       dd0_lo_n);
-  __m256i sum0_hi      = _mm256_madd_epi16    (dd0_hi,       dd0_hi_n);
-  __m256i sum1_lo      = _mm256_madd_epi16    (dd1_lo,       dd1_lo_n);
-  __m256i sum1_hi      = _mm256_madd_epi16    (dd1_hi,       dd1_hi_n);
-
-  __m256i sum0         = _mm256_add_epi32     (sum0_lo,      sum0_hi);
-  __m256i sum1         = _mm256_add_epi32     (sum1_lo,      sum1_hi);
-  return                 _mm256_add_epi32     (sum0,         sum1);
-}
-
-static INLINE __m256i FIX_W32 do_one_edge_ymm(const __m256i a,
-                                              const __m256i b,
-                                              const __m256i c,
-                                              const __m256i orig,
-                                              const __m256i badbyte_mask,
-                                              const __m256i offsets_256)
+// Load the samples from curr_pos to the end of the row, which is less than
+// 32 samples wide, with the rest of the bytes zeroed
+static INLINE __m256i load_row_rest(const uint8_t *buf,
+                                    const int32_t  curr_pos,
+                                    const int32_t  rest_pos,
+                                    const int32_t  width_rest,
+                                    const __m256i  db4_mask)
 {
-  __m256i eo_cat = calc_eo_cat(a, b, c);
-          eo_cat = _mm256_or_si256    (eo_cat,      badbyte_mask);
-  __m256i offset = _mm256_shuffle_epi8(offsets_256, eo_cat);
-
-  __m256i offset_lo, offset_hi;
-  cvt_epi8_epi16(offset, &offset_lo, &offset_hi);
-
-  __m256i diff_lo, diff_hi;
-  diff_epi8_epi16(orig, c, &diff_lo, &diff_hi);
-
-  return calc_diff_off_delta(diff_lo, diff_hi, offset, orig);
+  uint32_t last = load_border_bytes(buf, rest_pos, width_rest);
+  __m256i  v    = _mm256_maskload_epi32((const int32_t *)(buf + curr_pos), db4_mask);
+  return          _mm256_insert_epi32  (v, last, 7);
 }
 
-static int32_t sao_edge_ddistortion_avx2(const uint8_t *orig_data,
-                                         const uint8_t *rec_data,
-                                               int32_t  block_width,
-                                               int32_t  block_height,
-                                               int32_t  eo_class,
-                                         const int32_t  offsets[NUM_SAO_EDGE_CATEGORIES])
+// Accumulate the statistics of all edge classes for 32 samples. Only the
+// categories 1-4 are counted, category 0 gets what is left of the totals.
+// The sums are accumulated as 64-bit and the counts as 8-bit values.
+static INLINE void calc_stats_one_ymm(const __m256i  a[SAO_NUM_EO],
+                                      const __m256i  b[SAO_NUM_EO],
+                                      const __m256i  c,
+                                      const __m256i  orig,
+                                      const __m256i  badbyte_mask,
+                                            __m256i *total_accum,
+                                            __m256i  diff_accum[SAO_NUM_EO][NUM_SAO_EDGE_CATEGORIES],
+                                            __m256i  cnt_accum[SAO_NUM_EO][NUM_SAO_EDGE_CATEGORIES])
 {
-  uint32_t y, x;
-  vector2d_t a_ofs = g_sao_edge_offsets[eo_class][0];
-  vector2d_t b_ofs = g_sao_edge_offsets[eo_class][1];
-
-  uint32_t scan_width = block_width -   2;
-  uint32_t width_db32 = scan_width  & ~31;
-  uint32_t width_db4  = scan_width  &  ~3;
-  uint32_t width_rest = scan_width  &   3;
-
-  // Form the load&store mask
-  const __m256i wdb4_256      = _mm256_set1_epi32 (width_db4 & 31);
-  const __m256i indexes       = _mm256_setr_epi32 (3, 7, 11, 15, 19, 23, 27, 31);
-  const __m256i db4_mask      = _mm256_cmpgt_epi32(wdb4_256, indexes);
-
-  const __m256i zero          = _mm256_setzero_si256();
-
-  __m128i offsets03 = _mm_loadu_si128((const __m128i *)offsets);
-  __m128i offsets4  = _mm_cvtsi32_si128(offsets[4]);
-
-  uint16_t offsets_ok = epi32v_fits_in_epi8s(offsets03) &
-                        epi32v_fits_in_epi8s(offsets4);
-
-  assert(NUM_SAO_EDGE_CATEGORIES == 5);
-
-  if (offsets_ok != 0xffff) {
-    return sao_edge_ddistortion_generic(orig_data,
-                                        rec_data,
-                                        block_width,
-                                        block_height,
-                                        eo_class,
-                                        offsets);
-  }
-
-  __m128i offsets03_8b = truncate_epi32_epi8(offsets03);
-  __m128i offsets4_8b  = truncate_epi32_epi8(offsets4);
-  __m128i offsets_8b   = _mm_unpacklo_epi32 (offsets03_8b, offsets4_8b);
-  __m256i offsets_256  = broadcast_xmm2ymm  (offsets_8b);
-
-  __m256i sum = _mm256_setzero_si256();
-  for (y = 1; y < (uint32_t)block_height - 1; y++) {
-    for (x = 1; x < width_db32 + 1; x += 32) {
-      uint32_t c_pos =  y            * block_width + x;
-      uint32_t a_pos = (y + a_ofs.y) * block_width + x + a_ofs.x;
-      uint32_t b_pos = (y + b_ofs.y) * block_width + x + b_ofs.x;
-
-      __m256i a      = _mm256_loadu_si256((const __m256i *)(rec_data  + a_pos));
-      __m256i b      = _mm256_loadu_si256((const __m256i *)(rec_data  + b_pos));
-      __m256i c      = _mm256_loadu_si256((const __m256i *)(rec_data  + c_pos));
-      __m256i orig   = _mm256_loadu_si256((const __m256i *)(orig_data + c_pos));
-
-      __m256i curr   = do_one_edge_ymm(a, b, c, orig, zero, offsets_256);
-              sum    = _mm256_add_epi32(sum, curr);
-    }
-    if (scan_width > width_db32) {
-      const uint32_t curr_cpos   =  y            * block_width + x;
-      const uint32_t rest_cpos   =  y            * block_width + width_db4 + 1;
-
-      const  int32_t curr_apos   = (y + a_ofs.y) * block_width + x + a_ofs.x;
-      const  int32_t rest_apos   = (y + a_ofs.y) * block_width + width_db4 + a_ofs.x + 1;
-
-      const  int32_t curr_bpos   = (y + b_ofs.y) * block_width + x + b_ofs.x;
-      const  int32_t rest_bpos   = (y + b_ofs.y) * block_width + width_db4 + b_ofs.x + 1;
-
-      // Same trick to read a narrow line as there is in the band SAO routine
-      uint32_t a_last         = load_border_bytes(rec_data,  rest_apos, width_rest);
-      uint32_t b_last         = load_border_bytes(rec_data,  rest_bpos, width_rest);
-      uint32_t c_last         = load_border_bytes(rec_data,  rest_cpos, width_rest);
-      uint32_t orig_last      = load_border_bytes(orig_data, rest_cpos, width_rest);
+  const __m256i zero = _mm256_setzero_si256();
 
-      const int32_t *a_ptr    = (const int32_t *)(rec_data  + curr_apos);
-      const int32_t *b_ptr    = (const int32_t *)(rec_data  + curr_bpos);
-      const int32_t *c_ptr    = (const int32_t *)(rec_data  + curr_cpos);
-      const int32_t *orig_ptr = (const int32_t *)(orig_data + curr_cpos);
+  __m256i orig_sum = _mm256_sad_epu8 (orig,         zero);
+  __m256i c_sum    = _mm256_sad_epu8 (c,            zero);
+  *total_accum     = _mm256_add_epi64(*total_accum, _mm256_sub_epi64(orig_sum, c_sum));
 
-      __m256i a    = _mm256_maskload_epi32(a_ptr,    db4_mask);
-      __m256i b    = _mm256_maskload_epi32(b_ptr,    db4_mask);
-      __m256i c    = _mm256_maskload_epi32(c_ptr,    db4_mask);
-      __m256i orig = _mm256_maskload_epi32(orig_ptr, db4_mask);
+  for (int32_t eo_class = SAO_EO0; eo_class < SAO_NUM_EO; eo_class++) {
+    __m256i eo_cat = calc_eo_cat    (a[eo_class], b[eo_class], c);
+            eo_cat = _mm256_or_si256(eo_cat,      badbyte_mask);
 
-              a    = _mm256_insert_epi32  (a,        a_last,    7);
-              b    = _mm256_insert_epi32  (b,        b_last,    7);
-              c    = _mm256_insert_epi32  (c,        c_last,    7);
-              orig = _mm256_insert_epi32  (orig,     orig_last, 7);
+    for (int32_t i = SAO_EO_CAT1; i < NUM_SAO_EDGE_CATEGORIES; i++) {
+      __m256i curr_id  = _mm256_set1_epi8 (i);
+      __m256i eoc_mask = _mm256_cmpeq_epi8(eo_cat,   curr_id);
 
-      // Mask all unused bytes to 0xFF, so they won't count anywhere
-      __m256i badbyte_mask = gen_badbyte_mask(db4_mask, width_rest);
+      __m256i eoc_orig = _mm256_and_si256 (orig,     eoc_mask);
+      __m256i eoc_c    = _mm256_and_si256 (c,        eoc_mask);
+      __m256i eoc_diff = _mm256_sub_epi64 (_mm256_sad_epu8(eoc_orig, zero),
+                                           _mm256_sad_epu8(eoc_c,    zero));
 
-      __m256i curr  = do_one_edge_ymm(a, b, c, orig, badbyte_mask, offsets_256);
-              sum   = _mm256_add_epi32(sum, curr);
+      diff_accum[eo_class][i] = _mm256_add_epi64(diff_accum[eo_class][i], eoc_diff);
+      cnt_accum[eo_class][i]  = _mm256_sub_epi8 (cnt_accum[eo_class][i],  eoc_mask);
     }
   }
-  return hsum_8x32b(sum);
 }
 
-static void FIX_W32 calc_edge_dir_one_ymm(const __m256i  a,
-                                          const __m256i  b,
-                                          const __m256i  c,
-                                          const __m256i  orig,
-                                          const __m256i  badbyte_mask,
-                                                __m256i *diff_accum,
-                                                int32_t *hit_cnt)
+// Sum the four 64-bit lanes
+static INLINE int32_t hsum_4x64b(const __m256i v)
 {
-  const __m256i ones_16 = _mm256_set1_epi16(1);
-        __m256i eo_cat  = calc_eo_cat      (a, b, c);
-                eo_cat  = _mm256_or_si256  (eo_cat, badbyte_mask);
-
-  __m256i diffs_lo, diffs_hi;
-  diff_epi8_epi16(orig, c, &diffs_lo, &diffs_hi);
-
-  for (uint32_t i = 0; i < 5; i++) {
-    __m256i  curr_id       = _mm256_set1_epi8    (i);
-    __m256i  eoc_mask      = _mm256_cmpeq_epi8   (eo_cat, curr_id);
-    uint32_t eoc_bits      = _mm256_movemask_epi8(eoc_mask);
-    uint32_t eoc_hits      = _mm_popcnt_u32      (eoc_bits);
-
-    __m256i  eoc_mask_lo   = _mm256_unpacklo_epi8(eoc_mask,      eoc_mask);
-    __m256i  eoc_mask_hi   = _mm256_unpackhi_epi8(eoc_mask,      eoc_mask);
-
-    __m256i  eoc_diffs_lo  = _mm256_and_si256    (diffs_lo,      eoc_mask_lo);
-    __m256i  eoc_diffs_hi  = _mm256_and_si256    (diffs_hi,      eoc_mask_hi);
-
-    __m256i  eoc_diffs_16  = _mm256_add_epi16    (eoc_diffs_lo,  eoc_diffs_hi);
-    __m256i  eoc_diffs_32  = _mm256_madd_epi16   (eoc_diffs_16,  ones_16);
-
-             diff_accum[i] = _mm256_add_epi32    (diff_accum[i], eoc_diffs_32);
-             hit_cnt[i]   += eoc_hits;
-  }
+  __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+          sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+  return (int32_t)_mm_cvtsi128_si64(sum);
 }
 
-static void calc_sao_edge_dir_avx2(const uint8_t *orig_data,
-                                   const uint8_t *rec_data,
-                                         int32_t  eo_class,
-                                         int32_t  block_width,
-                                         int32_t  block_height,
-                                         int32_t  cat_sum_cnt[2][NUM_SAO_EDGE_CATEGORIES])
+static void calc_sao_stats_avx2(const uint8_t     *orig_data,
+                                const uint8_t     *rec_data,
+                                      int32_t      block_width,
+                                      int32_t      block_height,
+                                      int32_t      bitdepth,
+                                      sao_stats_t *stats)
 {
-  vector2d_t a_ofs = g_sao_edge_offsets[eo_class][0];
-  vector2d_t b_ofs = g_sao_edge_offsets[eo_class][1];
-
-  int32_t *diff_sum   = cat_sum_cnt[0];
-  int32_t *hit_cnt    = cat_sum_cnt[1];
+  const int32_t shift = bitdepth - 5;
 
   int32_t scan_width  = block_width -   2;
   int32_t width_db32  = scan_width  & ~31;
@@ -444,61 +237,105 @@ static void calc_sao_edge_dir_avx2(const uint8_t *orig_data,
   const __m256i wdb4_256      = _mm256_set1_epi32 (width_db4 & 31);
   const __m256i indexes       = _mm256_setr_epi32 (3, 7, 11, 15, 19, 23, 27, 31);
   const __m256i db4_mask      = _mm256_cmpgt_epi32(wdb4_256, indexes);
+  const __m256i badbyte_mask  = gen_badbyte_mask  (db4_mask, width_rest);
 
-  __m256i diff_accum[5] = { _mm256_setzero_si256() };
+  int32_t offsets[SAO_NUM_EO][2];
+  for (int32_t eo_class = SAO_EO0; eo_class < SAO_NUM_EO; eo_class++) {
+    offsets[eo_class][0] = g_sao_edge_offsets[eo_class][0].y * block_width + g_sao_edge_offsets[eo_class][0].x;
+    offsets[eo_class][1] = g_sao_edge_offsets[eo_class][1].y * block_width + g_sao_edge_offsets[eo_class][1].x;
+  }
 
-  int32_t y, x;
-  for (y = 1; y < block_height - 1; y++) {
-    for (x = 1; x < width_db32 + 1; x += 32) {
-      const uint32_t a_off = (y + a_ofs.y) * block_width + x + a_ofs.x;
-      const uint32_t b_off = (y + b_ofs.y) * block_width + x + b_ofs.x;
-      const uint32_t c_off =  y            * block_width + x;
+  int32_t band_sum[32] = { 0 };
+  int32_t band_cnt[32] = { 0 };
+
+  // Each byte of the counts gets at most one sample from each of the 32
+  // sample wide vectors of the block, which the LCU size keeps below 256.
+  assert(block_width <= LCU_WIDTH && block_height <= LCU_WIDTH);
 
-      __m256i a      = _mm256_loadu_si256((const __m256i *)(rec_data  + a_off));
-      __m256i b      = _mm256_loadu_si256((const __m256i *)(rec_data  + b_off));
-      __m256i c      = _mm256_loadu_si256((const __m256i *)(rec_data  + c_off));
-      __m256i orig   = _mm256_loadu_si256((const __m256i *)(orig_data + c_off));
+  __m256i total_accum = _mm256_setzero_si256();
+  __m256i diff_accum[SAO_NUM_EO][NUM_SAO_EDGE_CATEGORIES];
+  __m256i cnt_accum [SAO_NUM_EO][NUM_SAO_EDGE_CATEGORIES];
+  memset(diff_accum, 0, sizeof(diff_accum));
+  memset(cnt_accum,  0, sizeof(cnt_accum));
 
-      calc_edge_dir_one_ymm(a, b, c, orig, zero, diff_accum, hit_cnt);
+  for (int32_t y = 0; y < block_height; y++) {
+    const uint8_t *orig_row = orig_data + y * block_width;
+    const uint8_t *rec_row  = rec_data  + y * block_width;
+
+    // The band of each sample is looked up one by one, the row is in the
+    // cache for the edge classes anyway.
+    for (int32_t x = 0; x < block_width; x++) {
+      const uint8_t band = rec_row[x] >> shift;
+      band_sum[band] += orig_row[x] - rec_row[x];
+      band_cnt[band] += 1;
     }
-    if (scan_width > width_db32) {
-      const uint32_t curr_cpos   =  y            * block_width + x;
-      const uint32_t rest_cpos   =  y            * block_width + width_db4 + 1;
 
-      const  int32_t curr_apos   = (y + a_ofs.y) * block_width + x + a_ofs.x;
-      const  int32_t rest_apos   = (y + a_ofs.y) * block_width + width_db4 + a_ofs.x + 1;
+    if (y == 0 || y == block_height - 1 || scan_width <= 0) {
+      continue;
+    }
 
-      const  int32_t curr_bpos   = (y + b_ofs.y) * block_width + x + b_ofs.x;
-      const  int32_t rest_bpos   = (y + b_ofs.y) * block_width + width_db4 + b_ofs.x + 1;
+    __m256i a[SAO_NUM_EO];
+    __m256i b[SAO_NUM_EO];
 
-            uint32_t a_last      = load_border_bytes(rec_data,  rest_apos, width_rest);
-            uint32_t b_last      = load_border_bytes(rec_data,  rest_bpos, width_rest);
-            uint32_t c_last      = load_border_bytes(rec_data,  rest_cpos, width_rest);
-            uint32_t orig_last   = load_border_bytes(orig_data, rest_cpos, width_rest);
+    int32_t x;
+    for (x = 1; x < width_db32 + 1; x += 32) {
+      const int32_t c_off = y * block_width + x;
 
-      const int32_t *a_ptr       = (const int32_t *)(rec_data  + curr_apos);
-      const int32_t *b_ptr       = (const int32_t *)(rec_data  + curr_bpos);
-      const int32_t *c_ptr       = (const int32_t *)(rec_data  + curr_cpos);
-      const int32_t *orig_ptr    = (const int32_t *)(orig_data + curr_cpos);
+      __m256i c    = _mm256_loadu_si256((const __m256i *)(rec_data  + c_off));
+      __m256i orig = _mm256_loadu_si256((const __m256i *)(orig_data + c_off));
 
-      __m256i a    = _mm256_maskload_epi32(a_ptr,    db4_mask);
-      __m256i b    = _mm256_maskload_epi32(b_ptr,    db4_mask);
-      __m256i c    = _mm256_maskload_epi32(c_ptr,    db4_mask);
-      __m256i orig = _mm256_maskload_epi32(orig_ptr, db4_mask);
+      for (int32_t eo_class = SAO_EO0; eo_class < SAO_NUM_EO; eo_class++) {
+        a[eo_class] = _mm256_loadu_si256((const __m256i *)(rec_data + c_off + offsets[eo_class][0]));
+        b[eo_class] = _mm256_loadu_si256((const __m256i *)(rec_data + c_off + offsets[eo_class][1]));
+      }
 
-              a    = _mm256_insert_epi32  (a,        a_last,    7);
-              b    = _mm256_insert_epi32  (b,        b_last,    7);
-              c    = _mm256_insert_epi32  (c,        c_last,    7);
-              orig = _mm256_insert_epi32  (orig,     orig_last, 7);
+      calc_stats_one_ymm(a, b, c, orig, zero, &total_accum, diff_accum, cnt_accum);
+    }
+    if (scan_width > width_db32) {
+      const int32_t curr_cpos = y * block_width + x;
+      const int32_t rest_cpos = y * block_width + width_db4 + 1;
 
-      __m256i badbyte_mask = gen_badbyte_mask(db4_mask, width_rest);
+      __m256i c    = load_row_rest(rec_data,  curr_cpos, rest_cpos, width_rest, db4_mask);
+      __m256i orig = load_row_rest(orig_data, curr_cpos, rest_cpos, width_rest, db4_mask);
 
-      calc_edge_dir_one_ymm(a, b, c, orig, badbyte_mask, diff_accum, hit_cnt);
+      for (int32_t eo_class = SAO_EO0; eo_class < SAO_NUM_EO; eo_class++) {
+        const int32_t a_delta = offsets[eo_class][0];
+        const int32_t b_delta = offsets[eo_class][1];
+
+        a[eo_class] = load_row_rest(rec_data, curr_cpos + a_delta, rest_cpos + a_delta, width_rest, db4_mask);
+        b[eo_class] = load_row_rest(rec_data, curr_cpos + b_delta, rest_cpos + b_delta, width_rest, db4_mask);
+      }
+
+      calc_stats_one_ymm(a, b, c, orig, badbyte_mask, &total_accum, diff_accum, cnt_accum);
     }
   }
-  for (uint32_t i = 0; i < 5; i++) {
-    int32_t sum = hsum_8x32b(diff_accum[i]);
-    diff_sum[i] += sum;
+
+  for (int32_t band = 0; band < 32; band++) {
+    stats->band[0][band] += band_sum[band];
+    stats->band[1][band] += band_cnt[band];
+  }
+
+  if (block_width < 3 || block_height < 3) {
+    return;
+  }
+
+  // Category 0 has the samples that are not in any of the other categories.
+  const int32_t total_diff = hsum_4x64b(total_accum);
+  const int32_t total_cnt  = (block_width - 2) * (block_height - 2);
+
+  for (int32_t eo_class = SAO_EO0; eo_class < SAO_NUM_EO; eo_class++) {
+    int32_t cat0_diff = total_diff;
+    int32_t cat0_cnt  = total_cnt;
+    for (int32_t i = SAO_EO_CAT1; i < NUM_SAO_EDGE_CATEGORIES; i++) {
+      const int32_t diff = hsum_4x64b(diff_accum[eo_class][i]);
+      const int32_t cnt  = hsum_4x64b(_mm256_sad_epu8(cnt_accum[eo_class][i], zero));
+      stats->edge[eo_class][0][i] += diff;
+      stats->edge[eo_class][1][i] += cnt;
+      cat0_diff -= diff;
+      cat0_cnt  -= cnt;
+    }
+    stats->edge[eo_class][0][SAO_EO_CAT0] += cat0_diff;
+    stats->edge[eo_class][1][SAO_EO_CAT0] += cat0_cnt;
   }
 }
 
@@ -813,90 +650,6 @@ static void sao_reconstruct_color_avx2(const encoder_control_t *encoder,
   }
 }
 
-static int32_t sao_band_ddistortion_avx2(const encoder_state_t *state,
-                                         const uint8_t         *orig_data,
-                                         const uint8_t         *rec_data,
-                                               int32_t          block_width,
-                                               int32_t          block_height,
-                                               int32_t          band_pos,
-                                         const int32_t          sao_bands[4])
-{
-  const uint32_t bitdepth = 8;
-  const uint32_t shift    = bitdepth - 5;
-
-  // Clamp band_pos to 32 from above. It'll be subtracted from the shifted
-  // rec_data values, which in 8-bit depth will always be clamped to [0, 31],
-  // so if it ever exceeds 32, all the band values will be negative and
-  // ignored. Ditto for less than -4.
-  __m128i bp_128   = _mm_cvtsi32_si128    (band_pos);
-  __m128i hilimit  = _mm_cvtsi32_si128    (32);
-  __m128i lolimit  = _mm_cvtsi32_si128    (-4);
-
-          bp_128   = _mm_min_epi8         (bp_128, hilimit);
-          bp_128   = _mm_max_epi8         (bp_128, lolimit);
-
-  __m256i bp_256  = _mm256_broadcastb_epi8(bp_128);
-
-  __m128i sbs_32   = _mm_loadu_si128((const __m128i *)sao_bands);
-  __m128i sbs_8    = truncate_epi32_epi8(sbs_32);
-  __m256i sb_256   = broadcast_xmm2ymm  (sbs_8);
-
-  // These should trigger like, never, at least the later condition of block
-  // not being a multiple of 32 wide. Rather safe than sorry though, huge SAO
-  // bands are more tricky of these two because the algorithm needs a complete
-  // reimplementation to work on 16-bit values.
-  if (epi32v_fits_in_epi8s(sbs_32) != 0xffff)
-    goto use_generic;
-
-  // If VVC or something will start using SAO on blocks with width a multiple
-  // of 16, feel free to implement a XMM variant of this algorithm
-  if ((block_width & 31) != 0)
-    goto use_generic;
-
-  const __m256i zero          = _mm256_setzero_si256();
-  const __m256i threes        = _mm256_set1_epi8 (3);
-
-  __m256i sum = _mm256_setzero_si256();
-  for (int32_t y = 0; y < block_height; y++) {
-    for (int32_t x = 0; x < block_width; x += 32) {
-      const int32_t curr_pos = y * block_width + x;
-
-      __m256i   rd = _mm256_loadu_si256((const __m256i *)( rec_data + curr_pos));
-      __m256i orig = _mm256_loadu_si256((const __m256i *)(orig_data + curr_pos));
-
-      __m256i orig_lo, orig_hi, rd_lo, rd_hi;
-      cvt_epu8_epi16(orig, &orig_lo, &orig_hi);
-      cvt_epu8_epi16(rd,   &rd_lo,   &rd_hi);
-
-      __m256i diff_lo      = _mm256_sub_epi16     (orig_lo,      rd_lo);
-      __m256i diff_hi      = _mm256_sub_epi16     (orig_hi,      rd_hi);
-
-      // The shift will clamp band to 0...31; band_pos on the other
-      // hand is always between 0...32, so band will be -1...31. Anything
-      // below zero is ignored, so we can clamp band_pos to 32.
-      __m256i rd_divd      = srli_epi8           (rd,            shift);
-      __m256i band         = _mm256_sub_epi8     (rd_divd,       bp_256);
-
-      // Force all <0 or >3 bands to 0xff, which will zero the shuffle result
-      __m256i band_lt_0    = _mm256_cmpgt_epi8   (zero,          band);
-      __m256i band_gt_3    = _mm256_cmpgt_epi8   (band,          threes);
-      __m256i band_inv     = _mm256_or_si256     (band_lt_0,     band_gt_3);
-
-              band         = _mm256_or_si256     (band,          band_inv);
-
-      __m256i offsets      = _mm256_shuffle_epi8 (sb_256,        band);
-
-      __m256i curr_sum     = calc_diff_off_delta (diff_lo, diff_hi, offsets, orig);
-              sum          = _mm256_add_epi32    (sum,          curr_sum);
-    }
-  }
-  return hsum_8x32b(sum);
-
-use_generic:
-  return sao_band_ddistortion_generic(state, orig_data, rec_data, block_width,
-      block_height, band_pos, sao_bands);
-}
-
 #endif // UVG_BIT_DEPTH == 8
 #endif //COMPILE_INTEL_AVX2
 
@@ -906,10 +659,8 @@ int uvg_strategy_register_sao_avx2(void* opaque, uint8_t bitdepth)
 #if COMPILE_INTEL_AVX2
 #if UVG_BIT_DEPTH == 8
   if (bitdepth == 8) {
-    success &= uvg_strategyselector_register(opaque, "sao_edge_ddistortion", "avx2", 40, &sao_edge_ddistortion_avx2);
-    success &= uvg_strategyselector_register(opaque, "calc_sao_edge_dir", "avx2", 40, &calc_sao_edge_dir_avx2);
     success &= uvg_strategyselector_register(opaque, "sao_reconstruct_color", "avx2", 40, &sao_reconstruct_color_avx2);
-    success &= uvg_strategyselector_register(opaque, "sao_band_ddistortion", "avx2", 40, &sao_band_ddistortion_avx2);
+    success &= uvg_strategyselector_register(opaque, "calc_sao_stats", "avx2", 40, &calc_sao_stats_avx2);
   }
 #endif // UVG_BIT_DEPTH == 8
 #endif //COMPILE_INTEL_AVX2
@@ -47,6 +47,9 @@ static int16_t clip_alf(const int16_t clip, const int16_t ref, const int16_t val
 }
 
 static void alf_derive_classification_blk_generic(encoder_state_t * const state,
+  const uvg_pixel *src,
+  const int src_stride,
+  alf_classifier **classifier,
   const int shift,
   const int n_height,
   const int n_width,
@@ -57,7 +60,6 @@ static void alf_derive_classification_blk_generic(encoder_state_t * const state,
   const int vb_ctu_height,
   int vb_pos)
 {
-  videoframe_t* const frame = state->tile->frame;
   //int ***g_laplacian = state->tile->frame->alf_info->g_laplacian;
   //alf_classifier **g_classifier = state->tile->frame->alf_info->g_classifier;
   //CHECK((vb_ctu_height & (vb_ctu_height - 1)) != 0, "vb_ctu_height must be a power of 2");
@@ -65,10 +67,8 @@ static void alf_derive_classification_blk_generic(encoder_state_t * const state,
   static const int th[16] = { 0, 1, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3, 4 };
   int laplacian[NUM_DIRECTIONS][CLASSIFICATION_BLK_SIZE + 5][CLASSIFICATION_BLK_SIZE + 5];
   memset(laplacian, 0, sizeof(laplacian));
-  alf_classifier **classifier = state->tile->frame->alf_info->classifier;
 
-  const int stride = frame->rec->stride;
-  uvg_pixel *src = state->tile->frame->rec->y;
+  const int stride = src_stride;
   const int max_activity = 15;
 
   int fl = 2;
@@ -999,6 +999,150 @@ static void alf_get_blk_stats_generic(encoder_state_t* const state,
 }
 
 
+static void alf_filter_cc_blk_generic(uvg_pixel *chroma,
+  const int chroma_stride,
+  const uvg_pixel *luma,
+  const int luma_stride,
+  const int16_t *filter_coeff,
+  clp_rng clp_rng,
+  const int scale_x,
+  const int scale_y,
+  const int y_pos,
+  const int width,
+  const int height,
+  const int vb_ctu_height,
+  const int vb_pos)
+{
+  const int offset = 1 << clp_rng.bd >> 1;
+
+  for (int i = 0; i < height; i++)
+  {
+    uvg_pixel *src_self = chroma + i * chroma_stride;
+    const uvg_pixel *src_cross = luma + (i << scale_y) * luma_stride;
+
+    int offset1 = luma_stride;
+    int offset2 = -luma_stride;
+    int offset3 = 2 * luma_stride;
+
+    const int pos = ((y_pos + i) << scale_y) & (vb_ctu_height - 1);
+    if (scale_y == 0 && (pos == vb_pos || pos == vb_pos + 1))
+    {
+      continue;
+    }
+    if (pos == (vb_pos - 2) || pos == (vb_pos + 1))
+    {
+      offset3 = offset1;
+    }
+    else if (pos == (vb_pos - 1) || pos == vb_pos)
+    {
+      offset1 = 0;
+      offset2 = 0;
+      offset3 = 0;
+    }
+
+    for (int j = 0; j < width; j++)
+    {
+      const int j2 = j << scale_x;
+
+      int sum = 0;
+      const uvg_pixel curr_src_cross = src_cross[j2];
+      sum += filter_coeff[0] * (src_cross[offset2 + j2] - curr_src_cross);
+      sum += filter_coeff[1] * (src_cross[j2 - 1] - curr_src_cross);
+      sum += filter_coeff[2] * (src_cross[j2 + 1] - curr_src_cross);
+      sum += filter_coeff[3] * (src_cross[offset1 + j2 - 1] - curr_src_cross);
+      sum += filter_coeff[4] * (src_cross[offset1 + j2] - curr_src_cross);
+      sum += filter_coeff[5] * (src_cross[offset1 + j2 + 1] - curr_src_cross);
+      sum += filter_coeff[6] * (src_cross[offset3 + j2] - curr_src_cross);
+
+      sum = (sum + ((1 << 7/*m_scaleBits*/) >> 1)) >> 7/*m_scaleBits*/;
+      sum = uvg_fast_clip_32bit_to_pixel(sum + offset) - offset;
+      sum += src_self[j];
+      src_self[j] = uvg_fast_clip_32bit_to_pixel(sum);
+    }
+  }
+}
+
+static void alf_calc_covariance_cc_generic(int32_t e_local[MAX_NUM_CC_ALF_CHROMA_COEFF - 1],
+  const uvg_pixel *rec,
+  const int stride,
+  int vb_distance)
+{
+  const uvg_pixel *rec_y_m1 = rec - 1 * stride;
+  const uvg_pixel *rec_y_0 = rec;
+  const uvg_pixel *rec_y_p1 = rec + 1 * stride;
+  const uvg_pixel *rec_y_p2 = rec + 2 * stride;
+
+  if (vb_distance == -2 || vb_distance == +1)
+  {
+    rec_y_p2 = rec_y_p1;
+  }
+  else if (vb_distance == -1 || vb_distance == 0)
+  {
+    rec_y_m1 = rec_y_0;
+    rec_y_p2 = rec_y_p1 = rec_y_0;
+  }
+
+  const uvg_pixel center_value = rec_y_0[+0];
+  e_local[0] = rec_y_m1[+0] - center_value;
+  e_local[1] = rec_y_0[-1] - center_value;
+  e_local[2] = rec_y_0[+1] - center_value;
+  e_local[3] = rec_y_p1[-1] - center_value;
+  e_local[4] = rec_y_p1[+0] - center_value;
+  e_local[5] = rec_y_p1[+1] - center_value;
+  e_local[6] = rec_y_p2[+0] - center_value;
+}
+
+static void alf_get_blk_stats_cc_generic(alf_covariance *alf_covariance,
+  const uvg_pixel *org,
+  const int org_stride,
+  const uvg_pixel *rec,
+  const int rec_stride,
+  const uvg_pixel *rec_luma,
+  const int rec_luma_stride,
+  const int scale_x,
+  const int scale_y,
+  const int width,
+  const int height,
+  const int vb_ctu_height,
+  const int vb_pos)
+{
+  const int num_coeff = MAX_NUM_CC_ALF_CHROMA_COEFF - 1;
+  int32_t e_local[MAX_NUM_CC_ALF_CHROMA_COEFF - 1];
+
+  for (int i = 0; i < height; i++)
+  {
+    const int vb_distance = ((i << scale_y) % vb_ctu_height) - vb_pos;
+    const bool skip_this_row = (scale_y == 0 && (vb_distance == 0 || vb_distance == 1));
+    for (int j = 0; j < width && !skip_this_row; j++)
+    {
+      const int16_t y_local = org[j] - rec[j];
+      alf_calc_covariance_cc_generic(e_local, rec_luma + (j << scale_x), rec_luma_stride, vb_distance);
+
+      for (int k = 0; k < num_coeff; k++)
+      {
+        for (int l = k; l < num_coeff; l++)
+        {
+          alf_covariance->ee[k][l][0][0] += (int64_t)e_local[k] * e_local[l];
+        }
+        alf_covariance->y[k][0] += e_local[k] * y_local;
+      }
+      alf_covariance->pix_acc += y_local * (double)y_local;
+    }
+    org += org_stride;
+    rec += rec_stride;
+    rec_luma += rec_luma_stride << scale_y;
+  }
+
+  for (int k = 1; k < num_coeff; k++)
+  {
+    for (int l = 0; l < k; l++)
+    {
+      alf_covariance->ee[k][l][0][0] = alf_covariance->ee[l][k][0][0];
+    }
+  }
+}
+
+
 int uvg_strategy_register_alf_generic(void* opaque, uint8_t bitdepth)
 {
   bool success = true;
@@ -1007,6 +1151,8 @@ int uvg_strategy_register_alf_generic(void* opaque, uint8_t bitdepth)
   success &= uvg_strategyselector_register(opaque, "alf_filter_5x5_blk", "generic", 0, &alf_filter_5x5_block_generic);
   success &= uvg_strategyselector_register(opaque, "alf_filter_7x7_blk", "generic", 0, &alf_filter_7x7_block_generic);
   success &= uvg_strategyselector_register(opaque, "alf_get_blk_stats", "generic", 0, &alf_get_blk_stats_generic);
+  success &= uvg_strategyselector_register(opaque, "alf_filter_cc_blk", "generic", 0, &alf_filter_cc_blk_generic);
+  success &= uvg_strategyselector_register(opaque, "alf_get_blk_stats_cc", "generic", 0, &alf_get_blk_stats_cc_generic);
   
 
   return success;
@@ -0,0 +1,514 @@
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+#include "strategies/generic/filter-generic.h"
+
+#include <stdlib.h>
+
+#include "strategies/strategies-filter.h"
+#include "strategyselector.h"
+
+
+/**
+ * \brief Perform in strong luma filtering in place.
+ * \param line  line of 8 pixels, with center at index 4
+ * \param tc  tc treshold
+ * \return  Reach of the filter starting from center.
+ */
+static INLINE int uvg_filter_deblock_luma_strong(
+    uvg_pixel *line,
+    int32_t tc)
+{
+  const uvg_pixel m0 = line[0];
+  const uvg_pixel m1 = line[1];
+  const uvg_pixel m2 = line[2];
+  const uvg_pixel m3 = line[3];
+  const uvg_pixel m4 = line[4];
+  const uvg_pixel m5 = line[5];
+  const uvg_pixel m6 = line[6];
+  const uvg_pixel m7 = line[7];
+  const uint8_t tcW[3] = { 3, 2, 1 }; //Wheights for tc
+
+  line[1] = CLIP(m1 - tcW[2]*tc, m1 + tcW[2]*tc, (2*m0 + 3*m1 +   m2 +   m3 +   m4 + 4) >> 3);
+  line[2] = CLIP(m2 - tcW[1]*tc, m2 + tcW[1]*tc, (  m1 +   m2 +   m3 +   m4        + 2) >> 2);
+  line[3] = CLIP(m3 - tcW[0]*tc, m3 + tcW[0]*tc, (  m1 + 2*m2 + 2*m3 + 2*m4 +   m5 + 4) >> 3);
+  line[4] = CLIP(m4 - tcW[0]*tc, m4 + tcW[0]*tc, (  m2 + 2*m3 + 2*m4 + 2*m5 +   m6 + 4) >> 3);
+  line[5] = CLIP(m5 - tcW[1]*tc, m5 + tcW[1]*tc, (  m3 +   m4 +   m5 +   m6        + 2) >> 2);
+  line[6] = CLIP(m6 - tcW[2]*tc, m6 + tcW[2]*tc, (  m3 +   m4 +   m5 + 3*m6 + 2*m7 + 4) >> 3);
+
+  return 3;
+}
+
+/**
+ * \brief Perform in weak luma filtering in place.
+ * \param line  Line of 8 pixels, with center at index 4
+ * \param tc  The tc treshold
+ * \param p_2nd  Whether to filter the 2nd line of P
+ * \param q_2nd  Whether to filter the 2nd line of Q
+ */
+static INLINE int uvg_filter_deblock_luma_weak(
+    uvg_pixel *line,
+    int32_t tc,
+    bool p_2nd,
+    bool q_2nd)
+{
+  const uvg_pixel m1 = line[1];
+  const uvg_pixel m2 = line[2];
+  const uvg_pixel m3 = line[3];
+  const uvg_pixel m4 = line[4];
+  const uvg_pixel m5 = line[5];
+  const uvg_pixel m6 = line[6];
+
+  int32_t delta = (9 * (m4 - m3) - 3 * (m5 - m2) + 8) >> 4;
+
+  if (abs(delta) >= tc * 10) {
+    return 0;
+  } else {
+    int32_t tc2 = tc >> 1;
+    delta = CLIP(-tc, tc, delta);
+    line[3] = CLIP(0, PIXEL_MAX, (m3 + delta));
+    line[4] = CLIP(0, PIXEL_MAX, (m4 - delta));
+
+    if (p_2nd) {
+      int32_t delta1 = CLIP(-tc2, tc2, (((m1 + m3 + 1) >> 1) - m2 + delta) >> 1);
+      line[2] = CLIP(0, PIXEL_MAX, m2 + delta1);
+    }
+    if (q_2nd) {
+      int32_t delta2 = CLIP(-tc2, tc2, (((m6 + m4 + 1) >> 1) - m5 - delta) >> 1);
+      line[5] = CLIP(0, PIXEL_MAX, m5 + delta2);
+    }
+    
+    if (p_2nd || q_2nd) {
+      return 2;
+    } else {
+      return 1;
+    }
+  }
+}
+
+/**
+ * \brief Gather pixels needed for deblocking
+ */
+static INLINE void gather_deblock_pixels(
+    const uvg_pixel *src,
+    int step, 
+    int stride,
+    int reach,
+    uvg_pixel *dst)
+{
+  for (int i = -reach; i < +reach; ++i) {
+    dst[i + 4] = src[i * step + stride];
+  }
+}
+
+/**
+* \brief Gather pixels from src to dst using a custom stride and step for src
+*/
+static INLINE void gather_pixels(
+    const uvg_pixel *src,
+    int step,
+    int stride,
+    int numel,
+    uvg_pixel *dst)
+{
+  for (int i = 0; i < numel; ++i) {
+    dst[i] = src[i * step + stride];
+  }
+}
+
+/**
+* \brief Scatter pixels
+*/
+static INLINE void scatter_deblock_pixels(
+    const uvg_pixel *src,
+    int step, 
+    int stride,
+    int reach,
+    uvg_pixel *dst)
+{
+  for (int i = -reach; i < +reach; ++i) {
+    dst[i * step + stride] = src[i + 4];
+  }
+}
+
+/**
+ * \brief Perform large block strong luma filtering in place.
+ * \param line  line of 8 pixels, with center at index 4
+ * \param lineL extended pixels with P pixels in [0,3] and Q pixels in [4,7]
+ * \param tc  tc treshold
+ * \param filter_length_P filter length in the P block
+ * \param filter_length_Q filter length in the Q block
+ * \return  Reach of the filter starting from center.
+ */
+static INLINE int uvg_filter_deblock_large_block(uvg_pixel *line, uvg_pixel *lineL, const int32_t tc,
+                                                 const uint8_t filter_length_P, const uint8_t filter_length_Q)
+{
+  int ref_P = 0;
+  int ref_Q = 0;
+  int ref_middle = 0;
+
+  const int coeffs7[7] = { 59, 50, 41, 32, 23, 14, 5 };
+  const int coeffs5[5] = { 58, 45, 32, 19, 6 };
+  const int coeffs3[3] = { 53, 32, 11 };
+
+  const int *coeffs_P = NULL;
+  const int *coeffs_Q = NULL;
+
+  //Form P/Q arrays that contain all of the samples to make things simpler later
+  const uvg_pixel lineP[8] = { line[3], line[2], line[1], line[0],
+                               lineL[3], lineL[2], lineL[1], lineL[0] };
+  const uvg_pixel lineQ[8] = { line[4], line[5], line[6], line[7],
+                               lineL[4], lineL[5], lineL[6], lineL[7] };
+  //Separate destination arrays with only six output pixels going in line and  rest to lineL to simplify things later
+  uvg_pixel* dstP[7] = { line + 3, line + 2, line + 1,
+                         lineL + 3, lineL + 2, lineL + 1, lineL + 0 };
+  uvg_pixel* dstQ[7] = { line + 4, line + 5, line + 6,
+                         lineL + 4, lineL + 5, lineL + 6, lineL + 7 };
+
+  //Get correct filter coeffs and Q/P end samples
+  switch (filter_length_P)
+  {
+  case 7:
+    ref_P = (lineP[6] + lineP[7] + 1) >> 1;
+    coeffs_P = coeffs7;
+    break;
+
+  case 5:
+    ref_P = (lineP[4] + lineP[5] + 1) >> 1;
+    coeffs_P = coeffs5;
+    break;
+
+  case 3:
+    ref_P = (lineP[2] + lineP[3] + 1) >> 1;
+    coeffs_P = coeffs3;
+    break;
+  }
+
+  switch (filter_length_Q)
+  {
+  case 7:
+    ref_Q = (lineQ[6] + lineQ[7] + 1) >> 1;
+    coeffs_Q = coeffs7;
+    break;
+
+  case 5:
+    ref_Q = (lineQ[4] + lineQ[5] + 1) >> 1;
+    coeffs_Q = coeffs5;
+    break;
+
+  case 3:
+    ref_Q = (lineQ[2] + lineQ[3] + 1) >> 1;
+    coeffs_Q = coeffs3;
+    break;
+  }
+
+  //Get middle samples
+  if (filter_length_P == filter_length_Q) {
+    if (filter_length_P == 7) {
+      ref_middle = (lineP[6] + lineP[5] + lineP[4] + lineP[3] + lineP[2] + lineP[1]
+                    + 2 * (lineP[0] + lineQ[0])
+                    + lineQ[1] + lineQ[2] + lineQ[3] + lineQ[4] + lineQ[5] + lineQ[6] + 8) >> 4;
+    }
+    else { //filter_length_P == 5
+      ref_middle = (lineP[4] + lineP[3]
+                    + 2 * (lineP[2] + lineP[1] + lineP[0] + lineQ[0] + lineQ[1] + lineQ[2])
+                    + lineQ[3] + lineQ[4] + 8) >> 4;
+    }
+  }
+  else {
+    const uint8_t lenS = MIN(filter_length_P, filter_length_Q);
+    const uint8_t lenL = MAX(filter_length_P, filter_length_Q);
+    const uvg_pixel *refS = filter_length_P < filter_length_Q ? lineP : lineQ;
+    const uvg_pixel *refL = filter_length_P < filter_length_Q ? lineQ : lineP;
+
+    if (lenL == 7 && lenS == 5) {
+      ref_middle = (lineP[5] + lineP[4] + lineP[3] + lineP[2]
+                    + 2 * (lineP[1] + lineP[0] + lineQ[0] + lineQ[1])
+                    + lineQ[2] + lineQ[3] + lineQ[4] + lineQ[5] + 8) >> 4;
+    }
+    else if (lenL == 7 && lenS == 3) {
+      ref_middle = (3 * refS[0] + 2 * refL[0] + 3 * refS[1] + refL[1] + 2 * refS[2]
+                    + refL[2] + refL[3] + refL[4] + refL[5] + refL[6] + 8) >> 4;
+    }
+    else { //lenL == 5 && lenS == 3
+    ref_middle = (lineP[3] + lineP[2] + lineP[1] + lineP[0]
+                  + lineQ[0] + lineQ[1] + lineQ[2] + lineQ[3] + 4) >> 3;
+
+    }
+  }
+
+  //Filter pixels in the line
+
+  const uint8_t tc7[7] = { 6, 5, 4, 3, 2, 1, 1 };
+  const uint8_t tc3[3] = { 6, 4, 2 };
+
+  const uint8_t *tc_coeff_P = (filter_length_P == 3) ? tc3 : tc7;
+  const uint8_t *tc_coeff_Q = (filter_length_Q == 3) ? tc3 : tc7;
+
+  for (size_t i = 0; i < filter_length_P; i++)
+  {
+    int range = (tc * tc_coeff_P[i]) >> 1;
+    *dstP[i] = CLIP(lineP[i] - range, lineP[i] + range, (ref_middle * coeffs_P[i] + ref_P * (64 - coeffs_P[i]) + 32) >> 6);
+  }
+
+  for (size_t i = 0; i < filter_length_Q; i++)
+  {
+    int range = (tc * tc_coeff_Q[i]) >> 1;
+    *dstQ[i] = CLIP(lineQ[i] - range, lineQ[i] + range, (ref_middle * coeffs_Q[i] + ref_Q * (64 - coeffs_Q[i]) + 32) >> 6);
+  }
+
+  return 3;
+}
+
+/**
+* \brief Determine if strong or weak filtering should be used
+*/
+static INLINE bool use_strong_filtering(const uvg_pixel * const b0, const uvg_pixel * const b3,
+                                        const uvg_pixel * const b0L, const uvg_pixel * const b3L,
+                                        const int_fast32_t dp0, const int_fast32_t dq0,
+                                        const int_fast32_t dp3, const int_fast32_t dq3,
+                                        const int32_t tc, const int32_t beta,
+                                        const bool is_side_P_large, const bool is_side_Q_large,
+                                        const uint8_t max_filter_length_P, const uint8_t max_filter_length_Q)
+{
+  int_fast32_t sp0 = abs(b0[0] - b0[3]);
+  int_fast32_t sp3 = abs(b3[0] - b3[3]);
+
+  if (is_side_P_large || is_side_Q_large) { //Large block decision
+    int_fast32_t sq0 = abs(b0[4] - b0[7]);
+    int_fast32_t sq3 = abs(b3[4] - b3[7]);
+    uvg_pixel tmp0, tmp3;
+    if (is_side_P_large) {
+      if (max_filter_length_P == 7) {
+        tmp0 = b0L[0];
+        tmp3 = b3L[0];
+        sp0 = sp0 + abs(b0L[3] - b0L[2] - b0L[1] + tmp0);
+        sp3 = sp3 + abs(b3L[3] - b3L[2] - b3L[1] + tmp3);
+      } else {
+        tmp0 = b0L[2];
+        tmp3 = b3L[2];
+      }
+      sp0 = (sp0 + abs(b0[0] - tmp0) + 1) >> 1;
+      sp3 = (sp3 + abs(b3[0] - tmp3) + 1) >> 1;
+    }
+    if (is_side_Q_large) {
+      if (max_filter_length_Q == 7) {
+        tmp0 = b0L[7];
+        tmp3 = b3L[7];
+        sq0 = sq0 + abs(b0L[4] - b0L[5] - b0L[6] + tmp0);
+        sq3 = sq3 + abs(b3L[4] - b3L[5] - b3L[6] + tmp3);
+      } else {
+        tmp0 = b0L[5];
+        tmp3 = b3L[5];
+      }
+      sq0 = (sq0 + abs(tmp0 - b0[7]) + 1) >> 1;
+      sq3 = (sq3 + abs(tmp3 - b3[7]) + 1) >> 1;
+    }
+    return 2 * (dp0 + dq0) < beta >> 4 &&
+      2 * (dp3 + dq3) < beta >> 4 &&
+      abs(b0[3] - b0[4]) < (5 * tc + 1) >> 1 &&
+      abs(b3[3] - b3[4]) < (5 * tc + 1) >> 1 &&
+      sp0 + sq0 < (beta * 3 >> 5) &&
+      sp3 + sq3 < (beta * 3 >> 5);
+  } else { //Normal decision
+    return 2 * (dp0 + dq0) < beta >> 2 &&
+      2 * (dp3 + dq3) < beta >> 2 &&
+      abs(b0[3] - b0[4]) < (5 * tc + 1) >> 1 &&
+      abs(b3[3] - b3[4]) < (5 * tc + 1) >> 1 &&
+      sp0 + abs(b0[4] - b0[7]) < beta >> 3 &&
+      sp3 + abs(b3[4] - b3[7]) < beta >> 3;
+  }
+}
+
+/**
+ * \brief Decide and filter a single 4-sample segment of a luma edge.
+ *
+ * \param edge_src  q0 sample of the first line of the segment
+ * \param x_stride  distance between samples across the edge
+ * \param y_stride  distance between samples along the edge
+ * \param segment   filter parameters of the segment
+ */
+void uvg_deblock_luma_segment_generic(uvg_pixel *edge_src,
+                                      int32_t x_stride,
+                                      int32_t y_stride,
+                                      const deblock_segment_t *segment)
+{
+  const int32_t tc = segment->tc;
+  const int32_t beta = segment->beta;
+  const int32_t side_threshold = (beta + (beta >> 1)) >> 3;
+  const uint8_t max_filter_length_P = segment->max_filter_length_P;
+  const uint8_t max_filter_length_Q = segment->max_filter_length_Q;
+  const bool is_side_P_large = segment->is_side_P_large;
+  const bool is_side_Q_large = segment->is_side_Q_large;
+
+  if (tc == 0) return;
+
+  // Gather the lines of pixels required for the filter on/off decision.
+  //TODO: May need to limit reach in small blocks?
+  uvg_pixel b[4][8];
+  gather_deblock_pixels(edge_src, x_stride, 0 * y_stride, 4, &b[0][0]);
+  gather_deblock_pixels(edge_src, x_stride, 3 * y_stride, 4, &b[3][0]);
+
+  int_fast32_t dp0 = abs(b[0][1] - 2 * b[0][2] + b[0][3]);
+  int_fast32_t dq0 = abs(b[0][4] - 2 * b[0][5] + b[0][6]);
+  int_fast32_t dp3 = abs(b[3][1] - 2 * b[3][2] + b[3][3]);
+  int_fast32_t dq3 = abs(b[3][4] - 2 * b[3][5] + b[3][6]);
+  int_fast32_t dp = dp0 + dp3;
+  int_fast32_t dq = dq0 + dq3;
+
+  bool sw = false;
+
+  if (is_side_P_large || is_side_Q_large) {
+    int_fast32_t dp0L = dp0;
+    int_fast32_t dq0L = dq0;
+    int_fast32_t dp3L = dp3;
+    int_fast32_t dq3L = dq3;
+    
+    //In case of large blocks, need to gather extra pixels
+    //bL:
+    //line0 p7 p6 p5 p4 q4 q5 q6 q7
+    uvg_pixel bL[4][8];
+
+    if (is_side_P_large) {
+      gather_pixels(edge_src - 8 * x_stride, x_stride, 0 * y_stride, 4, &bL[0][0]);
+      gather_pixels(edge_src - 8 * x_stride, x_stride, 3 * y_stride, 4, &bL[3][0]);
+      dp0L = (dp0L + abs(bL[0][2] - 2 * bL[0][3] + b[0][0]) + 1) >> 1;
+      dp3L = (dp3L + abs(bL[3][2] - 2 * bL[3][3] + b[3][0]) + 1) >> 1;
+    }
+    if (is_side_Q_large) {
+      gather_pixels(edge_src + 4 * x_stride, x_stride, 0 * y_stride, 4, &bL[0][4]);
+      gather_pixels(edge_src + 4 * x_stride, x_stride, 3 * y_stride, 4, &bL[3][4]);
+      dq0L = (dq0L + abs(b[0][7] - 2 * bL[0][4] + bL[0][5]) + 1) >> 1;
+      dq3L = (dq3L + abs(b[3][7] - 2 * bL[3][4] + bL[3][5]) + 1) >> 1;
+    }
+    
+    int_fast32_t dpL = dp0L + dp3L;
+    int_fast32_t dqL = dq0L + dq3L;
+
+    if (dpL + dqL < beta) {
+      sw = use_strong_filtering(&b[0][0], &b[3][0], &bL[0][0], &bL[3][0],
+                                dp0L, dq0L, dp3L, dq3L, tc, beta,
+                                is_side_P_large, is_side_Q_large,
+                                max_filter_length_P, max_filter_length_Q);
+      if (sw) {
+        gather_deblock_pixels(edge_src, x_stride, 1 * y_stride, 4, &b[1][0]);
+        gather_deblock_pixels(edge_src, x_stride, 2 * y_stride, 4, &b[2][0]);
+        if (is_side_P_large)
+        {
+          gather_pixels(edge_src - 8 * x_stride, x_stride, 1 * y_stride, 4, &bL[1][0]);
+          gather_pixels(edge_src - 8 * x_stride, x_stride, 2 * y_stride, 4, &bL[2][0]);
+        }
+        if (is_side_Q_large)
+        {
+          gather_pixels(edge_src + 4 * x_stride, x_stride, 1 * y_stride, 4, &bL[1][4]);
+          gather_pixels(edge_src + 4 * x_stride, x_stride, 2 * y_stride, 4, &bL[2][4]);
+        }
+
+        for (int i = 0; i < 4; ++i) {
+          int filter_reach;
+          filter_reach = uvg_filter_deblock_large_block(&b[i][0], &bL[i][0], tc,
+                                                        is_side_P_large ? max_filter_length_P : 3, 
+                                                        is_side_Q_large ? max_filter_length_Q : 3);
+          scatter_deblock_pixels(&b[i][0], x_stride, i * y_stride, filter_reach, edge_src);
+          if (is_side_P_large) {
+            const int diff_reach = (max_filter_length_P - filter_reach) >> 1;
+            const int dst_offset = (filter_reach + diff_reach) * x_stride;
+            scatter_deblock_pixels(&bL[i][0] - diff_reach, x_stride, i * y_stride, diff_reach, edge_src - dst_offset);
+          }
+          if (is_side_Q_large) {
+            const int diff_reach = (max_filter_length_Q - filter_reach) >> 1;
+            const int dst_offset = (filter_reach + diff_reach) * x_stride;
+            scatter_deblock_pixels(&bL[i][0] + diff_reach, x_stride, i * y_stride, diff_reach, edge_src + dst_offset);
+          }
+        }
+      }
+    }
+  }
+
+  if (!sw)
+  {
+    if (dp + dq < beta) {
+      if (max_filter_length_P > 2 && max_filter_length_Q > 2) {
+        // Strong filtering flag checking.
+        sw = use_strong_filtering(b[0], b[3], NULL, NULL,
+                                  dp0, dq0, dp3, dq3, tc, beta,
+                                  false, false, 7, 7);
+      }
+
+      // Read lines 1 and 2. Weak filtering doesn't use the outermost pixels
+      // but let's give them anyway to simplify control flow.
+      gather_deblock_pixels(edge_src, x_stride, 1 * y_stride, 4, &b[1][0]);
+      gather_deblock_pixels(edge_src, x_stride, 2 * y_stride, 4, &b[2][0]);
+
+      for (int i = 0; i < 4; ++i) {
+        int filter_reach;
+        if (sw) {
+          filter_reach = uvg_filter_deblock_luma_strong(&b[i][0], tc);
+        } else {
+          bool p_2nd = false;
+          bool q_2nd = false;
+          if (max_filter_length_P > 1 && max_filter_length_Q > 1) {
+            p_2nd = dp < side_threshold;
+            q_2nd = dq < side_threshold;
+          }
+          filter_reach = uvg_filter_deblock_luma_weak(&b[i][0], tc, p_2nd, q_2nd);
+        }
+        scatter_deblock_pixels(&b[i][0], x_stride, i * y_stride, filter_reach, edge_src);
+      }
+    }
+  }
+}
+
+
+/**
+ * \brief Decide and filter the 4-sample segments of a luma edge one at a time.
+ */
+static void deblock_luma_edge_generic(uvg_pixel *src,
+                                      int32_t x_stride,
+                                      int32_t y_stride,
+                                      const deblock_segment_t *segments,
+                                      int num_segments)
+{
+  for (int i = 0; i < num_segments; ++i) {
+    uvg_deblock_luma_segment_generic(&src[i * 4 * y_stride], x_stride, y_stride, &segments[i]);
+  }
+}
+
+
+int uvg_strategy_register_filter_generic(void* opaque, uint8_t bitdepth)
+{
+  bool success = true;
+
+  success &= uvg_strategyselector_register(opaque, "deblock_luma_edge", "generic", 0, &deblock_luma_edge_generic);
+
+  return success;
+}
@@ -39,6 +39,20 @@
  */
 
 #include "global.h" // IWYU pragma: keep
+#include "cu.h"
+
+void uvg_angular_pred_generic(
+  const cu_loc_t* const cu_loc,
+  const int_fast8_t intra_mode,
+  const int_fast8_t channel_type,
+  const uvg_pixel *const in_ref_above,
+  const uvg_pixel *const in_ref_left,
+  uvg_pixel *const dst,
+  const uint8_t multi_ref_idx,
+  const uint8_t isp_mode,
+  const int cu_dim);
+
+void uvg_mip_boundary_downsampling_1D(int* reduced_dst, const int* const ref_src, int src_len, int dst_len);
 
 int uvg_strategy_register_intra_generic(void* opaque, uint8_t bitdepth);
 
@@ -762,11 +762,11 @@ void uvg_get_extended_block_generic(uvg_epol_args *args) {
 
   int min_y = args->blk_y - args->pad_t;
   int max_y = args->blk_y + args->blk_h + args->pad_b + args->pad_b_simd - 1;
-  bool out_of_bounds_y = (min_y < 0) || (max_y >= args->src_h);
+  bool out_of_bounds_y = (min_y < -args->src_pad) || (max_y >= args->src_h + args->src_pad);
 
   int min_x = args->blk_x - args->pad_l;
   int max_x = args->blk_x + args->blk_w + args->pad_r - 1;
-  bool out_of_bounds_x = (min_x < 0) || (max_x >= args->src_w);
+  bool out_of_bounds_x = (min_x < -args->src_pad) || (max_x >= args->src_w + args->src_pad);
 
   if (out_of_bounds_y || out_of_bounds_x) {
 
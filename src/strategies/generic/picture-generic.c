@@ -366,6 +366,17 @@ SATD_NxN(generic, 32)
 SATD_NxN(generic, 64)
 SATD_ANY_SIZE(generic)
 
+/**
+ * \brief  Calculate the sum of the SATDs of the U and V blocks.
+ */
+static unsigned satd_any_size_uv_generic(int width, int height,
+                                         const uvg_pixel *pred_u, const uvg_pixel *pred_v, const int pred_stride,
+                                         const uvg_pixel *orig_u, const uvg_pixel *orig_v, const int orig_stride)
+{
+  return satd_any_size_generic(width, height, pred_u, pred_stride, orig_u, orig_stride) +
+         satd_any_size_generic(width, height, pred_v, pred_stride, orig_v, orig_stride);
+}
+
 
 // Declare these functions to make sure the signature of the macro matches.
 static cost_pixel_nxn_multi_func satd_4x4_dual_generic;
@@ -1353,6 +1364,32 @@ static double pixel_var_generic(const uvg_pixel *arr, const uint32_t len)
   return var;
 }
 
+/**
+ * \brief Calculate the sum and the sum of squares of each 4x4 block.
+ *
+ * The results are stored in raster order with width / 4 blocks per row.
+ * Width and height must be multiples of 4.
+ */
+static void pixel_sums_4x4_generic(const uvg_pixel *buf, const int stride, const int width, const int height, uint32_t *sums, uint32_t *sums_sq)
+{
+  const int blocks_per_row = width >> 2;
+  for (int y = 0; y < height; y += 4) {
+    for (int x = 0; x < width; x += 4) {
+      uint32_t sum = 0;
+      uint32_t sum_sq = 0;
+      for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+          const uint32_t px = buf[(y + i) * stride + x + j];
+          sum += px;
+          sum_sq += px * px;
+        }
+      }
+      sums[(y >> 2) * blocks_per_row + (x >> 2)] = sum;
+      sums_sq[(y >> 2) * blocks_per_row + (x >> 2)] = sum_sq;
+    }
+  }
+}
+
 
 static void generate_residual_generic(const uvg_pixel* ref_in, const uvg_pixel* pred_in, int16_t* residual, 
   int width, int height, int ref_stride, int pred_stride)
@@ -1478,6 +1515,7 @@ int uvg_strategy_register_picture_generic(void* opaque, uint8_t bitdepth)
   success &= uvg_strategyselector_register(opaque, "satd_64x64_dual", "generic", 0, &satd_64x64_dual_generic);
   success &= uvg_strategyselector_register(opaque, "satd_any_size", "generic", 0, &satd_any_size_generic);
   success &= uvg_strategyselector_register(opaque, "satd_any_size_vtm", "generic", 0, &xGetHADs);
+  success &= uvg_strategyselector_register(opaque, "satd_any_size_uv", "generic", 0, &satd_any_size_uv_generic);
   success &= uvg_strategyselector_register(opaque, "satd_any_size_quad", "generic", 0, &satd_any_size_quad_generic);
 
   success &= uvg_strategyselector_register(opaque, "pixels_calc_ssd", "generic", 0, &pixels_calc_ssd_generic);
@@ -1488,6 +1526,7 @@ int uvg_strategy_register_picture_generic(void* opaque, uint8_t bitdepth)
   success &= uvg_strategyselector_register(opaque, "hor_sad", "generic", 0, &hor_sad_generic);
 
   success &= uvg_strategyselector_register(opaque, "pixel_var", "generic", 0, &pixel_var_generic);
+  success &= uvg_strategyselector_register(opaque, "pixel_sums_4x4", "generic", 0, &pixel_sums_4x4_generic);
 
   success &= uvg_strategyselector_register(opaque, "generate_residual", "generic", 0, &generate_residual_generic);
 
@@ -43,6 +43,7 @@
 #include "transform.h"
 #include "fast_coeff_cost.h"
 #include "reshape.h"
+#include "strategies/strategies-reshape.h"
 
 /**
 * \brief quantize transformed coefficents
@@ -480,16 +481,7 @@ int uvg_quantize_residual_generic(encoder_state_t *const state,
   uvg_generate_residual(ref_in, pred_in, residual, width, height, in_stride, in_stride);
 
   if (state->tile->frame->lmcs_aps->m_sliceReshapeInfo.enableChromaAdj && color != COLOR_Y) {
-    int y, x;
-    int sign, absval;
-    int maxAbsclipBD = (1 << UVG_BIT_DEPTH) - 1;
-    for (y = 0; y < height; ++y) {
-      for (x = 0; x < width; ++x) {
-        sign = residual[x + y * width] >= 0 ? 1 : -1;
-        absval = sign * residual[x + y * width];
-        residual[x + y * width] = (int16_t)CLIP(-maxAbsclipBD, maxAbsclipBD, sign * (((absval << CSCALE_FP_PREC) + (lmcs_chroma_adj >> 1)) / lmcs_chroma_adj));
-      }
-    }
+    uvg_lmcs_scale_chroma_fwd(residual, width * height, lmcs_chroma_adj);
   }
 
   // Transform residual. (residual -> coeff)
@@ -570,22 +562,7 @@ int uvg_quantize_residual_generic(encoder_state_t *const state,
     }
     
     if (state->tile->frame->lmcs_aps->m_sliceReshapeInfo.enableChromaAdj && color != COLOR_Y) {
-      int y, x;
-      int sign, absval;
-      int maxAbsclipBD = (1 << UVG_BIT_DEPTH) - 1;
-      for (y = 0; y < height; ++y) {
-        for (x = 0; x < width; ++x) {
-          residual[x + y * width] = (int16_t)CLIP((int16_t)(-maxAbsclipBD - 1), (int16_t)maxAbsclipBD, residual[x + y * width]);
-          sign = residual[x + y * width] >= 0 ? 1 : -1;
-          absval = sign * residual[x + y * width];
-          int val = sign * ((absval * lmcs_chroma_adj + (1 << (CSCALE_FP_PREC - 1))) >> CSCALE_FP_PREC);
-          if (sizeof(uvg_pixel) == 2) // avoid overflow when storing data
-          {
-            val = CLIP(-32768, 32767, val);
-          }
-          residual[x + y * width] = (int16_t)val;
-        }
-      }
+      uvg_lmcs_scale_chroma_inv(residual, width * height, lmcs_chroma_adj);
     }
 
     // Get quantized reconstruction. (residual + pred_in -> rec_out)
@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+#include "strategies/generic/reshape-generic.h"
+
+#include "strategies/strategies-reshape.h"
+#include "strategyselector.h"
+
+
+void uvg_lmcs_map_luma_generic(const uvg_pixel *src,
+  int32_t src_stride,
+  uvg_pixel *dst,
+  int32_t dst_stride,
+  int width,
+  int height,
+  const uvg_pixel *lut)
+{
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      dst[x] = lut[src[x]];
+    }
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
+
+void uvg_lmcs_scale_chroma_fwd_generic(int16_t *residual, int count, int adj)
+{
+  const int maxAbsclipBD = (1 << UVG_BIT_DEPTH) - 1;
+  for (int i = 0; i < count; i++) {
+    int sign = residual[i] >= 0 ? 1 : -1;
+    int absval = sign * residual[i];
+    residual[i] = (int16_t)CLIP(-maxAbsclipBD, maxAbsclipBD, sign * (((absval << CSCALE_FP_PREC) + (adj >> 1)) / adj));
+  }
+}
+
+void uvg_lmcs_scale_chroma_inv_generic(int16_t *residual, int count, int adj)
+{
+  const int maxAbsclipBD = (1 << UVG_BIT_DEPTH) - 1;
+  for (int i = 0; i < count; i++) {
+    residual[i] = (int16_t)CLIP((int16_t)(-maxAbsclipBD - 1), (int16_t)maxAbsclipBD, residual[i]);
+    int sign = residual[i] >= 0 ? 1 : -1;
+    int absval = sign * residual[i];
+    int val = sign * ((absval * adj + (1 << (CSCALE_FP_PREC - 1))) >> CSCALE_FP_PREC);
+    if (sizeof(uvg_pixel) == 2) // avoid overflow when storing data
+    {
+      val = CLIP(-32768, 32767, val);
+    }
+    residual[i] = (int16_t)val;
+  }
+}
+
+
+int uvg_strategy_register_reshape_generic(void* opaque, uint8_t bitdepth)
+{
+  bool success = true;
+
+  success &= uvg_strategyselector_register(opaque, "lmcs_map_luma", "generic", 0, &uvg_lmcs_map_luma_generic);
+  success &= uvg_strategyselector_register(opaque, "lmcs_scale_chroma_fwd", "generic", 0, &uvg_lmcs_scale_chroma_fwd_generic);
+  success &= uvg_strategyselector_register(opaque, "lmcs_scale_chroma_inv", "generic", 0, &uvg_lmcs_scale_chroma_inv_generic);
+
+  return success;
+}
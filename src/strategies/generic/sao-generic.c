@@ -42,39 +42,48 @@
 
 
 /**
+ * \brief Collect the statistics of all edge classes and bands of a block.
+ *
  * \param orig_data  Original pixel data. 64x64 for luma, 32x32 for chroma.
  * \param rec_data  Reconstructed pixel data. 64x64 for luma, 32x32 for chroma.
- * \param dir_offsets
- * \param is_chroma  0 for luma, 1 for chroma. Indicates
+ * \param bitdepth  Bit depth of the samples, for the band classification.
+ * \param stats  Statistics the block is added to.
  */
-static void calc_sao_edge_dir_generic(const uvg_pixel *orig_data,
-                                      const uvg_pixel *rec_data,
-                                      int eo_class,
-                                      int block_width,
-                                      int block_height,
-                                      int cat_sum_cnt[2][NUM_SAO_EDGE_CATEGORIES])
+static void calc_sao_stats_generic(const uvg_pixel *orig_data,
+                                   const uvg_pixel *rec_data,
+                                   int block_width,
+                                   int block_height,
+                                   int bitdepth,
+                                   sao_stats_t *stats)
 {
-  int y, x;
-  vector2d_t a_ofs = g_sao_edge_offsets[eo_class][0];
-  vector2d_t b_ofs = g_sao_edge_offsets[eo_class][1];
-  // Arrays orig_data and rec_data are quarter size for chroma.
+  const int shift = bitdepth - 5;
 
-  // Don't sample the edge pixels because this function doesn't have access to
-  // their neighbours.
+  for (int y = 0; y < block_height; ++y) {
+    for (int x = 0; x < block_width; ++x) {
+      const uvg_pixel *c_data = &rec_data[y * block_width + x];
+      const uvg_pixel c = c_data[0];
+      const int diff = orig_data[y * block_width + x] - c;
 
-  
+      stats->band[0][c >> shift] += diff;
+      stats->band[1][c >> shift] += 1;
 
-  for (y = 1; y < block_height - 1; ++y) {
-    for (x = 1; x < block_width - 1; ++x) {
-      const uvg_pixel *c_data = &rec_data[y * block_width + x];
-      uvg_pixel a = c_data[a_ofs.y * block_width + a_ofs.x];
-      uvg_pixel c = c_data[0];
-      uvg_pixel b = c_data[b_ofs.y * block_width + b_ofs.x];
+      // Edge pixels are not sampled because their neighbours are not
+      // available.
+      if (y == 0 || y == block_height - 1 || x == 0 || x == block_width - 1) {
+        continue;
+      }
+
+      for (int eo_class = SAO_EO0; eo_class < SAO_NUM_EO; ++eo_class) {
+        vector2d_t a_ofs = g_sao_edge_offsets[eo_class][0];
+        vector2d_t b_ofs = g_sao_edge_offsets[eo_class][1];
+        uvg_pixel a = c_data[a_ofs.y * block_width + a_ofs.x];
+        uvg_pixel b = c_data[b_ofs.y * block_width + b_ofs.x];
 
-      int eo_cat = sao_calc_eo_cat(a, b, c);
+        int eo_cat = sao_calc_eo_cat(a, b, c);
 
-      cat_sum_cnt[0][eo_cat] += orig_data[y * block_width + x] - c;
-      cat_sum_cnt[1][eo_cat] += 1;
+        stats->edge[eo_class][0][eo_cat] += diff;
+        stats->edge[eo_class][1][eo_cat] += 1;
+      }
     }
   }
 }
@@ -128,10 +137,8 @@ int uvg_strategy_register_sao_generic(void* opaque, uint8_t bitdepth)
 {
   bool success = true;
 
-  success &= uvg_strategyselector_register(opaque, "sao_edge_ddistortion", "generic", 0, &sao_edge_ddistortion_generic);
-  success &= uvg_strategyselector_register(opaque, "calc_sao_edge_dir", "generic", 0, &calc_sao_edge_dir_generic);
   success &= uvg_strategyselector_register(opaque, "sao_reconstruct_color", "generic", 0, &sao_reconstruct_color_generic);
-  success &= uvg_strategyselector_register(opaque, "sao_band_ddistortion", "generic", 0, &sao_band_ddistortion_generic);
+  success &= uvg_strategyselector_register(opaque, "calc_sao_stats", "generic", 0, &calc_sao_stats_generic);
 
   return success;
 }
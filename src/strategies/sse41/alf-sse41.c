@@ -43,6 +43,9 @@
 #include "strategyselector.h"
 
 static void alf_derive_classification_blk_sse41(encoder_state_t * const state,
+  const uvg_pixel *src,
+  const int src_stride,
+  alf_classifier **classifier,
   const int shift,
   const int n_height,
   const int n_width,
@@ -53,9 +56,8 @@ static void alf_derive_classification_blk_sse41(encoder_state_t * const state,
   const int vb_ctu_height,
   int vb_pos)
 {
-  videoframe_t* const frame = state->tile->frame;
-  const size_t imgStride = frame->rec->stride;
-  const uvg_pixel *  srcExt    = state->tile->frame->rec->y;
+  const size_t imgStride = src_stride;
+  const uvg_pixel *  srcExt    = src;
 
   const int imgHExtended = n_height + 4;
   const int imgWExtended = n_width + 4;
@@ -63,8 +65,6 @@ static void alf_derive_classification_blk_sse41(encoder_state_t * const state,
   const int posX = blk_pos_x;
   const int posY = blk_pos_y;
 
-  //alf_classifier** classifier = state->tile->frame->alf_info->classifier;
-
   // 18x40 array
   uint16_t colSums[(CLASSIFICATION_BLK_SIZE + 4) >> 1]
                   [CLASSIFICATION_BLK_SIZE + 8];
@@ -330,23 +330,23 @@ static void alf_derive_classification_blk_sse41(encoder_state_t * const state,
       transpose_idx         = _mm_add_epi32(transpose_idx, dirTempDMinus1);
       transpose_idx         = _mm_add_epi32(transpose_idx, dirTempDMinus1);
 
-      int yOffset = 2 * i + blk_pos_y;
-      int xOffset = j + blk_pos_x;
+      int yOffset = 2 * i + blk_dst_y;
+      int xOffset = j + blk_dst_x;
 
       static_assert(sizeof(alf_classifier) == 2, "alf_classifier type must be 16 bits wide");
       __m128i v;
       v = _mm_unpacklo_epi8(class_idx, transpose_idx);
       v = _mm_shuffle_epi8(v, _mm_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 8, 9, 8, 9, 8, 9, 8, 9));
-      _mm_storeu_si128((__m128i *) (state->tile->frame->alf_info->classifier[yOffset] + xOffset), v);
-      _mm_storeu_si128((__m128i *) (state->tile->frame->alf_info->classifier[yOffset + 1] + xOffset), v);
-      _mm_storeu_si128((__m128i *) (state->tile->frame->alf_info->classifier[yOffset + 2] + xOffset), v);
-      _mm_storeu_si128((__m128i *) (state->tile->frame->alf_info->classifier[yOffset + 3] + xOffset), v);
+      _mm_storeu_si128((__m128i *) (classifier[yOffset] + xOffset), v);
+      _mm_storeu_si128((__m128i *) (classifier[yOffset + 1] + xOffset), v);
+      _mm_storeu_si128((__m128i *) (classifier[yOffset + 2] + xOffset), v);
+      _mm_storeu_si128((__m128i *) (classifier[yOffset + 3] + xOffset), v);
       v = _mm_unpackhi_epi8(class_idx, transpose_idx);
       v = _mm_shuffle_epi8(v, _mm_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 8, 9, 8, 9, 8, 9, 8, 9));
-      _mm_storeu_si128((__m128i *) (state->tile->frame->alf_info->classifier[yOffset + 4] + xOffset), v);
-      _mm_storeu_si128((__m128i *) (state->tile->frame->alf_info->classifier[yOffset + 5] + xOffset), v);
-      _mm_storeu_si128((__m128i *) (state->tile->frame->alf_info->classifier[yOffset + 6] + xOffset), v);
-      _mm_storeu_si128((__m128i *) (state->tile->frame->alf_info->classifier[yOffset + 7] + xOffset), v);
+      _mm_storeu_si128((__m128i *) (classifier[yOffset + 4] + xOffset), v);
+      _mm_storeu_si128((__m128i *) (classifier[yOffset + 5] + xOffset), v);
+      _mm_storeu_si128((__m128i *) (classifier[yOffset + 6] + xOffset), v);
+      _mm_storeu_si128((__m128i *) (classifier[yOffset + 7] + xOffset), v);
     }
   }
 }
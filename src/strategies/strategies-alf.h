@@ -46,6 +46,9 @@
 
 // Declare function pointers.
 typedef void (alf_derive_classification_blk_func)(encoder_state_t * const state,
+  const uvg_pixel *src,
+  const int src_stride,
+  alf_classifier **classifier,
   const int shift,
   const int n_height,
   const int n_width,
@@ -108,11 +111,41 @@ typedef void (alf_get_blk_stats_func)(encoder_state_t* const state,
   int vb_pos,
   short alf_clipping_values[MAX_NUM_CHANNEL_TYPE][MAX_ALF_NUM_CLIPPING_VALUES]);
 
+typedef void (alf_filter_cc_blk_func)(uvg_pixel *chroma,
+  const int chroma_stride,
+  const uvg_pixel *luma,
+  const int luma_stride,
+  const int16_t *filter_coeff,
+  clp_rng clp_rng,
+  const int scale_x,
+  const int scale_y,
+  const int y_pos,
+  const int width,
+  const int height,
+  const int vb_ctu_height,
+  const int vb_pos);
+
+typedef void (alf_get_blk_stats_cc_func)(alf_covariance *alf_covariance,
+  const uvg_pixel *org,
+  const int org_stride,
+  const uvg_pixel *rec,
+  const int rec_stride,
+  const uvg_pixel *rec_luma,
+  const int rec_luma_stride,
+  const int scale_x,
+  const int scale_y,
+  const int width,
+  const int height,
+  const int vb_ctu_height,
+  const int vb_pos);
+
 // Declare function pointers.
 extern alf_derive_classification_blk_func * uvg_alf_derive_classification_blk;
 extern alf_filter_5x5_blk_func* uvg_alf_filter_5x5_blk;
 extern alf_filter_7x7_blk_func* uvg_alf_filter_7x7_blk;
 extern alf_get_blk_stats_func* uvg_alf_get_blk_stats;
+extern alf_filter_cc_blk_func* uvg_alf_filter_cc_blk;
+extern alf_get_blk_stats_cc_func* uvg_alf_get_blk_stats_cc;
 
 int uvg_strategy_register_alf(void* opaque, uint8_t bitdepth);
 
@@ -122,5 +155,7 @@ int uvg_strategy_register_alf(void* opaque, uint8_t bitdepth);
   {"alf_filter_5x5_blk", (void**) &uvg_alf_filter_5x5_blk}, \
   {"alf_filter_7x7_blk", (void**) &uvg_alf_filter_7x7_blk}, \
   {"alf_get_blk_stats", (void**) &uvg_alf_get_blk_stats}, \
+  {"alf_filter_cc_blk", (void**) &uvg_alf_filter_cc_blk}, \
+  {"alf_get_blk_stats_cc", (void**) &uvg_alf_get_blk_stats_cc}, \
  
 
@@ -0,0 +1,68 @@
+#pragma once
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+/**
+ * \ingroup Optimization
+ * \file
+ * Interface for deblocking filter functions.
+ */
+
+#include "global.h" // IWYU pragma: keep
+#include "uvg266.h"
+#include "filter.h"
+
+
+// Declare function pointers.
+/**
+ * \brief Decide and filter the 4-sample segments of a luma edge.
+ *
+ * \param src           first q0 sample of the edge
+ * \param x_stride      distance between samples across the edge
+ * \param y_stride      distance between samples along the edge
+ * \param segments      filter parameters of each segment
+ * \param num_segments  number of 4-sample segments in the edge
+ */
+typedef void (deblock_luma_edge_func)(uvg_pixel *src,
+  int32_t x_stride,
+  int32_t y_stride,
+  const deblock_segment_t *segments,
+  int num_segments);
+
+extern deblock_luma_edge_func * uvg_deblock_luma_edge;
+
+int uvg_strategy_register_filter(void* opaque, uint8_t bitdepth);
+
+
+#define STRATEGIES_FILTER_EXPORTS \
+  {"deblock_luma_edge", (void**) &uvg_deblock_luma_edge}, \
+
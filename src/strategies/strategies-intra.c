@@ -39,9 +39,13 @@
 
 // Define function pointers.
 angular_pred_func *uvg_angular_pred;
+angular_pred_multi_func *uvg_angular_pred_multi;
 intra_pred_planar_func *uvg_intra_pred_planar;
 intra_pred_filtered_dc_func *uvg_intra_pred_filtered_dc;
 pdpc_planar_dc_func *uvg_pdpc_planar_dc;
+mip_pred_func *uvg_mip_predict;
+cclm_downsample_func *uvg_cclm_downsample;
+cclm_linear_transform_func *uvg_cclm_linear_transform;
 
 int uvg_strategy_register_intra(void* opaque, uint8_t bitdepth) {
   bool success = true;
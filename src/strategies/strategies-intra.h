@@ -55,6 +55,13 @@ typedef void (angular_pred_func)(
   const uint8_t isp_mode,
   const int cu_dim);
 
+typedef void (angular_pred_multi_func)(
+  const cu_loc_t* const cu_loc,
+  const int8_t *const modes,
+  const int num_modes,
+  const uvg_intra_ref *const *const used_refs,
+  uvg_pixel *const *const dsts);
+
 typedef void (intra_pred_planar_func)(
   const cu_loc_t* const cu_loc,
   color_t color,
@@ -76,20 +83,52 @@ typedef void (pdpc_planar_dc_func)(
   const uvg_intra_ref *const used_ref,
   uvg_pixel *const dst);
 
+typedef void (mip_pred_func)(
+  const uvg_intra_references * const refs,
+  const uint16_t pred_block_width,
+  const uint16_t pred_block_height,
+  uvg_pixel *dst,
+  const int mip_mode,
+  const bool mip_transp);
+
+typedef void (cclm_downsample_func)(
+  const uvg_pixel *y_rec,
+  const int rec_stride,
+  const uvg_pixel *left,
+  uvg_pixel *dst,
+  const int dst_stride,
+  const int width,
+  const int height);
+
+typedef void (cclm_linear_transform_func)(
+  const cclm_parameters_t *const cclm_params,
+  const uvg_pixel *src,
+  uvg_pixel *dst,
+  const int width,
+  const int height);
+
 // Declare function pointers.
 extern angular_pred_func * uvg_angular_pred;
+extern angular_pred_multi_func * uvg_angular_pred_multi;
 extern intra_pred_planar_func * uvg_intra_pred_planar;
 extern intra_pred_filtered_dc_func * uvg_intra_pred_filtered_dc;
 extern pdpc_planar_dc_func * uvg_pdpc_planar_dc;
+extern mip_pred_func * uvg_mip_predict;
+extern cclm_downsample_func * uvg_cclm_downsample;
+extern cclm_linear_transform_func * uvg_cclm_linear_transform;
 
 int uvg_strategy_register_intra(void* opaque, uint8_t bitdepth);
 
 
 #define STRATEGIES_INTRA_EXPORTS \
   {"angular_pred", (void**) &uvg_angular_pred}, \
+  {"angular_pred_multi", (void**) &uvg_angular_pred_multi}, \
   {"intra_pred_planar", (void**) &uvg_intra_pred_planar}, \
   {"intra_pred_filtered_dc", (void**) &uvg_intra_pred_filtered_dc}, \
   {"pdpc_planar_dc", (void**) &uvg_pdpc_planar_dc}, \
+  {"mip_predict", (void**) &uvg_mip_predict}, \
+  {"cclm_downsample", (void**) &uvg_cclm_downsample}, \
+  {"cclm_linear_transform", (void**) &uvg_cclm_linear_transform}, \
 
 
 
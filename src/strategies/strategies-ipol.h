@@ -70,6 +70,7 @@ typedef struct {
   int src_w; // Width
   int src_h; // Height
   int src_s; // Stride
+  int src_pad; // Extended samples on each side, read without extrapolation
 
   // Requested sampling position, base dimensions, and padding
   int blk_x;
@@ -72,6 +72,7 @@ cost_pixel_nxn_multi_func * uvg_satd_64x64_dual = 0;
 
 cost_pixel_any_size_func * uvg_satd_any_size = 0;
 cost_pixel_any_size_func * uvg_satd_any_size_vtm = 0;
+cost_pixel_any_size_uv_func * uvg_satd_any_size_uv = 0;
 cost_pixel_any_size_multi_func * uvg_satd_any_size_quad = 0;
 
 pixels_calc_ssd_func * uvg_pixels_calc_ssd = 0;
@@ -83,6 +84,7 @@ ver_sad_func *uvg_ver_sad = 0;
 hor_sad_func *uvg_hor_sad = 0;
 
 pixel_var_func *uvg_pixel_var = 0;
+pixel_sums_4x4_func *uvg_pixel_sums_4x4 = 0;
 
 generate_residual_func *uvg_generate_residual = 0;
 
@@ -123,6 +123,7 @@ typedef unsigned (cost_pixel_any_size_func)(
 );
 typedef void (cost_pixel_nxn_multi_func)(const pred_buffer preds, const uvg_pixel *orig, unsigned num_modes, unsigned *costs_out);
 typedef void (cost_pixel_any_size_multi_func)(int width, int height, const uvg_pixel **preds, const int stride, const uvg_pixel *orig, const int orig_stride, unsigned num_modes, unsigned *costs_out, int8_t *valid);
+typedef unsigned (cost_pixel_any_size_uv_func)(int width, int height, const uvg_pixel *pred_u, const uvg_pixel *pred_v, const int pred_stride, const uvg_pixel *orig_u, const uvg_pixel *orig_v, const int orig_stride);
 
 typedef unsigned (pixels_calc_ssd_func)(const uvg_pixel *const ref, const uvg_pixel *const rec, const int ref_stride, const int rec_stride, const int width, const int height);
 typedef optimized_sad_func_ptr_t (get_optimized_sad_func)(int32_t);
@@ -148,6 +149,7 @@ typedef void (inter_recon_bipred_func)(lcu_t * const lcu,
   const bool predict_chroma);
 
 typedef double (pixel_var_func)(const uvg_pixel *buf, const uint32_t len);
+typedef void (pixel_sums_4x4_func)(const uvg_pixel *buf, const int stride, const int width, const int height, uint32_t *sums, uint32_t *sums_sq);
 
 typedef void (generate_residual_func)(const uvg_pixel* ref_in, const uvg_pixel* pred_in, int16_t* residual, int width, int height, int ref_stride, int pred_stride);
 
@@ -176,6 +178,7 @@ extern cost_pixel_nxn_func * uvg_satd_32x32;
 extern cost_pixel_nxn_func * uvg_satd_64x64;
 extern cost_pixel_any_size_func *uvg_satd_any_size;
 extern cost_pixel_any_size_func *uvg_satd_any_size_vtm;
+extern cost_pixel_any_size_uv_func *uvg_satd_any_size_uv;
 
 extern cost_pixel_nxn_multi_func * uvg_sad_4x4_dual;
 extern cost_pixel_nxn_multi_func * uvg_sad_8x8_dual;
@@ -200,6 +203,7 @@ extern ver_sad_func *uvg_ver_sad;
 extern hor_sad_func *uvg_hor_sad;
 
 extern pixel_var_func *uvg_pixel_var;
+extern pixel_sums_4x4_func *uvg_pixel_sums_4x4;
 
 extern generate_residual_func* uvg_generate_residual;
 
@@ -223,6 +227,7 @@ cost_pixel_nxn_multi_func * uvg_pixels_get_sad_dual_func(unsigned width, unsigne
   {"satd_64x64", (void**) &uvg_satd_64x64}, \
   {"satd_any_size", (void**) &uvg_satd_any_size}, \
   {"satd_any_size_vtm", (void**) &uvg_satd_any_size_vtm}, \
+  {"satd_any_size_uv", (void**) &uvg_satd_any_size_uv}, \
   {"sad_4x4_dual", (void**) &uvg_sad_4x4_dual}, \
   {"sad_8x8_dual", (void**) &uvg_sad_8x8_dual}, \
   {"sad_16x16_dual", (void**) &uvg_sad_16x16_dual}, \
@@ -240,6 +245,7 @@ cost_pixel_nxn_multi_func * uvg_pixels_get_sad_dual_func(unsigned width, unsigne
   {"ver_sad", (void**) &uvg_ver_sad}, \
   {"hor_sad", (void**) &uvg_hor_sad}, \
   {"pixel_var", (void**) &uvg_pixel_var}, \
+  {"pixel_sums_4x4", (void**) &uvg_pixel_sums_4x4}, \
   {"generate_residual", (void**) &uvg_generate_residual}, \
 
 
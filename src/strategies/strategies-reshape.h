@@ -0,0 +1,88 @@
+#pragma once
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+/**
+ * \ingroup Optimization
+ * \file
+ * Interface for luma mapping with chroma scaling functions.
+ */
+
+#include "global.h" // IWYU pragma: keep
+#include "uvg266.h"
+
+
+// Declare function pointers.
+/**
+ * \brief Map luma samples through a lookup table.
+ *
+ * The source and the destination may be the same buffer.
+ *
+ * \param src         source samples
+ * \param src_stride  distance between source rows
+ * \param dst         destination samples
+ * \param dst_stride  distance between destination rows
+ * \param width       width of the block
+ * \param height      height of the block
+ * \param lut         mapped value of each sample value
+ */
+typedef void (lmcs_map_luma_func)(const uvg_pixel *src,
+  int32_t src_stride,
+  uvg_pixel *dst,
+  int32_t dst_stride,
+  int width,
+  int height,
+  const uvg_pixel *lut);
+
+/**
+ * \brief Scale a chroma residual in place.
+ *
+ * \param residual  residual samples
+ * \param count     number of residual samples
+ * \param adj       chroma residual scale with CSCALE_FP_PREC fractional bits
+ */
+typedef void (lmcs_scale_chroma_residual_func)(int16_t *residual,
+  int count,
+  int adj);
+
+extern lmcs_map_luma_func * uvg_lmcs_map_luma;
+extern lmcs_scale_chroma_residual_func * uvg_lmcs_scale_chroma_fwd;
+extern lmcs_scale_chroma_residual_func * uvg_lmcs_scale_chroma_inv;
+
+int uvg_strategy_register_reshape(void* opaque, uint8_t bitdepth);
+
+
+#define STRATEGIES_RESHAPE_EXPORTS \
+  {"lmcs_map_luma", (void**) &uvg_lmcs_map_luma}, \
+  {"lmcs_scale_chroma_fwd", (void**) &uvg_lmcs_scale_chroma_fwd}, \
+  {"lmcs_scale_chroma_inv", (void**) &uvg_lmcs_scale_chroma_inv}, \
+
@@ -37,10 +37,8 @@
 
 
 // Define function pointers.
-sao_edge_ddistortion_func * uvg_sao_edge_ddistortion;
-calc_sao_edge_dir_func * uvg_calc_sao_edge_dir;
 sao_reconstruct_color_func * uvg_sao_reconstruct_color;
-sao_band_ddistortion_func * uvg_sao_band_ddistortion;
+calc_sao_stats_func * uvg_calc_sao_stats;
 
 
 int uvg_strategy_register_sao(void* opaque, uint8_t bitdepth) {
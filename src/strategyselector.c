@@ -111,6 +111,16 @@ int uvg_strategyselector_init(int32_t cpuid, uint8_t bitdepth) {
     fprintf(stderr, "uvg_strategy_register_depquant failed!\n");
     return 0;
   }
+
+  if (!uvg_strategy_register_filter(&strategies, bitdepth)) {
+    fprintf(stderr, "uvg_strategy_register_filter failed!\n");
+    return 0;
+  }
+
+  if (!uvg_strategy_register_reshape(&strategies, bitdepth)) {
+    fprintf(stderr, "uvg_strategy_register_reshape failed!\n");
+    return 0;
+  }
   
   while(cur_strategy_to_select->fptr) {
     *(cur_strategy_to_select->fptr) = strategyselector_choose_for(&strategies, cur_strategy_to_select->strategy_type);
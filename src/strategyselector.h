@@ -110,6 +110,8 @@ int uvg_strategyselector_register(void *opaque, const char *type, const char *st
 #include "strategies/strategies-encode.h"
 #include "strategies/strategies-depquant.h"
 #include "strategies/strategies-alf.h"
+#include "strategies/strategies-filter.h"
+#include "strategies/strategies-reshape.h"
 
 static const strategy_to_select_t strategies_to_select[] = {
   STRATEGIES_NAL_EXPORTS
@@ -122,6 +124,8 @@ static const strategy_to_select_t strategies_to_select[] = {
   STRATEGIES_ENCODE_EXPORTS
   STRATEGIES_ALF_EXPORTS
   STRATEGIES_DEPQUANT_EXPORTS
+  STRATEGIES_FILTER_EXPORTS
+  STRATEGIES_RESHAPE_EXPORTS
   { NULL, NULL },
 };
 
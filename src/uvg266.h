@@ -173,6 +173,16 @@ enum uvg_me_early_termination
   UVG_ME_EARLY_TERMINATION_SENSITIVE = 2
 };
 
+/**
+* \brief Hash based motion search mode
+*/
+enum uvg_hash_me
+{
+  UVG_HASH_ME_OFF = 0,
+  UVG_HASH_ME_ON = 1,
+  UVG_HASH_ME_AUTO = 2
+};
+
 
 /**
  * \brief Format the pixels are read in.
@@ -556,6 +566,16 @@ typedef struct uvg_config
 
   uint8_t ref_wraparound; /* \brief MV reference wraparound */
 
+  enum uvg_hash_me hash_me; /*!< \brief Hash based motion search mode. */
+
+  uint8_t intra_gradient_presel; /*!< \brief Select intra rough search modes from source gradients. */
+
+  uint8_t intra_chroma_fast; /*!< \brief Prune chroma intra modes with a rough search and DM early exit. */
+
+  uint8_t alf_low_latency; /*!< \brief Filter with the ALF APSs of previous frames during the CTU encoding. */
+
+  uint8_t ref_padding; /*!< \brief Extend the borders of the reconstructed pictures for motion compensation. */
+
 } uvg_config;
 
 /**
@@ -37,6 +37,7 @@
 #include "image.h"
 #include "sao.h"
 #include "alf.h"
+#include "filter.h"
 
 /**
  * \brief Allocate new frame
@@ -57,6 +58,8 @@ videoframe_t * uvg_videoframe_alloc(int32_t width,
   frame->height_in_lcu = CEILDIV(frame->height, LCU_WIDTH);
 
   frame->sao_luma = MALLOC(sao_info_t, frame->width_in_lcu * frame->height_in_lcu);
+  frame->deblock_map = MALLOC(deblock_edge_info_t,
+                              2 * frame->width_in_lcu * frame->height_in_lcu * (LCU_WIDTH / 4) * (LCU_WIDTH / 4));
   if (chroma_format != UVG_CSP_400) {
     frame->sao_chroma = MALLOC(sao_info_t, frame->width_in_lcu * frame->height_in_lcu);
     if (cclm) {
@@ -98,9 +101,12 @@ int uvg_videoframe_free(videoframe_t * const frame)
 
   uvg_cu_array_free(&frame->cu_array);
   uvg_cu_array_free(&frame->chroma_cu_array);
+  uvg_motion_field_free(&frame->motion_field);
+  uvg_block_hash_free(&frame->block_hash);
 
   FREE_POINTER(frame->sao_luma);
   FREE_POINTER(frame->sao_chroma);
+  FREE_POINTER(frame->deblock_map);
 
   free(frame);
 
@@ -71,10 +71,13 @@ typedef struct videoframe
 
   cu_array_t* cu_array;     //!< \brief Info for each CU at each depth.
   cu_array_t* chroma_cu_array;     //!< \brief Info for each CU at each depth.
+  motion_field_t* motion_field; //!< \brief Compressed motion for TMVP in later frames.
+  uvg_block_hash_t* block_hash; //!< \brief Hash of the reconstructed 8x8 luma blocks for hash motion search or NULL.
   struct lmcs_aps* lmcs_aps; //!< \brief LMCS parameters for both the current frame.
   struct sao_info_t *sao_luma;   //!< \brief Array of sao parameters for every LCU.
   struct sao_info_t *sao_chroma;   //!< \brief Array of sao parameters for every LCU.
   struct alf_info_t *alf_info;   //!< \brief Array of alf parameters for both luma and chroma.
+  struct deblock_edge_info_t *deblock_map; //!< \brief Deblocking parameters of the left and the top edge of every 4x4 luma block.
   struct param_set_map* alf_param_set_map;
 
   int32_t poc;           //!< \brief Picture order count
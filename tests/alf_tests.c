@@ -0,0 +1,194 @@
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ * 
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+#include "greatest/greatest.h"
+
+#include "test_strategies.h"
+
+#include "src/alf.h"
+#include "src/strategies/strategies-alf.h"
+
+#include <stdlib.h>
+
+
+//////////////////////////////////////////////////////////////////////////
+// MACROS
+#define PADDING 8
+#define LUMA_STRIDE (2 * LCU_WIDTH + 4 * PADDING)
+#define LUMA_ROWS (LCU_WIDTH + 2 * PADDING)
+#define CHROMA_STRIDE (LCU_WIDTH + 4 * PADDING)
+
+//////////////////////////////////////////////////////////////////////////
+// GLOBALS
+static uvg_pixel luma_buf[LUMA_STRIDE * LUMA_ROWS];
+static uvg_pixel org_buf[CHROMA_STRIDE * LCU_WIDTH];
+static uvg_pixel rec_buf[CHROMA_STRIDE * LCU_WIDTH];
+static uvg_pixel expected_buf[CHROMA_STRIDE * LCU_WIDTH];
+static uvg_pixel actual_buf[CHROMA_STRIDE * LCU_WIDTH];
+
+static alf_covariance expected_cov;
+static alf_covariance actual_cov;
+
+static const uvg_pixel *luma = &luma_buf[PADDING * LUMA_STRIDE + 2 * PADDING];
+
+// Chroma block sizes and positions of the subsampling formats, with and
+// without the virtual boundary of the LCU rows.
+static const struct {
+  int scale_x;
+  int scale_y;
+  int width;
+  int height;
+  int y_pos;
+  int vb_pos;
+} blocks[] = {
+  { 1, 1, LCU_WIDTH / 2, LCU_WIDTH / 2, 0, LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA },
+  { 1, 1, 36, 20, 48, LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA },
+  { 1, 1, LCU_WIDTH / 2, LCU_WIDTH / 2, 0, LCU_WIDTH + 16 },
+  { 1, 0, LCU_WIDTH / 2, LCU_WIDTH, 0, LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA },
+  { 0, 0, LCU_WIDTH, LCU_WIDTH, 0, LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA },
+  { 0, 0, 20, 12, 116, LCU_WIDTH - ALF_VB_POS_ABOVE_CTUROW_LUMA },
+};
+
+static struct test_env_t {
+  alf_filter_cc_blk_func *filter_func;
+  alf_filter_cc_blk_func *generic_filter_func;
+  alf_get_blk_stats_cc_func *stats_func;
+  alf_get_blk_stats_cc_func *generic_stats_func;
+  const strategy_t * strategy;
+} test_env;
+
+
+//////////////////////////////////////////////////////////////////////////
+// SETUP, TEARDOWN AND HELPER FUNCTIONS
+static void setup_tests()
+{
+  // Pseudo random samples with the full range of sample values.
+  rand_seed(12345);
+  for (int i = 0; i < LUMA_STRIDE * LUMA_ROWS; ++i) {
+    luma_buf[i] = next_rand() & 0xff;
+  }
+  for (int i = 0; i < CHROMA_STRIDE * LCU_WIDTH; ++i) {
+    org_buf[i] = next_rand() & 0xff;
+    rec_buf[i] = next_rand() & 0xff;
+  }
+
+  test_env.generic_filter_func = get_generic_strategy("alf_filter_cc_blk");
+  test_env.generic_stats_func = get_generic_strategy("alf_get_blk_stats_cc");
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TESTS
+
+/**
+ * Test that the CC-ALF filtering matches the generic implementation for
+ * the chroma formats and random filters.
+ */
+TEST alf_filter_cc_blk(void)
+{
+  ASSERT(test_env.generic_filter_func != NULL);
+
+  const clp_rng clp_rng = { 0, (1 << UVG_BIT_DEPTH) - 1, UVG_BIT_DEPTH, 0 };
+
+  for (int b = 0; b < sizeof(blocks) / sizeof(blocks[0]); ++b) {
+    for (int round = 0; round < 4; ++round) {
+      int16_t filter_coeff[MAX_NUM_CC_ALF_CHROMA_COEFF] = { 0 };
+      for (int k = 0; k < MAX_NUM_CC_ALF_CHROMA_COEFF - 1; ++k) {
+        filter_coeff[k] = (next_rand() % 129) - 64;
+      }
+
+      memcpy(expected_buf, rec_buf, sizeof(rec_buf));
+      memcpy(actual_buf, rec_buf, sizeof(rec_buf));
+
+      test_env.generic_filter_func(expected_buf, CHROMA_STRIDE, luma, LUMA_STRIDE, filter_coeff, clp_rng,
+        blocks[b].scale_x, blocks[b].scale_y, blocks[b].y_pos, blocks[b].width, blocks[b].height,
+        LCU_WIDTH, blocks[b].vb_pos);
+      test_env.filter_func(actual_buf, CHROMA_STRIDE, luma, LUMA_STRIDE, filter_coeff, clp_rng,
+        blocks[b].scale_x, blocks[b].scale_y, blocks[b].y_pos, blocks[b].width, blocks[b].height,
+        LCU_WIDTH, blocks[b].vb_pos);
+
+      if (memcmp(expected_buf, actual_buf, sizeof(rec_buf)) != 0) {
+        FAILm("CC-ALF filtering differs from generic");
+      }
+    }
+  }
+
+  PASS();
+}
+
+/**
+ * Test that the CC-ALF statistics match the generic implementation for the
+ * chroma formats.
+ */
+TEST alf_get_blk_stats_cc(void)
+{
+  ASSERT(test_env.generic_stats_func != NULL);
+
+  for (int b = 0; b < sizeof(blocks) / sizeof(blocks[0]); ++b) {
+    memset(&expected_cov, 0, sizeof(expected_cov));
+    memset(&actual_cov, 0, sizeof(actual_cov));
+
+    test_env.generic_stats_func(&expected_cov, org_buf, CHROMA_STRIDE, rec_buf, CHROMA_STRIDE, luma, LUMA_STRIDE,
+      blocks[b].scale_x, blocks[b].scale_y, blocks[b].width, blocks[b].height,
+      LCU_WIDTH, blocks[b].vb_pos);
+    test_env.stats_func(&actual_cov, org_buf, CHROMA_STRIDE, rec_buf, CHROMA_STRIDE, luma, LUMA_STRIDE,
+      blocks[b].scale_x, blocks[b].scale_y, blocks[b].width, blocks[b].height,
+      LCU_WIDTH, blocks[b].vb_pos);
+
+    if (memcmp(&expected_cov, &actual_cov, sizeof(expected_cov)) != 0) {
+      FAILm("CC-ALF statistics differ from generic");
+    }
+  }
+
+  PASS();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TEST FIXTURES
+SUITE(alf_tests)
+{
+  setup_tests();
+
+  for (volatile unsigned i = 0; i < strategies.count; ++i) {
+    const strategy_t * strategy = &strategies.strategies[i];
+    test_env.strategy = strategy;
+
+    if (strcmp(strategy->type, "alf_filter_cc_blk") == 0) {
+      test_env.filter_func = strategy->fptr;
+      RUN_TEST(alf_filter_cc_blk);
+    } else if (strcmp(strategy->type, "alf_get_blk_stats_cc") == 0) {
+      test_env.stats_func = strategy->fptr;
+      RUN_TEST(alf_get_blk_stats_cc);
+    }
+  }
+}
@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ * 
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+#include "greatest/greatest.h"
+
+#include "test_strategies.h"
+
+#include "src/filter.h"
+#include "src/strategies/strategies-filter.h"
+
+#include <stdlib.h>
+
+
+//////////////////////////////////////////////////////////////////////////
+// MACROS
+#define BUF_WIDTH (LCU_WIDTH + 32)
+#define BUF_HEIGHT (LCU_WIDTH + 32)
+#define NUM_SEGMENTS 14
+
+//////////////////////////////////////////////////////////////////////////
+// GLOBALS
+static uvg_pixel rec_buf[BUF_WIDTH * BUF_HEIGHT];
+static uvg_pixel expected_buf[BUF_WIDTH * BUF_HEIGHT];
+static uvg_pixel actual_buf[BUF_WIDTH * BUF_HEIGHT];
+
+static deblock_segment_t segments[NUM_SEGMENTS];
+
+static struct test_env_t {
+  deblock_luma_edge_func *tested_func;
+  deblock_luma_edge_func *generic_func;
+  const strategy_t * strategy;
+} test_env;
+
+
+//////////////////////////////////////////////////////////////////////////
+// SETUP, TEARDOWN AND HELPER FUNCTIONS
+/**
+ * Fill the buffer with smooth blocks separated by steps at the edges, so
+ * that all of the filter decisions get exercised.
+ */
+static void fill_blocks(edge_dir dir)
+{
+  for (int y = 0; y < BUF_HEIGHT; ++y) {
+    for (int x = 0; x < BUF_WIDTH; ++x) {
+      const int across = dir == EDGE_VER ? x : y;
+      const int block = across / 8;
+      const int base = 64 + (block * 37) % 128;
+      const int noise = (next_rand() % 5) - 2;
+      rec_buf[x + y * BUF_WIDTH] = CLIP_TO_PIXEL(base + (across % 8) + noise);
+    }
+  }
+}
+
+static void randomize_segments(void)
+{
+  static const uint8_t filter_lengths[] = { 1, 3, 7 };
+  for (int i = 0; i < NUM_SEGMENTS; ++i) {
+    deblock_segment_t *seg = &segments[i];
+    seg->tc = (next_rand() % 8) == 0 ? 0 : next_rand() % 25;
+    seg->beta = 6 + next_rand() % 83;
+    seg->max_filter_length_P = filter_lengths[next_rand() % 3];
+    seg->max_filter_length_Q = seg->max_filter_length_P == 1 ? 1 : filter_lengths[1 + next_rand() % 2];
+    seg->is_side_P_large = seg->max_filter_length_P > 3 && next_rand() % 2;
+    seg->is_side_Q_large = seg->max_filter_length_Q > 3;
+  }
+}
+
+static void setup_tests()
+{
+  rand_seed(12345);
+  test_env.generic_func = get_generic_strategy("deblock_luma_edge");
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TESTS
+
+/**
+ * Test that the luma deblocking of vertical and horizontal edges matches the
+ * generic implementation for random filter parameters.
+ */
+TEST deblock_luma_edge(void)
+{
+  ASSERT(test_env.generic_func != NULL);
+
+  const edge_dir dirs[] = { EDGE_VER, EDGE_HOR };
+  for (int d = 0; d < 2; ++d) {
+    const int32_t x_stride = dirs[d] == EDGE_VER ? 1 : BUF_WIDTH;
+    const int32_t y_stride = dirs[d] == EDGE_VER ? BUF_WIDTH : 1;
+
+    for (int round = 0; round < 64; ++round) {
+      fill_blocks(dirs[d]);
+      randomize_segments();
+
+      // Edge between the blocks at 16 samples from the top left corner.
+      const int offset = 16 * x_stride + 8 * y_stride;
+      memcpy(expected_buf, rec_buf, sizeof(rec_buf));
+      memcpy(actual_buf, rec_buf, sizeof(rec_buf));
+
+      test_env.generic_func(&expected_buf[offset], x_stride, y_stride, segments, NUM_SEGMENTS);
+      test_env.tested_func(&actual_buf[offset], x_stride, y_stride, segments, NUM_SEGMENTS);
+
+      if (memcmp(expected_buf, actual_buf, sizeof(rec_buf)) != 0) {
+        FAILm("Luma deblocking differs from generic");
+      }
+    }
+  }
+
+  PASS();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TEST FIXTURES
+SUITE(filter_tests)
+{
+  setup_tests();
+
+  for (volatile unsigned i = 0; i < strategies.count; ++i) {
+    const strategy_t * strategy = &strategies.strategies[i];
+    test_env.strategy = strategy;
+
+    if (strcmp(strategy->type, "deblock_luma_edge") == 0) {
+      test_env.tested_func = strategy->fptr;
+      RUN_TEST(deblock_luma_edge);
+    }
+  }
+}
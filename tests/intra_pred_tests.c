@@ -0,0 +1,161 @@
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+#include "greatest/greatest.h"
+
+#include "test_strategies.h"
+
+#include "src/encoderstate.h"
+#include "src/intra.h"
+#include "src/strategies/strategies-intra.h"
+
+#include <stdlib.h>
+
+
+//////////////////////////////////////////////////////////////////////////
+// MACROS
+#define MIN_LOG_W 2
+#define MAX_LOG_W 5
+#define MAX_W (1 << MAX_LOG_W)
+#define NUM_PARALLEL 4
+
+//////////////////////////////////////////////////////////////////////////
+// GLOBALS
+static uvg_intra_references refs;
+
+// Only the fields read by the prediction are set.
+static encoder_control_t encoder_control;
+static videoframe_t frame;
+static encoder_state_config_tile_t tile;
+static encoder_state_t state;
+
+static struct test_env_t {
+  angular_pred_multi_func *tested_func;
+  const strategy_t * strategy;
+} test_env;
+
+
+//////////////////////////////////////////////////////////////////////////
+// SETUP, TEARDOWN AND HELPER FUNCTIONS
+static void setup_tests()
+{
+  // Pseudo random references with the full range of sample values.
+  rand_seed(12345);
+  for (int i = 0; i < INTRA_REF_LENGTH; ++i) {
+    refs.ref.top[i] = next_rand() & 0xff;
+    refs.ref.left[i] = next_rand() & 0xff;
+  }
+  refs.ref.left[0] = refs.ref.top[0];
+
+  frame.width = 64;
+  tile.frame = &frame;
+  state.encoder_control = &encoder_control;
+  state.tile = &tile;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TESTS
+
+/**
+ * Test that predicting a batch of angular modes gives the same result as
+ * predicting the modes one at a time with uvg_intra_predict, for all block
+ * sizes searched by the rough mode search.
+ */
+TEST angular_pred_multi(void)
+{
+  ALIGNED(32) uvg_pixel expected[MAX_W * MAX_W];
+  ALIGNED(32) uvg_pixel actual[NUM_PARALLEL][MAX_W * MAX_W];
+  uvg_pixel *const dsts[NUM_PARALLEL] = { actual[0], actual[1], actual[2], actual[3] };
+
+  angular_pred_multi_func *const best_func = uvg_angular_pred_multi;
+  uvg_angular_pred_multi = test_env.tested_func;
+
+  for (int log_h = MIN_LOG_W; log_h <= MAX_LOG_W; ++log_h) {
+    for (int log_w = MIN_LOG_W; log_w <= MAX_LOG_W; ++log_w) {
+      const int width = 1 << log_w;
+      const int height = 1 << log_h;
+      cu_loc_t cu_loc;
+      uvg_cu_loc_ctor(&cu_loc, 0, 0, width, height);
+
+      intra_search_data_t data;
+      memset(&data, 0, sizeof(data));
+      data.pred_cu.log2_width = log_w;
+      data.pred_cu.log2_height = log_h;
+
+      // The filtered reference depends on the block size.
+      refs.filtered_initialized = false;
+
+      for (int first = 2; first <= 66; first += NUM_PARALLEL) {
+        int8_t modes[NUM_PARALLEL];
+        for (int i = 0; i < NUM_PARALLEL; ++i) {
+          modes[i] = MIN(first + i, 66);
+        }
+        uvg_intra_predict_angular_multi(&state, &refs, &data.pred_cu, &cu_loc, modes, NUM_PARALLEL, dsts);
+
+        for (int i = 0; i < NUM_PARALLEL; ++i) {
+          data.pred_cu.intra.mode = modes[i];
+          uvg_intra_predict(&state, &refs, &cu_loc, &cu_loc, COLOR_Y, expected, &data, NULL);
+
+          for (int px = 0; px < width * height; ++px) {
+            if (expected[px] != actual[i][px]) {
+              uvg_angular_pred_multi = best_func;
+              FAILm("Multi-mode angular prediction differs from uvg_intra_predict");
+            }
+          }
+        }
+      }
+    }
+  }
+
+  uvg_angular_pred_multi = best_func;
+  PASS();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TEST FIXTURES
+SUITE(intra_pred_tests)
+{
+  setup_tests();
+
+  for (volatile unsigned i = 0; i < strategies.count; ++i) {
+    const strategy_t * strategy = &strategies.strategies[i];
+
+    if (strcmp(strategy->type, "angular_pred_multi") != 0) continue;
+
+    test_env.tested_func = strategy->fptr;
+    test_env.strategy = strategy;
+
+    RUN_TEST(angular_pred_multi);
+  }
+}
@@ -0,0 +1,137 @@
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ * 
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+#include "greatest/greatest.h"
+
+#include "test_strategies.h"
+
+#include "src/intra.h"
+#include "src/strategies/strategies-intra.h"
+
+#include <stdlib.h>
+
+
+//////////////////////////////////////////////////////////////////////////
+// MACROS
+#define MIN_LOG_W 2
+#define MAX_LOG_W 5
+#define MAX_W (1 << MAX_LOG_W)
+
+//////////////////////////////////////////////////////////////////////////
+// GLOBALS
+static uvg_intra_references refs;
+
+static struct test_env_t {
+  mip_pred_func *tested_func;
+  mip_pred_func *generic_func;
+  const strategy_t * strategy;
+} test_env;
+
+
+//////////////////////////////////////////////////////////////////////////
+// SETUP, TEARDOWN AND HELPER FUNCTIONS
+static void setup_tests()
+{
+  // Pseudo random references with the full range of sample values.
+  rand_seed(12345);
+  for (int i = 0; i < INTRA_REF_LENGTH; ++i) {
+    refs.ref.top[i] = next_rand() & 0xff;
+    refs.ref.left[i] = next_rand() & 0xff;
+  }
+  refs.ref.left[0] = refs.ref.top[0];
+  refs.filtered_initialized = false;
+
+  test_env.generic_func = get_generic_strategy("mip_predict");
+}
+
+static int mip_num_modes(int width, int height)
+{
+  if (width == 4 && height == 4) return 16;
+  if (width == 4 || height == 4 || (width == 8 && height == 8)) return 8;
+  return 6;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TESTS
+
+/**
+ * Test that the prediction matches the generic implementation for all
+ * block sizes, modes and transpositions.
+ */
+TEST mip_predict(void)
+{
+  ASSERT(test_env.generic_func != NULL);
+
+  ALIGNED(32) uvg_pixel expected[MAX_W * MAX_W];
+  ALIGNED(32) uvg_pixel actual[MAX_W * MAX_W];
+
+  for (int log_h = MIN_LOG_W; log_h <= MAX_LOG_W; ++log_h) {
+    for (int log_w = MIN_LOG_W; log_w <= MAX_LOG_W; ++log_w) {
+      const int width = 1 << log_w;
+      const int height = 1 << log_h;
+      for (int mode = 0; mode < mip_num_modes(width, height); ++mode) {
+        for (int transp = 0; transp < 2; ++transp) {
+          test_env.generic_func(&refs, width, height, expected, mode, transp);
+          test_env.tested_func(&refs, width, height, actual, mode, transp);
+
+          for (int i = 0; i < width * height; ++i) {
+            if (expected[i] != actual[i]) {
+              FAILm("MIP prediction differs from generic");
+            }
+          }
+        }
+      }
+    }
+  }
+
+  PASS();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TEST FIXTURES
+SUITE(mip_tests)
+{
+  setup_tests();
+
+  for (volatile unsigned i = 0; i < strategies.count; ++i) {
+    const strategy_t * strategy = &strategies.strategies[i];
+
+    if (strcmp(strategy->type, "mip_predict") != 0) continue;
+
+    test_env.tested_func = strategy->fptr;
+    test_env.strategy = strategy;
+
+    RUN_TEST(mip_predict);
+  }
+}
@@ -0,0 +1,207 @@
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ * 
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+#include "greatest/greatest.h"
+
+#include "test_strategies.h"
+
+#include "src/strategies/strategies-reshape.h"
+
+#include <stdlib.h>
+
+
+//////////////////////////////////////////////////////////////////////////
+// MACROS
+#define STRIDE 112
+#define ROWS 12
+#define MAX_RESIDUAL (32 * 32)
+
+//////////////////////////////////////////////////////////////////////////
+// GLOBALS
+static uvg_pixel lut[256];
+static uvg_pixel src_buf[STRIDE * ROWS];
+static uvg_pixel expected_buf[STRIDE * ROWS];
+static uvg_pixel actual_buf[STRIDE * ROWS];
+
+static int16_t residual[MAX_RESIDUAL];
+static int16_t expected_residual[MAX_RESIDUAL];
+static int16_t actual_residual[MAX_RESIDUAL];
+
+static const int widths[] = { 104, 64, 33, 32, 31, 7, 1 };
+static const int counts[] = { MAX_RESIDUAL, 512, 64, 17, 16, 8, 4 };
+static const int adjs[] = { 1 << CSCALE_FP_PREC, 256, 1000, 2731, 4096, 11702, 32768 };
+
+static struct test_env_t {
+  lmcs_map_luma_func *map_func;
+  lmcs_map_luma_func *generic_map_func;
+  lmcs_scale_chroma_residual_func *fwd_func;
+  lmcs_scale_chroma_residual_func *generic_fwd_func;
+  lmcs_scale_chroma_residual_func *inv_func;
+  lmcs_scale_chroma_residual_func *generic_inv_func;
+  const strategy_t * strategy;
+} test_env;
+
+
+//////////////////////////////////////////////////////////////////////////
+// SETUP, TEARDOWN AND HELPER FUNCTIONS
+static void setup_tests()
+{
+  // Pseudo random table and samples with the full range of sample values.
+  rand_seed(12345);
+  for (int i = 0; i < 256; ++i) {
+    lut[i] = next_rand() & 0xff;
+  }
+  for (int i = 0; i < STRIDE * ROWS; ++i) {
+    src_buf[i] = next_rand() & 0xff;
+  }
+
+  test_env.generic_map_func = get_generic_strategy("lmcs_map_luma");
+  test_env.generic_fwd_func = get_generic_strategy("lmcs_scale_chroma_fwd");
+  test_env.generic_inv_func = get_generic_strategy("lmcs_scale_chroma_inv");
+}
+
+/**
+ * Scale random residuals of the given range with a strategy and the generic
+ * implementation.
+ */
+static int scale_matches_generic(lmcs_scale_chroma_residual_func *func,
+  lmcs_scale_chroma_residual_func *generic_func,
+  int max_abs)
+{
+  for (int c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+    for (int a = 0; a < sizeof(adjs) / sizeof(adjs[0]); ++a) {
+      for (int i = 0; i < MAX_RESIDUAL; ++i) {
+        residual[i] = (next_rand() % (2 * max_abs + 1)) - max_abs;
+      }
+      memcpy(expected_residual, residual, sizeof(residual));
+      memcpy(actual_residual, residual, sizeof(residual));
+
+      generic_func(expected_residual, counts[c], adjs[a]);
+      func(actual_residual, counts[c], adjs[a]);
+
+      if (memcmp(expected_residual, actual_residual, sizeof(residual)) != 0) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TESTS
+
+/**
+ * Test that the luma mapping matches the generic implementation, also when
+ * mapping in place.
+ */
+TEST lmcs_map_luma(void)
+{
+  ASSERT(test_env.generic_map_func != NULL);
+
+  for (int w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w) {
+    memset(expected_buf, 0, sizeof(expected_buf));
+    memset(actual_buf, 0, sizeof(actual_buf));
+
+    test_env.generic_map_func(src_buf, STRIDE, expected_buf, STRIDE, widths[w], ROWS, lut);
+    test_env.map_func(src_buf, STRIDE, actual_buf, STRIDE, widths[w], ROWS, lut);
+
+    if (memcmp(expected_buf, actual_buf, sizeof(actual_buf)) != 0) {
+      FAILm("Luma mapping differs from generic");
+    }
+
+    memcpy(actual_buf, src_buf, sizeof(src_buf));
+    memcpy(expected_buf, src_buf, sizeof(src_buf));
+    test_env.generic_map_func(expected_buf, STRIDE, expected_buf, STRIDE, widths[w], ROWS, lut);
+    test_env.map_func(actual_buf, STRIDE, actual_buf, STRIDE, widths[w], ROWS, lut);
+
+    if (memcmp(expected_buf, actual_buf, sizeof(actual_buf)) != 0) {
+      FAILm("In place luma mapping differs from generic");
+    }
+  }
+
+  PASS();
+}
+
+/**
+ * Test that the forward chroma residual scaling matches the generic
+ * implementation for residuals of the full range.
+ */
+TEST lmcs_scale_chroma_fwd(void)
+{
+  ASSERT(test_env.generic_fwd_func != NULL);
+
+  if (!scale_matches_generic(test_env.fwd_func, test_env.generic_fwd_func, (1 << UVG_BIT_DEPTH) - 1)) {
+    FAILm("Forward chroma scaling differs from generic");
+  }
+
+  PASS();
+}
+
+/**
+ * Test that the inverse chroma residual scaling matches the generic
+ * implementation, including the clipping of residuals out of range.
+ */
+TEST lmcs_scale_chroma_inv(void)
+{
+  ASSERT(test_env.generic_inv_func != NULL);
+
+  if (!scale_matches_generic(test_env.inv_func, test_env.generic_inv_func, 3 << UVG_BIT_DEPTH)) {
+    FAILm("Inverse chroma scaling differs from generic");
+  }
+
+  PASS();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TEST FIXTURES
+SUITE(reshape_tests)
+{
+  setup_tests();
+
+  for (volatile unsigned i = 0; i < strategies.count; ++i) {
+    const strategy_t * strategy = &strategies.strategies[i];
+    test_env.strategy = strategy;
+
+    if (strcmp(strategy->type, "lmcs_map_luma") == 0) {
+      test_env.map_func = strategy->fptr;
+      RUN_TEST(lmcs_map_luma);
+    } else if (strcmp(strategy->type, "lmcs_scale_chroma_fwd") == 0) {
+      test_env.fwd_func = strategy->fptr;
+      RUN_TEST(lmcs_scale_chroma_fwd);
+    } else if (strcmp(strategy->type, "lmcs_scale_chroma_inv") == 0) {
+      test_env.inv_func = strategy->fptr;
+      RUN_TEST(lmcs_scale_chroma_inv);
+    }
+  }
+}
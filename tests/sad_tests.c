@@ -44,7 +44,9 @@
 
 //////////////////////////////////////////////////////////////////////////
 // DEFINES
-#define TEST_SAD(X, Y) uvg_image_calc_sad(g_pic, g_ref, 0, 0, (X), (Y), 8, 8, NULL)
+#define TEST_SAD(X, Y) uvg_image_calc_sad(g_pic, g_ref, 0, 0, (X), (Y), 8, 8, NULL, 0)
+#define PADDING 16
+#define TEST_PADDED_SAD(X, Y) uvg_image_calc_sad(g_pic, g_padded_ref, 0, 0, (X), (Y), 8, 8, NULL, PADDING)
 
 //////////////////////////////////////////////////////////////////////////
 // GLOBALS
@@ -76,6 +78,7 @@ static uvg_picture *g_big_pic = 0;
 static uvg_picture *g_big_ref = 0;
 static uvg_picture *g_64x64_zero = 0;
 static uvg_picture *g_64x64_max = 0;
+static uvg_picture *g_padded_ref = 0;
 
 static struct sad_test_env_t {
   int width;
@@ -126,6 +129,21 @@ static void setup_tests()
   
   g_64x64_max = uvg_image_alloc(UVG_CSP_420, 64, 64);
   memset(g_64x64_max->y, PIXEL_MAX, 64 * 64 * sizeof(uvg_pixel));
+
+  // Same as g_ref, but the borders are extended in two parts like the LCU
+  // rows of a reference picture.
+  g_padded_ref = uvg_image_alloc_padded(UVG_CSP_420, 8, 8, PADDING);
+  for (int y = 0; y < 8; ++y) {
+    for (int x = 0; x < 8; ++x) {
+      g_padded_ref->y[y*g_padded_ref->stride + x] = ref_data[8*y + x] + 48;
+    }
+  }
+  for (int y = 0; y < 4; ++y) {
+    memset(&g_padded_ref->u[y*g_padded_ref->stride / 2], 0, 4 * sizeof(uvg_pixel));
+    memset(&g_padded_ref->v[y*g_padded_ref->stride / 2], 0, 4 * sizeof(uvg_pixel));
+  }
+  uvg_image_extend_borders(g_padded_ref, 0, 4, 8, 4, PADDING);
+  uvg_image_extend_borders(g_padded_ref, 0, 0, 8, 4, PADDING);
 }
 
 static void tear_down_tests()
@@ -136,6 +154,7 @@ static void tear_down_tests()
   uvg_image_free(g_big_ref);
   uvg_image_free(g_64x64_zero);
   uvg_image_free(g_64x64_max);
+  uvg_image_free(g_padded_ref);
 }
 
 
@@ -281,6 +300,21 @@ TEST test_bottomright_out(void)
   PASS();
 }
 
+//////////////////////////////////////////////////////////////////////////
+// EXTENDED BORDER TESTS
+
+TEST test_padded_ref(void)
+{
+  // Reading the extended borders directly gives the same result as
+  // extrapolating the pixels outside the frame.
+  for (int y = -DIST; y <= DIST; ++y) {
+    for (int x = -DIST; x <= DIST; ++x) {
+      ASSERT_EQ(TEST_SAD(x, y), TEST_PADDED_SAD(x, y));
+    }
+  }
+  PASS();
+}
+
 static unsigned simple_sad(const uvg_pixel* buf1, const uvg_pixel* buf2, unsigned stride,
                            unsigned width, unsigned height)
 {
@@ -385,6 +419,8 @@ SUITE(sad_tests)
     RUN_TEST(test_bottom_out);
     RUN_TEST(test_bottomright_out);
 
+    RUN_TEST(test_padded_ref);
+
     struct dimension {
       int width;
       int height;
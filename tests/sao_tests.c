@@ -0,0 +1,235 @@
+/*****************************************************************************
+ * This file is part of uvg266 VVC encoder.
+ *
+ * Copyright (c) 2021, Tampere University, ITU/ISO/IEC, project contributors
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ * 
+ * * Neither the name of the Tampere University or ITU/ISO/IEC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * INCLUDING NEGLIGENCE OR OTHERWISE ARISING IN ANY WAY OUT OF THE USE OF THIS
+ ****************************************************************************/
+
+
+#include "greatest/greatest.h"
+
+#include "test_strategies.h"
+
+#include "src/sao.h"
+#include "src/strategies/strategies-sao.h"
+
+#include <stdlib.h>
+
+
+//////////////////////////////////////////////////////////////////////////
+// GLOBALS
+static uvg_pixel orig_buf[LCU_WIDTH * LCU_WIDTH];
+static uvg_pixel rec_buf[LCU_WIDTH * LCU_WIDTH];
+
+static sao_stats_t expected_stats;
+static sao_stats_t actual_stats;
+
+// Block sizes of luma and chroma LCUs, including the partial ones at the
+// right and bottom borders of the frame.
+static const struct {
+  int width;
+  int height;
+} blocks[] = {
+  { LCU_WIDTH, LCU_WIDTH },
+  { LCU_WIDTH / 2, LCU_WIDTH / 2 },
+  { 58, 24 },
+  { 55, 20 },
+  { 36, 12 },
+  { 8, 64 },
+  { 4, 4 },
+  { 2, 2 },
+};
+
+static struct test_env_t {
+  calc_sao_stats_func *tested_func;
+  calc_sao_stats_func *generic_func;
+  const strategy_t * strategy;
+} test_env;
+
+
+//////////////////////////////////////////////////////////////////////////
+// SETUP, TEARDOWN AND HELPER FUNCTIONS
+/**
+ * Fill the buffers with a noisy gradient, so that all of the edge
+ * categories and bands get samples.
+ */
+static void fill_blocks(void)
+{
+  for (int y = 0; y < LCU_WIDTH; ++y) {
+    for (int x = 0; x < LCU_WIDTH; ++x) {
+      const int base = (x * 2 + y * 2) & 0xff;
+      rec_buf[x + y * LCU_WIDTH] = CLIP_TO_PIXEL(base + (next_rand() % 9) - 4);
+      orig_buf[x + y * LCU_WIDTH] = CLIP_TO_PIXEL(base + (next_rand() % 31) - 15);
+    }
+  }
+}
+
+/**
+ * Change in SSE caused by the edge offsets, computed sample by sample.
+ */
+static int edge_ddistortion(int width, int height, sao_eo_class eo_class,
+                            const int offsets[NUM_SAO_EDGE_CATEGORIES])
+{
+  static const int eo_idx_to_cat[] = { 1, 2, 0, 3, 4 };
+  const vector2d_t a_ofs = g_sao_edge_offsets[eo_class][0];
+  const vector2d_t b_ofs = g_sao_edge_offsets[eo_class][1];
+
+  int sum = 0;
+  for (int y = 1; y < height - 1; ++y) {
+    for (int x = 1; x < width - 1; ++x) {
+      const int c = rec_buf[y * width + x];
+      const int a = rec_buf[(y + a_ofs.y) * width + x + a_ofs.x];
+      const int b = rec_buf[(y + b_ofs.y) * width + x + b_ofs.x];
+      const int offset = offsets[eo_idx_to_cat[2 + SIGN3(c - a) + SIGN3(c - b)]];
+
+      const int diff = orig_buf[y * width + x] - c;
+      const int delta = diff - offset;
+      sum += delta * delta - diff * diff;
+    }
+  }
+  return sum;
+}
+
+/**
+ * Change in SSE caused by the band offsets, computed sample by sample.
+ */
+static int band_ddistortion(int width, int height, int band_pos, const int offsets[4])
+{
+  const int shift = UVG_BIT_DEPTH - 5;
+
+  int sum = 0;
+  for (int i = 0; i < width * height; ++i) {
+    const int band = (rec_buf[i] >> shift) - band_pos;
+    const int offset = band >= 0 && band <= 3 ? offsets[band] : 0;
+
+    const int diff = orig_buf[i] - rec_buf[i];
+    const int delta = diff - offset;
+    sum += delta * delta - diff * diff;
+  }
+  return sum;
+}
+
+static void setup_tests()
+{
+  rand_seed(12345);
+  test_env.generic_func = get_generic_strategy("calc_sao_stats");
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TESTS
+
+/**
+ * Test that the SAO statistics match the generic implementation for the
+ * block sizes of the LCUs.
+ */
+TEST calc_sao_stats(void)
+{
+  ASSERT(test_env.generic_func != NULL);
+
+  for (int b = 0; b < sizeof(blocks) / sizeof(blocks[0]); ++b) {
+    for (int round = 0; round < 4; ++round) {
+      fill_blocks();
+
+      memset(&expected_stats, 0, sizeof(expected_stats));
+      memset(&actual_stats, 0, sizeof(actual_stats));
+
+      test_env.generic_func(orig_buf, rec_buf, blocks[b].width, blocks[b].height, UVG_BIT_DEPTH, &expected_stats);
+      test_env.tested_func(orig_buf, rec_buf, blocks[b].width, blocks[b].height, UVG_BIT_DEPTH, &actual_stats);
+
+      if (memcmp(&expected_stats, &actual_stats, sizeof(expected_stats)) != 0) {
+        FAILm("SAO statistics differ from generic");
+      }
+    }
+  }
+
+  PASS();
+}
+
+
+/**
+ * Test that the change in SSE computed from the statistics matches the one
+ * computed sample by sample, for random offsets.
+ */
+TEST sao_ddistortion_stats(void)
+{
+  ASSERT(test_env.generic_func != NULL);
+
+  for (int b = 0; b < sizeof(blocks) / sizeof(blocks[0]); ++b) {
+    const int width = blocks[b].width;
+    const int height = blocks[b].height;
+
+    for (int round = 0; round < 4; ++round) {
+      fill_blocks();
+
+      sao_stats_t stats;
+      memset(&stats, 0, sizeof(stats));
+      test_env.generic_func(orig_buf, rec_buf, width, height, UVG_BIT_DEPTH, &stats);
+
+      for (int eo_class = SAO_EO0; eo_class < SAO_NUM_EO; ++eo_class) {
+        int offsets[NUM_SAO_EDGE_CATEGORIES];
+        for (int i = 0; i < NUM_SAO_EDGE_CATEGORIES; ++i) {
+          offsets[i] = next_rand() % 15 - 7;
+        }
+        ASSERT_EQ(edge_ddistortion(width, height, eo_class, offsets),
+                  uvg_sao_edge_ddistortion_stats(&stats, eo_class, offsets));
+      }
+
+      for (int band_pos = 0; band_pos < 32; ++band_pos) {
+        int offsets[4];
+        for (int i = 0; i < 4; ++i) {
+          offsets[i] = next_rand() % 15 - 7;
+        }
+        ASSERT_EQ(band_ddistortion(width, height, band_pos, offsets),
+                  uvg_sao_band_ddistortion_stats(&stats, band_pos, offsets));
+      }
+    }
+  }
+
+  PASS();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// TEST FIXTURES
+SUITE(sao_tests)
+{
+  setup_tests();
+
+  RUN_TEST(sao_ddistortion_stats);
+
+  for (volatile unsigned i = 0; i < strategies.count; ++i) {
+    const strategy_t * strategy = &strategies.strategies[i];
+    test_env.strategy = strategy;
+
+    if (strcmp(strategy->type, "calc_sao_stats") == 0) {
+      test_env.tested_func = strategy->fptr;
+      RUN_TEST(calc_sao_stats);
+    }
+  }
+}
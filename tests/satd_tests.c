@@ -51,6 +51,7 @@ static uvg_pixel * satd_bufs[NUM_TESTS][7][2];
 static struct {
   int log_width; // for selecting dim from satd_bufs
   cost_pixel_nxn_func * tested_func;
+  cost_pixel_any_size_uv_func * uv_func;
 } satd_test_env;
 
 
@@ -172,6 +173,28 @@ TEST satd_test_gradient(void)
   PASS();
 }
 
+TEST satd_test_uv(void)
+{
+  // Sums of the checkers and gradient results above.
+  const int satd_uv_results[4] = { 4006, 9714, 20999, 64295 };
+
+  for (int log_width = 2; log_width <= 5; ++log_width) {
+    const int width = 1 << log_width;
+    uvg_pixel * u1 = satd_bufs[1][log_width][0];
+    uvg_pixel * u2 = satd_bufs[1][log_width][1];
+    uvg_pixel * v1 = satd_bufs[2][log_width][0];
+    uvg_pixel * v2 = satd_bufs[2][log_width][1];
+
+    unsigned result1 = satd_test_env.uv_func(width, width, u1, v1, width, u2, v2, width);
+    unsigned result2 = satd_test_env.uv_func(width, width, u2, v2, width, u1, v1, width);
+
+    ASSERT_EQ(result1, result2);
+    ASSERT_EQ(result1, satd_uv_results[log_width - 2]);
+  }
+
+  PASS();
+}
+
 //////////////////////////////////////////////////////////////////////////
 // TEST FIXTURES
 SUITE(satd_tests)
@@ -210,5 +233,14 @@ SUITE(satd_tests)
     RUN_TEST(satd_test_gradient);
   }
 
+  for (volatile unsigned i = 0; i < strategies.count; ++i) {
+    if (strcmp(strategies.strategies[i].type, "satd_any_size_uv") != 0) {
+      continue;
+    }
+    satd_test_env.uv_func = strategies.strategies[i].fptr;
+
+    RUN_TEST(satd_test_uv);
+  }
+
   satd_tear_down_tests();
 }
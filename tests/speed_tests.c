@@ -35,6 +35,7 @@
 #include "test_strategies.h"
 
 #include "src/image.h"
+#include "src/strategies/strategies-intra.h"
 #include "src/threads.h"
 
 #include <math.h>
@@ -314,6 +315,53 @@ TEST dct_speed(const int width)
 }
 
 
+TEST cclm_speed(const int width)
+{
+  uint64_t call_cnt = 0;
+  UVG_CLOCK_T clock_now;
+  UVG_GET_TIME(&clock_now);
+  double test_end = UVG_CLOCK_T_AS_DOUBLE(clock_now) + TIME_PER_TEST;
+
+  uvg_pixel _dst[32 * 32 + SIMD_ALIGNMENT];
+  uvg_pixel *dst = ALIGNED_POINTER(_dst, SIMD_ALIGNMENT);
+  const cclm_parameters_t cclm_params = { .a = 11, .shift = 4, .b = 37 };
+
+  // Loop until time allocated for test has passed.
+  for (unsigned i = 0;
+    test_end > UVG_CLOCK_T_AS_DOUBLE(clock_now);
+    ++i)
+  {
+    int test = i % NUM_TESTS;
+    uint64_t sum = 0;
+    for (int chunk = 0; chunk < NUM_CHUNKS; ++chunk) {
+      // Chunks are 64x64 luma, which downsample to a 32x32 chroma block.
+      const uvg_pixel *buf = &bufs[test][chunk * 64 * 64];
+      if (strcmp(test_env.strategy->type, "cclm_downsample") == 0) {
+        cclm_downsample_func *tested_func = test_env.tested_func;
+        tested_func(buf, 64, buf, dst, width, width, width);
+      } else {
+        cclm_linear_transform_func *tested_func = test_env.tested_func;
+        tested_func(&cclm_params, buf, dst, width, width);
+      }
+      sum += dst[0] + 1;
+      ++call_cnt;
+    }
+
+    ASSERT(sum > 0);
+    UVG_GET_TIME(&clock_now)
+  }
+
+  double test_time = TIME_PER_TEST + UVG_CLOCK_T_AS_DOUBLE(clock_now) - test_end;
+  sprintf(test_env.msg, "%.3fM x %s(%ix%i):%s",
+    (double)call_cnt / 1000000.0 / test_time,
+    test_env.strategy->type,
+    width,
+    width,
+    test_env.strategy->strategy_name);
+  PASSm(test_env.msg);
+}
+
+
 TEST intra_sad(void)
 {
   return test_intra_speed(test_env.width);
@@ -344,6 +392,12 @@ TEST inter_sad(void)
 }
 
 
+TEST cclm(void)
+{
+  return cclm_speed(test_env.width);
+}
+
+
 TEST fdct(void)
 {
   return dct_speed(test_env.width);
@@ -432,6 +486,14 @@ SUITE(speed_tests)
                strcmp(strategy->type, "fast_inverse_dst_4x4") == 0)
     {
       RUN_TEST(idct);
+    } else if (strcmp(strategy->type, "cclm_downsample") == 0 ||
+               strcmp(strategy->type, "cclm_linear_transform") == 0)
+    {
+      // Chroma block sizes the CCLM functions are called with.
+      for (volatile int width = 4; width <= 32; width *= 2) {
+        test_env.width = width;
+        RUN_TEST(cclm);
+      }
     }
   }
 
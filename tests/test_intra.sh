@@ -21,3 +21,12 @@ valgrind_test $common_args --lfnst
 valgrind_test $common_args --lfnst --rd=3 --cclm --mip --dual-tree --fast-residual-cost 0
 valgrind_test $common_args --rd=2 --isp --cpuid=0 --fast-residual-cost 0
 valgrind_test $common_args --rd=2 --isp --cpuid=0 --lfnst --mts=intra --fast-residual-cost 0
+
+# All-intra frames are encoded in parallel with OWF. The output must not
+# depend on the number of threads.
+valgrind_test $common_args --owf=4 --threads=2
+valgrind_test $common_args --owf=4 --threads=2 --alf=full --rd=2
+prepare 256x128 10 yuv420p
+print_and_run ../bin/uvg266 -i "${yuvfile}" --input-res=256x128 -o "${reffile}" -p1 --preset=ultrafast --no-wpp --alf=full --owf=4 --threads=0
+print_and_run ../bin/uvg266 -i "${yuvfile}" --input-res=256x128 -o "${vvcfile}" -p1 --preset=ultrafast --no-wpp --alf=full --owf=4 --threads=3
+cmp "${reffile}" "${vvcfile}"
@@ -6,3 +6,6 @@ set -eu
 . "${0%/*}/util.sh"
 
 encode_test 1x65 1 yuv420p 1
+
+# ALF does not support tiles.
+encode_test 264x130 1 yuv420p 1 --tiles=2x2 --alf=full
@@ -34,6 +34,8 @@
 
 #include "src/strategyselector.h"
 
+#include <string.h>
+
 
 strategy_list_t strategies;
 
@@ -62,4 +64,57 @@ void init_test_strategies()
     fprintf(stderr, "strategy_register_quant failed!\n");
     return;
   }
+
+  if (!uvg_strategy_register_intra(&strategies, UVG_BIT_DEPTH)) {
+    fprintf(stderr, "strategy_register_intra failed!\n");
+    return;
+  }
+
+  if (!uvg_strategy_register_alf(&strategies, UVG_BIT_DEPTH)) {
+    fprintf(stderr, "strategy_register_alf failed!\n");
+    return;
+  }
+
+  if (!uvg_strategy_register_filter(&strategies, UVG_BIT_DEPTH)) {
+    fprintf(stderr, "strategy_register_filter failed!\n");
+    return;
+  }
+
+  if (!uvg_strategy_register_sao(&strategies, UVG_BIT_DEPTH)) {
+    fprintf(stderr, "strategy_register_sao failed!\n");
+    return;
+  }
+
+  if (!uvg_strategy_register_reshape(&strategies, UVG_BIT_DEPTH)) {
+    fprintf(stderr, "strategy_register_reshape failed!\n");
+    return;
+  }
+}
+
+
+static unsigned rand_state = 12345;
+
+void rand_seed(unsigned seed)
+{
+  rand_state = seed;
+}
+
+int next_rand(void)
+{
+  rand_state = rand_state * 1103515245 + 12345;
+  return (rand_state >> 16) & 0x7fff;
+}
+
+
+void * get_generic_strategy(const char *type)
+{
+  for (unsigned i = 0; i < strategies.count; ++i) {
+    const strategy_t *strat = &strategies.strategies[i];
+    if (strcmp(strat->type, type) == 0 &&
+        strcmp(strat->strategy_name, "generic") == 0)
+    {
+      return strat->fptr;
+    }
+  }
+  return NULL;
 }
@@ -39,4 +39,11 @@ extern strategy_list_t strategies;
 
 void init_test_strategies();
 
+// Pseudo random numbers in range 0..0x7fff, repeatable after rand_seed.
+void rand_seed(unsigned seed);
+int next_rand(void);
+
+// Function pointer of the generic strategy of a type or NULL.
+void * get_generic_strategy(const char *type);
+
 #endif // TEST_STRATEGIES_H_
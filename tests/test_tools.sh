@@ -15,4 +15,29 @@ valgrind_test $common_args --transform-skip --tr-skip-max-size=5
 valgrind_test $common_args --vaq=8
 valgrind_test $common_args --vaq=8 --bitrate 350000
 valgrind_test $common_args --vaq=8 --rc-algorithm oba --bitrate 350000
-valgrind_test $common_args --ibc=1
\ No newline at end of file
+valgrind_test $common_args --ibc=1
+valgrind_test $common_args --alf=no-cc --alf-low-latency
+valgrind_test $common_args --ref-padding --bipred --subme=4
+valgrind_test $common_args --hash-me=on --bipred --gop=8
+
+# The low latency ALF filters the rows in the wavefront jobs and derives the
+# filters of the next frames in parallel with them. The output must not
+# depend on the number of threads.
+prepare 264x130 10 yuv420p
+print_and_run ../bin/uvg266 -i "${yuvfile}" --input-res=264x130 -o "${reffile}" -p0 -r1 --threads=0 --wpp --gop=8 --alf=no-cc --alf-low-latency
+print_and_run ../bin/uvg266 -i "${yuvfile}" --input-res=264x130 -o "${vvcfile}" -p0 -r1 --threads=4 --wpp --owf=2 --gop=8 --alf=no-cc --alf-low-latency
+cmp "${reffile}" "${vvcfile}"
+
+# Extending the reference borders must not change the output, also when the
+# cross component ALF of the references runs in parallel with the next frames.
+prepare 264x130 10 yuv420p
+print_and_run ../bin/uvg266 -i "${yuvfile}" --input-res=264x130 -o "${reffile}" -p0 -r1 --threads=4 --wpp --owf=2 --alf=full
+print_and_run ../bin/uvg266 -i "${yuvfile}" --input-res=264x130 -o "${vvcfile}" -p0 -r1 --threads=4 --wpp --owf=2 --alf=full --ref-padding
+cmp "${reffile}" "${vvcfile}"
+
+# With tiles the borders are extended by the loop filter jobs of each tile.
+# The tiles option disables WPP, so --wpp is given after it.
+prepare 264x130 10 yuv420p
+print_and_run ../bin/uvg266 -i "${yuvfile}" --input-res=264x130 -o "${reffile}" -p0 -r1 --threads=4 --tiles=2x2 --wpp --owf=2 --gop=8 --bipred
+print_and_run ../bin/uvg266 -i "${yuvfile}" --input-res=264x130 -o "${vvcfile}" -p0 -r1 --threads=4 --tiles=2x2 --wpp --owf=2 --gop=8 --bipred --ref-padding
+cmp "${reffile}" "${vvcfile}"
@@ -42,6 +42,12 @@ extern SUITE(satd_tests);
 extern SUITE(speed_tests);
 extern SUITE(dct_tests);
 extern SUITE(mts_tests);
+extern SUITE(mip_tests);
+extern SUITE(intra_pred_tests);
+extern SUITE(alf_tests);
+extern SUITE(filter_tests);
+extern SUITE(sao_tests);
+extern SUITE(reshape_tests);
 #endif //UVG_BIT_DEPTH == 8
 
 extern SUITE(coeff_sum_tests);
@@ -59,6 +65,12 @@ int main(int argc, char **argv)
   RUN_SUITE(satd_tests);
   RUN_SUITE(dct_tests);
   RUN_SUITE(mts_tests);
+  RUN_SUITE(mip_tests);
+  RUN_SUITE(intra_pred_tests);
+  RUN_SUITE(alf_tests);
+  RUN_SUITE(filter_tests);
+  RUN_SUITE(sao_tests);
+  RUN_SUITE(reshape_tests);
 
   if (greatest_info.suite_filter &&
       greatest_name_match("speed", greatest_info.suite_filter))
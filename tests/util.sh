@@ -7,9 +7,11 @@ set -eu${BASH+o pipefail}
 # Temporary files for encoder input and output.
 yuvfile="$(mktemp)"
 vvcfile="$(mktemp)"
+# Output of the reference encoding in tests that compare two encodings.
+reffile="$(mktemp)"
 
 cleanup() {
-    rm -rf "${yuvfile}" "${vvcfile}"
+    rm -rf "${yuvfile}" "${vvcfile}" "${reffile}"
 }
 trap cleanup EXIT
 